@@ -27,13 +27,999 @@
  */
 
 #include <sys/types.h>
+#include <sys/eventfd.h>
 #include <net/ethernet.h>
 #include <netinet/if_ether.h>
 #include <net/if.h>
 #include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
 #include "oes_status.h"
 #include "oes_types.h"
 #include "oes_api_event.h"
+#include "oes_event.h"
+
+/************************************************
+ *  Local definitions
+ ***********************************************/
+
+/*
+ * Events are written once into broadcast rings shared by all
+ * channels, one ring ("lane") per priority class, and each
+ * channel reads every lane through its own cursor. An event is
+ * copied once no matter how many channels receive it. Slots are
+ * recycled when the producer wraps around, a channel whose
+ * cursor lags by more than the lane size has lost the
+ * overwritten events; a per slot sequence number lets the reader
+ * detect it. Producers are serialized and also stamp each event
+ * with a global sequence, which orders events across lanes.
+ */
+#define OES_EVENT_LANE_CNT       (OES_EVENT_LANE_MAX + 1)
+#define OES_EVENT_LANE_SIZE_PORT (1 << 10)
+#define OES_EVENT_LANE_SIZE_FLUSH (1 << 10)
+#define OES_EVENT_LANE_SIZE_LEARN (1 << 14)
+#define OES_EVENT_LANE_SIZE_NEIGH (1 << 12)
+#define OES_EVENT_SEQ_BUSY       (~0ULL)
+#define OES_EVENT_CHANNEL_MAX    64
+#define OES_EVENT_REG_MAX        32
+#define OES_EVENT_SNAPSHOT_CHUNK 64
+#define OES_EVENT_FLUSH_FILTER_MAX 16
+#define OES_EVENT_CACHE_LINE     64
+#define OES_EVENT_WAIT_SPIN      1024
+#define OES_EVENT_LATENCY_MAX_BIT 39
+#define OES_EVENT_CLOCK_CALIB_NS 2000000ULL
+#define OES_EVENT_SNAPSHOT_REQUESTED 1
+#define OES_EVENT_SNAPSHOT_RUNNING   2
+
+struct oes_event_slot {
+    unsigned long long seq;          /**< lane sequence of the event, BUSY while written */
+    unsigned long long gseq;         /**< global sequence of the event */
+    int br_id;                       /**< bridge the event belongs to */
+    struct oes_event_info event_info;
+};
+
+struct oes_event_lane_ring {
+    struct oes_event_slot *slots;
+    unsigned long long mask;
+    unsigned long long posted;
+    unsigned long long head __attribute__((aligned(OES_EVENT_CACHE_LINE)));
+} __attribute__((aligned(OES_EVENT_CACHE_LINE)));
+
+/*
+ * A flush is delivered ahead of the learn/age events queued
+ * before it. Those events are now stale, the filter drops the
+ * ones in the flush scope until the learn lane passes the flush.
+ */
+struct oes_event_flush_filter {
+    unsigned long long gseq;         /**< global sequence of the flush */
+    int br_id;
+    struct oes_event_fdb fdb_event;
+};
+
+struct oes_event_reg {
+    int in_use;
+    int br_id;
+    enum oes_event event_id;
+    unsigned long long since;        /**< first global sequence delivered for the registration */
+    int snapshot;                    /**< REQUESTED by ADD, RUNNING once the reader owns the state below */
+    int snapshot_started;            /**< snapshot_key holds the last entry reported */
+    unsigned int snapshot_entry_cnt;
+    struct oes_event_info snapshot_key;
+};
+
+struct oes_event_channel {
+    unsigned long long cursor[OES_EVENT_LANE_CNT]; /**< next sequence to read, written by the reader only */
+    unsigned long long dropped[OES_EVENT_LANE_CNT];
+    unsigned long long max_lag[OES_EVENT_LANE_CNT];
+    unsigned long long received;
+    int waiting;                     /**< reader sleeps on fd, producer must signal */
+    int fd;
+    int in_use;
+    int closing;                     /**< DESTROY waits for the readers to leave */
+    int readers;                     /**< receive calls in progress, under the db lock */
+    int reg_cnt;
+    int snapshot_cnt;                /**< registrations waiting for their snapshot, atomic */
+    struct oes_event_reg regs[OES_EVENT_REG_MAX];
+    struct oes_event_reg *chunk_reg_p; /**< registration the pending chunk belongs to */
+    enum oes_event_lane chunk_lane;  /**< lane of the live events of the chunk entries */
+    unsigned long long chunk_seq;    /**< global sequence the chunk was read at */
+    unsigned int chunk_cnt;
+    unsigned int chunk_pos;
+    int chunk_last;
+    struct oes_event_info chunk[OES_EVENT_SNAPSHOT_CHUNK];
+    unsigned int flush_filter_cnt;
+    struct oes_event_flush_filter flush_filters[OES_EVENT_FLUSH_FILTER_MAX];
+    struct oes_event_latency_histogram latency[OES_EVENT_ID_MAX + 1]; /**< written by the reader only */
+    unsigned long long latency_epoch[OES_EVENT_ID_MAX + 1]; /**< READ_CLEAR epoch latency max_ns was taken in */
+} __attribute__((aligned(OES_EVENT_CACHE_LINE)));
+
+/*
+ * Events are stamped with the TSC when it is invariant, scaled
+ * to ns against CLOCK_MONOTONIC once at start up. Otherwise the
+ * coarse monotonic clock is used, it is read from the vDSO
+ * without a syscall.
+ */
+struct oes_event_clock {
+    int initialized;
+    int use_tsc;
+    unsigned long long tsc_base;
+    unsigned long long ns_base;
+    unsigned long long mult;         /**< ns per tick, 32.32 fixed point */
+};
+
+struct oes_event_db {
+    pthread_mutex_t lock;            /**< serializes producers and channel configuration */
+    pthread_cond_t readers_cond;     /**< signaled when the last reader leaves a closing channel */
+    int lanes_allocated;
+    struct oes_event_clock clock;
+    struct oes_event_latency_histogram latency_retired[OES_EVENT_ID_MAX + 1];
+    struct oes_event_latency_histogram latency_base[OES_EVENT_ID_MAX + 1];
+    unsigned long long latency_epoch[OES_EVENT_ID_MAX + 1]; /**< READ_CLEAR count */
+    unsigned int channel_cnt;
+    unsigned int channel_hwm;        /**< channels above this index are unused */
+    unsigned int reg_cnt[OES_EVENT_ID_MAX + 1];
+    oes_event_snapshot_iter_t snapshot_iter[OES_EVENT_ID_MAX + 1];
+    unsigned long long gseq;         /**< global sequence of the next event */
+    struct oes_event_lane_ring lanes[OES_EVENT_LANE_CNT];
+    struct oes_event_channel channels[OES_EVENT_CHANNEL_MAX];
+};
+
+static const unsigned long long oes_event_lane_size[OES_EVENT_LANE_CNT] = {
+    [OES_EVENT_LANE_PORT] = OES_EVENT_LANE_SIZE_PORT,
+    [OES_EVENT_LANE_FDB_FLUSH] = OES_EVENT_LANE_SIZE_FLUSH,
+    [OES_EVENT_LANE_FDB_LEARN] = OES_EVENT_LANE_SIZE_LEARN,
+    [OES_EVENT_LANE_NEIGH] = OES_EVENT_LANE_SIZE_NEIGH,
+};
+
+static struct oes_event_db oes_event_db = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .readers_cond = PTHREAD_COND_INITIALIZER,
+};
+
+/************************************************
+ *  Local functions
+ ***********************************************/
+
+static unsigned long long
+oes_event_clock_monotonic(const clockid_t clock_id)
+{
+    struct timespec ts;
+
+    clock_gettime(clock_id, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void
+oes_event_clock_init(struct oes_event_clock *clock_p)
+{
+#if defined(__x86_64__)
+    unsigned int eax, ebx, ecx, edx;
+    unsigned long long ns, tsc;
+
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1 << 8))) {
+        clock_p->ns_base = oes_event_clock_monotonic(CLOCK_MONOTONIC);
+        clock_p->tsc_base = __rdtsc();
+        do {
+            ns = oes_event_clock_monotonic(CLOCK_MONOTONIC);
+            tsc = __rdtsc();
+        } while (ns - clock_p->ns_base < OES_EVENT_CLOCK_CALIB_NS);
+        if (tsc > clock_p->tsc_base) {
+            clock_p->mult = ((ns - clock_p->ns_base) << 32) / (tsc - clock_p->tsc_base);
+            clock_p->use_tsc = 1;
+        }
+    }
+#endif
+    clock_p->initialized = 1;
+}
+
+static inline unsigned long long
+oes_event_clock_now(const struct oes_event_clock *clock_p)
+{
+#if defined(__x86_64__)
+    if (clock_p->use_tsc) {
+        return clock_p->ns_base +
+               (unsigned long long)(((unsigned __int128)(__rdtsc() - clock_p->tsc_base) *
+                                     clock_p->mult) >> 32);
+    }
+#endif
+    return oes_event_clock_monotonic(CLOCK_MONOTONIC_COARSE);
+}
+
+static inline unsigned int
+oes_event_latency_bucket(const unsigned long long ns)
+{
+    unsigned int msb;
+
+    if (ns < (1 << OES_EVENT_LATENCY_SUB_BITS)) {
+        return ns;
+    }
+    msb = 63 - __builtin_clzll(ns);
+    if (msb > OES_EVENT_LATENCY_MAX_BIT) {
+        return OES_EVENT_LATENCY_BUCKET_CNT - 1;
+    }
+    return ((msb - OES_EVENT_LATENCY_SUB_BITS + 1) << OES_EVENT_LATENCY_SUB_BITS) +
+           ((ns >> (msb - OES_EVENT_LATENCY_SUB_BITS)) &
+            ((1 << OES_EVENT_LATENCY_SUB_BITS) - 1));
+}
+
+static inline unsigned long long
+oes_event_latency_bucket_floor(const unsigned int bucket)
+{
+    if (bucket < (1 << OES_EVENT_LATENCY_SUB_BITS)) {
+        return bucket;
+    }
+    return ((1ULL << OES_EVENT_LATENCY_SUB_BITS) +
+            (bucket & ((1 << OES_EVENT_LATENCY_SUB_BITS) - 1))) <<
+           ((bucket >> OES_EVENT_LATENCY_SUB_BITS) - 1);
+}
+
+static inline void
+oes_event_counter_inc(unsigned long long *counter_p,
+                      const unsigned long long delta)
+{
+    /* single writer, the atomic store only keeps concurrent readers whole */
+    __atomic_store_n(counter_p, *counter_p + delta, __ATOMIC_RELAXED);
+}
+
+/*
+ * The maximum cannot be rebased like the counters, it restarts
+ * when the channel sees a new READ_CLEAR epoch.
+ */
+static void
+oes_event_latency_record(struct oes_event_channel *channel_p,
+                         const struct oes_event_info *event_info_p,
+                         const unsigned long long now)
+{
+    const enum oes_event event_id = event_info_p->event_id;
+    struct oes_event_latency_histogram *histogram_p = &channel_p->latency[event_id];
+    unsigned long long ns = 0, epoch;
+
+    /* the coarse clock may read behind the TSC stamp of a very fresh event */
+    if (now > event_info_p->timestamp) {
+        ns = now - event_info_p->timestamp;
+    }
+    oes_event_counter_inc(&histogram_p->count, 1);
+    oes_event_counter_inc(&histogram_p->sum_ns, ns);
+    oes_event_counter_inc(&histogram_p->buckets[oes_event_latency_bucket(ns)], 1);
+
+    epoch = __atomic_load_n(&oes_event_db.latency_epoch[event_id], __ATOMIC_RELAXED);
+    if (channel_p->latency_epoch[event_id] != epoch) {
+        __atomic_store_n(&histogram_p->max_ns, ns, __ATOMIC_RELAXED);
+        __atomic_store_n(&channel_p->latency_epoch[event_id], epoch, __ATOMIC_RELAXED);
+    } else if (ns > histogram_p->max_ns) {
+        __atomic_store_n(&histogram_p->max_ns, ns, __ATOMIC_RELAXED);
+    }
+}
+
+/*
+ * Adds the counters of a histogram, the maximum is taken only
+ * when it belongs to the current READ_CLEAR epoch.
+ */
+static void
+oes_event_latency_add(struct oes_event_latency_histogram *to_p,
+                      const struct oes_event_latency_histogram *from_p,
+                      const int max_valid)
+{
+    unsigned long long max_ns;
+    int i;
+
+    to_p->count += __atomic_load_n(&from_p->count, __ATOMIC_RELAXED);
+    to_p->sum_ns += __atomic_load_n(&from_p->sum_ns, __ATOMIC_RELAXED);
+    max_ns = __atomic_load_n(&from_p->max_ns, __ATOMIC_RELAXED);
+    if (max_valid && (max_ns > to_p->max_ns)) {
+        to_p->max_ns = max_ns;
+    }
+    for (i = 0; i < OES_EVENT_LATENCY_BUCKET_CNT; i++) {
+        to_p->buckets[i] += __atomic_load_n(&from_p->buckets[i], __ATOMIC_RELAXED);
+    }
+}
+
+static inline int
+oes_event_latency_max_valid(const struct oes_event_channel *channel_p,
+                            const enum oes_event event_id)
+{
+    return __atomic_load_n(&channel_p->latency_epoch[event_id], __ATOMIC_RELAXED) ==
+           oes_event_db.latency_epoch[event_id];
+}
+
+static struct oes_event_channel *
+oes_event_channel_find(const int fd)
+{
+    int i;
+
+    if (fd < 0) {
+        return NULL;
+    }
+    for (i = 0; i < oes_event_db.channel_hwm; i++) {
+        if (oes_event_db.channels[i].in_use && !oes_event_db.channels[i].closing &&
+            (oes_event_db.channels[i].fd == fd)) {
+            return &oes_event_db.channels[i];
+        }
+    }
+    return NULL;
+}
+
+static struct oes_event_reg *
+oes_event_reg_find(struct oes_event_channel *channel_p,
+                   const int br_id,
+                   const enum oes_event event_id)
+{
+    int i;
+
+    for (i = 0; i < channel_p->reg_cnt; i++) {
+        struct oes_event_reg *reg_p = &channel_p->regs[i];
+
+        if (__atomic_load_n(&reg_p->in_use, __ATOMIC_ACQUIRE) &&
+            (reg_p->br_id == br_id) && (reg_p->event_id == event_id)) {
+            return reg_p;
+        }
+    }
+    return NULL;
+}
+
+static oes_status_e
+oes_event_lanes_alloc(void)
+{
+    struct oes_event_lane_ring *lane_p;
+    unsigned long long i;
+    int lane;
+
+    for (lane = OES_EVENT_LANE_MIN; lane <= OES_EVENT_LANE_MAX; lane++) {
+        lane_p = &oes_event_db.lanes[lane];
+        if (posix_memalign((void **)&lane_p->slots, OES_EVENT_CACHE_LINE,
+                           oes_event_lane_size[lane] * sizeof(*lane_p->slots)) != 0) {
+            while (--lane >= OES_EVENT_LANE_MIN) {
+                free(oes_event_db.lanes[lane].slots);
+                oes_event_db.lanes[lane].slots = NULL;
+            }
+            return OES_STATUS_NO_MEMORY;
+        }
+        for (i = 0; i < oes_event_lane_size[lane]; i++) {
+            lane_p->slots[i].seq = OES_EVENT_SEQ_BUSY;
+        }
+        lane_p->mask = oes_event_lane_size[lane] - 1;
+    }
+
+    /* lanes are kept for the process lifetime, readers never see them go away */
+    oes_event_db.lanes_allocated = 1;
+    return OES_STATUS_SUCCESS;
+}
+
+static oes_status_e
+oes_event_channel_create(int *fd_p)
+{
+    struct oes_event_channel *channel_p = NULL;
+    oes_status_e status;
+    int i, fd;
+
+    for (i = 0; i < OES_EVENT_CHANNEL_MAX; i++) {
+        if (!oes_event_db.channels[i].in_use) {
+            channel_p = &oes_event_db.channels[i];
+            break;
+        }
+    }
+    if (channel_p == NULL) {
+        return OES_STATUS_NO_RESOURCES;
+    }
+
+    if (!oes_event_db.clock.initialized) {
+        oes_event_clock_init(&oes_event_db.clock);
+    }
+    if (!oes_event_db.lanes_allocated) {
+        status = oes_event_lanes_alloc();
+        if (status != OES_STATUS_SUCCESS) {
+            return status;
+        }
+    }
+
+    fd = eventfd(0, EFD_CLOEXEC);
+    if (fd < 0) {
+        return OES_STATUS_NO_RESOURCES;
+    }
+
+    memset(channel_p, 0, sizeof(*channel_p));
+    channel_p->fd = fd;
+    channel_p->waiting = 1;
+    for (i = OES_EVENT_LANE_MIN; i <= OES_EVENT_LANE_MAX; i++) {
+        channel_p->cursor[i] = oes_event_db.lanes[i].head;
+    }
+    channel_p->in_use = 1;
+    oes_event_db.channel_cnt++;
+    if (channel_p - oes_event_db.channels >= oes_event_db.channel_hwm) {
+        oes_event_db.channel_hwm = channel_p - oes_event_db.channels + 1;
+    }
+    *fd_p = fd;
+
+    return OES_STATUS_SUCCESS;
+}
+
+static oes_status_e
+oes_event_channel_destroy(const int fd)
+{
+    struct oes_event_channel *channel_p = oes_event_channel_find(fd);
+    unsigned long long one = 1;
+    int i;
+
+    if (channel_p == NULL) {
+        return OES_STATUS_ENTRY_NOT_FOUND;
+    }
+
+    /* wake the readers blocked on the fd and wait for them to leave */
+    __atomic_store_n(&channel_p->closing, 1, __ATOMIC_SEQ_CST);
+    while (channel_p->readers > 0) {
+        if (write(channel_p->fd, &one, sizeof(one)) < 0) {
+            /* the counter is saturated, the readers are awake anyway */
+        }
+        pthread_cond_wait(&oes_event_db.readers_cond, &oes_event_db.lock);
+    }
+
+    for (i = 0; i < channel_p->reg_cnt; i++) {
+        if (channel_p->regs[i].in_use) {
+            oes_event_db.reg_cnt[channel_p->regs[i].event_id]--;
+        }
+    }
+    for (i = OES_EVENT_ID_MIN; i <= OES_EVENT_ID_MAX; i++) {
+        oes_event_latency_add(&oes_event_db.latency_retired[i], &channel_p->latency[i],
+                              oes_event_latency_max_valid(channel_p, i));
+    }
+    channel_p->in_use = 0;
+    close(channel_p->fd);
+    oes_event_db.channel_cnt--;
+
+    return OES_STATUS_SUCCESS;
+}
+
+static enum oes_event_lane
+oes_event_lane_get(const struct oes_event_info *event_info_p)
+{
+    if (event_info_p->event_id == OES_EVENT_ID_PORT) {
+        return OES_EVENT_LANE_PORT;
+    }
+    if (event_info_p->event_id == OES_EVENT_ID_NEIGH) {
+        return OES_EVENT_LANE_NEIGH;
+    }
+    if ((event_info_p->event_info.fdb_event.fbd_event_type == OES_FDB_EVENT_LEARN) ||
+        (event_info_p->event_info.fdb_event.fbd_event_type == OES_FDB_EVENT_AGE)) {
+        return OES_EVENT_LANE_FDB_LEARN;
+    }
+    return OES_EVENT_LANE_FDB_FLUSH;
+}
+
+/*
+ * Key order of the entries carried by events, the order
+ * snapshot iterators walk in. Only port and FDB learn/age
+ * events describe a single entry; FDB flushes are never
+ * filtered by a snapshot, neighbour events have none.
+ */
+static int
+oes_event_keyed(const struct oes_event_info *event_info_p)
+{
+    enum oes_event_lane lane = oes_event_lane_get(event_info_p);
+
+    return (lane == OES_EVENT_LANE_PORT) || (lane == OES_EVENT_LANE_FDB_LEARN);
+}
+
+static int
+oes_event_key_cmp(const struct oes_event_info *a_p,
+                  const struct oes_event_info *b_p)
+{
+    const struct oes_fdb_uc_mac_addr_params *fdb_a_p, *fdb_b_p;
+
+    if (a_p->event_id == OES_EVENT_ID_PORT) {
+        if (a_p->event_info.port_event.log_port != b_p->event_info.port_event.log_port) {
+            return (a_p->event_info.port_event.log_port <
+                    b_p->event_info.port_event.log_port) ? -1 : 1;
+        }
+        return 0;
+    }
+
+    fdb_a_p = &a_p->event_info.fdb_event.fdb_event_data.fdb_entry.fdb_entry;
+    fdb_b_p = &b_p->event_info.fdb_event.fdb_event_data.fdb_entry.fdb_entry;
+    if (fdb_a_p->vid != fdb_b_p->vid) {
+        return (fdb_a_p->vid < fdb_b_p->vid) ? -1 : 1;
+    }
+    return memcmp(&fdb_a_p->mac_addr, &fdb_b_p->mac_addr, sizeof(fdb_a_p->mac_addr));
+}
+
+/*
+ * A live event of a registration which is being snapshotted is
+ * delivered only when the snapshot already reported its entry;
+ * later entries are reported by the snapshot in their state at
+ * the time their chunk is read.
+ */
+static int
+oes_event_snapshot_filter(const struct oes_event_reg *reg_p,
+                          const struct oes_event_info *event_info_p)
+{
+    int snapshot = __atomic_load_n(&reg_p->snapshot, __ATOMIC_ACQUIRE);
+
+    if (!snapshot || !oes_event_keyed(event_info_p)) {
+        return 1;
+    }
+    return (snapshot == OES_EVENT_SNAPSHOT_RUNNING) && reg_p->snapshot_started &&
+           (oes_event_key_cmp(event_info_p, &reg_p->snapshot_key) <= 0);
+}
+
+static int
+oes_event_flush_scope_match(const struct oes_event_fdb *flush_p,
+                            const struct oes_fdb_uc_mac_addr_params *entry_p)
+{
+    switch (flush_p->fbd_event_type) {
+    case OES_FDB_EVENT_FLUSH_ALL:
+        return 1;
+
+    case OES_FDB_EVENT_FLUSH_VID:
+        return entry_p->vid == flush_p->fdb_event_data.fdb_vid.vid;
+
+    case OES_FDB_EVENT_FLUSH_PORT:
+        return entry_p->log_port == flush_p->fdb_event_data.fdb_port.port;
+
+    case OES_FDB_EVENT_FLUSH_PORT_VID:
+        return (entry_p->log_port == flush_p->fdb_event_data.fdb_port_vid.port) &&
+               (entry_p->vid == flush_p->fdb_event_data.fdb_port_vid.vid);
+
+    default:
+        return 0;
+    }
+}
+
+/*
+ * Returns 1 when an FDB entry, in its state at global sequence
+ * gseq, was superseded by a flush already delivered.
+ */
+static int
+oes_event_flush_filter(const struct oes_event_channel *channel_p,
+                       const int br_id,
+                       const struct oes_event_info *event_info_p,
+                       const unsigned long long gseq)
+{
+    const struct oes_event_flush_filter *filter_p;
+    unsigned int i;
+
+    for (i = 0; i < channel_p->flush_filter_cnt; i++) {
+        filter_p = &channel_p->flush_filters[i];
+        if ((gseq < filter_p->gseq) && (br_id == filter_p->br_id) &&
+            oes_event_flush_scope_match(&filter_p->fdb_event,
+                                        &event_info_p->event_info.fdb_event.fdb_event_data.fdb_entry.fdb_entry)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Drops the filters of flushes older than gseq, the learn lane
+ * and any snapshot chunk read from now on are past them.
+ */
+static void
+oes_event_flush_filter_expire(struct oes_event_channel *channel_p,
+                              const unsigned long long gseq)
+{
+    unsigned int i = 0;
+
+    while (i < channel_p->flush_filter_cnt) {
+        if (channel_p->flush_filters[i].gseq < gseq) {
+            channel_p->flush_filters[i] =
+                channel_p->flush_filters[--channel_p->flush_filter_cnt];
+        } else {
+            i++;
+        }
+    }
+}
+
+/*
+ * Ends the snapshot of a registration, from the state given or
+ * from any state when expected is 0. The reader and DELETE both
+ * end snapshots, only the one clearing the flag drops the channel
+ * count. Returns 0 when the snapshot had ended or changed owner.
+ */
+static int
+oes_event_snapshot_done(struct oes_event_channel *channel_p,
+                        struct oes_event_reg *reg_p,
+                        int expected)
+{
+    if (expected == 0) {
+        if (!__atomic_exchange_n(&reg_p->snapshot, 0, __ATOMIC_ACQ_REL)) {
+            return 0;
+        }
+    } else if (!__atomic_compare_exchange_n(&reg_p->snapshot, &expected, 0, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+    __atomic_sub_fetch(&channel_p->snapshot_cnt, 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static void
+oes_event_snapshot_restart(struct oes_event_channel *channel_p)
+{
+    int i;
+
+    for (i = 0; i < channel_p->reg_cnt; i++) {
+        channel_p->regs[i].snapshot_started = 0;
+        channel_p->regs[i].snapshot_entry_cnt = 0;
+    }
+    channel_p->chunk_reg_p = NULL;
+}
+
+/*
+ * Reads the next chunk of the first registration waiting for
+ * its snapshot. The chunk is delivered once the channel has
+ * read its lane up to the global sequence the chunk was read at.
+ */
+static void
+oes_event_snapshot_fetch(struct oes_event_channel *channel_p)
+{
+    struct oes_event_reg *reg_p = NULL;
+    oes_event_snapshot_iter_t iter;
+    unsigned long long seq, now;
+    unsigned int cnt = OES_EVENT_SNAPSHOT_CHUNK, i;
+    int state = OES_EVENT_SNAPSHOT_REQUESTED;
+
+    for (i = 0; i < channel_p->reg_cnt; i++) {
+        if (__atomic_load_n(&channel_p->regs[i].in_use, __ATOMIC_ACQUIRE) &&
+            __atomic_load_n(&channel_p->regs[i].snapshot, __ATOMIC_ACQUIRE)) {
+            reg_p = &channel_p->regs[i];
+            break;
+        }
+    }
+    if (reg_p == NULL) {
+        /* the ADD counting it has not published the registration yet */
+        return;
+    }
+    /* ADD only requests the snapshot, the reader resets its own state */
+    if (__atomic_load_n(&reg_p->snapshot, __ATOMIC_ACQUIRE) == OES_EVENT_SNAPSHOT_REQUESTED) {
+        reg_p->snapshot_started = 0;
+        reg_p->snapshot_entry_cnt = 0;
+        if (!__atomic_compare_exchange_n(&reg_p->snapshot, &state, OES_EVENT_SNAPSHOT_RUNNING, 0,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return;
+        }
+    }
+
+    iter = __atomic_load_n(&oes_event_db.snapshot_iter[reg_p->event_id], __ATOMIC_ACQUIRE);
+    if ((iter == NULL) ||
+        (iter(reg_p->br_id, reg_p->snapshot_started ? &reg_p->snapshot_key : NULL,
+              channel_p->chunk, &cnt, &seq) != OES_STATUS_SUCCESS)) {
+        cnt = 0;
+        seq = oes_event_seq_get();
+    }
+
+    now = oes_event_clock_now(&oes_event_db.clock);
+    for (i = 0; i < cnt; i++) {
+        channel_p->chunk[i].event_id = reg_p->event_id;
+        channel_p->chunk[i].timestamp = now;
+    }
+    channel_p->chunk_reg_p = reg_p;
+    channel_p->chunk_lane = (reg_p->event_id == OES_EVENT_ID_PORT) ?
+                            OES_EVENT_LANE_PORT : OES_EVENT_LANE_FDB_LEARN;
+    channel_p->chunk_seq = seq;
+    channel_p->chunk_cnt = cnt;
+    channel_p->chunk_pos = 0;
+    channel_p->chunk_last = (cnt < OES_EVENT_SNAPSHOT_CHUNK);
+}
+
+/*
+ * Delivers the pending chunk, then the end marker after the
+ * last one. Returns 0 when the chunk is done and nothing was
+ * delivered.
+ */
+static int
+oes_event_snapshot_emit(struct oes_event_channel *channel_p,
+                        struct oes_event_info *event_info_p)
+{
+    struct oes_event_reg *reg_p = channel_p->chunk_reg_p;
+
+    /* a REQUESTED state means the registration was deleted and the slot reused */
+    if (!__atomic_load_n(&reg_p->in_use, __ATOMIC_ACQUIRE) ||
+        (__atomic_load_n(&reg_p->snapshot, __ATOMIC_ACQUIRE) != OES_EVENT_SNAPSHOT_RUNNING)) {
+        channel_p->chunk_reg_p = NULL;
+        return 0;
+    }
+    while (channel_p->chunk_pos < channel_p->chunk_cnt) {
+        *event_info_p = channel_p->chunk[channel_p->chunk_pos++];
+        reg_p->snapshot_key = *event_info_p;
+        reg_p->snapshot_started = 1;
+        /* the entry was read before a flush already delivered */
+        if ((event_info_p->event_id == OES_EVENT_ID_FDB) &&
+            oes_event_flush_filter(channel_p, reg_p->br_id, event_info_p,
+                                   channel_p->chunk_seq - 1)) {
+            continue;
+        }
+        reg_p->snapshot_entry_cnt++;
+        return 1;
+    }
+
+    channel_p->chunk_reg_p = NULL;
+    if (!channel_p->chunk_last) {
+        return 0;
+    }
+    /* a DELETE racing the end marker owns the count then */
+    if (!oes_event_snapshot_done(channel_p, reg_p, OES_EVENT_SNAPSHOT_RUNNING)) {
+        return 0;
+    }
+
+    memset(event_info_p, 0, sizeof(*event_info_p));
+    event_info_p->event_id = OES_EVENT_ID_SNAPSHOT_END;
+    event_info_p->event_info.snapshot_end.event_id = reg_p->event_id;
+    event_info_p->event_info.snapshot_end.br_id = reg_p->br_id;
+    event_info_p->event_info.snapshot_end.entry_cnt = reg_p->snapshot_entry_cnt;
+    event_info_p->timestamp = oes_event_clock_now(&oes_event_db.clock);
+    return 1;
+}
+
+/*
+ * Copies the next event of a lane, with a global sequence below
+ * limit, out of the ring. Returns 1 when an event was read, 0
+ * when the cursor reached the limit or the producer, -1 when
+ * the lane lapped the channel during a snapshot, which restarts
+ * it.
+ */
+static int
+oes_event_lane_read(struct oes_event_channel *channel_p,
+                    const enum oes_event_lane lane,
+                    const unsigned long long limit,
+                    struct oes_event_slot *slot_copy_p)
+{
+    struct oes_event_lane_ring *lane_p = &oes_event_db.lanes[lane];
+    unsigned long long cursor = channel_p->cursor[lane];
+    unsigned long long head, lag;
+    struct oes_event_slot *slot_p;
+
+    for (;;) {
+        head = __atomic_load_n(&lane_p->head, __ATOMIC_SEQ_CST);
+        if (cursor == head) {
+            return 0;
+        }
+
+        lag = head - cursor;
+        if (lag > lane_p->mask) {
+            /* lapped, the slot under the cursor may already be rewritten */
+            channel_p->dropped[lane] += lag - lane_p->mask;
+            cursor = head - lane_p->mask;
+            lag = lane_p->mask;
+            __atomic_store_n(&channel_p->cursor[lane], cursor, __ATOMIC_RELEASE);
+            if (__atomic_load_n(&channel_p->snapshot_cnt, __ATOMIC_ACQUIRE) > 0) {
+                oes_event_snapshot_restart(channel_p);
+                return -1;
+            }
+        }
+        if (lag > channel_p->max_lag[lane]) {
+            channel_p->max_lag[lane] = lag;
+        }
+
+        slot_p = &lane_p->slots[cursor & lane_p->mask];
+        if (__atomic_load_n(&slot_p->seq, __ATOMIC_ACQUIRE) != cursor) {
+            continue;
+        }
+        *slot_copy_p = *slot_p;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot_p->seq, __ATOMIC_RELAXED) != cursor) {
+            continue;
+        }
+        if (slot_copy_p->gseq >= limit) {
+            return 0;
+        }
+
+        __atomic_store_n(&channel_p->cursor[lane], cursor + 1, __ATOMIC_RELEASE);
+        return 1;
+    }
+}
+
+/*
+ * Copies the next event for the channel, lanes are drained in
+ * strict priority order. Returns 1 when an event was read, 0
+ * when the channel is drained. Events of bridges/ids the
+ * channel is not registered for are skipped.
+ */
+static int
+oes_event_channel_pop(struct oes_event_channel *channel_p,
+                      struct oes_event_info *event_info_p)
+{
+    struct oes_event_slot slot;
+    struct oes_event_reg *reg_p;
+    unsigned long long limit;
+    int lane, chunk_due, rc = 0;
+
+    for (;;) {
+        if ((channel_p->chunk_reg_p == NULL) &&
+            (__atomic_load_n(&channel_p->snapshot_cnt, __ATOMIC_ACQUIRE) > 0)) {
+            oes_event_snapshot_fetch(channel_p);
+        }
+
+        for (lane = OES_EVENT_LANE_MIN; lane <= OES_EVENT_LANE_MAX; lane++) {
+            if ((lane == OES_EVENT_LANE_FDB_FLUSH) &&
+                (channel_p->flush_filter_cnt == OES_EVENT_FLUSH_FILTER_MAX)) {
+                /* let the learn lane catch up and expire filters first */
+                continue;
+            }
+            chunk_due = (channel_p->chunk_reg_p != NULL) && (channel_p->chunk_lane == lane);
+            limit = chunk_due ? channel_p->chunk_seq : OES_EVENT_SEQ_BUSY;
+            rc = oes_event_lane_read(channel_p, lane, limit, &slot);
+            if (rc != 0) {
+                break;
+            }
+            if (chunk_due) {
+                rc = oes_event_snapshot_emit(channel_p, event_info_p) ? 2 : -1;
+                break;
+            }
+            if ((lane == OES_EVENT_LANE_FDB_LEARN) && (channel_p->flush_filter_cnt > 0)) {
+                /* nothing older than the current sequence is left to filter */
+                oes_event_flush_filter_expire(channel_p, oes_event_seq_get());
+            }
+        }
+        if (rc == 2) {
+            break;
+        }
+        if (rc < 0) {
+            continue;
+        }
+        if (rc == 0) {
+            return 0;
+        }
+
+        *event_info_p = slot.event_info;
+        reg_p = oes_event_reg_find(channel_p, slot.br_id, event_info_p->event_id);
+        if ((reg_p == NULL) || (slot.gseq < reg_p->since) ||
+            !oes_event_snapshot_filter(reg_p, event_info_p)) {
+            continue;
+        }
+        if (lane == OES_EVENT_LANE_FDB_LEARN) {
+            oes_event_flush_filter_expire(channel_p, slot.gseq);
+            if (oes_event_flush_filter(channel_p, slot.br_id, event_info_p, slot.gseq)) {
+                continue;
+            }
+        } else if (lane == OES_EVENT_LANE_FDB_FLUSH) {
+            channel_p->flush_filters[channel_p->flush_filter_cnt].gseq = slot.gseq;
+            channel_p->flush_filters[channel_p->flush_filter_cnt].br_id = slot.br_id;
+            channel_p->flush_filters[channel_p->flush_filter_cnt].fdb_event =
+                event_info_p->event_info.fdb_event;
+            channel_p->flush_filter_cnt++;
+        }
+        break;
+    }
+
+    channel_p->received++;
+    return 1;
+}
+
+static int
+oes_event_channel_pending(const struct oes_event_channel *channel_p)
+{
+    int lane;
+
+    for (lane = OES_EVENT_LANE_MIN; lane <= OES_EVENT_LANE_MAX; lane++) {
+        if (__atomic_load_n(&oes_event_db.lanes[lane].head, __ATOMIC_SEQ_CST) !=
+            channel_p->cursor[lane]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Blocks on the channel fd until the producer publishes. The
+ * waiting flag is raised before the lanes are checked again so
+ * a concurrent publish either is seen or signals the fd.
+ */
+static oes_status_e
+oes_event_channel_wait(struct oes_event_channel *channel_p)
+{
+    unsigned long long cnt;
+    int spin;
+
+    /* a short spin saves the eventfd round trip under steady load */
+    for (spin = 0; spin < OES_EVENT_WAIT_SPIN; spin++) {
+        if (oes_event_channel_pending(channel_p)) {
+            return OES_STATUS_SUCCESS;
+        }
+    }
+
+    __atomic_store_n(&channel_p->waiting, 1, __ATOMIC_SEQ_CST);
+    if (oes_event_channel_pending(channel_p)) {
+        return OES_STATUS_SUCCESS;
+    }
+    /* DESTROY raises closing before it signals the fd */
+    if (__atomic_load_n(&channel_p->closing, __ATOMIC_SEQ_CST)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    if ((read(channel_p->fd, &cnt, sizeof(cnt)) < 0) && (errno != EINTR)) {
+        return OES_STATUS_ERROR;
+    }
+    return OES_STATUS_SUCCESS;
+}
+
+static void
+oes_event_channel_signal(const int br_id,
+                         const enum oes_event event_id)
+{
+    unsigned long long one = 1;
+    struct oes_event_channel *channel_p;
+    int i;
+
+    for (i = 0; i < oes_event_db.channel_hwm; i++) {
+        channel_p = &oes_event_db.channels[i];
+        if (!channel_p->in_use ||
+            !__atomic_load_n(&channel_p->waiting, __ATOMIC_SEQ_CST) ||
+            (oes_event_reg_find(channel_p, br_id, event_id) == NULL)) {
+            continue;
+        }
+        if (__atomic_exchange_n(&channel_p->waiting, 0, __ATOMIC_SEQ_CST)) {
+            if (write(channel_p->fd, &one, sizeof(one)) < 0) {
+                /* the counter is saturated, the reader is awake anyway */
+            }
+        }
+    }
+}
+
+/************************************************
+ *  Internal functions
+ ***********************************************/
+
+oes_status_e
+oes_event_snapshot_iter_set(const enum oes_event event_id,
+                            oes_event_snapshot_iter_t iter)
+{
+    if ((event_id != OES_EVENT_ID_FDB) && (event_id != OES_EVENT_ID_PORT)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    __atomic_store_n(&oes_event_db.snapshot_iter[event_id], iter, __ATOMIC_RELEASE);
+    return OES_STATUS_SUCCESS;
+}
+
+unsigned long long
+oes_event_seq_get(void)
+{
+    return __atomic_load_n(&oes_event_db.gseq, __ATOMIC_ACQUIRE);
+}
+
+oes_status_e
+oes_event_post(const int br_id,
+               const struct oes_event_info *event_info_p)
+{
+    struct oes_event_lane_ring *lane_p;
+    struct oes_event_slot *slot_p;
+    unsigned long long head;
+
+    if ((event_info_p == NULL) ||
+        (event_info_p->event_id >= OES_EVENT_ID_SNAPSHOT_END)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    if (__atomic_load_n(&oes_event_db.reg_cnt[event_info_p->event_id],
+                        __ATOMIC_RELAXED) == 0) {
+        return OES_STATUS_SUCCESS;
+    }
+
+    pthread_mutex_lock(&oes_event_db.lock);
+
+    lane_p = &oes_event_db.lanes[oes_event_lane_get(event_info_p)];
+    head = lane_p->head;
+    slot_p = &lane_p->slots[head & lane_p->mask];
+    __atomic_store_n(&slot_p->seq, OES_EVENT_SEQ_BUSY, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot_p->gseq = oes_event_db.gseq;
+    slot_p->br_id = br_id;
+    slot_p->event_info = *event_info_p;
+    slot_p->event_info.timestamp = oes_event_clock_now(&oes_event_db.clock);
+    __atomic_store_n(&slot_p->seq, head, __ATOMIC_RELEASE);
+    __atomic_store_n(&lane_p->head, head + 1, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&oes_event_db.gseq, oes_event_db.gseq + 1, __ATOMIC_RELEASE);
+    lane_p->posted++;
+
+    oes_event_channel_signal(br_id, event_info_p->event_id);
+
+    pthread_mutex_unlock(&oes_event_db.lock);
+
+    return OES_STATUS_SUCCESS;
+}
 
 /**
  * This function sets the log verbosity level of EVENT  MODULE
@@ -82,14 +1068,38 @@ oes_status_e
 oes_api_event_fd_set(const enum oes_access_cmd access_cmd, int *fd_p,
                      void *event_fd_vs_ext)
 {
-    return OES_STATUS_SUCCESS;
+    oes_status_e status;
+
+    if (fd_p == NULL) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_mutex_lock(&oes_event_db.lock);
+    switch (access_cmd) {
+    case OES_ACCESS_CMD_CREATE:
+        status = oes_event_channel_create(fd_p);
+        break;
+
+    case OES_ACCESS_CMD_DESTROY:
+        status = oes_event_channel_destroy(*fd_p);
+        break;
+
+    default:
+        status = OES_STATUS_CMD_UNSUPPORTED;
+        break;
+    }
+    pthread_mutex_unlock(&oes_event_db.lock);
+
+    return status;
 }
 
 /**
- * Register/DeRegister Events  (Port up /down , FDB event)
+ * Register/DeRegister Events  (Port up /down , FDB event,
+ * neighbour event)
  *
  * @param[in] access_cmd - ADD/DELETE    -
- * @param[in] br_id - Bridge id
+ * @param[in] br_id - Bridge id, virtual router ID for neighbour
+ *       events
  * @param[in] event_id - Event ID.
  * @param[in] fd - The file descriptor for the events to be send.
  * @param[in,out] event_register_vs_ext - vendor specific
@@ -107,7 +1117,83 @@ oes_api_event_register_set(const enum oes_access_cmd access_cmd,
                            const int fd,
                            void *event_register_vs_ext)
 {
-    return OES_STATUS_SUCCESS;
+    const struct oes_event_register_params *params_p = event_register_vs_ext;
+    struct oes_event_channel *channel_p;
+    struct oes_event_reg *reg_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    int i;
+
+    if ((event_id != OES_EVENT_ID_FDB) && (event_id != OES_EVENT_ID_PORT) &&
+        (event_id != OES_EVENT_ID_NEIGH)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    /* snapshots need the owning module to install its iterator first */
+    if ((access_cmd == OES_ACCESS_CMD_ADD) && (params_p != NULL) &&
+        params_p->enable_snapshot &&
+        (__atomic_load_n(&oes_event_db.snapshot_iter[event_id], __ATOMIC_ACQUIRE) == NULL)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_mutex_lock(&oes_event_db.lock);
+
+    channel_p = oes_event_channel_find(fd);
+    if (channel_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+        goto out;
+    }
+    reg_p = oes_event_reg_find(channel_p, br_id, event_id);
+
+    switch (access_cmd) {
+    case OES_ACCESS_CMD_ADD:
+        if (reg_p != NULL) {
+            status = OES_STATUS_ENTRY_ALREADY_EXISTS;
+            break;
+        }
+        for (i = 0; i < OES_EVENT_REG_MAX; i++) {
+            if (!channel_p->regs[i].in_use) {
+                reg_p = &channel_p->regs[i];
+                break;
+            }
+        }
+        if (reg_p == NULL) {
+            status = OES_STATUS_NO_RESOURCES;
+            break;
+        }
+        reg_p->br_id = br_id;
+        reg_p->event_id = event_id;
+        reg_p->since = oes_event_db.gseq;
+        if ((params_p != NULL) && params_p->enable_snapshot) {
+            /* counted before the registration is published, see snapshot_fetch */
+            __atomic_store_n(&reg_p->snapshot, OES_EVENT_SNAPSHOT_REQUESTED, __ATOMIC_RELEASE);
+            __atomic_add_fetch(&channel_p->snapshot_cnt, 1, __ATOMIC_RELEASE);
+        } else {
+            __atomic_store_n(&reg_p->snapshot, 0, __ATOMIC_RELEASE);
+        }
+        __atomic_store_n(&reg_p->in_use, 1, __ATOMIC_RELEASE);
+        if (i >= channel_p->reg_cnt) {
+            channel_p->reg_cnt = i + 1;
+        }
+        __atomic_add_fetch(&oes_event_db.reg_cnt[event_id], 1, __ATOMIC_RELAXED);
+        break;
+
+    case OES_ACCESS_CMD_DELETE:
+        if (reg_p == NULL) {
+            status = OES_STATUS_ENTRY_NOT_FOUND;
+            break;
+        }
+        __atomic_store_n(&reg_p->in_use, 0, __ATOMIC_RELEASE);
+        oes_event_snapshot_done(channel_p, reg_p, 0);
+        __atomic_sub_fetch(&oes_event_db.reg_cnt[event_id], 1, __ATOMIC_RELAXED);
+        break;
+
+    default:
+        status = OES_STATUS_CMD_UNSUPPORTED;
+        break;
+    }
+
+out:
+    pthread_mutex_unlock(&oes_event_db.lock);
+    return status;
 }
 
 /**
@@ -127,5 +1213,233 @@ oes_api_event_recv(const int fd,
                    struct oes_event_info *event_info_p,
                    void *event_recv_vs_ext)
 {
+    unsigned int cnt = 1;
+
+    return oes_api_event_recv_batch(fd, event_info_p, &cnt, event_recv_vs_ext);
+}
+
+/**
+ * This API enables the user to receive a batch of Events. The
+ * call blocks until at least one event is available and then
+ * returns as many pending events as fit in the list. Events
+ * are queued in priority lanes (enum oes_event_lane) drained
+ * in strict priority order, port events first; an FDB flush
+ * also discards the learn/age events it overtook.
+ * DESTROY of the channel wakes a blocked call, which then
+ * fails with OES_STATUS_PARAM_ERROR, and waits for it to leave.
+ *
+ *@param[in] fd - File descriptor to listen on.
+ *@param[out] event_info_list_p - event information array
+ *@param[in,out] event_cnt_p - array size, number of events
+ *       received
+ *@param[in,out] event_rcv_vs_ext - vendor specific
+ *       extention
+ *@return OES_STATUS_SUCCESS if operation completes successfully
+ *@return OES_STATUS_PARAM_ERROR if any input parameters is
+ *         invalid
+ *@return OES_STATUS_ERROR general error
+ */
+oes_status_e
+oes_api_event_recv_batch(const int fd,
+                         struct oes_event_info *event_info_list_p,
+                         unsigned int *event_cnt_p,
+                         void *event_recv_vs_ext)
+{
+    struct oes_event_channel *channel_p;
+    oes_status_e status;
+    unsigned long long now;
+    unsigned int cnt = 0, i;
+
+    if ((event_info_list_p == NULL) || (event_cnt_p == NULL) ||
+        (*event_cnt_p == 0)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    /* the reference keeps DESTROY from releasing the channel under the reader */
+    pthread_mutex_lock(&oes_event_db.lock);
+    channel_p = oes_event_channel_find(fd);
+    if (channel_p != NULL) {
+        channel_p->readers++;
+    }
+    pthread_mutex_unlock(&oes_event_db.lock);
+    if (channel_p == NULL) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    for (;;) {
+        while ((cnt < *event_cnt_p) &&
+               oes_event_channel_pop(channel_p, &event_info_list_p[cnt])) {
+            cnt++;
+        }
+        if (cnt > 0) {
+            break;
+        }
+        status = oes_event_channel_wait(channel_p);
+        if (status != OES_STATUS_SUCCESS) {
+            goto out;
+        }
+    }
+
+    now = oes_event_clock_now(&oes_event_db.clock);
+    for (i = 0; i < cnt; i++) {
+        oes_event_latency_record(channel_p, &event_info_list_p[i], now);
+    }
+
+    *event_cnt_p = cnt;
+    status = OES_STATUS_SUCCESS;
+
+out:
+    pthread_mutex_lock(&oes_event_db.lock);
+    if ((--channel_p->readers == 0) && channel_p->closing) {
+        pthread_cond_broadcast(&oes_event_db.readers_cond);
+    }
+    pthread_mutex_unlock(&oes_event_db.lock);
+    return status;
+}
+
+/**
+ * This API retrieves the statistics of an event channel. All
+ * channels share one broadcast ring per priority lane and each
+ * channel reads it through its own cursor, the lane depth is
+ * the distance between the channel cursor and the producer. A
+ * channel lagging by more than the lane size loses the oldest
+ * events of the lane.
+ *
+ *@param[in] fd - File descriptor of the channel.
+ *@param[out] stats_p - channel statistics
+ *@param[in,out] event_stats_vs_ext - vendor specific
+ *       extention
+ *@return OES_STATUS_SUCCESS if operation completes successfully
+ *@return OES_STATUS_PARAM_ERROR if any input parameters is
+ *         invalid
+ *@return OES_STATUS_ENTRY_NOT_FOUND if fd is not an event channel
+ */
+oes_status_e
+oes_api_event_stats_get(const int fd,
+                        struct oes_event_channel_stats *stats_p,
+                        void *event_stats_vs_ext)
+{
+    struct oes_event_channel *channel_p;
+    unsigned long long depth;
+    int lane;
+
+    if (stats_p == NULL) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_mutex_lock(&oes_event_db.lock);
+    channel_p = oes_event_channel_find(fd);
+    if (channel_p == NULL) {
+        pthread_mutex_unlock(&oes_event_db.lock);
+        return OES_STATUS_ENTRY_NOT_FOUND;
+    }
+    memset(stats_p, 0, sizeof(*stats_p));
+    stats_p->received = channel_p->received;
+    for (lane = OES_EVENT_LANE_MIN; lane <= OES_EVENT_LANE_MAX; lane++) {
+        depth = oes_event_db.lanes[lane].head -
+                __atomic_load_n(&channel_p->cursor[lane], __ATOMIC_ACQUIRE);
+        stats_p->lane_depth[lane] = depth;
+        stats_p->lane_dropped[lane] = channel_p->dropped[lane];
+        stats_p->dropped += channel_p->dropped[lane];
+        stats_p->lag += depth;
+        if (channel_p->max_lag[lane] > depth) {
+            depth = channel_p->max_lag[lane];
+        }
+        if (depth > stats_p->max_lag) {
+            stats_p->max_lag = depth;
+        }
+        if (depth >= oes_event_lane_size[lane] / 2) {
+            stats_p->slow = 1;
+        }
+    }
+    pthread_mutex_unlock(&oes_event_db.lock);
+
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This API reads the enqueue to dequeue latency histogram of an
+ * event ID, accumulated over all the event channels. Events are
+ * time stamped when produced and measured when received.
+ * The maximum restarts at every READ_CLEAR; an event received
+ * while READ_CLEAR runs may only count for it at bucket
+ * resolution, the floor of its bucket.
+ *
+ *@param[in] access_cmd - READ/READ_CLEAR
+ *@param[in] event_id - Event ID.
+ *@param[out] histogram_p - latency histogram since the last
+ *       READ_CLEAR
+ *@param[in,out] event_latency_vs_ext - vendor specific
+ *       extention
+ *@return OES_STATUS_SUCCESS if operation completes successfully
+ *@return OES_STATUS_PARAM_ERROR if any input parameters is
+ *         invalid
+ *@return OES_STATUS_CMD_UNSUPPORTED if access command isn't supported.
+ */
+oes_status_e
+oes_api_event_latency_get(const enum oes_access_cmd access_cmd,
+                          const enum oes_event event_id,
+                          struct oes_event_latency_histogram *histogram_p,
+                          void *event_latency_vs_ext)
+{
+    struct oes_event_latency_histogram *base_p;
+    struct oes_event_latency_histogram total;
+    unsigned int i;
+
+    if ((histogram_p == NULL) || (event_id > OES_EVENT_ID_MAX)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    if ((access_cmd != OES_ACCESS_CMD_READ) &&
+        (access_cmd != OES_ACCESS_CMD_READ_CLEAR)) {
+        return OES_STATUS_CMD_UNSUPPORTED;
+    }
+
+    pthread_mutex_lock(&oes_event_db.lock);
+
+    /*
+     * Channel histograms are owned by their reader, they are never
+     * zeroed here. READ_CLEAR moves a baseline which is subtracted
+     * from the running totals instead, and starts a new epoch for
+     * the maximum.
+     */
+    total = oes_event_db.latency_retired[event_id];
+    for (i = 0; i < oes_event_db.channel_hwm; i++) {
+        if (oes_event_db.channels[i].in_use) {
+            oes_event_latency_add(&total, &oes_event_db.channels[i].latency[event_id],
+                                  oes_event_latency_max_valid(&oes_event_db.channels[i],
+                                                              event_id));
+        }
+    }
+
+    base_p = &oes_event_db.latency_base[event_id];
+    histogram_p->count = total.count - base_p->count;
+    histogram_p->sum_ns = total.sum_ns - base_p->sum_ns;
+    for (i = 0; i < OES_EVENT_LATENCY_BUCKET_CNT; i++) {
+        histogram_p->buckets[i] = total.buckets[i] - base_p->buckets[i];
+    }
+    /*
+     * An event recorded while READ_CLEAR runs may land in the new
+     * buckets with its maximum left in the old epoch, the highest
+     * non empty bucket bounds the maximum from below.
+     */
+    histogram_p->max_ns = total.max_ns;
+    for (i = OES_EVENT_LATENCY_BUCKET_CNT; i > 0; i--) {
+        if (histogram_p->buckets[i - 1] != 0) {
+            if (oes_event_latency_bucket_floor(i - 1) > histogram_p->max_ns) {
+                histogram_p->max_ns = oes_event_latency_bucket_floor(i - 1);
+            }
+            break;
+        }
+    }
+
+    if (access_cmd == OES_ACCESS_CMD_READ_CLEAR) {
+        *base_p = total;
+        oes_event_db.latency_retired[event_id].max_ns = 0;
+        __atomic_store_n(&oes_event_db.latency_epoch[event_id],
+                         oes_event_db.latency_epoch[event_id] + 1, __ATOMIC_RELAXED);
+    }
+
+    pthread_mutex_unlock(&oes_event_db.lock);
+
     return OES_STATUS_SUCCESS;
 }
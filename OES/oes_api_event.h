@@ -86,14 +86,36 @@ oes_api_event_fd_set(
 
 
 /**
-* Register/DeRegister Events  (Port up /down , FDB event)
+* Register/DeRegister Events  (Port up /down , FDB event,
+* neighbour event)
+*
+* Neighbour events are registered with the virtual router ID as
+* br_id, and have no snapshot.
+*
+* On ADD, event_register_vs_ext may point to a struct
+* oes_event_register_params. With enable_snapshot set, the
+* channel first receives one synthetic event per current entry
+* (FDB learn events / port states), then an
+* OES_EVENT_ID_SNAPSHOT_END event, interleaved with the live
+* events so that no change is lost or reported twice. The
+* snapshot is read in chunks while receiving, writers are not
+* stalled. A channel which is lapped during the snapshot
+* restarts it.
+*
+* Snapshots are read through the iterator the module owning the
+* entries installs with oes_event_snapshot_iter_set(). None of
+* the modules in this tree keep FDB or port entries, so ADD with
+* enable_snapshot fails with OES_STATUS_PARAM_ERROR until an
+* iterator is installed; removing it later ends the pending
+* snapshots with an empty chunk.
 *
 * @param[in] access_cmd - ADD/DELETE    - 
-* @param[in] br_id - Bridge id 
+* @param[in] br_id - Bridge id, virtual router ID for neighbour
+*       events
 * @param[in] event_id - Event ID.
 * @param[in] fd - The file descriptor for the events to be send.
 * @param[in,out] event_register_vs_ext - vendor specific
-*       extention
+*       extention, struct oes_event_register_params on ADD
 * 
 * @return OES_STATUS_SUCCESS if operation completes successfully
 * @return OES_STATUS_PARAM_ERROR if any input parameters is 
@@ -130,4 +152,87 @@ oes_api_event_recv(
                   void * event_recv_vs_ext
                   );
 
+/**
+* This API enables the user to receive a batch of Events. The
+* call blocks until at least one event is available and then
+* returns as many pending events as fit in the list. Events
+* are queued in priority lanes (enum oes_event_lane) drained
+* in strict priority order, port events first; an FDB flush
+* also discards the learn/age events it overtook.
+* DESTROY of the channel wakes a blocked call, which then
+* fails with OES_STATUS_PARAM_ERROR, and waits for it to leave.
+*
+*@param[in] fd - File descriptor to listen on.
+*@param[out] event_info_list_p - event information array
+*@param[in,out] event_cnt_p - array size, number of events
+*       received
+*@param[in,out] event_rcv_vs_ext - vendor specific
+*       extention
+*@return OES_STATUS_SUCCESS if operation completes successfully 
+*@return OES_STATUS_PARAM_ERROR if any input parameters is 
+*         invalid
+*@return OES_STATUS_ERROR general error  
+*/
+
+oes_status_e
+oes_api_event_recv_batch(
+                        const int  fd,
+                        struct oes_event_info * event_info_list_p,
+                        unsigned int * event_cnt_p,
+                        void * event_recv_vs_ext
+                        );
+
+/**
+* This API retrieves the statistics of an event channel. All
+* channels share one broadcast ring per priority lane and each
+* channel reads it through its own cursor, the lane depth is
+* the distance between the channel cursor and the producer. A
+* channel lagging by more than the lane size loses the oldest
+* events of the lane.
+*
+*@param[in] fd - File descriptor of the channel.
+*@param[out] stats_p - channel statistics
+*@param[in,out] event_stats_vs_ext - vendor specific
+*       extention
+*@return OES_STATUS_SUCCESS if operation completes successfully 
+*@return OES_STATUS_PARAM_ERROR if any input parameters is 
+*         invalid
+*@return OES_STATUS_ENTRY_NOT_FOUND if fd is not an event channel
+*/
+
+oes_status_e
+oes_api_event_stats_get(
+                       const int  fd,
+                       struct oes_event_channel_stats * stats_p,
+                       void * event_stats_vs_ext
+                       );
+
+/**
+* This API reads the enqueue to dequeue latency histogram of an
+* event ID, accumulated over all the event channels. Events are
+* time stamped when produced and measured when received.
+* The maximum restarts at every READ_CLEAR; an event received
+* while READ_CLEAR runs may only count for it at bucket
+* resolution, the floor of its bucket.
+*
+*@param[in] access_cmd - READ/READ_CLEAR
+*@param[in] event_id - Event ID.
+*@param[out] histogram_p - latency histogram since the last
+*       READ_CLEAR
+*@param[in,out] event_latency_vs_ext - vendor specific
+*       extention
+*@return OES_STATUS_SUCCESS if operation completes successfully 
+*@return OES_STATUS_PARAM_ERROR if any input parameters is 
+*         invalid
+*@return OES_STATUS_CMD_UNSUPPORTED if access command isn't supported.
+*/
+
+oes_status_e
+oes_api_event_latency_get(
+                         const enum oes_access_cmd access_cmd,
+                         const enum oes_event event_id,
+                         struct oes_event_latency_histogram * histogram_p,
+                         void * event_latency_vs_ext
+                         );
+
 #endif /* __OES_API_EVENT_H__ */
@@ -0,0 +1,4356 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_api_router.h"
+#include "oes_router.h"
+#include "oes_event.h"
+
+#define OES_ROUTER_VR_MAX               1024
+#define OES_ROUTER_ROUTE_CHUNK_BITS     12
+#define OES_ROUTER_ROUTE_CHUNK_SIZE     (1 << OES_ROUTER_ROUTE_CHUNK_BITS)
+#define OES_ROUTER_ROUTE_MAX            (1 << 22)
+#define OES_ROUTER_ROUTE_HASH_MIN       64
+#define OES_ROUTER_ROUTE_CHUNK0_MIN     64
+#define OES_ROUTER_LOOKUP_BATCH_MIN     3            /* smaller batches are looked up one by one */
+#define OES_ROUTER_FIB_TREE_MAX         4096         /* routes of an IP version kept in a tree */
+#define OES_ROUTER_AGE_BATCH            256
+#define OES_ROUTER_AGE_JITTER_MAX       50
+#define OES_ROUTER_NHG_REHASH           0x9e3779b1u  /* spreads the flows of a member without neighbor */
+
+/*
+ * Route records live in fixed size chunks so that an index handed
+ * to the LPM stays valid while the table grows. The first chunk
+ * starts small and doubles up to a full one, so that a VR with a
+ * few routes only takes a few records: lookups may still read the
+ * chunk it is copied from, freed once they are done.
+ */
+struct oes_router_route {
+    struct oes_ip_prefix    key;        /**< prefix, host bits cleared */
+    unsigned long long      nhg_action; /**< group ID, set action above it: FORWARD takes that of the group */
+    unsigned int            hash_next;  /**< next route of the hash chain or free list, + 1 */
+    unsigned char           in_use;
+    unsigned char           staged;     /**< added during a bulk load, not in the LPM yet */
+};
+
+/*
+ * The tables lookups walk, created with the first route and the
+ * LPM of each IP version with its first route. DELETE_ALL
+ * unlinks it and tears it down once no lookup can be in it.
+ *
+ * Up to OES_ROUTER_FIB_TREE_MAX routes of an IP version are kept
+ * in a tree of the VR pool rather than in tables which back a
+ * page per scattered route: the IPv4 ones in tree4, as the first
+ * 4 bytes of IPv6 prefixes, the IPv6 ones in lpm6 while it is
+ * small. Past that, lpm4 is built from the routes and published
+ * with its tbl24, and lpm6 is expanded.
+ */
+struct oes_router_fib {
+    struct oes_router_lpm4  lpm4;   /**< tbl24 NULL until built */
+    struct oes_router_lpm6  tree4;  /**< IPv4 routes until lpm4 is built */
+    struct oes_router_lpm6  lpm6;
+};
+
+/*
+ * A VR allocates all its tables from its pool, and frees them
+ * with it. The route, next-hop group, neighbor and MC tables go
+ * through pools of their own under it, for their usage to be
+ * reported apart.
+ */
+struct oes_router_vr {
+    struct oes_router_attributes        attr;
+    struct oes_router_ecmp_hash_fields  ecmp_hash;
+    struct oes_router_pool              pool;
+    struct oes_router_pool              route_pool;   /**< route records, hash and order */
+    struct oes_router_pool              nhg_pool;
+    struct oes_router_pool              neigh_pool;   /**< neighbors and aging wheel */
+    struct oes_router_pool              mc_pool;
+    struct oes_router_fib             * fib;          /**< NULL until the first route */
+    struct oes_router_route           * route_chunks[OES_ROUTER_ROUTE_MAX / OES_ROUTER_ROUTE_CHUNK_SIZE];
+    unsigned int                        route_chunk0_size;
+    unsigned int                        route_cnt;
+    unsigned int                        route_ipv6_cnt;
+    unsigned int                        route_hwm;
+    unsigned int                        route_free;   /**< free route list, + 1 */
+    unsigned int                      * route_hash;   /**< chain heads, route index + 1 */
+    unsigned int                        route_hash_size;
+    struct oes_router_order             route_order;  /**< routes in key order, once paged */
+    unsigned char                       route_ordered;
+    struct oes_router_nhg_table         nhg_table;
+    struct oes_router_neigh_table       neigh_table;
+    struct oes_router_neigh_age_params  age_params;
+    struct oes_router_age_wheel         age_wheel;    /**< no slots while aging is off */
+    struct oes_router_mc_table          mc_table;
+    struct oes_router_cntr_table        cntr_table;
+    unsigned int                        rif_cnt;      /**< router interfaces */
+    unsigned char                       bulk;         /**< a bulk load is open */
+    unsigned int                      * bulk_list;    /**< staged route indexes */
+    unsigned int                        bulk_cnt;
+    unsigned int                        bulk_size;
+};
+
+struct oes_router_db {
+    pthread_rwlock_t            lock;
+    struct oes_router_vr      * vrs[OES_ROUTER_VR_MAX];
+    struct oes_router_pool      rif_pool;
+    struct oes_router_rif_table rif_table;  /**< router interfaces of all the routers */
+};
+
+static struct oes_router_db oes_router_db = {
+    .lock = PTHREAD_RWLOCK_INITIALIZER,
+    .rif_table = { .pool = &oes_router_db.rif_pool },
+};
+
+static struct oes_router_vr *
+oes_router_vr_get(const unsigned int vrid)
+{
+    /* lookups get here without the lock */
+    return (vrid < OES_ROUTER_VR_MAX) ? __atomic_load_n(&oes_router_db.vrs[vrid], __ATOMIC_ACQUIRE) : NULL;
+}
+
+/* router interface of a virtual router, NULL if there is none */
+static struct oes_router_rif *
+oes_router_vr_rif_get(const unsigned int vrid, const unsigned int rif)
+{
+    struct oes_router_rif *rif_p = oes_router_rif_get(&oes_router_db.rif_table, rif);
+
+    return ((rif_p != NULL) && (rif_p->vrid == vrid)) ? rif_p : NULL;
+}
+
+/* whether all the rifs of a list are router interfaces of a virtual router */
+static int
+oes_router_vr_rifs_valid(const unsigned int vrid, const unsigned int *rif_list_p, const unsigned int rif_cnt)
+{
+    unsigned int i;
+
+    for (i = 0; i < rif_cnt; i++) {
+        if (oes_router_vr_rif_get(vrid, rif_list_p[i]) == NULL) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static struct oes_router_route *
+oes_router_route_get(const struct oes_router_vr *vr_p, const unsigned int idx)
+{
+    return &__atomic_load_n(&vr_p->route_chunks[idx >> OES_ROUTER_ROUTE_CHUNK_BITS], __ATOMIC_ACQUIRE)
+           [idx & (OES_ROUTER_ROUTE_CHUNK_SIZE - 1)];
+}
+
+static const struct oes_ip_prefix *
+oes_router_route_key_get(const void *ctx_p, const unsigned int idx)
+{
+    return &oes_router_route_get(ctx_p, idx)->key;
+}
+
+/* records a chunk was allocated with */
+static unsigned int
+oes_router_route_chunk_size(const struct oes_router_vr *vr_p, const unsigned int chunk)
+{
+    return chunk ? OES_ROUTER_ROUTE_CHUNK_SIZE : vr_p->route_chunk0_size;
+}
+
+/* the group and the set action of a route, as one word */
+static unsigned long long
+oes_router_route_nhg_action(const enum oes_router_action action, const unsigned int nhg_id)
+{
+    return ((unsigned long long)action << 32) | nhg_id;
+}
+
+static unsigned int
+oes_router_route_nhg(const struct oes_router_route *route_p)
+{
+    return (unsigned int)route_p->nhg_action;
+}
+
+static enum oes_router_action
+oes_router_route_action(const struct oes_router_route *route_p)
+{
+    return (enum oes_router_action)(route_p->nhg_action >> 32);
+}
+
+/*
+ * Copies a prefix with its host bits cleared, so that equal
+ * prefixes compare and hash equal.
+ */
+static int
+oes_router_prefix_normalize(const struct oes_ip_prefix *prefix_p,
+                            struct oes_ip_prefix *key_p)
+{
+    unsigned int i, bits;
+
+    memset(key_p, 0, sizeof(*key_p));
+    key_p->prefix.version = prefix_p->prefix.version;
+    key_p->prefix_len = prefix_p->prefix_len;
+    switch (prefix_p->prefix.version) {
+    case OES_IPV4:
+        if (prefix_p->prefix_len > 32) {
+            return 0;
+        }
+        if (prefix_p->prefix_len) {
+            key_p->prefix.addr.ipv4.s_addr = prefix_p->prefix.addr.ipv4.s_addr &
+                                             htonl(0xffffffff << (32 - prefix_p->prefix_len));
+        }
+        return 1;
+
+    case OES_IPV6:
+        if (prefix_p->prefix_len > 128) {
+            return 0;
+        }
+        for (i = 0; i < 16; i++) {
+            bits = (prefix_p->prefix_len > i * 8) ? prefix_p->prefix_len - i * 8 : 0;
+            if (bits >= 8) {
+                key_p->prefix.addr.ipv6.s6_addr[i] = prefix_p->prefix.addr.ipv6.s6_addr[i];
+            } else if (bits) {
+                key_p->prefix.addr.ipv6.s6_addr[i] = prefix_p->prefix.addr.ipv6.s6_addr[i] &
+                                                     (0xff << (8 - bits));
+            }
+        }
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+static int
+oes_router_prefix_equal(const struct oes_ip_prefix *a_p,
+                        const struct oes_ip_prefix *b_p)
+{
+    if ((a_p->prefix.version != b_p->prefix.version) || (a_p->prefix_len != b_p->prefix_len)) {
+        return 0;
+    }
+    if (a_p->prefix.version == OES_IPV4) {
+        return a_p->prefix.addr.ipv4.s_addr == b_p->prefix.addr.ipv4.s_addr;
+    }
+    return memcmp(&a_p->prefix.addr.ipv6, &b_p->prefix.addr.ipv6, sizeof(struct in6_addr)) == 0;
+}
+
+static unsigned int
+oes_router_prefix_hash(const struct oes_ip_prefix *key_p)
+{
+    unsigned int hash = key_p->prefix_len * 0x9e3779b9 + key_p->prefix.version;
+    unsigned int words[4], i, cnt = 1;
+
+    if (key_p->prefix.version == OES_IPV4) {
+        words[0] = key_p->prefix.addr.ipv4.s_addr;
+    } else {
+        memcpy(words, &key_p->prefix.addr.ipv6, sizeof(words));
+        cnt = 4;
+    }
+    for (i = 0; i < cnt; i++) {
+        hash ^= words[i];
+        hash *= 0x85ebca6b;
+        hash ^= hash >> 13;
+        hash *= 0xc2b2ae35;
+        hash ^= hash >> 16;
+    }
+    return hash;
+}
+
+static int
+oes_router_route_find(const struct oes_router_vr *vr_p,
+                      const struct oes_ip_prefix *key_p,
+                      unsigned int *idx_p)
+{
+    struct oes_router_route *route_p;
+    unsigned int next;
+
+    if (vr_p->route_hash == NULL) {
+        return 0;
+    }
+    next = vr_p->route_hash[oes_router_prefix_hash(key_p) & (vr_p->route_hash_size - 1)];
+    while (next) {
+        route_p = oes_router_route_get(vr_p, next - 1);
+        if (oes_router_prefix_equal(&route_p->key, key_p)) {
+            *idx_p = next - 1;
+            return 1;
+        }
+        next = route_p->hash_next;
+    }
+    return 0;
+}
+
+static void
+oes_router_route_hash_link(struct oes_router_vr *vr_p, const unsigned int idx)
+{
+    struct oes_router_route *route_p = oes_router_route_get(vr_p, idx);
+    unsigned int bucket = oes_router_prefix_hash(&route_p->key) & (vr_p->route_hash_size - 1);
+
+    route_p->hash_next = vr_p->route_hash[bucket];
+    vr_p->route_hash[bucket] = idx + 1;
+}
+
+static void
+oes_router_route_hash_unlink(struct oes_router_vr *vr_p, const unsigned int idx)
+{
+    struct oes_router_route *route_p = oes_router_route_get(vr_p, idx);
+    unsigned int *next_p = &vr_p->route_hash[oes_router_prefix_hash(&route_p->key) &
+                                             (vr_p->route_hash_size - 1)];
+
+    while (*next_p != idx + 1) {
+        next_p = &oes_router_route_get(vr_p, *next_p - 1)->hash_next;
+    }
+    *next_p = route_p->hash_next;
+}
+
+/*
+ * Keeps the hash load at most one route per chain.
+ */
+static oes_status_e
+oes_router_route_hash_grow(struct oes_router_vr *vr_p)
+{
+    unsigned int size = vr_p->route_hash_size ? vr_p->route_hash_size * 2 : OES_ROUTER_ROUTE_HASH_MIN;
+    unsigned int *hash_p, idx;
+
+    if (vr_p->route_cnt < vr_p->route_hash_size) {
+        return OES_STATUS_SUCCESS;
+    }
+    hash_p = oes_router_pool_calloc(&vr_p->route_pool, size, sizeof(*hash_p));
+    if (hash_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    oes_router_pool_free(&vr_p->route_pool, vr_p->route_hash, vr_p->route_hash_size * sizeof(*hash_p));
+    vr_p->route_hash = hash_p;
+    vr_p->route_hash_size = size;
+    for (idx = 0; idx < vr_p->route_hwm; idx++) {
+        if (oes_router_route_get(vr_p, idx)->in_use) {
+            oes_router_route_hash_link(vr_p, idx);
+        }
+    }
+    return OES_STATUS_SUCCESS;
+}
+
+/*
+ * Makes room in the chunks for record idx, the next one past the
+ * high water mark.
+ */
+static oes_status_e
+oes_router_route_chunk_grow(struct oes_router_vr *vr_p, const unsigned int idx)
+{
+    unsigned int chunk = idx >> OES_ROUTER_ROUTE_CHUNK_BITS, size;
+    struct oes_router_route *chunk_p;
+
+    if (chunk) {
+        if (vr_p->route_chunks[chunk] == NULL) {
+            vr_p->route_chunks[chunk] = oes_router_pool_calloc(&vr_p->route_pool, OES_ROUTER_ROUTE_CHUNK_SIZE,
+                                                               sizeof(*chunk_p));
+        }
+        return (vr_p->route_chunks[chunk] == NULL) ? OES_STATUS_NO_MEMORY : OES_STATUS_SUCCESS;
+    }
+    if (idx < vr_p->route_chunk0_size) {
+        return OES_STATUS_SUCCESS;
+    }
+    size = vr_p->route_chunk0_size ? vr_p->route_chunk0_size * 2 : OES_ROUTER_ROUTE_CHUNK0_MIN;
+    chunk_p = oes_router_pool_calloc(&vr_p->route_pool, size, sizeof(*chunk_p));
+    if (chunk_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    if (vr_p->route_chunk0_size) {
+        memcpy(chunk_p, vr_p->route_chunks[0], vr_p->route_chunk0_size * sizeof(*chunk_p));
+    }
+    oes_router_pool_retire(&vr_p->route_pool,
+                           __atomic_exchange_n(&vr_p->route_chunks[0], chunk_p, __ATOMIC_ACQ_REL),
+                           vr_p->route_chunk0_size * sizeof(*chunk_p));
+    vr_p->route_chunk0_size = size;
+    return OES_STATUS_SUCCESS;
+}
+
+static oes_status_e
+oes_router_route_alloc(struct oes_router_vr *vr_p,
+                       const struct oes_ip_prefix *key_p,
+                       unsigned int *idx_p)
+{
+    struct oes_router_route *route_p;
+    oes_status_e status;
+    unsigned int idx;
+
+    status = oes_router_route_hash_grow(vr_p);
+    if (status != OES_STATUS_SUCCESS) {
+        return status;
+    }
+    if (vr_p->route_free) {
+        idx = vr_p->route_free - 1;
+        vr_p->route_free = oes_router_route_get(vr_p, idx)->hash_next;
+    } else {
+        if (vr_p->route_hwm == OES_ROUTER_ROUTE_MAX) {
+            return OES_STATUS_NO_RESOURCES;
+        }
+        idx = vr_p->route_hwm;
+        status = oes_router_route_chunk_grow(vr_p, idx);
+        if (status != OES_STATUS_SUCCESS) {
+            return status;
+        }
+        vr_p->route_hwm++;
+    }
+    route_p = oes_router_route_get(vr_p, idx);
+    memset(route_p, 0, sizeof(*route_p));
+    route_p->key = *key_p;
+    route_p->nhg_action = oes_router_route_nhg_action(OES_ROUTER_ACTION_DROP, OES_ROUTER_NEXT_HOP_GROUP_INVALID);
+    if (vr_p->route_ordered) {
+        status = oes_router_order_insert(&vr_p->route_order, idx);
+        if (status != OES_STATUS_SUCCESS) {
+            route_p->hash_next = vr_p->route_free;
+            vr_p->route_free = idx + 1;
+            return status;
+        }
+    }
+    route_p->in_use = 1;
+    oes_router_route_hash_link(vr_p, idx);
+    vr_p->route_cnt++;
+    vr_p->route_ipv6_cnt += (key_p->prefix.version == OES_IPV6);
+    *idx_p = idx;
+    return OES_STATUS_SUCCESS;
+}
+
+static void
+oes_router_route_release(void *ctx_p, const unsigned int idx)
+{
+    struct oes_router_vr *vr_p = ctx_p;
+
+    oes_router_route_get(vr_p, idx)->hash_next = vr_p->route_free;
+    vr_p->route_free = idx + 1;
+}
+
+/*
+ * Lookups which found the index in the LPM may still read the
+ * record, it is reused once they are done.
+ */
+static void
+oes_router_route_free(struct oes_router_vr *vr_p, const unsigned int idx)
+{
+    struct oes_router_route *route_p = oes_router_route_get(vr_p, idx);
+
+    oes_router_route_hash_unlink(vr_p, idx);
+    if (vr_p->route_ordered) {
+        oes_router_order_remove(&vr_p->route_order, idx);
+    }
+    route_p->in_use = 0;
+    vr_p->route_cnt--;
+    vr_p->route_ipv6_cnt -= (route_p->key.prefix.version == OES_IPV6);
+    oes_router_rcu_defer(oes_router_route_release, vr_p, idx);
+}
+
+/*
+ * Finds the closest shorter route covering a prefix, the one
+ * addresses fall back to when the prefix is deleted.
+ */
+static int
+oes_router_route_parent_find(const struct oes_router_vr *vr_p,
+                             const struct oes_ip_prefix *key_p,
+                             unsigned int *idx_p)
+{
+    struct oes_ip_prefix shorter, parent;
+    int len;
+
+    shorter = *key_p;
+    for (len = (int)key_p->prefix_len - 1; len >= 0; len--) {
+        shorter.prefix_len = len;
+        oes_router_prefix_normalize(&shorter, &parent);
+        /* staged routes are not in the LPM to fall back to */
+        if (oes_router_route_find(vr_p, &parent, idx_p) && !oes_router_route_get(vr_p, *idx_p)->staged) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Drops the dependents of the first cnt members of a group, with
+ * the neighbor entries left unresolved and without dependents.
+ */
+static void
+oes_router_nhg_deps_drop(struct oes_router_vr *vr_p, struct oes_router_nhg *nhg_p, const unsigned int cnt)
+{
+    struct oes_router_neigh *neigh_p;
+    unsigned int i;
+
+    for (i = 0; i < cnt; i++) {
+        neigh_p = &vr_p->neigh_table.neighs[nhg_p->deps[i].neigh_idx];
+        oes_router_neigh_dep_delete(&vr_p->neigh_table, neigh_p, nhg_p->deps[i].pos);
+        if (!neigh_p->resolved && (neigh_p->dep_cnt == 0)) {
+            oes_router_neigh_delete(&vr_p->neigh_table, neigh_p);
+        }
+    }
+    oes_router_pool_free(&vr_p->nhg_pool, nhg_p->deps, nhg_p->next_hop_cnt * sizeof(*nhg_p->deps));
+    nhg_p->deps = NULL;
+    nhg_p->resolved_cnt = 0;
+}
+
+static void
+oes_router_nhg_unlink(struct oes_router_vr *vr_p, const unsigned int nhg_id)
+{
+    struct oes_router_nhg *nhg_p = oes_router_nhg_find(&vr_p->nhg_table, nhg_id);
+
+    if ((nhg_p != NULL) && (nhg_p->deps != NULL)) {
+        oes_router_nhg_deps_drop(vr_p, nhg_p, nhg_p->next_hop_cnt);
+    }
+}
+
+/*
+ * Records each member of a group with the neighbor entry of its
+ * address, an unresolved one if the address has no neighbor, and
+ * counts the members resolved.
+ */
+static oes_status_e
+oes_router_nhg_link(struct oes_router_vr *vr_p, const unsigned int nhg_id)
+{
+    struct oes_router_nhg *nhg_p = oes_router_nhg_find(&vr_p->nhg_table, nhg_id);
+    struct oes_router_neigh *neigh_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned int i;
+
+    if (nhg_p == NULL) {
+        return OES_STATUS_SUCCESS;
+    }
+    nhg_p->deps = oes_router_pool_alloc(&vr_p->nhg_pool, nhg_p->next_hop_cnt * sizeof(*nhg_p->deps));
+    if (nhg_p->deps == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    nhg_p->resolved_cnt = 0;
+    for (i = 0; i < nhg_p->next_hop_cnt; i++) {
+        neigh_p = oes_router_neigh_find(&vr_p->neigh_table, &nhg_p->next_hop_list[i]);
+        if (neigh_p == NULL) {
+            status = oes_router_neigh_add(&vr_p->neigh_table, &nhg_p->next_hop_list[i], &neigh_p);
+        }
+        if (status == OES_STATUS_SUCCESS) {
+            nhg_p->deps[i].neigh_idx = neigh_p - vr_p->neigh_table.neighs;
+            status = oes_router_neigh_dep_add(&vr_p->neigh_table, neigh_p, nhg_id, &nhg_p->deps[i].pos);
+        }
+        if (status != OES_STATUS_SUCCESS) {
+            if ((neigh_p != NULL) && !neigh_p->resolved && (neigh_p->dep_cnt == 0)) {
+                oes_router_neigh_delete(&vr_p->neigh_table, neigh_p);
+            }
+            oes_router_nhg_deps_drop(vr_p, nhg_p, i);
+            oes_router_nhg_fwd_update(&vr_p->nhg_table, nhg_id);
+            return status;
+        }
+        nhg_p->resolved_cnt += neigh_p->resolved;
+    }
+    oes_router_nhg_fwd_update(&vr_p->nhg_table, nhg_id);
+    return OES_STATUS_SUCCESS;
+}
+
+/*
+ * Takes a group reference, the group is linked to its neighbors
+ * with the first one.
+ */
+static oes_status_e
+oes_router_vr_nhg_get(struct oes_router_vr *vr_p,
+                      const struct oes_uc_route_data *data_p,
+                      unsigned int *nhg_id_p)
+{
+    struct oes_router_nhg *nhg_p;
+    oes_status_e status;
+
+    status = oes_router_nhg_get(&vr_p->nhg_table, data_p->next_hop_list, data_p->next_hop_cnt,
+                                data_p->ecmp_bucket_cnt, data_p->ecmp_idle_timer, nhg_id_p);
+    if (status != OES_STATUS_SUCCESS) {
+        return status;
+    }
+    nhg_p = oes_router_nhg_find(&vr_p->nhg_table, *nhg_id_p);
+    if ((nhg_p != NULL) && (nhg_p->ref_cnt == 1)) {
+        status = oes_router_nhg_link(vr_p, *nhg_id_p);
+        if (status != OES_STATUS_SUCCESS) {
+            oes_router_nhg_put(&vr_p->nhg_table, *nhg_id_p);
+        }
+    }
+    return status;
+}
+
+static void
+oes_router_vr_nhg_put(struct oes_router_vr *vr_p, const unsigned int nhg_id)
+{
+    struct oes_router_nhg *nhg_p = oes_router_nhg_find(&vr_p->nhg_table, nhg_id);
+
+    if ((nhg_p != NULL) && (nhg_p->ref_cnt == 1)) {
+        oes_router_nhg_unlink(vr_p, nhg_id);
+    }
+    oes_router_nhg_put(&vr_p->nhg_table, nhg_id);
+}
+
+/*
+ * A member without a neighbor hands its flows over to the members
+ * with one, rehashed among them, until the group is changed: no
+ * route has to be set again for them to move.
+ */
+static unsigned int
+oes_router_nhg_member_resolved(const struct oes_router_vr *vr_p,
+                               const struct oes_router_nhg *nhg_p,
+                               const unsigned int member,
+                               const unsigned int hash)
+{
+    const struct oes_router_neigh *neighs_p = vr_p->neigh_table.neighs;
+    unsigned int i, nth;
+
+    if ((nhg_p->deps == NULL) || (nhg_p->resolved_cnt == 0) || neighs_p[nhg_p->deps[member].neigh_idx].resolved) {
+        return member;
+    }
+    nth = oes_router_ecmp_member(hash * OES_ROUTER_NHG_REHASH, nhg_p->resolved_cnt);
+    for (i = 0; i < nhg_p->next_hop_cnt; i++) {
+        if (neighs_p[nhg_p->deps[i].neigh_idx].resolved && (nth-- == 0)) {
+            return i;
+        }
+    }
+    return member;
+}
+
+/*
+ * Sets the action and group of a route, one word stored at once
+ * and released: a lookup which loads it finds both as they were
+ * set together, and the group set up.
+ */
+static void
+oes_router_route_nhg_attach(struct oes_router_vr *vr_p,
+                            const unsigned int idx,
+                            const enum oes_router_action action,
+                            const unsigned int nhg_id)
+{
+    struct oes_router_route *route_p = oes_router_route_get(vr_p, idx);
+
+    __atomic_store_n(&route_p->nhg_action, oes_router_route_nhg_action(action, nhg_id), __ATOMIC_RELEASE);
+}
+
+/* drops the group reference of a route */
+static void
+oes_router_route_nhg_put(struct oes_router_vr *vr_p, const unsigned int idx)
+{
+    oes_router_vr_nhg_put(vr_p, oes_router_route_nhg(oes_router_route_get(vr_p, idx)));
+}
+
+/*
+ * Marks a neighbor resolved or not. The groups which get their
+ * first resolved member or lose their last change action, their
+ * routes are not touched.
+ */
+static void
+oes_router_neigh_resolve(struct oes_router_vr *vr_p, struct oes_router_neigh *neigh_p, const int resolved)
+{
+    struct oes_router_nhg *nhg_p;
+    unsigned int i;
+
+    if (neigh_p->resolved == resolved) {
+        return;
+    }
+    oes_router_neigh_resolved_set(&vr_p->neigh_table, neigh_p, resolved);
+    for (i = 0; i < neigh_p->dep_cnt; i++) {
+        nhg_p = oes_router_nhg_find(&vr_p->nhg_table, neigh_p->dep_list[i].nhg_id);
+        if (resolved ? (nhg_p->resolved_cnt++ == 0) : (--nhg_p->resolved_cnt == 0)) {
+            oes_router_nhg_fwd_update(&vr_p->nhg_table, neigh_p->dep_list[i].nhg_id);
+        }
+    }
+}
+
+/*
+ * Frees all the routes, once the lookups and deferred releases
+ * are over.
+ */
+static void
+oes_router_vr_routes_flush(struct oes_router_vr *vr_p)
+{
+    unsigned int i;
+
+    for (i = 0; i < vr_p->nhg_table.nhg_size; i++) {
+        oes_router_nhg_unlink(vr_p, i);
+    }
+    oes_router_nhg_table_deinit(&vr_p->nhg_table);
+    oes_router_nhg_table_init(&vr_p->nhg_table, &vr_p->nhg_pool);
+    oes_router_pool_free(&vr_p->pool, vr_p->bulk_list, vr_p->bulk_size * sizeof(*vr_p->bulk_list));
+    vr_p->bulk_list = NULL;
+    vr_p->bulk_cnt = 0;
+    vr_p->bulk_size = 0;
+    for (i = 0; i < OES_ROUTER_ROUTE_MAX / OES_ROUTER_ROUTE_CHUNK_SIZE; i++) {
+        oes_router_pool_free(&vr_p->route_pool, vr_p->route_chunks[i],
+                             oes_router_route_chunk_size(vr_p, i) * sizeof(struct oes_router_route));
+        vr_p->route_chunks[i] = NULL;
+    }
+    vr_p->route_chunk0_size = 0;
+    oes_router_pool_free(&vr_p->route_pool, vr_p->route_hash, vr_p->route_hash_size * sizeof(*vr_p->route_hash));
+    vr_p->route_hash = NULL;
+    vr_p->route_hash_size = 0;
+    oes_router_order_deinit(&vr_p->route_order);
+    vr_p->route_ordered = 0;
+    vr_p->route_cnt = 0;
+    vr_p->route_ipv6_cnt = 0;
+    vr_p->route_hwm = 0;
+    vr_p->route_free = 0;
+}
+
+/* no lookup can be in the FIB anymore */
+static void
+oes_router_fib_destroy(struct oes_router_vr *vr_p, struct oes_router_fib *fib_p)
+{
+    if (fib_p == NULL) {
+        return;
+    }
+    oes_router_lpm4_deinit(&fib_p->lpm4);
+    oes_router_lpm6_deinit(&fib_p->tree4);
+    oes_router_lpm6_deinit(&fib_p->lpm6);
+    oes_router_pool_free(&vr_p->pool, fib_p, sizeof(*fib_p));
+}
+
+/* an IPv4 address, host order, as the IPv6 one tree4 holds */
+static void
+oes_router_tree4_addr(struct in6_addr *addr6_p, const unsigned int addr)
+{
+    memset(addr6_p, 0, sizeof(*addr6_p));
+    addr6_p->s6_addr[0] = addr >> 24;
+    addr6_p->s6_addr[1] = addr >> 16;
+    addr6_p->s6_addr[2] = addr >> 8;
+    addr6_p->s6_addr[3] = addr;
+}
+
+/*
+ * Builds lpm4 from the IPv4 routes in tree4 and publishes it with
+ * its tbl24: lookups move over, and the tree is torn down once
+ * none can be in it. Staged routes are left to the bulk commit.
+ */
+static oes_status_e
+oes_router_fib_lpm4_build(struct oes_router_vr *vr_p, struct oes_router_fib *fib_p)
+{
+    struct oes_router_route *route_p;
+    struct oes_router_lpm4 lpm4;
+    unsigned int *tbl24_p, idx;
+    oes_status_e status;
+
+    memset(&lpm4, 0, sizeof(lpm4));
+    status = oes_router_lpm4_init(&lpm4);
+    for (idx = 0; (status == OES_STATUS_SUCCESS) && (idx < vr_p->route_hwm); idx++) {
+        route_p = oes_router_route_get(vr_p, idx);
+        if (route_p->in_use && !route_p->staged && (route_p->key.prefix.version == OES_IPV4)) {
+            status = oes_router_lpm4_add(&lpm4, ntohl(route_p->key.prefix.addr.ipv4.s_addr),
+                                         route_p->key.prefix_len, idx);
+        }
+    }
+    if (status != OES_STATUS_SUCCESS) {
+        oes_router_lpm4_deinit(&lpm4);
+        return status;
+    }
+    tbl24_p = lpm4.tbl24;
+    lpm4.tbl24 = NULL;
+    fib_p->lpm4 = lpm4;
+    __atomic_store_n(&fib_p->lpm4.tbl24, tbl24_p, __ATOMIC_RELEASE);
+    oes_router_rcu_synchronize();
+    oes_router_lpm6_deinit(&fib_p->tree4);
+    return OES_STATUS_SUCCESS;
+}
+
+/*
+ * Creates the FIB and the LPM of an IP version on their first
+ * route, and moves the routes of a version out of its tree once
+ * they are too many. Lookups meanwhile see no FIB, or an LPM
+ * without routes, and miss.
+ */
+static oes_status_e
+oes_router_fib_prepare(struct oes_router_vr *vr_p, const enum oes_ip_version version)
+{
+    struct oes_router_fib *fib_p = vr_p->fib;
+
+    if (fib_p == NULL) {
+        fib_p = oes_router_pool_calloc(&vr_p->pool, 1, sizeof(*fib_p));
+        if (fib_p == NULL) {
+            return OES_STATUS_NO_MEMORY;
+        }
+        __atomic_store_n(&vr_p->fib, fib_p, __ATOMIC_RELEASE);
+    }
+    if (version == OES_IPV4) {
+        if (fib_p->lpm4.tbl24 != NULL) {
+            return OES_STATUS_SUCCESS;
+        }
+        if (vr_p->route_cnt - vr_p->route_ipv6_cnt > OES_ROUTER_FIB_TREE_MAX) {
+            return oes_router_fib_lpm4_build(vr_p, fib_p);
+        }
+        return (fib_p->tree4.pool != NULL) ? OES_STATUS_SUCCESS : oes_router_lpm6_init(&fib_p->tree4, &vr_p->pool);
+    }
+    if (fib_p->lpm6.pool == NULL) {
+        oes_router_lpm6_init(&fib_p->lpm6, &vr_p->pool);
+    }
+    if ((fib_p->lpm6.direct == NULL) && (vr_p->route_ipv6_cnt > OES_ROUTER_FIB_TREE_MAX)) {
+        return oes_router_lpm6_expand(&fib_p->lpm6);
+    }
+    return OES_STATUS_SUCCESS;
+}
+
+/* the VR is already unlinked from the database */
+static void
+oes_router_vr_destroy(struct oes_router_vr *vr_p)
+{
+    oes_router_rcu_barrier();
+    oes_router_vr_routes_flush(vr_p);
+    oes_router_fib_destroy(vr_p, vr_p->fib);
+    oes_router_age_wheel_deinit(&vr_p->age_wheel, &vr_p->neigh_table);
+    oes_router_neigh_table_deinit(&vr_p->neigh_table);
+    oes_router_mc_table_deinit(&vr_p->mc_table);
+    oes_router_cntr_table_deinit(&vr_p->cntr_table);
+    free(vr_p);
+}
+
+static oes_status_e
+oes_router_lpm_add(struct oes_router_vr *vr_p,
+                   const struct oes_ip_prefix *key_p,
+                   const unsigned int idx)
+{
+    struct in6_addr addr6;
+    oes_status_e status;
+
+    status = oes_router_fib_prepare(vr_p, key_p->prefix.version);
+    if (status != OES_STATUS_SUCCESS) {
+        return status;
+    }
+    if ((key_p->prefix.version == OES_IPV4) && (vr_p->fib->lpm4.tbl24 == NULL)) {
+        oes_router_tree4_addr(&addr6, ntohl(key_p->prefix.addr.ipv4.s_addr));
+        return oes_router_lpm6_add(&vr_p->fib->tree4, &addr6, key_p->prefix_len, idx);
+    }
+    if (key_p->prefix.version == OES_IPV4) {
+        return oes_router_lpm4_add(&vr_p->fib->lpm4, ntohl(key_p->prefix.addr.ipv4.s_addr),
+                                   key_p->prefix_len, idx);
+    }
+    return oes_router_lpm6_add(&vr_p->fib->lpm6, &key_p->prefix.addr.ipv6, key_p->prefix_len, idx);
+}
+
+/*
+ * Longest prefix match in a FIB which may not be there yet, or
+ * not have the LPM of the address version yet.
+ */
+static int
+oes_router_fib_lookup(const struct oes_router_fib *fib_p,
+                      const struct oes_ip_addr *addr_p,
+                      unsigned int *depth_p,
+                      unsigned int *idx_p)
+{
+    struct in6_addr addr6;
+
+    if (fib_p == NULL) {
+        return 0;
+    }
+    if (addr_p->version == OES_IPV4) {
+        if (__atomic_load_n(&fib_p->lpm4.tbl24, __ATOMIC_ACQUIRE) != NULL) {
+            return oes_router_lpm4_lookup(&fib_p->lpm4, ntohl(addr_p->addr.ipv4.s_addr), depth_p, idx_p);
+        }
+        oes_router_tree4_addr(&addr6, ntohl(addr_p->addr.ipv4.s_addr));
+        return oes_router_lpm6_lookup(&fib_p->tree4, &addr6, depth_p, idx_p);
+    }
+    return oes_router_lpm6_lookup(&fib_p->lpm6, &addr_p->addr.ipv6, depth_p, idx_p);
+}
+
+static void
+oes_router_lookup_clear(struct oes_uc_route_lookup *lookup_p)
+{
+    lookup_p->valid = 0;
+    lookup_p->action = OES_ROUTER_ACTION_DROP;
+    lookup_p->prefix_len = 0;
+    lookup_p->next_hop_group = OES_ROUTER_NEXT_HOP_GROUP_INVALID;
+}
+
+static void
+oes_router_lookup_set(const struct oes_router_vr *vr_p,
+                      struct oes_uc_route_lookup *lookup_p,
+                      const unsigned int depth,
+                      const unsigned int idx)
+{
+    const struct oes_router_route *route_p = oes_router_route_get(vr_p, idx);
+    unsigned long long nhg_action;
+    unsigned int nhg_id;
+
+    /* a route replaced under the lookup gives either data, never a mix of both */
+    lookup_p->valid = 1;
+    nhg_action = __atomic_load_n(&route_p->nhg_action, __ATOMIC_ACQUIRE);
+    nhg_id = (unsigned int)nhg_action;
+    lookup_p->action = (enum oes_router_action)(nhg_action >> 32);
+    if ((lookup_p->action == OES_ROUTER_ACTION_FORWARD) && (nhg_id != OES_ROUTER_NEXT_HOP_GROUP_INVALID)) {
+        lookup_p->action = oes_router_nhg_action(&vr_p->nhg_table, nhg_id);
+    }
+    lookup_p->prefix_len = depth;
+    lookup_p->next_hop_group = nhg_id;
+}
+
+/*
+ * Lookups run in an RCU read section, or under the read lock on
+ * the threads which got no reader slot.
+ */
+static int
+oes_router_lookup_begin(void)
+{
+    if (oes_router_rcu_read_lock()) {
+        return 1;
+    }
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    return 0;
+}
+
+static void
+oes_router_lookup_end(const int rcu)
+{
+    if (rcu) {
+        oes_router_rcu_read_unlock();
+    } else {
+        pthread_rwlock_unlock(&oes_router_db.lock);
+    }
+}
+
+/* the MAC is copied into the caller's mac_addr, if any */
+static void
+oes_router_neigh_data_get(struct oes_router_vr *vr_p,
+                          const struct oes_router_neigh *neigh_p,
+                          struct oes_neigh_data *data_p,
+                          const int clear)
+{
+    data_p->rif = neigh_p->rif;
+    if (data_p->mac_addr != NULL) {
+        *data_p->mac_addr = neigh_p->mac;
+    }
+    data_p->action = neigh_p->action;
+    data_p->activity = oes_router_neigh_activity_get(&vr_p->neigh_table, neigh_p, clear);
+}
+
+/*
+ * Deletes a neighbor, its entry stays unresolved while next hops
+ * depend on it.
+ */
+static void
+oes_router_neigh_remove(struct oes_router_vr *vr_p, struct oes_router_neigh *neigh_p)
+{
+    oes_router_age_cancel(&vr_p->age_wheel, &vr_p->neigh_table, neigh_p);
+    oes_router_neigh_resolve(vr_p, neigh_p, 0);
+    if (neigh_p->dep_cnt == 0) {
+        oes_router_neigh_delete(&vr_p->neigh_table, neigh_p);
+    }
+}
+
+/*
+ * Deletes the neighbors of a router interface, all of them for
+ * OES_ROUTER_INTERFACE_INVALID. An emptied table goes back to
+ * the pool.
+ */
+static void
+oes_router_neighs_delete(struct oes_router_vr *vr_p, const unsigned int rif)
+{
+    struct oes_router_neigh_table *table_p = &vr_p->neigh_table;
+    unsigned int idx;
+
+    for (idx = 0; idx < table_p->neigh_size; idx++) {
+        if (table_p->neighs[idx].resolved &&
+            ((rif == OES_ROUTER_INTERFACE_INVALID) || (table_p->neighs[idx].rif == rif))) {
+            oes_router_neigh_remove(vr_p, &table_p->neighs[idx]);
+        }
+    }
+    if (table_p->neigh_cnt == 0) {
+        oes_router_neigh_table_deinit(table_p);
+        oes_router_neigh_table_init(table_p, &vr_p->neigh_pool);
+    }
+}
+
+/* a neighbor without traffic for the age time gets refreshed */
+static void
+oes_router_neigh_age_start(struct oes_router_vr *vr_p,
+                           struct oes_router_neigh *neigh_p,
+                           const unsigned long long now)
+{
+    if (vr_p->age_wheel.slots == NULL) {
+        return;
+    }
+    neigh_p->refresh_cnt = 0;
+    oes_router_age_schedule(&vr_p->age_wheel, &vr_p->neigh_table, neigh_p,
+                            now + oes_router_age_delay(&vr_p->age_wheel, vr_p->age_params.age_time,
+                                                       vr_p->age_params.jitter));
+}
+
+/*
+ * Ages a neighbor which is due: one with traffic starts over,
+ * an idle one is refreshed, or deleted once refreshed enough.
+ * Returns 1 if it was deleted.
+ */
+static int
+oes_router_neigh_age(struct oes_router_vr *vr_p,
+                     const unsigned int vrid,
+                     struct oes_router_neigh *neigh_p,
+                     const unsigned long long now)
+{
+    struct oes_event_info event_info;
+    struct oes_event_neigh *event_p = &event_info.event_info.neigh_event;
+
+    if (oes_router_neigh_activity_age(&vr_p->neigh_table, neigh_p)) {
+        oes_router_neigh_age_start(vr_p, neigh_p, now);
+        return 0;
+    }
+
+    memset(&event_info, 0, sizeof(event_info));
+    event_info.event_id = OES_EVENT_ID_NEIGH;
+    event_p->vrid = vrid;
+    event_p->neigh_addr = neigh_p->addr;
+    event_p->rif = neigh_p->rif;
+    event_p->mac_addr = neigh_p->mac;
+    event_p->refresh_cnt = neigh_p->refresh_cnt;
+    if (neigh_p->refresh_cnt < vr_p->age_params.refresh_cnt) {
+        event_p->neigh_event_type = OES_NEIGH_EVENT_REFRESH;
+        oes_event_post(vrid, &event_info);
+        neigh_p->refresh_cnt++;
+        oes_router_age_schedule(&vr_p->age_wheel, &vr_p->neigh_table, neigh_p,
+                                now + oes_router_age_delay(&vr_p->age_wheel, vr_p->age_params.refresh_interval,
+                                                           vr_p->age_params.jitter));
+        return 0;
+    }
+    event_p->neigh_event_type = OES_NEIGH_EVENT_AGE;
+    oes_event_post(vrid, &event_info);
+    oes_router_neigh_remove(vr_p, neigh_p);
+    return 1;
+}
+
+/*
+ * The key of a multicast route from the API one: a multicast
+ * group, a unicast sender of the same version, zero for (*,G).
+ * Only (*,G) routes may take any ingress interface.
+ */
+static int
+oes_router_mc_key_get(const struct oes_mc_route_key *mc_key_p, struct oes_router_mc_key *key_p)
+{
+    const struct oes_ip_addr *group_p, *source_p;
+    static const struct in6_addr any6;
+
+    if ((mc_key_p == NULL) || (mc_key_p->mc_gruop_ip == NULL) || (mc_key_p->sender_ip == NULL)) {
+        return 0;
+    }
+    group_p = mc_key_p->mc_gruop_ip;
+    source_p = mc_key_p->sender_ip;
+    memset(key_p, 0, sizeof(*key_p));
+    key_p->group.version = group_p->version;
+    key_p->source.version = source_p->version;
+    key_p->ingress_rif = mc_key_p->ingress_rif;
+    if ((group_p->version == OES_IPV4) && (source_p->version == OES_IPV4)) {
+        key_p->group.addr.ipv4 = group_p->addr.ipv4;
+        key_p->source.addr.ipv4 = source_p->addr.ipv4;
+        return IN_MULTICAST(ntohl(group_p->addr.ipv4.s_addr)) &&
+               !IN_MULTICAST(ntohl(source_p->addr.ipv4.s_addr)) &&
+               ((mc_key_p->ingress_rif != OES_ROUTER_INTERFACE_INVALID) || (source_p->addr.ipv4.s_addr == 0));
+    }
+    if ((group_p->version == OES_IPV6) && (source_p->version == OES_IPV6)) {
+        key_p->group.addr.ipv6 = group_p->addr.ipv6;
+        key_p->source.addr.ipv6 = source_p->addr.ipv6;
+        return IN6_IS_ADDR_MULTICAST(&group_p->addr.ipv6) &&
+               !IN6_IS_ADDR_MULTICAST(&source_p->addr.ipv6) &&
+               ((mc_key_p->ingress_rif != OES_ROUTER_INTERFACE_INVALID) ||
+                (memcmp(&source_p->addr.ipv6, &any6, sizeof(any6)) == 0));
+    }
+    return 0;
+}
+
+static int
+oes_router_mc_any_source(const struct oes_router_mc_key *key_p)
+{
+    static const struct in6_addr any6;
+
+    if (key_p->source.version == OES_IPV4) {
+        return key_p->source.addr.ipv4.s_addr == 0;
+    }
+    return memcmp(&key_p->source.addr.ipv6, &any6, sizeof(any6)) == 0;
+}
+
+static void
+oes_router_mc_lookup_set(const struct oes_router_mc_route *route_p, struct oes_mc_route_lookup *lookup_p)
+{
+    memset(lookup_p, 0, sizeof(*lookup_p));
+    if (route_p == NULL) {
+        return;
+    }
+    lookup_p->valid = 1;
+    lookup_p->any_source = oes_router_mc_any_source(&route_p->key);
+    lookup_p->ingress_rif = route_p->key.ingress_rif;
+    lookup_p->action = route_p->action;
+    lookup_p->rif_cnt = oes_router_mc_rif_cnt(route_p);
+}
+
+/* the egress rifs are copied into the caller's rif_list, if any */
+static void
+oes_router_mc_data_get(const struct oes_router_mc_route *route_p, struct oes_mc_route_data *data_p)
+{
+    unsigned int rif_cnt = oes_router_mc_rif_cnt(route_p);
+
+    data_p->action = route_p->action;
+    if ((data_p->rif_list != NULL) && rif_cnt) {
+        memcpy(data_p->rif_list, route_p->rifs->rif_list,
+               ((data_p->rif_cnt < rif_cnt) ? data_p->rif_cnt : rif_cnt) * sizeof(*data_p->rif_list));
+    }
+    data_p->rif_cnt = rif_cnt;
+}
+
+static oes_status_e
+oes_router_route_stage(struct oes_router_vr *vr_p, const unsigned int idx)
+{
+    unsigned int size, *list_p;
+
+    if (vr_p->bulk_cnt == vr_p->bulk_size) {
+        size = vr_p->bulk_size ? vr_p->bulk_size * 2 : OES_ROUTER_ROUTE_CHUNK_SIZE;
+        list_p = oes_router_pool_realloc(&vr_p->pool, vr_p->bulk_list, vr_p->bulk_size * sizeof(*list_p),
+                                         size * sizeof(*list_p));
+        if (list_p == NULL) {
+            return OES_STATUS_NO_MEMORY;
+        }
+        vr_p->bulk_list = list_p;
+        vr_p->bulk_size = size;
+    }
+    vr_p->bulk_list[vr_p->bulk_cnt++] = idx;
+    oes_router_route_get(vr_p, idx)->staged = 1;
+    return OES_STATUS_SUCCESS;
+}
+
+static void
+oes_router_route_remove(struct oes_router_vr *vr_p, const unsigned int idx)
+{
+    oes_router_route_nhg_put(vr_p, idx);
+    oes_router_route_free(vr_p, idx);
+}
+
+static void
+oes_router_bulk_close(struct oes_router_vr *vr_p)
+{
+    oes_router_pool_free(&vr_p->pool, vr_p->bulk_list, vr_p->bulk_size * sizeof(*vr_p->bulk_list));
+    vr_p->bulk_list = NULL;
+    vr_p->bulk_cnt = 0;
+    vr_p->bulk_size = 0;
+    vr_p->bulk = 0;
+}
+
+/*
+ * Drops the routes staged by an aborted bulk load.
+ */
+static void
+oes_router_bulk_abort(struct oes_router_vr *vr_p)
+{
+    struct oes_router_route *route_p;
+    unsigned int i;
+
+    for (i = 0; i < vr_p->bulk_cnt; i++) {
+        route_p = oes_router_route_get(vr_p, vr_p->bulk_list[i]);
+        if (route_p->in_use && route_p->staged) {
+            route_p->staged = 0;
+            oes_router_route_remove(vr_p, vr_p->bulk_list[i]);
+        }
+    }
+    oes_router_bulk_close(vr_p);
+}
+
+/* adds IPv4 prefixes to tree4 one by one, failed is set on the ones left out */
+static oes_status_e
+oes_router_tree4_add_bulk(struct oes_router_fib *fib_p,
+                          struct oes_router_lpm4_rule *rule_list_p,
+                          const unsigned int cnt)
+{
+    oes_status_e status = OES_STATUS_SUCCESS;
+    struct in6_addr addr6;
+    unsigned int i;
+
+    for (i = 0; i < cnt; i++) {
+        oes_router_tree4_addr(&addr6, rule_list_p[i].addr);
+        rule_list_p[i].failed = (oes_router_lpm6_add(&fib_p->tree4, &addr6, rule_list_p[i].depth,
+                                                     rule_list_p[i].value) != OES_STATUS_SUCCESS);
+        if (rule_list_p[i].failed) {
+            status = OES_STATUS_NO_MEMORY;
+        }
+    }
+    return status;
+}
+
+/*
+ * Builds the staged routes into the LPMs. A route deleted while
+ * staged is no longer flagged, one deleted and added again is
+ * listed twice but flagged once. Routes the LPMs could not take
+ * are removed.
+ */
+static oes_status_e
+oes_router_bulk_commit(struct oes_router_vr *vr_p)
+{
+    struct oes_router_lpm4_rule *rule4_list_p;
+    struct oes_router_lpm6_rule *rule6_list_p;
+    unsigned int cnt4 = 0, cnt6 = 0, i, thread_cnt = oes_router_bulk_thread_cnt();
+    struct oes_router_route *route_p;
+    oes_status_e status4, status6;
+
+    for (i = 0; i < vr_p->bulk_cnt; i++) {
+        route_p = oes_router_route_get(vr_p, vr_p->bulk_list[i]);
+        if (route_p->key.prefix.version == OES_IPV4) {
+            cnt4++;
+        } else {
+            cnt6++;
+        }
+    }
+    /* while the routes are still staged, which a build of lpm4 leaves out */
+    status4 = cnt4 ? oes_router_fib_prepare(vr_p, OES_IPV4) : OES_STATUS_SUCCESS;
+    status6 = cnt6 ? oes_router_fib_prepare(vr_p, OES_IPV6) : OES_STATUS_SUCCESS;
+    rule4_list_p = malloc((cnt4 ? cnt4 : 1) * sizeof(*rule4_list_p));
+    rule6_list_p = malloc((cnt6 ? cnt6 : 1) * sizeof(*rule6_list_p));
+    if ((rule4_list_p == NULL) || (rule6_list_p == NULL)) {
+        free(rule4_list_p);
+        free(rule6_list_p);
+        return OES_STATUS_NO_MEMORY;
+    }
+
+    cnt4 = 0;
+    cnt6 = 0;
+    for (i = 0; i < vr_p->bulk_cnt; i++) {
+        route_p = oes_router_route_get(vr_p, vr_p->bulk_list[i]);
+        if (!route_p->in_use || !route_p->staged) {
+            continue;
+        }
+        route_p->staged = 0;
+        if (route_p->key.prefix.version == OES_IPV4) {
+            rule4_list_p[cnt4].addr = ntohl(route_p->key.prefix.addr.ipv4.s_addr);
+            rule4_list_p[cnt4].depth = route_p->key.prefix_len;
+            rule4_list_p[cnt4++].value = vr_p->bulk_list[i];
+        } else {
+            rule6_list_p[cnt6].addr = route_p->key.prefix.addr.ipv6;
+            rule6_list_p[cnt6].depth = route_p->key.prefix_len;
+            rule6_list_p[cnt6++].value = vr_p->bulk_list[i];
+        }
+    }
+    oes_router_bulk_close(vr_p);
+
+    /* the builds clear failed, routes of an LPM which cannot be created keep it */
+    for (i = 0; i < cnt4; i++) {
+        rule4_list_p[i].failed = 1;
+    }
+    for (i = 0; i < cnt6; i++) {
+        rule6_list_p[i].failed = 1;
+    }
+    if (cnt4 && (status4 == OES_STATUS_SUCCESS) && (vr_p->fib->lpm4.tbl24 == NULL)) {
+        status4 = oes_router_tree4_add_bulk(vr_p->fib, rule4_list_p, cnt4);
+    } else if (cnt4 && (status4 == OES_STATUS_SUCCESS)) {
+        status4 = oes_router_lpm4_add_bulk(&vr_p->fib->lpm4, rule4_list_p, cnt4, thread_cnt);
+    }
+    if (cnt6 && (status6 == OES_STATUS_SUCCESS)) {
+        status6 = oes_router_lpm6_add_bulk(&vr_p->fib->lpm6, rule6_list_p, cnt6, thread_cnt);
+    }
+    for (i = 0; i < cnt4; i++) {
+        if (rule4_list_p[i].failed) {
+            oes_router_route_remove(vr_p, rule4_list_p[i].value);
+        }
+    }
+    for (i = 0; i < cnt6; i++) {
+        if (rule6_list_p[i].failed) {
+            oes_router_route_remove(vr_p, rule6_list_p[i].value);
+        }
+    }
+    free(rule4_list_p);
+    free(rule6_list_p);
+    return (status4 != OES_STATUS_SUCCESS) ? status4 : status6;
+}
+
+static oes_status_e
+oes_router_uc_route_add(struct oes_router_vr *vr_p,
+                        const enum oes_access_cmd access_cmd,
+                        const struct oes_ip_prefix *key_p,
+                        const struct oes_uc_route_data *data_p)
+{
+    unsigned int idx, nhg_id;
+    oes_status_e status;
+    int found;
+
+    if ((data_p == NULL) || (data_p->action > OES_ROUTER_ACTION_FORWARD) ||
+        ((data_p->next_hop_cnt > 0) && (data_p->next_hop_list == NULL))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    if (data_p->ecmp_bucket_cnt &&
+        ((data_p->ecmp_bucket_cnt < OES_ROUTER_ECMP_BUCKET_MIN) ||
+         (data_p->ecmp_bucket_cnt > OES_ROUTER_ECMP_BUCKET_MAX) ||
+         (data_p->ecmp_bucket_cnt < data_p->next_hop_cnt))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    found = oes_router_route_find(vr_p, key_p, &idx);
+    if (!found && (access_cmd == OES_ACCESS_CMD_EDIT)) {
+        return OES_STATUS_ENTRY_NOT_FOUND;
+    }
+
+    status = oes_router_vr_nhg_get(vr_p, data_p, &nhg_id);
+    if (status != OES_STATUS_SUCCESS) {
+        return status;
+    }
+    if (found) {
+        /* the LPM keeps pointing at the same record */
+        oes_router_route_nhg_put(vr_p, idx);
+        oes_router_route_nhg_attach(vr_p, idx, data_p->action, nhg_id);
+        return OES_STATUS_SUCCESS;
+    }
+
+    status = oes_router_route_alloc(vr_p, key_p, &idx);
+    if (status != OES_STATUS_SUCCESS) {
+        oes_router_vr_nhg_put(vr_p, nhg_id);
+        return status;
+    }
+    oes_router_route_nhg_attach(vr_p, idx, data_p->action, nhg_id);
+    status = vr_p->bulk ? oes_router_route_stage(vr_p, idx) : oes_router_lpm_add(vr_p, key_p, idx);
+    if (status != OES_STATUS_SUCCESS) {
+        oes_router_route_remove(vr_p, idx);
+    }
+    return status;
+}
+
+static oes_status_e
+oes_router_lpm_delete(struct oes_router_vr *vr_p, const struct oes_ip_prefix *key_p)
+{
+    unsigned int parent_idx = 0, parent_len = 0;
+    struct in6_addr addr6;
+    int parent_valid = 0;
+
+    if ((key_p->prefix.version == OES_IPV4) && (vr_p->fib->lpm4.tbl24 == NULL)) {
+        oes_router_tree4_addr(&addr6, ntohl(key_p->prefix.addr.ipv4.s_addr));
+        return oes_router_lpm6_delete(&vr_p->fib->tree4, &addr6, key_p->prefix_len, 0, 0, 0);
+    }
+    /* the tree bitmap only expands prefixes up to the direct table */
+    if ((key_p->prefix.version == OES_IPV4) ||
+        ((key_p->prefix_len <= OES_ROUTER_LPM6_DIRECT_BITS) && (vr_p->fib->lpm6.direct != NULL))) {
+        parent_valid = oes_router_route_parent_find(vr_p, key_p, &parent_idx);
+        if (parent_valid) {
+            parent_len = oes_router_route_get(vr_p, parent_idx)->key.prefix_len;
+        }
+    }
+    if (key_p->prefix.version == OES_IPV4) {
+        oes_router_lpm4_delete(&vr_p->fib->lpm4, ntohl(key_p->prefix.addr.ipv4.s_addr), key_p->prefix_len,
+                               parent_valid, parent_len, parent_idx);
+        return OES_STATUS_SUCCESS;
+    }
+    return oes_router_lpm6_delete(&vr_p->fib->lpm6, &key_p->prefix.addr.ipv6, key_p->prefix_len,
+                                  parent_valid, parent_len, parent_idx);
+}
+
+static oes_status_e
+oes_router_uc_route_delete(struct oes_router_vr *vr_p,
+                           const struct oes_ip_prefix *key_p)
+{
+    struct oes_router_route *route_p;
+    oes_status_e status;
+    unsigned int idx;
+
+    if (!oes_router_route_find(vr_p, key_p, &idx)) {
+        return OES_STATUS_ENTRY_NOT_FOUND;
+    }
+    route_p = oes_router_route_get(vr_p, idx);
+    /* a staged route is skipped by the commit once unflagged */
+    if (route_p->staged) {
+        route_p->staged = 0;
+    } else {
+        status = oes_router_lpm_delete(vr_p, key_p);
+        if (status != OES_STATUS_SUCCESS) {
+            return status;
+        }
+    }
+    oes_router_route_remove(vr_p, idx);
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function sets the log verbosity level of router MODULE
+ * @param[in]  verbosity_level  - router  module verbosity level
+ *
+ * @return OES_STATUS_SUCCESS - Operation completes successfully
+ * @return OES_STATUS_PARAM_ERROR - Unsupported verbosity_level
+ * @return OES_STATUS_ERROR general error. 
+ */
+oes_status_e
+oes_api_router_log_verbosity_level_set(const int verbosity_level)
+{
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function gets the log verbosity level of the router 
+ * MODULE 
+ * @param[out]  verbosity_level_p router  module verbosity level
+ *
+ * @return OES_STATUS_SUCCESS - Operation completes successfully
+ * @return OES_STATUS_PARAM_ERROR - Unsupported verbosity_level
+ * @return OES_STATUS_ERROR general error. 
+ */
+oes_status_e
+oes_api_router_log_verbosity_level_get(int *verbosity_level_p)
+{
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function sets the ECMP hash function configuration 
+ * parameters. 
+ *  
+ * @param[in,out] vrid - Virtual router ID 
+ * @param[in] ecmp_hash_params_p - ECMP hash configuration. 
+ * @param[in,out] router_ecmp_hash_vs_ext- vendor specific 
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_NULL if parameter is NULL.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_ecmp_hash_params_set(const unsigned int vrid,
+                                    const struct oes_router_ecmp_hash_fields *ecmp_hash_params_p,
+                                    void *router_ecmp_hash_vs_ext)
+{
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if (ecmp_hash_params_p == NULL) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else {
+        vr_p->ecmp_hash = *ecmp_hash_params_p;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ * This function gets the ECMP hash function configuration 
+ * parameters. 
+ *  
+ * @param[in,out] vrid - Virtual router ID 
+ * @param[out] ecmp_hash_params_p - ECMP hash configuration. 
+ * @param[in,out] router_ecmp_hash_vs_ext- vendor specific 
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_NULL if parameter is NULL.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_ecmp_hash_params_get(const unsigned int vrid,
+                                    struct oes_router_ecmp_hash_fields *ecmp_hash_params_p,
+                                    void *router_ecmp_hash_vs_ext)
+{
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if (ecmp_hash_params_p == NULL) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else {
+        *ecmp_hash_params_p = vr_p->ecmp_hash;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ * This function computes the ECMP hashes of a list of flows
+ * with the hash fields enabled on the virtual router. The hash
+ * of a flow selects its member of an ECMP next-hop group.
+ *
+ * @param[in] vrid - Virtual router ID
+ * @param[in] flow_list_p - packet header fields array
+ * @param[out] hash_list_p - hash array, one per flow
+ * @param[in] flow_cnt - array size
+ * @param[in,out] router_ecmp_hash_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_ecmp_hash_get(const unsigned int vrid,
+                             const struct oes_router_flow *flow_list_p,
+                             unsigned int *hash_list_p,
+                             const unsigned int flow_cnt,
+                             void *router_ecmp_hash_vs_ext)
+{
+    struct oes_router_ecmp_hash_fields fields;
+    oes_status_e status;
+
+    if (flow_cnt && ((flow_list_p == NULL) || (hash_list_p == NULL))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    status = oes_api_router_ecmp_hash_params_get(vrid, &fields, NULL);
+    if (status != OES_STATUS_SUCCESS) {
+        return status;
+    }
+    /* hashing needs the fields only, not the lock */
+    oes_router_ecmp_hash_bulk(&fields, flow_list_p, flow_cnt, hash_list_p);
+    return OES_STATUS_SUCCESS;
+}
+
+/*
+ * The group of the route of a flow's destination, and the member
+ * the flow is forwarded to. NULL when no route with a group
+ * matches.
+ */
+static struct oes_router_nhg *
+oes_router_flow_member(struct oes_router_vr *vr_p,
+                       const struct oes_router_flow *flow_p,
+                       unsigned int *member_p,
+                       unsigned int *hash_p)
+{
+    struct oes_router_nhg *nhg_p;
+    unsigned int depth, idx;
+
+    if (!oes_router_fib_lookup(vr_p->fib, &flow_p->dst_ip, &depth, &idx)) {
+        return NULL;
+    }
+    nhg_p = oes_router_nhg_find(&vr_p->nhg_table, oes_router_route_nhg(oes_router_route_get(vr_p, idx)));
+    if (nhg_p == NULL) {
+        return NULL;
+    }
+    *hash_p = oes_router_ecmp_hash(&vr_p->ecmp_hash, flow_p);
+    *member_p = oes_router_nhg_member_resolved(vr_p, nhg_p, oes_router_nhg_member_select(nhg_p, *hash_p), *hash_p);
+    return nhg_p;
+}
+
+/**
+ * This function predicts the next hop a flow is forwarded to:
+ * the route of its destination address, and the member of the
+ * route's next-hop group its ECMP hash selects. The prediction
+ * is not traffic, the forwarded flows are reported with
+ * oes_api_router_ecmp_flow_update.
+ *
+ * @param[in] vrid - Virtual router ID
+ * @param[in] flow_p - packet header fields
+ * @param[out] next_hop_p - next hop
+ * @param[in,out] router_ecmp_hash_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if no route matches the
+ *         destination or the route has no next hop.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_ecmp_next_hop_get(const unsigned int vrid,
+                                 const struct oes_router_flow *flow_p,
+                                 struct oes_ip_addr *next_hop_p,
+                                 void *router_ecmp_hash_vs_ext)
+{
+    struct oes_router_nhg *nhg_p;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned int member, hash;
+
+    if ((flow_p == NULL) || (next_hop_p == NULL) ||
+        ((flow_p->dst_ip.version != OES_IPV4) && (flow_p->dst_ip.version != OES_IPV6))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+        goto out;
+    }
+    nhg_p = oes_router_flow_member(vr_p, flow_p, &member, &hash);
+    if (nhg_p == NULL) {
+        status = OES_STATUS_ENTRY_NOT_FOUND;
+        goto out;
+    }
+    *next_hop_p = nhg_p->next_hop_list[member];
+
+out:
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ * This function records flows forwarded by a software data
+ * path. In a resilient group the flow's bucket is marked used,
+ * which keeps it on its next hop for the idle timer, and the
+ * neighbour of the next hop is marked active. Flows no route
+ * with next hops matches are skipped.
+ *
+ * @param[in] vrid - Virtual router ID
+ * @param[in] flow_list_p - packet header fields array
+ * @param[in] flow_cnt - array size
+ * @param[in,out] router_ecmp_hash_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_ecmp_flow_update(const unsigned int vrid,
+                                const struct oes_router_flow *flow_list_p,
+                                const unsigned int flow_cnt,
+                                void *router_ecmp_hash_vs_ext)
+{
+    struct oes_router_nhg *nhg_p;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned long long now;
+    unsigned int member, hash, i;
+
+    if ((flow_cnt > 0) && (flow_list_p == NULL)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    for (i = 0; i < flow_cnt; i++) {
+        if ((flow_list_p[i].dst_ip.version != OES_IPV4) && (flow_list_p[i].dst_ip.version != OES_IPV6)) {
+            return OES_STATUS_PARAM_ERROR;
+        }
+    }
+
+    /* the bucket times and activity bits are atomic, the read lock keeps the groups */
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+        goto out;
+    }
+    now = oes_router_nhg_now();
+    for (i = 0; i < flow_cnt; i++) {
+        nhg_p = oes_router_flow_member(vr_p, &flow_list_p[i], &member, &hash);
+        if (nhg_p == NULL) {
+            continue;
+        }
+        oes_router_nhg_bucket_use(nhg_p, hash, now);
+        if (nhg_p->deps != NULL) {
+            oes_router_neigh_activity_set(&vr_p->neigh_table, nhg_p->deps[member].neigh_idx);
+        }
+    }
+
+out:
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ * This function runs the bucket upkeep of the resilient
+ * next-hop groups of a virtual router: the buckets of next hops
+ * above their share, idle for the idle timer of their group,
+ * move to the next hops below it. It is called periodically, at
+ * a fraction of the idle timers.
+ *
+ * @param[in] vrid - Virtual router ID
+ * @param[out] moved_cnt_p - buckets moved
+ * @param[in,out] router_ecmp_hash_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_ecmp_bucket_process(const unsigned int vrid,
+                                   unsigned int *moved_cnt_p,
+                                   void *router_ecmp_hash_vs_ext)
+{
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if (moved_cnt_p == NULL) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    *moved_cnt_p = 0;
+
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else {
+        *moved_cnt_p = oes_router_nhg_buckets_upkeep(&vr_p->nhg_table);
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function adds/modifies/deletes a virtual router.
+ *  The router ID is allocated and returned to the caller when
+ *  cmd is ADD, otherwise it is given by the caller. All
+ *  interfaces and routes associated with a router must be
+ *  deleted before the router can be deleted as well. Its
+ *  neighbors are deleted with it. A router takes little memory
+ *  until used: its FIB, route, next-hop group and neighbor
+ *  tables are created on first use, from a pool of its own
+ *  bounded by memory_limit.
+ *  
+ * @param[in] access_cmd - ADD/EDIT/DELETE. 
+ * @param[in,out] vrid_p - Virtual router ID 
+ * @param[in] router_attr_p - Router attributes. 
+ * @param[in,out] router_vs_ext- vendor specific extension 
+ *  
+ * @return OES_STATUS_SUCCESS if operation completes successfully. 
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid. 
+ * @return OES_STATUS_NO_RESOURCES if there are no resources to
+ *         create another router
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_set(const enum oes_access_cmd access_cmd,
+                   unsigned int *vrid_p,
+                   const struct oes_router_attributes *router_attr_p,
+                   void *router_vs_ext)
+{
+    struct oes_router_vr *vr_p = NULL;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned int vrid;
+
+    if ((vrid_p == NULL) ||
+        ((access_cmd != OES_ACCESS_CMD_DELETE) && (router_attr_p == NULL))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    switch (access_cmd) {
+    case OES_ACCESS_CMD_ADD:
+        for (vrid = 0; vrid < OES_ROUTER_VR_MAX; vrid++) {
+            if (oes_router_db.vrs[vrid] == NULL) {
+                break;
+            }
+        }
+        if (vrid == OES_ROUTER_VR_MAX) {
+            status = OES_STATUS_NO_RESOURCES;
+            break;
+        }
+        if (router_attr_p->memory_limit && (router_attr_p->memory_limit < sizeof(*vr_p))) {
+            status = OES_STATUS_PARAM_ERROR;
+            break;
+        }
+        /* the tables are created on first use */
+        vr_p = calloc(1, sizeof(*vr_p));
+        if (vr_p == NULL) {
+            status = OES_STATUS_NO_MEMORY;
+            break;
+        }
+        vr_p->pool.bytes = sizeof(*vr_p);
+        vr_p->pool.peak_bytes = sizeof(*vr_p);
+        vr_p->pool.limit = router_attr_p->memory_limit;
+        vr_p->route_pool.parent = &vr_p->pool;
+        vr_p->nhg_pool.parent = &vr_p->pool;
+        vr_p->neigh_pool.parent = &vr_p->pool;
+        vr_p->mc_pool.parent = &vr_p->pool;
+        oes_router_nhg_table_init(&vr_p->nhg_table, &vr_p->nhg_pool);
+        oes_router_neigh_table_init(&vr_p->neigh_table, &vr_p->neigh_pool);
+        oes_router_mc_table_init(&vr_p->mc_table, &vr_p->mc_pool);
+        oes_router_cntr_table_init(&vr_p->cntr_table, &vr_p->pool);
+        oes_router_order_init(&vr_p->route_order, &vr_p->route_pool, oes_router_route_key_get, vr_p);
+        vr_p->attr = *router_attr_p;
+        __atomic_store_n(&oes_router_db.vrs[vrid], vr_p, __ATOMIC_RELEASE);
+        *vrid_p = vrid;
+        break;
+
+    case OES_ACCESS_CMD_EDIT:
+        vr_p = oes_router_vr_get(*vrid_p);
+        if ((vr_p == NULL) || (router_attr_p->memory_limit && (router_attr_p->memory_limit < sizeof(*vr_p)))) {
+            status = OES_STATUS_PARAM_ERROR;
+            break;
+        }
+        /* a limit below the usage only stops further allocations */
+        vr_p->attr = *router_attr_p;
+        __atomic_store_n(&vr_p->pool.limit, router_attr_p->memory_limit, __ATOMIC_RELAXED);
+        break;
+
+    case OES_ACCESS_CMD_DELETE:
+        vr_p = oes_router_vr_get(*vrid_p);
+        if (vr_p == NULL) {
+            status = OES_STATUS_PARAM_ERROR;
+            break;
+        }
+        if (vr_p->route_cnt || vr_p->rif_cnt) {
+            status = OES_STATUS_ERROR;
+            break;
+        }
+        __atomic_store_n(&oes_router_db.vrs[*vrid_p], NULL, __ATOMIC_RELEASE);
+        oes_router_vr_destroy(vr_p);
+        break;
+
+    default:
+        status = OES_STATUS_CMD_UNSUPPORTED;
+        break;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function gets a virtual router information.
+ *  
+ * @param[in] vrid - Virtual router ID
+ * @param[out] router_attr_p - Router attributes. 
+ * @param[in,out] router_vs_ext- vendor specific extension 
+ *  
+ * @return OES_STATUS_SUCCESS if operation completes successfully. 
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid. 
+ * @return OES_STATUS_NO_RESOURCES if there are no resources to
+ *         create another router
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_get(const unsigned int vrid,
+                   struct oes_router_attributes *router_attr_p,
+                   void *router_vs_ext)
+{
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if (router_attr_p == NULL) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else {
+        *router_attr_p = vr_p->attr;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function gets the memory a virtual router uses. The
+ *  tables of a router are created on first use and allocated
+ *  from a pool of its own, freed with the router.
+ *
+ * @param[in] vrid - Virtual router ID
+ * @param[out] memory_p - pool and LPM table usage
+ * @param[in,out] router_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_memory_get(const unsigned int vrid,
+                          struct oes_router_memory *memory_p,
+                          void *router_vs_ext)
+{
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if (memory_p == NULL) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else {
+        memory_p->pool_bytes = __atomic_load_n(&vr_p->pool.bytes, __ATOMIC_RELAXED);
+        memory_p->pool_peak_bytes = __atomic_load_n(&vr_p->pool.peak_bytes, __ATOMIC_RELAXED);
+        memory_p->table_bytes = 0;
+        if (vr_p->fib != NULL) {
+            memory_p->table_bytes = oes_router_lpm4_table_bytes(&vr_p->fib->lpm4) +
+                                    oes_router_lpm6_table_bytes(&vr_p->fib->lpm6);
+        }
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/* fill and fragmentation of a table, in 1/10000 */
+static void
+oes_router_table_usage_ratios(struct oes_router_table_usage *usage_p)
+{
+    if (usage_p->free_bytes > usage_p->bytes) {
+        usage_p->free_bytes = usage_p->bytes;
+    }
+    usage_p->fill = usage_p->entry_max ?
+                    (unsigned long long)usage_p->entry_cnt * 10000 / usage_p->entry_max : 0;
+    usage_p->fragmentation = usage_p->bytes ? usage_p->free_bytes * 10000 / usage_p->bytes : 0;
+}
+
+/* usage of a table of records from a pool of its own */
+static void
+oes_router_table_usage_records(struct oes_router_table_usage *usage_p,
+                               const struct oes_router_pool *pool_p,
+                               const unsigned int cnt,
+                               const unsigned int size,
+                               const size_t record_size)
+{
+    memset(usage_p, 0, sizeof(*usage_p));
+    usage_p->bytes = __atomic_load_n(&pool_p->bytes, __ATOMIC_RELAXED);
+    usage_p->entry_cnt = cnt;
+    usage_p->entry_max = size;
+    usage_p->free_bytes = (unsigned long long)(size - cnt) * record_size;
+    oes_router_table_usage_ratios(usage_p);
+}
+
+/**
+ *  This function gets the memory a virtual router uses per
+ *  table: bytes, entries in use against the entries the table
+ *  holds without growing, and the bytes holding no entry. The
+ *  LPM tables are mapped, their bytes are the resident pages;
+ *  the free ones are given back by
+ *  oes_api_router_memory_compact().
+ *
+ * @param[in] vrid - Virtual router ID
+ * @param[out] stats_p - usage of each table
+ * @param[in,out] router_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_memory_stats_get(const unsigned int vrid,
+                                struct oes_router_memory_stats *stats_p,
+                                void *router_vs_ext)
+{
+    struct oes_router_vr *vr_p;
+    unsigned int route_max = 0, i;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if (stats_p == NULL) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+        goto out;
+    }
+    memset(stats_p, 0, sizeof(*stats_p));
+    stats_p->ipv4_route_cnt = vr_p->route_cnt - vr_p->route_ipv6_cnt;
+    stats_p->ipv6_route_cnt = vr_p->route_ipv6_cnt;
+    for (i = 0; i < OES_ROUTER_ROUTE_MAX / OES_ROUTER_ROUTE_CHUNK_SIZE; i++) {
+        if (vr_p->route_chunks[i] != NULL) {
+            route_max += oes_router_route_chunk_size(vr_p, i);
+        }
+    }
+    oes_router_table_usage_records(&stats_p->routes, &vr_p->route_pool, vr_p->route_cnt, route_max,
+                                   sizeof(struct oes_router_route));
+    oes_router_table_usage_records(&stats_p->nhgs, &vr_p->nhg_pool, vr_p->nhg_table.nhg_cnt,
+                                   vr_p->nhg_table.nhg_size, sizeof(struct oes_router_nhg));
+    oes_router_table_usage_records(&stats_p->neighs, &vr_p->neigh_pool, vr_p->neigh_table.neigh_cnt,
+                                   vr_p->neigh_table.neigh_size, sizeof(struct oes_router_neigh));
+    oes_router_table_usage_records(&stats_p->mc_routes, &vr_p->mc_pool, vr_p->mc_table.route_cnt,
+                                   vr_p->mc_table.route_size, sizeof(struct oes_router_mc_route));
+    if (vr_p->fib != NULL) {
+        oes_router_lpm4_usage(&vr_p->fib->lpm4, &stats_p->lpm4);
+        oes_router_lpm6_usage(&vr_p->fib->lpm6, &stats_p->lpm6);
+        if (vr_p->fib->lpm4.tbl24 == NULL) {
+            stats_p->lpm4.bytes = vr_p->fib->tree4.node_bytes;
+        }
+    } else {
+        stats_p->lpm4.entry_max = OES_ROUTER_LPM4_TBL8_GROUP_CNT;
+        stats_p->lpm6.entry_max = OES_ROUTER_LPM6_DIRECT_CNT;
+    }
+    oes_router_table_usage_ratios(&stats_p->lpm4);
+    oes_router_table_usage_ratios(&stats_p->lpm6);
+
+out:
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function gives back the memory the LPM tables of a
+ *  virtual router no longer need after routes were withdrawn:
+ *  the IPv4 tbl8 groups in use are packed below the free ones
+ *  and the tail is unmapped, the empty table pages are dropped.
+ *  A table is only compacted when its fragmentation, as
+ *  reported by oes_api_router_memory_stats_get(), is at least
+ *  min_fragmentation. Lookups go on meanwhile, route updates
+ *  wait for it. It is meant to be called periodically, from a
+ *  thread of the caller.
+ *
+ * @param[in] vrid - Virtual router ID
+ * @param[in] min_fragmentation - in 1/10000, 0 to compact
+ *       anyway
+ * @param[out] reclaimed_bytes_p - bytes given back
+ * @param[in,out] router_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_memory_compact(const unsigned int vrid,
+                              const unsigned int min_fragmentation,
+                              unsigned long long *reclaimed_bytes_p,
+                              void *router_vs_ext)
+{
+    struct oes_router_table_usage usage;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if ((reclaimed_bytes_p == NULL) || (min_fragmentation > 10000)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    *reclaimed_bytes_p = 0;
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+        goto out;
+    }
+    if (vr_p->fib == NULL) {
+        goto out;
+    }
+    oes_router_lpm4_usage(&vr_p->fib->lpm4, &usage);
+    oes_router_table_usage_ratios(&usage);
+    if (usage.free_bytes && (usage.fragmentation >= min_fragmentation)) {
+        *reclaimed_bytes_p += oes_router_lpm4_compact(&vr_p->fib->lpm4);
+    }
+    oes_router_lpm6_usage(&vr_p->fib->lpm6, &usage);
+    oes_router_table_usage_ratios(&usage);
+    if (usage.free_bytes && (usage.fragmentation >= min_fragmentation)) {
+        *reclaimed_bytes_p += oes_router_lpm6_compact(&vr_p->fib->lpm6);
+    }
+
+out:
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/*
+ * Drops what refers to a router interface about to be deleted,
+ * since its rif may go to another router next: its neighbors,
+ * its counters, the multicast routes it is the ingress interface
+ * of, and itself from the egress lists of the others. The
+ * egress lists are done first, they alone may fail.
+ */
+static oes_status_e
+oes_router_vr_rif_purge(struct oes_router_vr *vr_p, const unsigned int rif)
+{
+    struct oes_router_mc_table *mc_table_p = &vr_p->mc_table;
+    struct oes_router_mc_route *route_p;
+    oes_status_e status;
+    unsigned int idx;
+
+    for (idx = 0; idx < mc_table_p->route_size; idx++) {
+        route_p = &mc_table_p->routes[idx];
+        if (route_p->in_use && (route_p->key.ingress_rif != rif) && oes_router_mc_rif_has(route_p, rif)) {
+            status = oes_router_mc_rifs_update(mc_table_p, route_p, 0, &rif, 1);
+            if (status != OES_STATUS_SUCCESS) {
+                return status;
+            }
+        }
+    }
+    for (idx = 0; idx < mc_table_p->route_size; idx++) {
+        route_p = &mc_table_p->routes[idx];
+        if (route_p->in_use && (route_p->key.ingress_rif == rif)) {
+            oes_router_mc_delete(mc_table_p, route_p);
+        }
+    }
+    oes_router_neighs_delete(vr_p, rif);
+    oes_router_cntr_disable(&vr_p->cntr_table, rif);
+    return OES_STATUS_SUCCESS;
+}
+
+/*
+ * Drops the neighbors and the multicast routes of a router whose
+ * interfaces are about to be all deleted, in one pass over the
+ * multicast routes: the routes of a given ingress interface go,
+ * the others keep no egress interface since they may only have
+ * the router's. Unlike one interface at a time nothing is
+ * allocated, it cannot fail.
+ */
+static void
+oes_router_vr_rifs_purge(struct oes_router_vr *vr_p)
+{
+    struct oes_router_mc_table *mc_table_p = &vr_p->mc_table;
+    struct oes_router_mc_route *route_p;
+    unsigned int idx;
+
+    for (idx = 0; idx < mc_table_p->route_size; idx++) {
+        route_p = &mc_table_p->routes[idx];
+        if (!route_p->in_use) {
+            continue;
+        }
+        if (route_p->key.ingress_rif != OES_ROUTER_INTERFACE_INVALID) {
+            oes_router_mc_delete(mc_table_p, route_p);
+        } else {
+            oes_router_mc_rifs_clear(mc_table_p, route_p);
+        }
+    }
+    oes_router_neighs_delete(vr_p, OES_ROUTER_INTERFACE_INVALID);
+}
+
+/**
+ *  This function adds/modifies/deletes/delete_all a router
+ *  interface. A router interface is associated with L2
+ *  interface, a (bridge, VLAN) or a port, which has at most one
+ *  router interface. The rif is allocated and returned to the
+ *  caller when cmd is ADD, deleted rifs are reused; rifs are
+ *  unique across the virtual routers. EDIT changes the
+ *  attributes only, ifc_p is ignored. DELETE_ALL deletes all the
+ *  interfaces of the router, rif_p is ignored. A new interface
+ *  routes the frames of its MAC with its admin state down for
+ *  both IP versions. Deleting an interface deletes its
+ *  neighbors, its counters and the multicast routes it is the
+ *  ingress interface of, and drops it from the egress lists of
+ *  the other multicast routes. DELETE_ALL does not fail once
+ *  the router is found: it deletes all the interfaces or, for a
+ *  router without any, nothing.
+ * 
+ * @param[in] access_cmd - ADD/EDIT/DELETE/DELETE ALL.
+ * @param[in] vrid - Virtual Router ID. 
+ * @param[in,out] rif_p - Router Interface ID.  
+ * @param[in] ifc_p - Interface type and parameters e.g. 
+ *       vlan,port ... 
+ * @param[in] ifc_attr_p - Interface attributes e.g mac address 
+ *       mtu ,rpc ... .
+ * @param[in,out] router_interface_vs_ext- vendor specific 
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully. 
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if router interface was not added.
+ * @return OES_STATUS_ENTRY_ALREADY_EXISTS if the L2 interface
+ *         has a router interface already.
+ * @return OES_STATUS_NO_RESOURCES if no interface is available to create. 
+ * @return OES_STATUS_NO_MEMORY if the interfaces cannot grow, or
+ *         the egress lists of the multicast routes of the deleted
+ *         interface cannot be changed; the interface is left as it
+ *         was.
+ * @return OES_STATUS_CMD_UNSUPPORTED if access command isn't supported.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_interface_set(const enum oes_access_cmd access_cmd,
+                             const unsigned int vrid,
+                             unsigned int *rif_p,
+                             const struct oes_l3_interface *ifc_p,
+                             const struct oes_l3_interface_attributes *ifc_attr_p,
+                             void *router_interface_vs_ext)
+{
+    struct oes_router_rif_table *table_p = &oes_router_db.rif_table;
+    struct oes_router_rif *router_ifc_p;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned int rif;
+
+    if (((access_cmd != OES_ACCESS_CMD_DELETE_ALL) && (rif_p == NULL)) ||
+        ((access_cmd == OES_ACCESS_CMD_ADD) && (ifc_p == NULL)) ||
+        (((access_cmd == OES_ACCESS_CMD_ADD) || (access_cmd == OES_ACCESS_CMD_EDIT)) && (ifc_attr_p == NULL))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+        goto out;
+    }
+    switch (access_cmd) {
+    case OES_ACCESS_CMD_ADD:
+        status = oes_router_rif_add(table_p, vrid, ifc_p, ifc_attr_p, rif_p);
+        if (status == OES_STATUS_SUCCESS) {
+            vr_p->rif_cnt++;
+        }
+        break;
+
+    case OES_ACCESS_CMD_EDIT:
+        router_ifc_p = oes_router_vr_rif_get(vrid, *rif_p);
+        if (router_ifc_p == NULL) {
+            status = OES_STATUS_ENTRY_NOT_FOUND;
+            break;
+        }
+        status = oes_router_rif_attr_set(table_p, router_ifc_p, ifc_attr_p);
+        break;
+
+    case OES_ACCESS_CMD_DELETE:
+        router_ifc_p = oes_router_vr_rif_get(vrid, *rif_p);
+        if (router_ifc_p == NULL) {
+            status = OES_STATUS_ENTRY_NOT_FOUND;
+            break;
+        }
+        status = oes_router_vr_rif_purge(vr_p, *rif_p);
+        if (status != OES_STATUS_SUCCESS) {
+            break;
+        }
+        oes_router_rif_delete(table_p, router_ifc_p);
+        vr_p->rif_cnt--;
+        break;
+
+    case OES_ACCESS_CMD_DELETE_ALL:
+        oes_router_vr_rifs_purge(vr_p);
+        for (rif = 0; vr_p->rif_cnt && (rif < table_p->rif_size); rif++) {
+            router_ifc_p = oes_router_vr_rif_get(vrid, rif);
+            if (router_ifc_p == NULL) {
+                continue;
+            }
+            oes_router_cntr_disable(&vr_p->cntr_table, rif);
+            oes_router_rif_delete(table_p, router_ifc_p);
+            vr_p->rif_cnt--;
+        }
+        break;
+
+    default:
+        status = OES_STATUS_CMD_UNSUPPORTED;
+        break;
+    }
+    oes_router_rcu_reclaim();
+
+out:
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ * This function gets a router interface information. 
+ * 
+ * @param[in] vrid - Virtual Router ID. 
+ * @param[in] rif - Router Interface ID.  
+ * @param[out] ifc - Interface type and parameters
+ * @param[out] ifc_attr - Interface attributes 
+ * @param[in,out] router_interface_vs_ext- vendor specific 
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully. 
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if router interface was not added. 
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_interface_get(const unsigned int vrid,
+                             const unsigned int rif,
+                             struct oes_l3_interface *ifc_p,
+                             struct oes_l3_interface_attributes *ifc_attr_p,
+                             void *router_interface_vs_ext)
+{
+    struct oes_router_rif *router_ifc_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if ((ifc_p == NULL) || (ifc_attr_p == NULL)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    if (oes_router_vr_get(vrid) == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if ((router_ifc_p = oes_router_vr_rif_get(vrid, rif)) == NULL) {
+        status = OES_STATUS_ENTRY_NOT_FOUND;
+    } else {
+        *ifc_p = router_ifc_p->ifc;
+        *ifc_attr_p = router_ifc_p->attr;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function sets admin state of a router interface. Admin state is set per
+ *  IP version.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] rif - Router Interface ID.
+ * @param[in] admin_state_p - Admin state.
+ * @param[in,out] router_interface_state_vs_ext- vendor specific
+ *       extension
+ *  
+ * @return OES_STATUS_SUCCESS if operation completes successfully. 
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if router interface was not added.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_interface_state_set(const unsigned int vrid,
+                                   const unsigned int rif,
+                                   const struct oes_l3_interface_admin_state *admin_state_p,
+                                   void *router_interface_state_vs_ext)
+{
+    struct oes_router_rif *router_ifc_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if (admin_state_p == NULL) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    if (oes_router_vr_get(vrid) == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if ((router_ifc_p = oes_router_vr_rif_get(vrid, rif)) == NULL) {
+        status = OES_STATUS_ENTRY_NOT_FOUND;
+    } else {
+        router_ifc_p->admin_state = *admin_state_p;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function gets admin state of a router interface.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] rif - Router Interface ID.
+ * @param[out] admin_state_p - Admin state.
+ * @param[in,out] router_interface_state_vs_ext- vendor specific
+ *       extension
+ *  
+ * @return OES_STATUS_SUCCESS if operation completes successfully. 
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if router interface was not added.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_interface_state_get(const unsigned int vrid,
+                                   const unsigned int rif,
+                                   struct oes_l3_interface_admin_state *admin_state_p,
+                                   void *router_interface_state_vs_ext)
+{
+    struct oes_router_rif *router_ifc_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if (admin_state_p == NULL) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    if (oes_router_vr_get(vrid) == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if ((router_ifc_p = oes_router_vr_rif_get(vrid, rif)) == NULL) {
+        status = OES_STATUS_ENTRY_NOT_FOUND;
+    } else {
+        *admin_state_p = router_ifc_p->admin_state;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function adds/deletes a MAC address from a router interface.
+ *  Frames to the MACs of an interface, on its L2 interface, are
+ *  routed. The MACs are added besides the MAC of the interface
+ *  attributes, which DELETE_ALL leaves. MACs the interface has
+ *  already, or has not for a DELETE, are skipped; an ADD adds
+ *  all the MACs or none.
+ * 
+ * @param[in] access_cmd - ADD/DELETE/DELETE_ALL. 
+ * @param[in] vrid - Virtual Router ID. 
+ * @param[in] rif - Router Interface ID.
+ * @param[in] mac_addr_list_p - MAC addresses array.
+ * @param[in] mac_cnt - MAC addresses array size.
+ * @param[in,out] router_interface_mac_vs_ext- vendor specific
+ *       extension
+ *  
+ * @return OES_STATUS_SUCCESS if operation completes successfully. 
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if router interface was not added.
+ * @return OES_STATUS_PARAM_EXCEEDS_RANGE if the interface would
+ *         get more than 65535 MACs.
+ * @return OES_STATUS_NO_MEMORY if the MACs cannot grow.
+ * @return OES_STATUS_CMD_UNSUPPORTED if access command isn't supported.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_interface_mac_set(const enum oes_access_cmd access_cmd,
+                                 const unsigned int vrid,
+                                 const unsigned int rif,
+                                 const struct ether_addr *mac_addr_list_p,
+                                 const unsigned short mac_cnt,
+                                 void *router_interface_mac_vs_ext)
+{
+    struct oes_router_rif *router_ifc_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if ((access_cmd != OES_ACCESS_CMD_ADD) && (access_cmd != OES_ACCESS_CMD_DELETE) &&
+        (access_cmd != OES_ACCESS_CMD_DELETE_ALL)) {
+        return OES_STATUS_CMD_UNSUPPORTED;
+    }
+    if ((access_cmd != OES_ACCESS_CMD_DELETE_ALL) && mac_cnt && (mac_addr_list_p == NULL)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    if (oes_router_vr_get(vrid) == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if ((router_ifc_p = oes_router_vr_rif_get(vrid, rif)) == NULL) {
+        status = OES_STATUS_ENTRY_NOT_FOUND;
+    } else if (access_cmd == OES_ACCESS_CMD_DELETE_ALL) {
+        oes_router_rif_macs_clear(&oes_router_db.rif_table, router_ifc_p);
+    } else {
+        status = oes_router_rif_macs_update(&oes_router_db.rif_table, router_ifc_p,
+                                            access_cmd == OES_ACCESS_CMD_ADD, mac_addr_list_p, mac_cnt);
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function gets MAC address of a router interface, the
+ *  MACs added to it, the latest first. When *mac_cnt_p is 0, it
+ *  only returns their number. Otherwise up to *mac_cnt_p MACs
+ *  are read, and *mac_cnt_p is set to the number read.
+ * 
+ * @param[in] access_cmd - GET. 
+ * @param[in] vrid - Virtual Router ID. 
+ * @param[in] rif - Router Interface ID.
+ * @param[out] mac_addr_list_p - MAC addresses array .
+ * @param[in,out] mac_cnt_p - MAC addresses array size . 
+ * @param[in,out] router_interface_mac_vs_ext- vendor specific
+ *       extension 
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully. 
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if router interface was not added.
+ * @return OES_STATUS_CMD_UNSUPPORTED if access command isn't supported.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_interface_mac_get(const enum oes_access_cmd access_cmd,
+                                 const unsigned int vrid,
+                                 const unsigned int rif,
+                                 struct ether_addr *mac_addr_list_p,
+                                 unsigned short *mac_cnt_p,
+                                 void *router_interface_mac_vs_ext)
+{
+    struct oes_router_rif *router_ifc_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if (access_cmd != OES_ACCESS_CMD_GET) {
+        return OES_STATUS_CMD_UNSUPPORTED;
+    }
+    if ((mac_cnt_p == NULL) || (*mac_cnt_p && (mac_addr_list_p == NULL))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    if (oes_router_vr_get(vrid) == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if ((router_ifc_p = oes_router_vr_rif_get(vrid, rif)) == NULL) {
+        status = OES_STATUS_ENTRY_NOT_FOUND;
+    } else if (*mac_cnt_p == 0) {
+        *mac_cnt_p = router_ifc_p->mac_added;
+    } else {
+        *mac_cnt_p = oes_router_rif_macs_list(&oes_router_db.rif_table, router_ifc_p, mac_addr_list_p, *mac_cnt_p);
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function finds the router interface a frame is routed
+ *  by, for a software data path: the interface of its ingress
+ *  L2 interface, a (bridge, VLAN) or a port, which has its
+ *  destination MAC. A frame without one is bridged. The
+ *  (L2 interface, MAC) pairs of all the interfaces are hashed
+ *  together, the lookup takes one probe whatever the number of
+ *  interfaces. The caller routes the IP versions the admin state
+ *  of the interface enables.
+ *
+ * @param[in] ifc_p - ingress L2 interface of the frame
+ * @param[in] mac_addr_p - destination MAC of the frame
+ * @param[out] lookup_p - router and interface found, with its
+ *       admin state
+ * @param[in,out] router_interface_mac_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if no interface routes the
+ *         frame.
+ */
+oes_status_e
+oes_api_router_interface_mac_lookup(const struct oes_l3_interface *ifc_p,
+                                    const struct ether_addr *mac_addr_p,
+                                    struct oes_l3_interface_lookup *lookup_p,
+                                    void *router_interface_mac_vs_ext)
+{
+    struct oes_router_rif *router_ifc_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if ((ifc_p == NULL) || (mac_addr_p == NULL) || (lookup_p == NULL)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    router_ifc_p = oes_router_rif_lookup(&oes_router_db.rif_table, ifc_p, mac_addr_p);
+    if (router_ifc_p == NULL) {
+        status = OES_STATUS_ENTRY_NOT_FOUND;
+    } else {
+        lookup_p->vrid = router_ifc_p->vrid;
+        lookup_p->rif = router_ifc_p - oes_router_db.rif_table.rifs;
+        lookup_p->admin_state = router_ifc_p->admin_state;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function adds/modifies/deletes/delete_all a neighbour
+ *  information. The neighbour information associate an IP
+ *  address to a MAC address. The neighbour IP addresses are
+ *  learned via ARP/ND discovery at the control protocols layer,
+ *  the interface that the neighbours are associated with is
+ *  derived from the IP interface configuration. When calling
+ *  with DELETE command, rif parameter is ignored. At DELETE_ALL
+ *  operation the neighbours associated with the router
+ *  interface parameter will be deleted in case it is valid, in
+ *  case rif is invalid , all neighbours will be deleted.
+ *  Adding a neighbour resolves the next hops with its address,
+ *  deleting it unresolves them: the unicast routes depending on
+ *  it switch between TRAP and FORWARD in the same call. Only
+ *  the next-hop groups of the neighbour are updated, whatever
+ *  the number of their routes, and flows hashed to a next hop
+ *  without neighbour move to the other next hops of its group.
+ *  With aging on, ADD/EDIT (re)starts the aging of the
+ *  neighbour: a refresh answered by an EDIT keeps it.
+ * 
+ * @param[in] access_cmd - ADD/EDIT/DELETE/DELETE_ALL.
+ * @param[in] vrid - Virtual Router ID. 
+ * @param[in] neigh_key_p - neigh IP address. 
+ * @param[in] neigh_data_p- neigh data including rif,mac address
+ *       , action(TRAP/DROP/FORWARD) ,activity
+ * @param[in,out] router_neigh_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully. 
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid. 
+ * @return OES_STATUS_NO_RESOURCES if no neighbour entry is available to create.
+ * @return OES_STATUS_NO_MEMORY if the router reached its memory limit.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_neigh_set(const enum oes_access_cmd access_cmd,
+                         const unsigned int vrid,
+                         const struct oes_ip_addr *neigh_key_p,
+                         const struct oes_neigh_data *neigh_data_p,
+                         void *router_neigh_vs_ext)
+{
+    struct oes_router_neigh *neigh_p;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if ((access_cmd != OES_ACCESS_CMD_DELETE_ALL) &&
+        ((neigh_key_p == NULL) || ((neigh_key_p->version != OES_IPV4) && (neigh_key_p->version != OES_IPV6)))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    if (((access_cmd == OES_ACCESS_CMD_ADD) || (access_cmd == OES_ACCESS_CMD_EDIT)) &&
+        ((neigh_data_p == NULL) || (neigh_data_p->mac_addr == NULL) ||
+         (neigh_data_p->action > OES_ROUTER_ACTION_FORWARD))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+        goto out;
+    }
+
+    switch (access_cmd) {
+    case OES_ACCESS_CMD_ADD:
+    case OES_ACCESS_CMD_EDIT:
+        if (oes_router_vr_rif_get(vrid, neigh_data_p->rif) == NULL) {
+            status = OES_STATUS_PARAM_ERROR;
+            break;
+        }
+        neigh_p = oes_router_neigh_find(&vr_p->neigh_table, neigh_key_p);
+        if ((access_cmd == OES_ACCESS_CMD_EDIT) && ((neigh_p == NULL) || !neigh_p->resolved)) {
+            status = OES_STATUS_ENTRY_NOT_FOUND;
+            break;
+        }
+        if (neigh_p == NULL) {
+            status = oes_router_neigh_add(&vr_p->neigh_table, neigh_key_p, &neigh_p);
+            if (status != OES_STATUS_SUCCESS) {
+                break;
+            }
+        }
+        neigh_p->rif = neigh_data_p->rif;
+        neigh_p->mac = *neigh_data_p->mac_addr;
+        neigh_p->action = neigh_data_p->action;
+        /* the routes to next hops with this address forward */
+        oes_router_neigh_resolve(vr_p, neigh_p, 1);
+        oes_router_neigh_age_start(vr_p, neigh_p, oes_router_age_now());
+        break;
+
+    case OES_ACCESS_CMD_DELETE:
+        neigh_p = oes_router_neigh_find(&vr_p->neigh_table, neigh_key_p);
+        if ((neigh_p == NULL) || !neigh_p->resolved) {
+            status = OES_STATUS_ENTRY_NOT_FOUND;
+            break;
+        }
+        oes_router_neigh_remove(vr_p, neigh_p);
+        break;
+
+    case OES_ACCESS_CMD_DELETE_ALL:
+        oes_router_neighs_delete(vr_p, ((neigh_data_p != NULL) ? neigh_data_p->rif : OES_ROUTER_INTERFACE_INVALID));
+        break;
+
+    default:
+        status = OES_STATUS_CMD_UNSUPPORTED;
+        break;
+    }
+
+out:
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function gets/get activity a neighbour information.
+ *  function can receive four types of input: 
+ *     1) get information for specific  neigh
+ *      user should inserts  sepecific neigh as the first
+ *      neigh_key element in the neigh_key array , neigh_cnt
+ *      should be equal to 1, access_cmd should be
+ *      OES_ACCESS_CMD_GET
+ *  
+ *     2) get neigh  activity information for specific neigh
+ *      user should inserts sepecific neigh as the first
+ *      neigh_key element in the neigh_key array , neigh_cnt
+ *      should be equal to 1, access_cmd should be
+ *      OES_ACCESS_CMD_GET_ACTIVITY. The activity is cleared on
+ *      read, a neighbour is active if it had traffic since.
+ *  
+ *   - 3) get a list of first n neighs ,user
+ *      should provide an empty  neigh_key array array
+ *      neigh_cnt should be equal to n,access_cmd should be
+ *      OES_ACCESS_CMD_GET_FIRST
+ *
+ *   - 4) get a list of n  neighs  which comes after
+ *      certain neigh(it does not have to exist) user should
+ *      insert the certain neigh as the first neigh_key element
+ *      in the neigh_key array , neigh_cnt should be equal to n,
+ *      OES_ACCESS_CMD_GET_NEXT
+ * 
+ * @param[in] access_cmd - GET/GET_NEXT/GET_FIRST/GET_ACTIVITY 
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in,out] neigh_key_list_p - neigh IP address array 
+ * @param[out] neigh_data_list_p- neigh data  array , each neigh
+ *       data element includes rif,mac address ,
+ *       action(TRAP/DROP/FORWARD) ,activity
+ * @param[in,out] neigh_cnt_p - array size  
+ * @param[in,out] router_neigh_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully. 
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if neighbour was not added.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_neigh_get(const enum oes_access_cmd access_cmd,
+                         const unsigned int vrid,
+                         struct oes_ip_addr *neigh_key_list_p,
+                         struct oes_neigh_data *neigh_data_list_p,
+                         unsigned short *neigh_cnt_p,
+                         void *router_neigh_vs_ext)
+{
+    struct oes_router_neigh **neigh_list_pp = NULL;
+    struct oes_router_neigh *neigh_p;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned int cnt, i;
+
+    if ((neigh_key_list_p == NULL) || (neigh_data_list_p == NULL) || (neigh_cnt_p == NULL)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    switch (access_cmd) {
+    case OES_ACCESS_CMD_GET:
+    case OES_ACCESS_CMD_GET_ACTIVITY:
+        if (*neigh_cnt_p != 1) {
+            return OES_STATUS_PARAM_ERROR;
+        }
+        break;
+
+    case OES_ACCESS_CMD_GET_FIRST:
+    case OES_ACCESS_CMD_GET_NEXT:
+        neigh_list_pp = malloc((*neigh_cnt_p ? *neigh_cnt_p : 1) * sizeof(*neigh_list_pp));
+        if (neigh_list_pp == NULL) {
+            return OES_STATUS_NO_MEMORY;
+        }
+        break;
+
+    default:
+        return OES_STATUS_CMD_UNSUPPORTED;
+    }
+
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if ((access_cmd == OES_ACCESS_CMD_GET) || (access_cmd == OES_ACCESS_CMD_GET_ACTIVITY)) {
+        /* the activity is cleared on read with GET_ACTIVITY */
+        neigh_p = oes_router_neigh_find(&vr_p->neigh_table, neigh_key_list_p);
+        if ((neigh_p == NULL) || !neigh_p->resolved) {
+            status = OES_STATUS_ENTRY_NOT_FOUND;
+        } else {
+            oes_router_neigh_data_get(vr_p, neigh_p, neigh_data_list_p,
+                                      access_cmd == OES_ACCESS_CMD_GET_ACTIVITY);
+        }
+    } else {
+        /* the neighbors after the one given, which need not exist */
+        cnt = oes_router_neigh_list(&vr_p->neigh_table,
+                                    (access_cmd == OES_ACCESS_CMD_GET_NEXT) ? neigh_key_list_p : NULL,
+                                    neigh_list_pp, *neigh_cnt_p);
+        for (i = 0; i < cnt; i++) {
+            neigh_key_list_p[i] = neigh_list_pp[i]->addr;
+            oes_router_neigh_data_get(vr_p, neigh_list_pp[i], &neigh_data_list_p[i], 0);
+        }
+        *neigh_cnt_p = cnt;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    free(neigh_list_pp);
+    return status;
+}
+
+/**
+ *  This function sweeps the neighbour activity of a virtual
+ *  router: it lists the neighbours which had traffic since the
+ *  last sweep, or those which had none. The activity of all the
+ *  neighbours is kept in a bitmap, a sweep scans its bits rather
+ *  than getting each neighbour. With READ_CLEAR the sweep starts
+ *  a new period, once all the neighbours found fit in the array.
+ *  The aging keeps its own copy of the activity, a sweep does
+ *  not hide traffic from it.
+ *
+ * @param[in] access_cmd - READ/READ_CLEAR
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] active - 1 for the active neighbours, 0 for the
+ *       inactive ones
+ * @param[out] neigh_key_list_p - neigh IP address array
+ * @param[in,out] neigh_cnt_p - array size, the number of
+ *       neighbours found on return. When more are found than the
+ *       array takes, it holds the first ones and the activity is
+ *       not cleared.
+ * @param[in,out] router_neigh_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_NO_MEMORY if the sweep list cannot be allocated.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_neigh_activity_get(const enum oes_access_cmd access_cmd,
+                                  const unsigned int vrid,
+                                  const unsigned char active,
+                                  struct oes_ip_addr *neigh_key_list_p,
+                                  unsigned int *neigh_cnt_p,
+                                  void *router_neigh_vs_ext)
+{
+    struct oes_router_neigh **neigh_list_pp;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned int found, i;
+
+    if ((neigh_key_list_p == NULL) || (neigh_cnt_p == NULL)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    if ((access_cmd != OES_ACCESS_CMD_READ) && (access_cmd != OES_ACCESS_CMD_READ_CLEAR)) {
+        return OES_STATUS_CMD_UNSUPPORTED;
+    }
+    neigh_list_pp = malloc((*neigh_cnt_p ? *neigh_cnt_p : 1) * sizeof(*neigh_list_pp));
+    if (neigh_list_pp == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else {
+        found = oes_router_neigh_activity_sweep(&vr_p->neigh_table, active != 0,
+                                                access_cmd == OES_ACCESS_CMD_READ_CLEAR,
+                                                neigh_list_pp, *neigh_cnt_p);
+        for (i = 0; (i < found) && (i < *neigh_cnt_p); i++) {
+            neigh_key_list_p[i] = neigh_list_pp[i]->addr;
+        }
+        *neigh_cnt_p = found;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    free(neigh_list_pp);
+    return status;
+}
+
+/**
+ *  This function records traffic to neighbours, for a software
+ *  data path: each resolved neighbour of the list is marked
+ *  active, for the activity sweeps, GET_ACTIVITY and the aging
+ *  alike. It takes the traffic of any route, directly connected
+ *  hosts included. Addresses without a resolved neighbour are
+ *  skipped.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] neigh_key_list_p - neigh IP address array
+ * @param[in] neigh_cnt - array size
+ * @param[in,out] router_neigh_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_neigh_activity_update(const unsigned int vrid,
+                                     const struct oes_ip_addr *neigh_key_list_p,
+                                     const unsigned int neigh_cnt,
+                                     void *router_neigh_vs_ext)
+{
+    struct oes_router_neigh *neigh_p;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned int i;
+
+    if ((neigh_cnt > 0) && (neigh_key_list_p == NULL)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    /* the activity bits are atomic, the read lock keeps the table */
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+        goto out;
+    }
+    for (i = 0; i < neigh_cnt; i++) {
+        neigh_p = oes_router_neigh_find(&vr_p->neigh_table, &neigh_key_list_p[i]);
+        if (neigh_p != NULL) {
+            oes_router_neigh_activity_set(&vr_p->neigh_table, neigh_p - vr_p->neigh_table.neighs);
+        }
+    }
+
+out:
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function sets the neighbour aging of a virtual router.
+ *  The traffic is the one reported with
+ *  oes_api_router_neigh_activity_update and
+ *  oes_api_router_ecmp_flow_update.
+ *  A neighbour without traffic for age_time gets an
+ *  OES_NEIGH_EVENT_REFRESH event every refresh_interval, the
+ *  control protocols probe it and EDIT it once it answers. After
+ *  refresh_cnt events without traffic nor EDIT, it is deleted
+ *  and an OES_NEIGH_EVENT_AGE event is sent. The events go to
+ *  the channels registered for OES_EVENT_ID_NEIGH with the
+ *  virtual router ID. Each delay is shortened by up to jitter
+ *  percent at random so that neighbours added together are not
+ *  probed together. Setting the aging restarts it for all the
+ *  neighbours.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] params_p - aging parameters, age_time 0 turns aging
+ *       off
+ * @param[in,out] router_neigh_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_NO_MEMORY if the router reached its memory limit.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_neigh_age_params_set(const unsigned int vrid,
+                                    const struct oes_router_neigh_age_params *params_p,
+                                    void *router_neigh_vs_ext)
+{
+    struct oes_router_neigh_table *table_p;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned long long now;
+    unsigned int idx;
+
+    if ((params_p == NULL) || (params_p->jitter > OES_ROUTER_AGE_JITTER_MAX) ||
+        (params_p->age_time && params_p->refresh_cnt && (params_p->refresh_interval == 0))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+        goto out;
+    }
+    table_p = &vr_p->neigh_table;
+    oes_router_age_wheel_deinit(&vr_p->age_wheel, table_p);
+    memset(&vr_p->age_params, 0, sizeof(vr_p->age_params));
+    if (params_p->age_time == 0) {
+        goto out;
+    }
+    now = oes_router_age_now();
+    status = oes_router_age_wheel_init(&vr_p->age_wheel, &vr_p->neigh_pool,
+                                       (params_p->age_time > params_p->refresh_interval) ?
+                                       params_p->age_time : params_p->refresh_interval,
+                                       now ^ ((unsigned long long)vrid << 32));
+    if (status != OES_STATUS_SUCCESS) {
+        goto out;
+    }
+    vr_p->age_params = *params_p;
+    for (idx = 0; idx < table_p->neigh_size; idx++) {
+        if (table_p->neighs[idx].resolved) {
+            oes_router_neigh_age_start(vr_p, &table_p->neighs[idx], now);
+        }
+    }
+
+out:
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function gets the neighbour aging of a virtual router.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[out] params_p - aging parameters
+ * @param[in,out] router_neigh_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_neigh_age_params_get(const unsigned int vrid,
+                                    struct oes_router_neigh_age_params *params_p,
+                                    void *router_neigh_vs_ext)
+{
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if (params_p == NULL) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else {
+        *params_p = vr_p->age_params;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function runs the neighbour aging of a virtual router
+ *  up to the current time. It is called periodically, as often
+ *  as the refresh events should be accurate; it only looks at
+ *  the neighbours due since the last call.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[out] aged_cnt_p - neighbours deleted
+ * @param[in,out] router_neigh_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_neigh_age_process(const unsigned int vrid,
+                                 unsigned int *aged_cnt_p,
+                                 void *router_neigh_vs_ext)
+{
+    struct oes_router_neigh *due_list[OES_ROUTER_AGE_BATCH];
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned long long now;
+    unsigned int cnt, i;
+
+    if (aged_cnt_p == NULL) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    *aged_cnt_p = 0;
+
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else {
+        now = oes_router_age_now();
+        do {
+            cnt = oes_router_age_expire(&vr_p->age_wheel, &vr_p->neigh_table, now,
+                                        due_list, OES_ROUTER_AGE_BATCH);
+            for (i = 0; i < cnt; i++) {
+                *aged_cnt_p += oes_router_neigh_age(vr_p, vrid, due_list[i], now);
+            }
+        } while (cnt == OES_ROUTER_AGE_BATCH);
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function adds/deletes an unicast route into the routing
+ *  table. The route is composed of network address and next hop
+ *  array which may contains more than one entry for ECMP. In
+ *  case the neigh, entry is not known yet,the route will be
+ *  added with action TRAP . Upon neigh entry resolved and
+ *  configured, the route is modified into FORWARD: a FORWARD
+ *  route traps while none of its next hops has a neighbour,
+ *  oes_api_router_neigh_set updates it without the route being
+ *  set again. Calling
+ *  with SET cmd will replace all next hop entries associated
+ *  with the route. (If the route does not exist, it will be
+ *  created).
+ *  
+ * @param[in] access_cmd - ADD/DELETE/DELETE ALL .
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] uc_route_key_p - IP network address+prefix len 
+ * @param[in] uc_route_data_p - routing table data including 
+ *       action(tarp,drop,forward),next-hop list
+ * @param[in,out] router_uc_route_vs_ext- vendor specific 
+ *       extension
+ *  
+ * @return OES_STATUS_SUCCESS if operation completes successfully. 
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_NO_RESOURCES if no routes is available to create.
+ * @return OES_STATUS_NO_MEMORY if the router reached its memory limit.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_uc_route_set(const enum oes_access_cmd access_cmd,
+                            const unsigned int vrid,
+                            const struct oes_ip_prefix *uc_route_key_p,
+                            const struct oes_uc_route_data *uc_route_data_p,
+                            void *router_uc_route_vs_ext)
+{
+    struct oes_router_fib *fib_p;
+    struct oes_router_vr *vr_p;
+    struct oes_ip_prefix key;
+    oes_status_e status;
+
+    if ((access_cmd != OES_ACCESS_CMD_DELETE_ALL) &&
+        ((uc_route_key_p == NULL) || !oes_router_prefix_normalize(uc_route_key_p, &key))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+        goto out;
+    }
+
+    switch (access_cmd) {
+    case OES_ACCESS_CMD_ADD:
+    case OES_ACCESS_CMD_EDIT:
+        status = oes_router_uc_route_add(vr_p, access_cmd, &key, uc_route_data_p);
+        break;
+
+    case OES_ACCESS_CMD_DELETE:
+        status = oes_router_uc_route_delete(vr_p, &key);
+        break;
+
+    case OES_ACCESS_CMD_DELETE_ALL:
+        /* lookups miss at once, rather than see the FIB emptied, the next route creates a new one */
+        fib_p = __atomic_exchange_n(&vr_p->fib, NULL, __ATOMIC_ACQ_REL);
+        oes_router_rcu_barrier();
+        oes_router_vr_routes_flush(vr_p);
+        oes_router_fib_destroy(vr_p, fib_p);
+        status = OES_STATUS_SUCCESS;
+        break;
+
+    default:
+        status = OES_STATUS_CMD_UNSUPPORTED;
+        break;
+    }
+    oes_router_rcu_reclaim();
+
+out:
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function opens, commits or aborts a bulk load of the
+ *  unicast routing table of a virtual router. While a bulk load
+ *  is open, routes added by oes_api_router_uc_route_set are
+ *  staged: they are stored and oes_api_router_uc_route_get
+ *  returns them, but lookups do not see them until the commit
+ *  builds them all into the LPM at once, on several threads.
+ *  Routes deleted while staged never reach the LPM, deletes of
+ *  the routes installed before take effect immediately.
+ *
+ * @param[in] access_cmd - CREATE opens, APPLY commits, DESTROY
+ *       aborts the bulk load and drops the staged routes.
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in,out] router_uc_route_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR if a bulk load is already open at
+ *         CREATE, or none is at APPLY and DESTROY.
+ * @return OES_STATUS_NO_MEMORY, OES_STATUS_NO_RESOURCES if some
+ *         staged routes could not be built into the LPM, they are
+ *         removed from the table.
+ */
+oes_status_e
+oes_api_router_uc_route_bulk_set(const enum oes_access_cmd access_cmd,
+                                 const unsigned int vrid,
+                                 void *router_uc_route_vs_ext)
+{
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+        goto out;
+    }
+
+    switch (access_cmd) {
+    case OES_ACCESS_CMD_CREATE:
+        if (vr_p->bulk) {
+            status = OES_STATUS_ERROR;
+            break;
+        }
+        vr_p->bulk = 1;
+        break;
+
+    case OES_ACCESS_CMD_APPLY:
+        status = vr_p->bulk ? oes_router_bulk_commit(vr_p) : OES_STATUS_ERROR;
+        break;
+
+    case OES_ACCESS_CMD_DESTROY:
+        if (!vr_p->bulk) {
+            status = OES_STATUS_ERROR;
+            break;
+        }
+        oes_router_bulk_abort(vr_p);
+        break;
+
+    default:
+        status = OES_STATUS_CMD_UNSUPPORTED;
+        break;
+    }
+    oes_router_rcu_reclaim();
+
+out:
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/* next hops are copied into the caller's next_hop_list, up to next_hop_cnt */
+static void
+oes_router_route_data_get(const struct oes_router_vr *vr_p,
+                          const struct oes_router_route *route_p,
+                          struct oes_uc_route_data *data_p)
+{
+    struct oes_router_nhg *nhg_p;
+
+    data_p->action = oes_router_route_action(route_p);
+    data_p->activity = 0;
+    data_p->ecmp_bucket_cnt = 0;
+    data_p->ecmp_idle_timer = 0;
+    if (oes_router_route_nhg(route_p) == OES_ROUTER_NEXT_HOP_GROUP_INVALID) {
+        data_p->next_hop_cnt = 0;
+        return;
+    }
+    nhg_p = oes_router_nhg_find(&vr_p->nhg_table, oes_router_route_nhg(route_p));
+    if ((data_p->next_hop_list != NULL) && data_p->next_hop_cnt) {
+        memcpy(data_p->next_hop_list, nhg_p->next_hop_list,
+               ((data_p->next_hop_cnt < nhg_p->next_hop_cnt) ?
+                data_p->next_hop_cnt : nhg_p->next_hop_cnt) * sizeof(struct oes_ip_addr));
+    }
+    data_p->next_hop_cnt = nhg_p->next_hop_cnt;
+    data_p->ecmp_bucket_cnt = nhg_p->bucket_cnt;
+    data_p->ecmp_idle_timer = nhg_p->idle_timer;
+}
+
+/*
+ * Sorts the routes of a VR the first time they are paged
+ * through, under the write lock. Route updates keep the order
+ * from then on, until the routes are flushed.
+ */
+static oes_status_e
+oes_router_route_order_build(struct oes_router_vr *vr_p)
+{
+    unsigned int *idx_list_p;
+    unsigned int idx, cnt = 0;
+    oes_status_e status;
+
+    if (vr_p->route_ordered) {
+        return OES_STATUS_SUCCESS;
+    }
+    idx_list_p = malloc((vr_p->route_cnt ? vr_p->route_cnt : 1) * sizeof(*idx_list_p));
+    if (idx_list_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    for (idx = 0; idx < vr_p->route_hwm; idx++) {
+        if (oes_router_route_get(vr_p, idx)->in_use) {
+            idx_list_p[cnt++] = idx;
+        }
+    }
+    status = oes_router_order_build(&vr_p->route_order, idx_list_p, cnt);
+    free(idx_list_p);
+    if (status == OES_STATUS_SUCCESS) {
+        vr_p->route_ordered = 1;
+    }
+    return status;
+}
+
+/* copies the routes after a key, in key order, a leaf's worth at a time */
+static unsigned int
+oes_router_route_list(const struct oes_router_vr *vr_p,
+                      const struct oes_ip_prefix *after_p,
+                      struct oes_ip_prefix *key_list_p,
+                      struct oes_uc_route_data *data_list_p,
+                      const unsigned int cnt)
+{
+    unsigned int idx_list[OES_ROUTER_ORDER_LEAF];
+    const struct oes_router_route *route_p;
+    unsigned int listed = 0, n, i;
+
+    while (listed < cnt) {
+        n = oes_router_order_list(&vr_p->route_order, after_p, idx_list,
+                                  (cnt - listed < OES_ROUTER_ORDER_LEAF) ? cnt - listed : OES_ROUTER_ORDER_LEAF);
+        for (i = 0; i < n; i++) {
+            route_p = oes_router_route_get(vr_p, idx_list[i]);
+            key_list_p[listed + i] = route_p->key;
+            oes_router_route_data_get(vr_p, route_p, &data_list_p[listed + i]);
+        }
+        listed += n;
+        if (n < OES_ROUTER_ORDER_LEAF) {
+            break;
+        }
+        after_p = &key_list_p[listed - 1];
+    }
+    return listed;
+}
+
+/**
+ * This function gets unicast route entires from the SDK The 
+ * function can receive three types of input: 
+ *     1) get information for specific  unicast route,user
+ *      should insert the certain unicast route as the first
+ *      uc_route_key element in the uc_route_key array ,
+ *      uc_route_cnt should be equal to 1,
+ *      access_cmd should be OES_ACCESS_CMD_GET
+ *
+ *   - 2) get a list of first n unicast routes ,user
+ *      should provide an empty uc_route_key  array uc_route_cnt
+ *      should be equal to n,access_cmd should be
+ *      OES_ACCESS_CMD_GET_FIRST
+ *
+ *   - 3) get a list of n  unicast routes which comes after
+ *      certain unicast route (it does not have to exist) user
+ *      should insert the certain unicast route as the first
+ *      uc_route_key element in the uc_route_key array ,
+ *      uc_route_cnt should be equal to n,
+ *      access_cmd should be OES_ACCESS_CMD_GET_NEXT
+ *
+ *  Routes are listed by IP version, address, then prefix
+ *  length. The first GET_FIRST or GET_NEXT of a virtual router
+ *  sorts its routes once, and route updates keep them sorted,
+ *  so each page costs a logarithmic seek and the copy of its
+ *  routes. uc_route_cnt is set to the number of routes listed.
+ *  
+ * @param[in] access_cmd - GET/GET NEXT/GET FIRST.
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in,out] uc_route_key_list_p  - IP network 
+ *       address+prefix len array
+ * @param[out] uc_route_data_list_p - routing table data 
+ *       including action(tarp,drop,forward),next-hop list array,
+ *       the action as set rather than the one in effect
+ * @param[in,out] uc_route_cnt_p - array size 
+ * @param[in,out] router_uc_route_vs_ext- vendor specific 
+ *       extension
+ *  
+ * @return OES_STATUS_SUCCESS if operation completes successfully. 
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if GET finds no such route.
+ * @return OES_STATUS_NO_MEMORY if the routes cannot be sorted.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_uc_route_get(const enum oes_access_cmd access_cmd,
+                            const unsigned int vrid,
+                            struct oes_ip_prefix *uc_route_key_list_p,
+                            struct oes_uc_route_data *uc_route_data_list_p,
+                            unsigned short *uc_route_cnt_p,
+                            void *router_uc_route_vs_ext)
+{
+    struct oes_router_vr *vr_p;
+    struct oes_ip_prefix key;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned int idx;
+
+    if ((uc_route_key_list_p == NULL) || (uc_route_data_list_p == NULL) || (uc_route_cnt_p == NULL)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    switch (access_cmd) {
+    case OES_ACCESS_CMD_GET:
+        if ((*uc_route_cnt_p != 1) || !oes_router_prefix_normalize(uc_route_key_list_p, &key)) {
+            return OES_STATUS_PARAM_ERROR;
+        }
+        break;
+
+    case OES_ACCESS_CMD_GET_NEXT:
+    case OES_ACCESS_CMD_GET_FIRST:
+        if ((access_cmd == OES_ACCESS_CMD_GET_NEXT) && !oes_router_prefix_normalize(uc_route_key_list_p, &key)) {
+            return OES_STATUS_PARAM_ERROR;
+        }
+        break;
+
+    default:
+        return OES_STATUS_CMD_UNSUPPORTED;
+    }
+
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if ((vr_p != NULL) && (access_cmd != OES_ACCESS_CMD_GET) && !vr_p->route_ordered) {
+        pthread_rwlock_unlock(&oes_router_db.lock);
+        pthread_rwlock_wrlock(&oes_router_db.lock);
+        vr_p = oes_router_vr_get(vrid);
+        if (vr_p != NULL) {
+            status = oes_router_route_order_build(vr_p);
+        }
+    }
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if (access_cmd == OES_ACCESS_CMD_GET) {
+        if (!oes_router_route_find(vr_p, &key, &idx)) {
+            status = OES_STATUS_ENTRY_NOT_FOUND;
+        } else {
+            oes_router_route_data_get(vr_p, oes_router_route_get(vr_p, idx), uc_route_data_list_p);
+        }
+    } else if (status == OES_STATUS_SUCCESS) {
+        /* the routes after the one given, which need not exist */
+        *uc_route_cnt_p = oes_router_route_list(vr_p, (access_cmd == OES_ACCESS_CMD_GET_NEXT) ? &key : NULL,
+                                                uc_route_key_list_p, uc_route_data_list_p, *uc_route_cnt_p);
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function looks up the longest prefix match of an
+ *  address in the unicast routing table of a virtual router.
+ *  Lookups do not wait for route updates: a route added,
+ *  replaced or deleted meanwhile is seen either before or
+ *  after the update.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] addr_p - IP address to look up
+ * @param[out] lookup_p - matched route action in effect, prefix
+ *       length and next-hop group
+ * @param[in,out] router_uc_route_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if no route matches the address.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_uc_route_lookup(const unsigned int vrid,
+                               const struct oes_ip_addr *addr_p,
+                               struct oes_uc_route_lookup *lookup_p,
+                               void *router_uc_route_vs_ext)
+{
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned int depth, idx;
+    int rcu;
+
+    if ((addr_p == NULL) || (lookup_p == NULL) ||
+        ((addr_p->version != OES_IPV4) && (addr_p->version != OES_IPV6))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    oes_router_lookup_clear(lookup_p);
+    rcu = oes_router_lookup_begin();
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+        goto out;
+    }
+    if (!oes_router_fib_lookup(__atomic_load_n(&vr_p->fib, __ATOMIC_ACQUIRE), addr_p, &depth, &idx)) {
+        status = OES_STATUS_ENTRY_NOT_FOUND;
+    } else {
+        oes_router_lookup_set(vr_p, lookup_p, depth, idx);
+    }
+
+out:
+    oes_router_lookup_end(rcu);
+    return status;
+}
+
+/**
+ *  This function looks up the longest prefix match of a list of
+ *  addresses, of either IP version, in the unicast routing table
+ *  of a virtual router. The lookups of the list are interleaved
+ *  so that their memory accesses overlap, lists of fewer than
+ *  three addresses are looked up one by one. Addresses no route
+ *  matches get a result with valid cleared. Like single
+ *  lookups, they run alongside route updates.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] addr_list_p - IP address array
+ * @param[out] lookup_list_p - lookup result array, one per
+ *       address
+ * @param[in] addr_cnt - array size
+ * @param[in,out] router_uc_route_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_uc_route_lookup_batch(const unsigned int vrid,
+                                     const struct oes_ip_addr *addr_list_p,
+                                     struct oes_uc_route_lookup *lookup_list_p,
+                                     const unsigned int addr_cnt,
+                                     void *router_uc_route_vs_ext)
+{
+    const struct in6_addr *addr6_list[OES_ROUTER_LPM_BULK_MAX], *tree4_list[OES_ROUTER_LPM_BULK_MAX];
+    struct in6_addr tree4_addr_list[OES_ROUTER_LPM_BULK_MAX];
+    unsigned int addr4_list[OES_ROUTER_LPM_BULK_MAX];
+    unsigned char depth4_list[OES_ROUTER_LPM_BULK_MAX], depth6_list[OES_ROUTER_LPM_BULK_MAX];
+    unsigned int value4_list[OES_ROUTER_LPM_BULK_MAX], value6_list[OES_ROUTER_LPM_BULK_MAX];
+    unsigned short idx4_list[OES_ROUTER_LPM_BULK_MAX], idx6_list[OES_ROUTER_LPM_BULK_MAX];
+    unsigned int base, cnt, cnt4, cnt6, i;
+    const struct oes_router_fib *fib_p;
+    const struct oes_router_lpm4 *lpm4_p;
+    const struct oes_router_lpm6 *lpm6_p, *tree4_p;
+    struct oes_router_vr *vr_p;
+    unsigned int depth, idx;
+    int rcu;
+
+    if ((addr_cnt > 0) && ((addr_list_p == NULL) || (lookup_list_p == NULL))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    rcu = oes_router_lookup_begin();
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        oes_router_lookup_end(rcu);
+        return OES_STATUS_PARAM_ERROR;
+    }
+    fib_p = __atomic_load_n(&vr_p->fib, __ATOMIC_ACQUIRE);
+
+    /* too few lookups to overlap, the interleaving only costs */
+    if (addr_cnt < OES_ROUTER_LOOKUP_BATCH_MIN) {
+        for (i = 0; i < addr_cnt; i++) {
+            oes_router_lookup_clear(&lookup_list_p[i]);
+            if (((addr_list_p[i].version == OES_IPV4) || (addr_list_p[i].version == OES_IPV6)) &&
+                oes_router_fib_lookup(fib_p, &addr_list_p[i], &depth, &idx)) {
+                oes_router_lookup_set(vr_p, &lookup_list_p[i], depth, idx);
+            }
+        }
+        oes_router_lookup_end(rcu);
+        return OES_STATUS_SUCCESS;
+    }
+
+    /* no FIB yet has no routes, its addresses keep the cleared result */
+    lpm4_p = ((fib_p != NULL) && (__atomic_load_n(&fib_p->lpm4.tbl24, __ATOMIC_ACQUIRE) != NULL)) ?
+             &fib_p->lpm4 : NULL;
+    tree4_p = ((fib_p != NULL) && (lpm4_p == NULL)) ? &fib_p->tree4 : NULL;
+    lpm6_p = (fib_p != NULL) ? &fib_p->lpm6 : NULL;
+
+    for (base = 0; base < addr_cnt; base += cnt) {
+        cnt = addr_cnt - base;
+        if (cnt > OES_ROUTER_LPM_BULK_MAX) {
+            cnt = OES_ROUTER_LPM_BULK_MAX;
+        }
+        cnt4 = 0;
+        cnt6 = 0;
+        for (i = 0; i < cnt; i++) {
+            oes_router_lookup_clear(&lookup_list_p[base + i]);
+            if ((addr_list_p[base + i].version == OES_IPV4) && (fib_p != NULL)) {
+                idx4_list[cnt4] = i;
+                addr4_list[cnt4] = ntohl(addr_list_p[base + i].addr.ipv4.s_addr);
+                if (tree4_p != NULL) {
+                    oes_router_tree4_addr(&tree4_addr_list[cnt4], addr4_list[cnt4]);
+                    tree4_list[cnt4] = &tree4_addr_list[cnt4];
+                }
+                cnt4++;
+            } else if ((addr_list_p[base + i].version == OES_IPV6) && (lpm6_p != NULL)) {
+                idx6_list[cnt6] = i;
+                addr6_list[cnt6++] = &addr_list_p[base + i].addr.ipv6;
+            }
+        }
+        if (cnt4 && (tree4_p != NULL)) {
+            oes_router_lpm6_lookup_bulk(tree4_p, tree4_list, cnt4, depth4_list, value4_list);
+        } else if (cnt4) {
+            oes_router_lpm4_lookup_bulk(lpm4_p, addr4_list, cnt4, depth4_list, value4_list);
+        }
+        if (cnt6) {
+            oes_router_lpm6_lookup_bulk(lpm6_p, addr6_list, cnt6, depth6_list, value6_list);
+        }
+
+        /* route records are one more dependent access, overlap them too */
+        for (i = 0; i < cnt4; i++) {
+            if (depth4_list[i] != OES_ROUTER_LPM_MISS) {
+                __builtin_prefetch(oes_router_route_get(vr_p, value4_list[i]));
+            }
+        }
+        for (i = 0; i < cnt6; i++) {
+            if (depth6_list[i] != OES_ROUTER_LPM_MISS) {
+                __builtin_prefetch(oes_router_route_get(vr_p, value6_list[i]));
+            }
+        }
+        for (i = 0; i < cnt4; i++) {
+            if (depth4_list[i] != OES_ROUTER_LPM_MISS) {
+                oes_router_lookup_set(vr_p, &lookup_list_p[base + idx4_list[i]],
+                                      depth4_list[i], value4_list[i]);
+            }
+        }
+        for (i = 0; i < cnt6; i++) {
+            if (depth6_list[i] != OES_ROUTER_LPM_MISS) {
+                oes_router_lookup_set(vr_p, &lookup_list_p[base + idx6_list[i]],
+                                      depth6_list[i], value6_list[i]);
+            }
+        }
+    }
+    oes_router_lookup_end(rcu);
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ *  This function gets the next hops of a next-hop group
+ *  returned by a route lookup. When next_hop_cnt is 0, the API
+ *  will return the number of next hops and next_hop_list will
+ *  remain empty.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] next_hop_group - next-hop group ID
+ * @param[out] next_hop_list_p - next hop array
+ * @param[in,out] next_hop_cnt_p - next hop array size
+ * @param[in,out] router_next_hop_group_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if the group does not exist.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_next_hop_group_get(const unsigned int vrid,
+                                  const unsigned int next_hop_group,
+                                  struct oes_ip_addr *next_hop_list_p,
+                                  unsigned short *next_hop_cnt_p,
+                                  void *router_next_hop_group_vs_ext)
+{
+    struct oes_router_nhg *nhg_p;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if ((next_hop_cnt_p == NULL) || (*next_hop_cnt_p && (next_hop_list_p == NULL))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if ((nhg_p = oes_router_nhg_find(&vr_p->nhg_table, next_hop_group)) == NULL) {
+        status = OES_STATUS_ENTRY_NOT_FOUND;
+    } else {
+        if (*next_hop_cnt_p) {
+            memcpy(next_hop_list_p, nhg_p->next_hop_list,
+                   ((*next_hop_cnt_p < nhg_p->next_hop_cnt) ? *next_hop_cnt_p : nhg_p->next_hop_cnt) *
+                   sizeof(*next_hop_list_p));
+        }
+        *next_hop_cnt_p = nhg_p->next_hop_cnt;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function changes the members of a next-hop group. The
+ *  group is shared by all the routes with the same next hops,
+ *  so the change applies to all of them at once, in a time
+ *  independent of their number.
+ *
+ * @param[in] access_cmd - ADD/DELETE/EDIT next hops.
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] next_hop_group - next-hop group ID
+ * @param[in] next_hop_list_p - next hops to add, delete or set
+ * @param[in] next_hop_cnt - number of next hops
+ * @param[in,out] router_next_hop_group_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid,
+ *         if the group would be left without next hops, or with a
+ *         next hop twice or next hops of both IP versions.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if the group or a deleted
+ *         next hop does not exist.
+ * @return OES_STATUS_NO_MEMORY if the next hops cannot be stored.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_next_hop_group_set(const enum oes_access_cmd access_cmd,
+                                  const unsigned int vrid,
+                                  const unsigned int next_hop_group,
+                                  const struct oes_ip_addr *next_hop_list_p,
+                                  const unsigned short next_hop_cnt,
+                                  void *router_next_hop_group_vs_ext)
+{
+    struct oes_router_nhg *nhg_p;
+    struct oes_router_vr *vr_p;
+    oes_status_e status, link_status;
+
+    if (next_hop_cnt && (next_hop_list_p == NULL)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    nhg_p = (vr_p != NULL) ? oes_router_nhg_find(&vr_p->nhg_table, next_hop_group) : NULL;
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if (nhg_p == NULL) {
+        status = OES_STATUS_ENTRY_NOT_FOUND;
+    } else {
+        /* the group is linked again to the neighbors of its new members, which sets its action */
+        oes_router_nhg_unlink(vr_p, next_hop_group);
+        status = oes_router_nhg_members_set(&vr_p->nhg_table, access_cmd, next_hop_group,
+                                            next_hop_list_p, next_hop_cnt);
+        link_status = oes_router_nhg_link(vr_p, next_hop_group);
+        status = (status != OES_STATUS_SUCCESS) ? status : link_status;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function gets the number of buckets each next hop of a
+ *  resilient next-hop group holds, in the order of the list
+ *  oes_api_router_next_hop_group_get returns. When next_hop_cnt
+ *  is 0, the API will return the number of next hops only.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] next_hop_group - next-hop group ID
+ * @param[out] bucket_cnt_list_p - buckets per next hop
+ * @param[in,out] next_hop_cnt_p - array size
+ * @param[in,out] router_next_hop_group_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid,
+ *         or if the group does not use resilient hashing.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if the group does not exist.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_next_hop_group_buckets_get(const unsigned int vrid,
+                                          const unsigned int next_hop_group,
+                                          unsigned short *bucket_cnt_list_p,
+                                          unsigned short *next_hop_cnt_p,
+                                          void *router_next_hop_group_vs_ext)
+{
+    struct oes_router_nhg *nhg_p;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned int i;
+
+    if ((next_hop_cnt_p == NULL) || (*next_hop_cnt_p && (bucket_cnt_list_p == NULL))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if ((nhg_p = oes_router_nhg_find(&vr_p->nhg_table, next_hop_group)) == NULL) {
+        status = OES_STATUS_ENTRY_NOT_FOUND;
+    } else if (nhg_p->bucket_cnt == 0) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else {
+        for (i = 0; (i < *next_hop_cnt_p) && (i < nhg_p->next_hop_cnt); i++) {
+            bucket_cnt_list_p[i] = __atomic_load_n(&nhg_p->occupancy[i], __ATOMIC_RELAXED);
+        }
+        *next_hop_cnt_p = nhg_p->next_hop_cnt;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ *  This function allocates/deallocates a router interface
+ *  counter. The counter has a cache line per CPU, so that the
+ *  data path of each CPU counts on a line of its own.
+ *
+ * @param[in] access_cmd - ADD /DELETE . 
+ * @param[in] vrid - Virtual Router ID. 
+ * @param[in] rif - Router Interface ID.
+ * @param[in,out] router_cntr_alloc_vs_ext- vendor specific 
+ *       extension
+ *  
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_ERROR f any input parameter is 
+ *         invalid.
+ * @return OES_STATUS_ENTRY_ALREADY_EXISTS if the counter is
+ *         already allocated.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if the counter to
+ *         deallocate is not allocated.
+ * @return OES_STATUS_NO_MEMORY if the router reached its memory
+ *         limit.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_interface_cntr_enable_set(const enum oes_access_cmd access_cmd,
+                                         const unsigned int vrid,
+                                         const unsigned int rif,
+                                         void *router_interface_cntr_vs_ext)
+{
+    struct oes_router_vr *vr_p;
+    oes_status_e status;
+
+    if ((access_cmd != OES_ACCESS_CMD_ADD) && (access_cmd != OES_ACCESS_CMD_DELETE)) {
+        return OES_STATUS_CMD_UNSUPPORTED;
+    }
+    if (rif == OES_ROUTER_INTERFACE_INVALID) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if (access_cmd == OES_ACCESS_CMD_ADD) {
+        status = (oes_router_vr_rif_get(vrid, rif) != NULL) ? oes_router_cntr_enable(&vr_p->cntr_table, rif) :
+                 OES_STATUS_PARAM_ERROR;
+    } else {
+        status = oes_router_cntr_disable(&vr_p->cntr_table, rif);
+    }
+    oes_router_rcu_reclaim();
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ * This function reads router interface counter, the sum of the
+ * lines of all the CPUs. READ CLEAR does not write the lines the
+ * data path counts on: the sums it reads become the baseline
+ * later reads start from.
+ *
+ * @param[in] access_cmd - READ/READ CLEAR. 
+ * @param[in] vrid - Virtual Router ID. 
+ * @param[in] rif - Router Interface ID. 
+ * @param[out]cntr_p - Router Interface counter extension 
+ * @param[in,out] router_cntr_alloc_vs_ext- vendor specific 
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully. 
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid. 
+ * @return OES_STATUS_ENTRY_NOT_FOUND if the counter is not allocated.
+ * @return OES_STATUS_CMD_UNSUPPORTED if access command isn't supported.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_interface_cntr_get(const enum oes_access_cmd access_cmd,
+                                  const unsigned int vrid,
+                                  const unsigned int rif,
+                                  struct oes_router_cntr *cntr_p,
+                                  void *router_interface_cntr_vs_ext)
+{
+    struct oes_router_rif_cntr *rif_cntr_p;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if ((access_cmd != OES_ACCESS_CMD_READ) && (access_cmd != OES_ACCESS_CMD_READ_CLEAR)) {
+        return OES_STATUS_CMD_UNSUPPORTED;
+    }
+    if (cntr_p == NULL) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    /* a clear writes the baseline, clears are serialized */
+    if (access_cmd == OES_ACCESS_CMD_READ_CLEAR) {
+        pthread_rwlock_wrlock(&oes_router_db.lock);
+    } else {
+        pthread_rwlock_rdlock(&oes_router_db.lock);
+    }
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if ((rif_cntr_p = oes_router_cntr_find(&vr_p->cntr_table, rif)) == NULL) {
+        status = OES_STATUS_ENTRY_NOT_FOUND;
+    } else {
+        oes_router_cntr_read(&vr_p->cntr_table, rif_cntr_p, access_cmd == OES_ACCESS_CMD_READ_CLEAR, cntr_p);
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+ * This function counts packets of a router interface, for a
+ * software data path. They are added to the counter line of the
+ * CPU it runs on, without the router lock, alongside the reads.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] rif - Router Interface ID.
+ * @param[in] cntr_p - packets and bytes to add
+ * @param[in,out] router_interface_cntr_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if the counter is not allocated.
+ */
+oes_status_e
+oes_api_router_interface_cntr_update(const unsigned int vrid,
+                                     const unsigned int rif,
+                                     const struct oes_router_cntr *cntr_p,
+                                     void *router_interface_cntr_vs_ext)
+{
+    struct oes_router_rif_cntr *rif_cntr_p;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    int rcu;
+
+    if (cntr_p == NULL) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    rcu = oes_router_lookup_begin();
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if ((rif_cntr_p = oes_router_cntr_find(&vr_p->cntr_table, rif)) == NULL) {
+        status = OES_STATUS_ENTRY_NOT_FOUND;
+    } else {
+        oes_router_cntr_add(&vr_p->cntr_table, rif_cntr_p, cntr_p);
+    }
+    oes_router_lookup_end(rcu);
+    return status;
+}
+
+/**
+ * This function reads the counters of the router interfaces of
+ * a virtual router, in ascending rif order, from first_rif on.
+ * When *rif_cnt_p is 0, it only returns the number of counters
+ * allocated from first_rif on. Otherwise up to *rif_cnt_p
+ * counters are read like oes_api_router_interface_cntr_get(),
+ * and *rif_cnt_p is set to the number read; reading again from
+ * the last rif + 1 continues the list.
+ *
+ * @param[in] access_cmd - READ/READ CLEAR.
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] first_rif - Router Interface ID to start from.
+ * @param[out] rif_list_p - Router Interface IDs
+ * @param[out] cntr_list_p - their counters
+ * @param[in,out] rif_cnt_p - array size, then number read
+ * @param[in,out] router_interface_cntr_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_CMD_UNSUPPORTED if access command isn't supported.
+ */
+oes_status_e
+oes_api_router_interface_cntr_bulk_get(const enum oes_access_cmd access_cmd,
+                                       const unsigned int vrid,
+                                       const unsigned int first_rif,
+                                       unsigned int *rif_list_p,
+                                       struct oes_router_cntr *cntr_list_p,
+                                       unsigned int *rif_cnt_p,
+                                       void *router_interface_cntr_vs_ext)
+{
+    struct oes_router_rif_cntr *rif_cntr_p;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned int cnt = 0;
+
+    if ((access_cmd != OES_ACCESS_CMD_READ) && (access_cmd != OES_ACCESS_CMD_READ_CLEAR)) {
+        return OES_STATUS_CMD_UNSUPPORTED;
+    }
+    if ((rif_cnt_p == NULL) || (*rif_cnt_p && ((rif_list_p == NULL) || (cntr_list_p == NULL)))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    if ((access_cmd == OES_ACCESS_CMD_READ_CLEAR) && *rif_cnt_p) {
+        pthread_rwlock_wrlock(&oes_router_db.lock);
+    } else {
+        pthread_rwlock_rdlock(&oes_router_db.lock);
+    }
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+        goto out;
+    }
+    if (*rif_cnt_p == 0) {
+        for (rif_cntr_p = oes_router_cntr_next(&vr_p->cntr_table, first_rif); rif_cntr_p != NULL;
+             rif_cntr_p = oes_router_cntr_next(&vr_p->cntr_table, rif_cntr_p->rif + 1)) {
+            cnt++;
+        }
+        *rif_cnt_p = cnt;
+        goto out;
+    }
+    for (rif_cntr_p = oes_router_cntr_next(&vr_p->cntr_table, first_rif); (rif_cntr_p != NULL) && (cnt < *rif_cnt_p);
+         rif_cntr_p = oes_router_cntr_next(&vr_p->cntr_table, rif_cntr_p->rif + 1), cnt++) {
+        rif_list_p[cnt] = rif_cntr_p->rif;
+        oes_router_cntr_read(&vr_p->cntr_table, rif_cntr_p, access_cmd == OES_ACCESS_CMD_READ_CLEAR,
+                             &cntr_list_p[cnt]);
+    }
+    *rif_cnt_p = cnt;
+
+out:
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+*  This function adds/ deletes a multicast route into/from the
+*  MC routing table. Routes are hashed on (sender, group,
+*  ingress rif); a (*,G) route with ingress rif
+*  OES_ROUTER_INTERFACE_INVALID takes the packets of any ingress
+*  interface. ADD replaces the action and egress rif list of a
+*  route which exists, EDIT only changes an existing one.
+*  DELETE_ALL frees the table of the vrid at once. Routes with
+*  the same egress rifs share one copy of the list.
+* 
+* @param[in] access_cmd - ADD/EDIT/DELETE/DELETE_ALL
+*       	   DELETE_ALL command deletes all multicast routes associated
+*       	   with vrid.
+* @param[in] vrid - Virtual Router ID.
+* @param[in] mc_route_key_p - group ip, sender IP, ingress rif 
+*       (in order to configure *.G rule sender IP should be
+*       0.0.0.0)
+* @param[in] mc_route_data_p -mc route action , egress rif list 
+* @param[in,out] router_mc_route_vs_ext- vendor specific 
+*       extension      
+*
+* @return OES_STATUS_SUCCESS if operation completes successfully. 
+* @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+* @return OES_STATUS_ENTRY_NOT_FOUND if the route to edit or delete does not exist.
+* @return OES_STATUS_NO_MEMORY if the router reached its memory limit.
+* @return OES_STATUS_ERROR general error.
+*/
+oes_status_e
+oes_api_router_mc_route_set(const enum oes_access_cmd access_cmd,
+                            const unsigned int vrid,
+                            const struct oes_mc_route_key *mc_route_key_p,
+                            const struct oes_mc_route_data *mc_route_data_p,
+                            void *router_mc_route_vs_ext)
+{
+    struct oes_router_mc_route *route_p;
+    struct oes_router_mc_key key;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    int created = 0;
+
+    if ((access_cmd != OES_ACCESS_CMD_DELETE_ALL) && !oes_router_mc_key_get(mc_route_key_p, &key)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    if (((access_cmd == OES_ACCESS_CMD_ADD) || (access_cmd == OES_ACCESS_CMD_EDIT)) &&
+        ((mc_route_data_p == NULL) || (mc_route_data_p->action.action > OES_ROUTER_ACTION_FORWARD) ||
+         (mc_route_data_p->rif_cnt && (mc_route_data_p->rif_list == NULL)))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+        goto out;
+    }
+
+    switch (access_cmd) {
+    case OES_ACCESS_CMD_ADD:
+    case OES_ACCESS_CMD_EDIT:
+        if (((key.ingress_rif != OES_ROUTER_INTERFACE_INVALID) &&
+             (oes_router_vr_rif_get(vrid, key.ingress_rif) == NULL)) ||
+            !oes_router_vr_rifs_valid(vrid, mc_route_data_p->rif_list, mc_route_data_p->rif_cnt)) {
+            status = OES_STATUS_PARAM_ERROR;
+            break;
+        }
+        route_p = oes_router_mc_find(&vr_p->mc_table, &key);
+        if (route_p == NULL) {
+            if (access_cmd == OES_ACCESS_CMD_EDIT) {
+                status = OES_STATUS_ENTRY_NOT_FOUND;
+                break;
+            }
+            status = oes_router_mc_add(&vr_p->mc_table, &key, &route_p);
+            if (status != OES_STATUS_SUCCESS) {
+                break;
+            }
+            created = 1;
+        }
+        status = oes_router_mc_rifs_set(&vr_p->mc_table, route_p, mc_route_data_p->rif_list,
+                                        mc_route_data_p->rif_cnt);
+        if (status != OES_STATUS_SUCCESS) {
+            if (created) {
+                oes_router_mc_delete(&vr_p->mc_table, route_p);
+            }
+            break;
+        }
+        route_p->action = mc_route_data_p->action;
+        break;
+
+    case OES_ACCESS_CMD_DELETE:
+        route_p = oes_router_mc_find(&vr_p->mc_table, &key);
+        if (route_p == NULL) {
+            status = OES_STATUS_ENTRY_NOT_FOUND;
+            break;
+        }
+        oes_router_mc_delete(&vr_p->mc_table, route_p);
+        break;
+
+    case OES_ACCESS_CMD_DELETE_ALL:
+        oes_router_mc_table_deinit(&vr_p->mc_table);
+        break;
+
+    default:
+        status = OES_STATUS_CMD_UNSUPPORTED;
+        break;
+    }
+
+out:
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+*  This function gets a multicast route from the MC routing table.
+*  function can receive three types of input: 
+ *     1) get information for specific multicast route,user
+ *      should insert the certain multicast route as the first
+ *      mc_route_key element in the mc_route_key array ,
+ *      mc_route_cnt should be equal to 1,
+ *      access_cmd should be OES_ACCESS_CMD_GET
+ *
+ *   - 2) get a list of first n multicast routes ,user
+ *      should provide an empty mc_route_key  array mc_route_cnt
+ *      should be equal to n,access_cmd should be
+ *      OES_ACCESS_CMD_GET_FIRST
+ *
+ *   - 3) get a list of n  multicast routes which comes after
+ *      certain multicast route (it does not have to exist) user
+ *      should insert the certain multicast route as the first
+ *      mc_route_key element in the mc_route_key array ,
+ *      mc_route_cnt should be equal to n,
+*       access_cmd should be OES_ACCESS_CMD_GET_NEXT
+*  
+* @param[in] access_cmd - GET/GET_NEXT/GET_FIRST/GET_ACTIVITY 
+* @param[in] vrid - Virtual Router ID. 
+* @param[in] mc_route_key_list_p  - array of mc_route_key each 
+*       mc_route_key  element includes group IP, sender IP,
+*       ingress rif (in order to configure
+*       *.G rule sender IP should be 0.0.0.0)
+* @param[out] mc_route_data_list_p  -array of mc_route_data 
+*       each mc_route_data element includes mc route action ,
+*       egress rif list: up to rif_cnt rifs are copied into
+*       rif_list when it is given, rif_cnt is set to the number
+*       the route has
+* @param[in,out] mc_route_cnt_p  - array size  
+* @param[in,out] router_mc_route_vs_ext- vendor specific 
+*       extension
+*  
+* @return OES_STATUS_SUCCESS if operation completes successfully.
+* @return OES_STATUS_PARAM_ERORR if any input parameter is 
+*         invalid.
+* @return OES_STATUS_NOT_FOUND if mc route is not found
+* @return OES_STATUS_ERROR general error.
+*/
+oes_status_e
+oes_api_router_mc_route_get(const enum oes_access_cmd access_cmd,
+                            const unsigned int vrid,
+                            struct oes_mc_route_key *mc_route_key_list_p,
+                            struct oes_mc_route_data *mc_route_data_list_p,
+                            unsigned short *mc_route_cnt_p,
+                            void *router_mc_route_vs_ext)
+{
+    struct oes_router_mc_route **route_list_pp = NULL;
+    struct oes_router_mc_route *route_p;
+    struct oes_router_mc_key key;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned int cnt, i;
+
+    if ((mc_route_key_list_p == NULL) || (mc_route_data_list_p == NULL) || (mc_route_cnt_p == NULL)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    switch (access_cmd) {
+    case OES_ACCESS_CMD_GET:
+        if ((*mc_route_cnt_p != 1) || !oes_router_mc_key_get(mc_route_key_list_p, &key)) {
+            return OES_STATUS_PARAM_ERROR;
+        }
+        break;
+
+    case OES_ACCESS_CMD_GET_NEXT:
+    case OES_ACCESS_CMD_GET_FIRST:
+        if ((access_cmd == OES_ACCESS_CMD_GET_NEXT) && !oes_router_mc_key_get(mc_route_key_list_p, &key)) {
+            return OES_STATUS_PARAM_ERROR;
+        }
+        for (i = 0; i < *mc_route_cnt_p; i++) {
+            if ((mc_route_key_list_p[i].mc_gruop_ip == NULL) || (mc_route_key_list_p[i].sender_ip == NULL)) {
+                return OES_STATUS_PARAM_ERROR;
+            }
+        }
+        route_list_pp = malloc((*mc_route_cnt_p ? *mc_route_cnt_p : 1) * sizeof(*route_list_pp));
+        if (route_list_pp == NULL) {
+            return OES_STATUS_NO_MEMORY;
+        }
+        break;
+
+    default:
+        return OES_STATUS_CMD_UNSUPPORTED;
+    }
+
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if (access_cmd == OES_ACCESS_CMD_GET) {
+        route_p = oes_router_mc_find(&vr_p->mc_table, &key);
+        if (route_p == NULL) {
+            status = OES_STATUS_ENTRY_NOT_FOUND;
+        } else {
+            oes_router_mc_data_get(route_p, mc_route_data_list_p);
+        }
+    } else {
+        /* the routes after the one given, which need not exist */
+        cnt = oes_router_mc_list(&vr_p->mc_table, (access_cmd == OES_ACCESS_CMD_GET_NEXT) ? &key : NULL,
+                                 route_list_pp, *mc_route_cnt_p);
+        for (i = 0; i < cnt; i++) {
+            *mc_route_key_list_p[i].mc_gruop_ip = route_list_pp[i]->key.group;
+            *mc_route_key_list_p[i].sender_ip = route_list_pp[i]->key.source;
+            mc_route_key_list_p[i].ingress_rif = route_list_pp[i]->key.ingress_rif;
+            oes_router_mc_data_get(route_list_pp[i], &mc_route_data_list_p[i]);
+        }
+        *mc_route_cnt_p = cnt;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    free(route_list_pp);
+    return status;
+}
+
+/**
+*  This function looks up the multicast route of a packet: the
+*  (S,G) route of its sender, group and ingress rif, else the
+*  (*,G) route of its ingress rif, else the (*,G) route of any
+*  ingress rif.
+*
+* @param[in] vrid - Virtual Router ID.
+* @param[in] mc_route_key_p - group IP, sender IP and ingress rif
+*       of the packet
+* @param[out] lookup_p - lookup result
+* @param[in,out] router_mc_route_vs_ext- vendor specific
+*       extension
+*
+* @return OES_STATUS_SUCCESS if operation completes successfully,
+*         valid is cleared when no route matches.
+* @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+* @return OES_STATUS_ERROR general error.
+*/
+oes_status_e
+oes_api_router_mc_route_lookup(const unsigned int vrid,
+                               const struct oes_mc_route_key *mc_route_key_p,
+                               struct oes_mc_route_lookup *lookup_p,
+                               void *router_mc_route_vs_ext)
+{
+    struct oes_router_mc_key key;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    if ((lookup_p == NULL) || !oes_router_mc_key_get(mc_route_key_p, &key)) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else {
+        oes_router_mc_lookup_set(oes_router_mc_lookup(&vr_p->mc_table, &key), lookup_p);
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+*  This function looks up the multicast routes of a list of
+*  packets like oes_api_router_mc_route_lookup. The hash chains
+*  of the packets of the list are fetched together so that their
+*  memory accesses overlap. Keys which are not valid get a
+*  result with valid cleared.
+*
+* @param[in] vrid - Virtual Router ID.
+* @param[in] mc_route_key_list_p - group IP, sender IP and
+*       ingress rif array, one per packet
+* @param[out] lookup_list_p - lookup result array, one per key
+* @param[in] key_cnt - array size
+* @param[in,out] router_mc_route_vs_ext- vendor specific
+*       extension
+*
+* @return OES_STATUS_SUCCESS if operation completes successfully.
+* @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+* @return OES_STATUS_ERROR general error.
+*/
+oes_status_e
+oes_api_router_mc_route_lookup_batch(const unsigned int vrid,
+                                     const struct oes_mc_route_key *mc_route_key_list_p,
+                                     struct oes_mc_route_lookup *lookup_list_p,
+                                     const unsigned int key_cnt,
+                                     void *router_mc_route_vs_ext)
+{
+    struct oes_router_mc_key key_list[OES_ROUTER_MC_BULK_MAX];
+    const struct oes_router_mc_route *route_list[OES_ROUTER_MC_BULK_MAX];
+    unsigned short idx_list[OES_ROUTER_MC_BULK_MAX];
+    unsigned int base, cnt, valid_cnt, i;
+    struct oes_router_vr *vr_p;
+
+    if ((key_cnt > 0) && ((mc_route_key_list_p == NULL) || (lookup_list_p == NULL))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        pthread_rwlock_unlock(&oes_router_db.lock);
+        return OES_STATUS_PARAM_ERROR;
+    }
+    for (base = 0; base < key_cnt; base += cnt) {
+        cnt = key_cnt - base;
+        if (cnt > OES_ROUTER_MC_BULK_MAX) {
+            cnt = OES_ROUTER_MC_BULK_MAX;
+        }
+        valid_cnt = 0;
+        for (i = 0; i < cnt; i++) {
+            oes_router_mc_lookup_set(NULL, &lookup_list_p[base + i]);
+            if (oes_router_mc_key_get(&mc_route_key_list_p[base + i], &key_list[valid_cnt])) {
+                idx_list[valid_cnt++] = i;
+            }
+        }
+        oes_router_mc_lookup_bulk(&vr_p->mc_table, key_list, valid_cnt, route_list);
+        for (i = 0; i < valid_cnt; i++) {
+            oes_router_mc_lookup_set(route_list[i], &lookup_list_p[base + idx_list[i]]);
+        }
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+*  This function adds/deletes an egress l3 interfaces to/from 
+*  multicast route. The route takes its own copy of the changed
+*  list, the other routes sharing the list it had keep it.
+*
+* @param[in] access_cmd - ADD/DELETE
+* @param[in] vrid - Virtual Router ID. 
+* @param[in] mc_route_key_p  -  mc_route_key  element includes 
+*       group IP, sender IP, ingress rif (in order to configure
+* @param[in] rif_list_p  -array of egress rif 
+* @param[in] rif_cnt  -egress rif array size  
+* @param[in,out] router_mc_egress_rif_vs_ext- vendor specific 
+*       extension
+*  
+* @return OES_STATUS_SUCCESS if operation completes successfully. 
+* @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+* @return OES_STATUS_ENTRY_NOT_FOUND if the route does not exist.
+* @return OES_STATUS_PARAM_EXCEEDS_RANGE if the route would get more than 65535 rifs.
+* @return OES_STATUS_NO_MEMORY if the router reached its memory limit.
+* @return OES_STATUS_NO_RESOURCES if no routes is available to create.
+* @return OES_STATUS_ERROR general error.
+*/
+oes_status_e
+oes_api_router_mc_egress_rif_set(const enum oes_access_cmd access_cmd,
+                                 const unsigned int vrid,
+                                 const struct oes_mc_route_key *mc_route_key_p,
+                                 const unsigned int *rif_list_p,
+                                 const unsigned short rif_cnt,
+                                 void *router_mc_egress_rif_vs_ext)
+{
+    struct oes_router_mc_route *route_p;
+    struct oes_router_mc_key key;
+    struct oes_router_vr *vr_p;
+    oes_status_e status;
+
+    if (!oes_router_mc_key_get(mc_route_key_p, &key) || (rif_cnt && (rif_list_p == NULL))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    if ((access_cmd != OES_ACCESS_CMD_ADD) && (access_cmd != OES_ACCESS_CMD_DELETE)) {
+        return OES_STATUS_CMD_UNSUPPORTED;
+    }
+
+    pthread_rwlock_wrlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if ((vr_p == NULL) ||
+        ((access_cmd == OES_ACCESS_CMD_ADD) && !oes_router_vr_rifs_valid(vrid, rif_list_p, rif_cnt))) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if ((route_p = oes_router_mc_find(&vr_p->mc_table, &key)) == NULL) {
+        status = OES_STATUS_ENTRY_NOT_FOUND;
+    } else {
+        status = oes_router_mc_rifs_update(&vr_p->mc_table, route_p, access_cmd == OES_ACCESS_CMD_ADD,
+                                           rif_list_p, rif_cnt);
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
+
+/**
+*  This function get a list of  egress l3 interfaces from
+*  multicast route. When egress_rif_num is 0 , the API will
+*  return a counter of the number of egress rifs , and rif_list
+*  will remain empty. Otherwise up to rif_cnt rifs are copied,
+*  in ascending order, and rif_cnt is set to the number the
+*  route has. The count is kept with the list, a count only get
+*  takes constant time.
+*  
+* @param[in] vrid - Virtual Router ID. 
+* @param[in] mc_route_key_p  -  mc_route_key  element includs 
+*       group ip, sender IP, ingress rif (in oredr to configure
+* @param[out] rif_list_p  -array of egress rif 
+* @param[in,out] rif_cnt_p  -egress rif array size  
+* @param[in,out] router_mc_egress_rif_vs_ext- vendor specific 
+*       extension
+*  
+*
+* @return OES_STATUS_SUCCESS if operation completes successfully.
+* @return OES_STATUS_CMD_UNSUPPORTED if access command isn't supported.
+* @return OES_STATUS_PARAM_EXCEEDS_RANGE if parameters exceed range.
+* @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+* @return OES_STATUS_NO_RESOURCES if no routes is available to create.
+* @return OES_STATUS_ERROR general error.
+*/
+oes_status_e
+oes_api_router_mc_egress_rif_get(const unsigned int vrid,
+                                 const struct oes_mc_route_key *mc_route_key_p,
+                                 unsigned int *rif_list_p,
+                                 unsigned short *rif_cnt_p,
+                                 void *router_mc_egress_rif_vs_ext)
+{
+    struct oes_router_mc_route *route_p;
+    struct oes_router_mc_key key;
+    struct oes_router_vr *vr_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+    unsigned int rif_cnt;
+
+    if (!oes_router_mc_key_get(mc_route_key_p, &key) || (rif_cnt_p == NULL) ||
+        (*rif_cnt_p && (rif_list_p == NULL))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+
+    pthread_rwlock_rdlock(&oes_router_db.lock);
+    vr_p = oes_router_vr_get(vrid);
+    if (vr_p == NULL) {
+        status = OES_STATUS_PARAM_ERROR;
+    } else if ((route_p = oes_router_mc_find(&vr_p->mc_table, &key)) == NULL) {
+        status = OES_STATUS_ENTRY_NOT_FOUND;
+    } else {
+        /* the count is kept with the list, a count only get copies nothing */
+        rif_cnt = oes_router_mc_rif_cnt(route_p);
+        if (*rif_cnt_p && rif_cnt) {
+            memcpy(rif_list_p, route_p->rifs->rif_list,
+                   ((*rif_cnt_p < rif_cnt) ? *rif_cnt_p : rif_cnt) * sizeof(*rif_list_p));
+        }
+        *rif_cnt_p = rif_cnt;
+    }
+    pthread_rwlock_unlock(&oes_router_db.lock);
+    return status;
+}
@@ -105,12 +105,116 @@ oes_api_router_ecmp_hash_params_get(
                                    void * router_ecmp_hash_vs_ext
                                    );
 
+/**
+ * This function computes the ECMP hashes of a list of flows
+ * with the hash fields enabled on the virtual router. The hash
+ * of a flow selects its member of an ECMP next-hop group.
+ *
+ * @param[in] vrid - Virtual router ID
+ * @param[in] flow_list_p - packet header fields array
+ * @param[out] hash_list_p - hash array, one per flow
+ * @param[in] flow_cnt - array size
+ * @param[in,out] router_ecmp_hash_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_ecmp_hash_get(
+                            const unsigned int   vrid,
+                            const struct oes_router_flow * flow_list_p,
+                            unsigned int * hash_list_p,
+                            const unsigned int   flow_cnt,
+                            void * router_ecmp_hash_vs_ext
+                            );
+
+/**
+ * This function predicts the next hop a flow is forwarded to:
+ * the route of its destination address, and the member of the
+ * route's next-hop group its ECMP hash selects. The prediction
+ * is not traffic, the forwarded flows are reported with
+ * oes_api_router_ecmp_flow_update.
+ *
+ * @param[in] vrid - Virtual router ID
+ * @param[in] flow_p - packet header fields
+ * @param[out] next_hop_p - next hop
+ * @param[in,out] router_ecmp_hash_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if no route matches the
+ *         destination or the route has no next hop.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_ecmp_next_hop_get(
+                                const unsigned int   vrid,
+                                const struct oes_router_flow * flow_p,
+                                struct oes_ip_addr * next_hop_p,
+                                void * router_ecmp_hash_vs_ext
+                                );
+
+/**
+ * This function records flows forwarded by a software data
+ * path. In a resilient group the flow's bucket is marked used,
+ * which keeps it on its next hop for the idle timer, and the
+ * neighbour of the next hop is marked active. Flows no route
+ * with next hops matches are skipped.
+ *
+ * @param[in] vrid - Virtual router ID
+ * @param[in] flow_list_p - packet header fields array
+ * @param[in] flow_cnt - array size
+ * @param[in,out] router_ecmp_hash_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_ecmp_flow_update(
+                               const unsigned int   vrid,
+                               const struct oes_router_flow * flow_list_p,
+                               const unsigned int   flow_cnt,
+                               void * router_ecmp_hash_vs_ext
+                               );
+
+/**
+ * This function runs the bucket upkeep of the resilient
+ * next-hop groups of a virtual router: the buckets of next hops
+ * above their share, idle for the idle timer of their group,
+ * move to the next hops below it. It is called periodically, at
+ * a fraction of the idle timers.
+ *
+ * @param[in] vrid - Virtual router ID
+ * @param[out] moved_cnt_p - buckets moved
+ * @param[in,out] router_ecmp_hash_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_ecmp_bucket_process(
+                                  const unsigned int   vrid,
+                                  unsigned int * moved_cnt_p,
+                                  void * router_ecmp_hash_vs_ext
+                                  );
+
 /**
  *  This function adds/modifies/deletes a virtual router.
  *  The router ID is allocated and returned to the caller when
  *  cmd is ADD, otherwise it is given by the caller. All
  *  interfaces and routes associated with a router must be
- *  deleted before the router can be deleted as well.
+ *  deleted before the router can be deleted as well. Its
+ *  neighbors are deleted with it. A router takes little memory
+ *  until used: its FIB, route, next-hop group and neighbor
+ *  tables are created on first use, from a pool of its own
+ *  bounded by memory_limit.
  *  
  * @param[in] access_cmd - ADD/EDIT/DELETE. 
  * @param[in,out] vrid_p - Virtual router ID 
@@ -152,11 +256,95 @@ oes_api_router_get(
                   void * router_vs_ext
                   );
 
+/**
+ *  This function gets the memory a virtual router uses. The
+ *  tables of a router are created on first use and allocated
+ *  from a pool of its own, freed with the router.
+ *
+ * @param[in] vrid - Virtual router ID
+ * @param[out] memory_p - pool and LPM table usage
+ * @param[in,out] router_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_memory_get(
+                         const unsigned int   vrid,
+                         struct oes_router_memory * memory_p,
+                         void * router_vs_ext
+                         );
+
+/**
+ *  This function gets the memory a virtual router uses per
+ *  table: bytes, entries in use against the entries the table
+ *  holds without growing, and the bytes holding no entry. The
+ *  LPM tables are mapped, their bytes are the resident pages;
+ *  the free ones are given back by
+ *  oes_api_router_memory_compact().
+ *
+ * @param[in] vrid - Virtual router ID
+ * @param[out] stats_p - usage of each table
+ * @param[in,out] router_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_memory_stats_get(
+                               const unsigned int   vrid,
+                               struct oes_router_memory_stats * stats_p,
+                               void * router_vs_ext
+                               );
+
+/**
+ *  This function gives back the memory the LPM tables of a
+ *  virtual router no longer need after routes were withdrawn:
+ *  the IPv4 tbl8 groups in use are packed below the free ones
+ *  and the tail is unmapped, the empty table pages are dropped.
+ *  A table is only compacted when its fragmentation, as
+ *  reported by oes_api_router_memory_stats_get(), is at least
+ *  min_fragmentation. Lookups go on meanwhile, route updates
+ *  wait for it. It is meant to be called periodically, from a
+ *  thread of the caller.
+ *
+ * @param[in] vrid - Virtual router ID
+ * @param[in] min_fragmentation - in 1/10000, 0 to compact
+ *       anyway
+ * @param[out] reclaimed_bytes_p - bytes given back
+ * @param[in,out] router_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_memory_compact(
+                             const unsigned int   vrid,
+                             const unsigned int   min_fragmentation,
+                             unsigned long long * reclaimed_bytes_p,
+                             void * router_vs_ext
+                             );
+
 
 /**
  *  This function adds/modifies/deletes/delete_all a router
  *  interface. A router interface is associated with L2
- *  interface.
+ *  interface, a (bridge, VLAN) or a port, which has at most one
+ *  router interface. The rif is allocated and returned to the
+ *  caller when cmd is ADD, deleted rifs are reused; rifs are
+ *  unique across the virtual routers. EDIT changes the
+ *  attributes only, ifc_p is ignored. DELETE_ALL deletes all the
+ *  interfaces of the router, rif_p is ignored. A new interface
+ *  routes the frames of its MAC with its admin state down for
+ *  both IP versions. Deleting an interface deletes its
+ *  neighbors, its counters and the multicast routes it is the
+ *  ingress interface of, and drops it from the egress lists of
+ *  the other multicast routes. DELETE_ALL does not fail once
+ *  the router is found: it deletes all the interfaces or, for a
+ *  router without any, nothing.
  * 
  * @param[in] access_cmd - ADD/EDIT/DELETE/DELETE ALL.
  * @param[in] vrid - Virtual Router ID. 
@@ -171,7 +359,14 @@ oes_api_router_get(
  * @return OES_STATUS_SUCCESS if operation completes successfully. 
  * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
  * @return OES_STATUS_ENTRY_NOT_FOUND if router interface was not added.
+ * @return OES_STATUS_ENTRY_ALREADY_EXISTS if the L2 interface
+ *         has a router interface already.
  * @return OES_STATUS_NO_RESOURCES if no interface is available to create. 
+ * @return OES_STATUS_NO_MEMORY if the interfaces cannot grow, or
+ *         the egress lists of the multicast routes of the deleted
+ *         interface cannot be changed; the interface is left as it
+ *         was.
+ * @return OES_STATUS_CMD_UNSUPPORTED if access command isn't supported.
  * @return OES_STATUS_ERROR general error.
  */
 oes_status_e
@@ -249,7 +444,7 @@ oes_api_router_interface_state_set(
  * @return OES_STATUS_ERROR general error.
  */
 oes_status_e
-oes_api_router_interface_state_set(
+oes_api_router_interface_state_get(
                                   const unsigned int   vrid,
                                   const unsigned int   rif,
                                   struct oes_l3_interface_admin_state * admin_state_p,
@@ -259,6 +454,11 @@ oes_api_router_interface_state_set(
 
 /**
  *  This function adds/deletes a MAC address from a router interface.
+ *  Frames to the MACs of an interface, on its L2 interface, are
+ *  routed. The MACs are added besides the MAC of the interface
+ *  attributes, which DELETE_ALL leaves. MACs the interface has
+ *  already, or has not for a DELETE, are skipped; an ADD adds
+ *  all the MACs or none.
  * 
  * @param[in] access_cmd - ADD/DELETE/DELETE_ALL. 
  * @param[in] vrid - Virtual Router ID. 
@@ -270,6 +470,11 @@ oes_api_router_interface_state_set(
  *  
  * @return OES_STATUS_SUCCESS if operation completes successfully. 
  * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if router interface was not added.
+ * @return OES_STATUS_PARAM_EXCEEDS_RANGE if the interface would
+ *         get more than 65535 MACs.
+ * @return OES_STATUS_NO_MEMORY if the MACs cannot grow.
+ * @return OES_STATUS_CMD_UNSUPPORTED if access command isn't supported.
  * @return OES_STATUS_ERROR general error.
  */
 oes_status_e
@@ -283,9 +488,12 @@ oes_api_router_interface_mac_set(
                                 );
 
 /**
- *  This function gets MAC address of a router interface.
+ *  This function gets MAC address of a router interface, the
+ *  MACs added to it, the latest first. When *mac_cnt_p is 0, it
+ *  only returns their number. Otherwise up to *mac_cnt_p MACs
+ *  are read, and *mac_cnt_p is set to the number read.
  * 
- * @param[in] access_cmd - ADD/DELETE/DELETE_ALL. 
+ * @param[in] access_cmd - GET. 
  * @param[in] vrid - Virtual Router ID. 
  * @param[in] rif - Router Interface ID.
  * @param[out] mac_addr_list_p - MAC addresses array .
@@ -295,6 +503,8 @@ oes_api_router_interface_mac_set(
  *
  * @return OES_STATUS_SUCCESS if operation completes successfully. 
  * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if router interface was not added.
+ * @return OES_STATUS_CMD_UNSUPPORTED if access command isn't supported.
  * @return OES_STATUS_ERROR general error.
  */
 oes_status_e
@@ -307,6 +517,36 @@ oes_api_router_interface_mac_get(
                                 void * router_interface_mac_vs_ext
                                 );
 
+/**
+ *  This function finds the router interface a frame is routed
+ *  by, for a software data path: the interface of its ingress
+ *  L2 interface, a (bridge, VLAN) or a port, which has its
+ *  destination MAC. A frame without one is bridged. The
+ *  (L2 interface, MAC) pairs of all the interfaces are hashed
+ *  together, the lookup takes one probe whatever the number of
+ *  interfaces. The caller routes the IP versions the admin state
+ *  of the interface enables.
+ *
+ * @param[in] ifc_p - ingress L2 interface of the frame
+ * @param[in] mac_addr_p - destination MAC of the frame
+ * @param[out] lookup_p - router and interface found, with its
+ *       admin state
+ * @param[in,out] router_interface_mac_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if no interface routes the
+ *         frame.
+ */
+oes_status_e
+oes_api_router_interface_mac_lookup(
+                                   const struct oes_l3_interface * ifc_p,
+                                   const struct ether_addr * mac_addr_p,
+                                   struct oes_l3_interface_lookup * lookup_p,
+                                   void * router_interface_mac_vs_ext
+                                   );
+
 /**
  *  This function adds/modifies/deletes/delete_all a neighbour
  *  information. The neighbour information associate an IP
@@ -318,6 +558,14 @@ oes_api_router_interface_mac_get(
  *  operation the neighbours associated with the router
  *  interface parameter will be deleted in case it is valid, in
  *  case rif is invalid , all neighbours will be deleted.
+ *  Adding a neighbour resolves the next hops with its address,
+ *  deleting it unresolves them: the unicast routes depending on
+ *  it switch between TRAP and FORWARD in the same call. Only
+ *  the next-hop groups of the neighbour are updated, whatever
+ *  the number of their routes, and flows hashed to a next hop
+ *  without neighbour move to the other next hops of its group.
+ *  With aging on, ADD/EDIT (re)starts the aging of the
+ *  neighbour: a refresh answered by an EDIT keeps it.
  * 
  * @param[in] access_cmd - ADD/EDIT/DELETE/DELETE_ALL.
  * @param[in] vrid - Virtual Router ID. 
@@ -329,6 +577,7 @@ oes_api_router_interface_mac_get(
  * @return OES_STATUS_SUCCESS if operation completes successfully. 
  * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid. 
  * @return OES_STATUS_NO_RESOURCES if no neighbour entry is available to create.
+ * @return OES_STATUS_NO_MEMORY if the router reached its memory limit.
  * @return OES_STATUS_ERROR general error.
  */
 
@@ -354,7 +603,8 @@ oes_api_router_neigh_set(
  *      user should inserts sepecific neigh as the first
  *      neigh_key element in the neigh_key array , neigh_cnt
  *      should be equal to 1, access_cmd should be
- *      OES_ACCESS_CMD_GET_ACTIVITY
+ *      OES_ACCESS_CMD_GET_ACTIVITY. The activity is cleared on
+ *      read, a neighbour is active if it had traffic since.
  *  
  *   - 3) get a list of first n neighs ,user
  *      should provide an empty  neigh_key array array
@@ -392,13 +642,149 @@ oes_api_router_neigh_get(
                         void * router_neigh_vs_ext
                         );
 
+/**
+ *  This function sweeps the neighbour activity of a virtual
+ *  router: it lists the neighbours which had traffic since the
+ *  last sweep, or those which had none. The activity of all the
+ *  neighbours is kept in a bitmap, a sweep scans its bits rather
+ *  than getting each neighbour. With READ_CLEAR the sweep starts
+ *  a new period, once all the neighbours found fit in the array.
+ *  The aging keeps its own copy of the activity, a sweep does
+ *  not hide traffic from it.
+ *
+ * @param[in] access_cmd - READ/READ_CLEAR
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] active - 1 for the active neighbours, 0 for the
+ *       inactive ones
+ * @param[out] neigh_key_list_p - neigh IP address array
+ * @param[in,out] neigh_cnt_p - array size, the number of
+ *       neighbours found on return. When more are found than the
+ *       array takes, it holds the first ones and the activity is
+ *       not cleared.
+ * @param[in,out] router_neigh_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_NO_MEMORY if the sweep list cannot be allocated.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_neigh_activity_get(
+                                 const enum oes_access_cmd access_cmd,
+                                 const unsigned int   vrid,
+                                 const unsigned char  active,
+                                 struct oes_ip_addr  * neigh_key_list_p,
+                                 unsigned int  * neigh_cnt_p,
+                                 void * router_neigh_vs_ext
+                                 );
+
+/**
+ *  This function records traffic to neighbours, for a software
+ *  data path: each resolved neighbour of the list is marked
+ *  active, for the activity sweeps, GET_ACTIVITY and the aging
+ *  alike. It takes the traffic of any route, directly connected
+ *  hosts included. Addresses without a resolved neighbour are
+ *  skipped.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] neigh_key_list_p - neigh IP address array
+ * @param[in] neigh_cnt - array size
+ * @param[in,out] router_neigh_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_neigh_activity_update(
+                                    const unsigned int   vrid,
+                                    const struct oes_ip_addr  * neigh_key_list_p,
+                                    const unsigned int   neigh_cnt,
+                                    void * router_neigh_vs_ext
+                                    );
+
+/**
+ *  This function sets the neighbour aging of a virtual router.
+ *  The traffic is the one reported with
+ *  oes_api_router_neigh_activity_update and
+ *  oes_api_router_ecmp_flow_update.
+ *  A neighbour without traffic for age_time gets an
+ *  OES_NEIGH_EVENT_REFRESH event every refresh_interval, the
+ *  control protocols probe it and EDIT it once it answers. After
+ *  refresh_cnt events without traffic nor EDIT, it is deleted
+ *  and an OES_NEIGH_EVENT_AGE event is sent. The events go to
+ *  the channels registered for OES_EVENT_ID_NEIGH with the
+ *  virtual router ID. Each delay is shortened by up to jitter
+ *  percent at random so that neighbours added together are not
+ *  probed together. Setting the aging restarts it for all the
+ *  neighbours.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] params_p - aging parameters, age_time 0 turns aging
+ *       off
+ * @param[in,out] router_neigh_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_NO_MEMORY if the router reached its memory limit.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_neigh_age_params_set(
+                                   const unsigned int   vrid,
+                                   const struct oes_router_neigh_age_params * params_p,
+                                   void * router_neigh_vs_ext
+                                   );
+
+/**
+ *  This function gets the neighbour aging of a virtual router.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[out] params_p - aging parameters
+ * @param[in,out] router_neigh_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_neigh_age_params_get(
+                                   const unsigned int   vrid,
+                                   struct oes_router_neigh_age_params * params_p,
+                                   void * router_neigh_vs_ext
+                                   );
+
+/**
+ *  This function runs the neighbour aging of a virtual router
+ *  up to the current time. It is called periodically, as often
+ *  as the refresh events should be accurate; it only looks at
+ *  the neighbours due since the last call.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[out] aged_cnt_p - neighbours deleted
+ * @param[in,out] router_neigh_vs_ext- vendor specific extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_neigh_age_process(
+                                const unsigned int   vrid,
+                                unsigned int  * aged_cnt_p,
+                                void * router_neigh_vs_ext
+                                );
+
 /**
  *  This function adds/deletes an unicast route into the routing
  *  table. The route is composed of network address and next hop
  *  array which may contains more than one entry for ECMP. In
  *  case the neigh, entry is not known yet,the route will be
  *  added with action TRAP . Upon neigh entry resolved and
- *  configured, the route can be modified into FORWARD. Calling
+ *  configured, the route is modified into FORWARD: a FORWARD
+ *  route traps while none of its next hops has a neighbour,
+ *  oes_api_router_neigh_set updates it without the route being
+ *  set again. Calling
  *  with SET cmd will replace all next hop entries associated
  *  with the route. (If the route does not exist, it will be
  *  created).
@@ -414,6 +800,7 @@ oes_api_router_neigh_get(
  * @return OES_STATUS_SUCCESS if operation completes successfully. 
  * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
  * @return OES_STATUS_NO_RESOURCES if no routes is available to create.
+ * @return OES_STATUS_NO_MEMORY if the router reached its memory limit.
  * @return OES_STATUS_ERROR general error.
  */
 
@@ -426,6 +813,37 @@ oes_api_router_uc_route_set(
                            void * router_uc_route_vs_ext
                            );
 
+/**
+ *  This function opens, commits or aborts a bulk load of the
+ *  unicast routing table of a virtual router. While a bulk load
+ *  is open, routes added by oes_api_router_uc_route_set are
+ *  staged: they are stored and oes_api_router_uc_route_get
+ *  returns them, but lookups do not see them until the commit
+ *  builds them all into the LPM at once, on several threads.
+ *  Routes deleted while staged never reach the LPM, deletes of
+ *  the routes installed before take effect immediately.
+ *
+ * @param[in] access_cmd - CREATE opens, APPLY commits, DESTROY
+ *       aborts the bulk load and drops the staged routes.
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in,out] router_uc_route_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR if a bulk load is already open at
+ *         CREATE, or none is at APPLY and DESTROY.
+ * @return OES_STATUS_NO_MEMORY, OES_STATUS_NO_RESOURCES if some
+ *         staged routes could not be built into the LPM, they are
+ *         removed from the table.
+ */
+oes_status_e
+oes_api_router_uc_route_bulk_set(
+                                const enum oes_access_cmd access_cmd,
+                                const unsigned int   vrid,
+                                void * router_uc_route_vs_ext
+                                );
+
 /**
  * This function gets unicast route entires from the SDK The 
  * function can receive three types of input: 
@@ -446,19 +864,28 @@ oes_api_router_uc_route_set(
  *      uc_route_key element in the uc_route_key array ,
  *      uc_route_cnt should be equal to n,
  *      access_cmd should be OES_ACCESS_CMD_GET_NEXT
+ *
+ *  Routes are listed by IP version, address, then prefix
+ *  length. The first GET_FIRST or GET_NEXT of a virtual router
+ *  sorts its routes once, and route updates keep them sorted,
+ *  so each page costs a logarithmic seek and the copy of its
+ *  routes. uc_route_cnt is set to the number of routes listed.
  *  
  * @param[in] access_cmd - GET/GET NEXT/GET FIRST.
  * @param[in] vrid - Virtual Router ID.
  * @param[in,out] uc_route_key_list_p  - IP network 
  *       address+prefix len array
  * @param[out] uc_route_data_list_p - routing table data 
- *       including action(tarp,drop,forward),next-hop list array
+ *       including action(tarp,drop,forward),next-hop list array,
+ *       the action as set rather than the one in effect
  * @param[in,out] uc_route_cnt_p - array size 
  * @param[in,out] router_uc_route_vs_ext- vendor specific 
  *       extension
  *  
  * @return OES_STATUS_SUCCESS if operation completes successfully. 
  * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if GET finds no such route.
+ * @return OES_STATUS_NO_MEMORY if the routes cannot be sorted.
  * @return OES_STATUS_ERROR general error.
  */
 oes_status_e 
@@ -471,10 +898,156 @@ oes_api_router_uc_route_get(
                            void * router_uc_route_vs_ext
                            );
 
+/**
+ *  This function looks up the longest prefix match of an
+ *  address in the unicast routing table of a virtual router.
+ *  Lookups do not wait for route updates: a route added,
+ *  replaced or deleted meanwhile is seen either before or
+ *  after the update.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] addr_p - IP address to look up
+ * @param[out] lookup_p - matched route action in effect, prefix
+ *       length and next-hop group
+ * @param[in,out] router_uc_route_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if no route matches the address.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_uc_route_lookup(
+                              const unsigned int   vrid,
+                              const struct oes_ip_addr * addr_p,
+                              struct oes_uc_route_lookup * lookup_p,
+                              void * router_uc_route_vs_ext
+                              );
+
+/**
+ *  This function looks up the longest prefix match of a list of
+ *  addresses, of either IP version, in the unicast routing table
+ *  of a virtual router. The lookups of the list are interleaved
+ *  so that their memory accesses overlap, lists of fewer than
+ *  three addresses are looked up one by one. Addresses no route
+ *  matches get a result with valid cleared. Like single
+ *  lookups, they run alongside route updates.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] addr_list_p - IP address array
+ * @param[out] lookup_list_p - lookup result array, one per
+ *       address
+ * @param[in] addr_cnt - array size
+ * @param[in,out] router_uc_route_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_uc_route_lookup_batch(
+                                    const unsigned int   vrid,
+                                    const struct oes_ip_addr * addr_list_p,
+                                    struct oes_uc_route_lookup * lookup_list_p,
+                                    const unsigned int   addr_cnt,
+                                    void * router_uc_route_vs_ext
+                                    );
+
+/**
+ *  This function gets the next hops of a next-hop group
+ *  returned by a route lookup. When next_hop_cnt is 0, the API
+ *  will return the number of next hops and next_hop_list will
+ *  remain empty.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] next_hop_group - next-hop group ID
+ * @param[out] next_hop_list_p - next hop array
+ * @param[in,out] next_hop_cnt_p - next hop array size
+ * @param[in,out] router_next_hop_group_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if the group does not exist.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_next_hop_group_get(
+                                 const unsigned int   vrid,
+                                 const unsigned int   next_hop_group,
+                                 struct oes_ip_addr * next_hop_list_p,
+                                 unsigned short * next_hop_cnt_p,
+                                 void * router_next_hop_group_vs_ext
+                                 );
+
+/**
+ *  This function changes the members of a next-hop group. The
+ *  group is shared by all the routes with the same next hops,
+ *  so the change applies to all of them at once, in a time
+ *  independent of their number.
+ *
+ * @param[in] access_cmd - ADD/DELETE/EDIT next hops.
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] next_hop_group - next-hop group ID
+ * @param[in] next_hop_list_p - next hops to add, delete or set
+ * @param[in] next_hop_cnt - number of next hops
+ * @param[in,out] router_next_hop_group_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid,
+ *         if the group would be left without next hops, or with a
+ *         next hop twice or next hops of both IP versions.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if the group or a deleted
+ *         next hop does not exist.
+ * @return OES_STATUS_NO_MEMORY if the next hops cannot be stored.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_next_hop_group_set(
+                                 const enum oes_access_cmd access_cmd,
+                                 const unsigned int   vrid,
+                                 const unsigned int   next_hop_group,
+                                 const struct oes_ip_addr * next_hop_list_p,
+                                 const unsigned short next_hop_cnt,
+                                 void * router_next_hop_group_vs_ext
+                                 );
+
+/**
+ *  This function gets the number of buckets each next hop of a
+ *  resilient next-hop group holds, in the order of the list
+ *  oes_api_router_next_hop_group_get returns. When next_hop_cnt
+ *  is 0, the API will return the number of next hops only.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] next_hop_group - next-hop group ID
+ * @param[out] bucket_cnt_list_p - buckets per next hop
+ * @param[in,out] next_hop_cnt_p - array size
+ * @param[in,out] router_next_hop_group_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid,
+ *         or if the group does not use resilient hashing.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if the group does not exist.
+ * @return OES_STATUS_ERROR general error.
+ */
+oes_status_e
+oes_api_router_next_hop_group_buckets_get(
+                                         const unsigned int   vrid,
+                                         const unsigned int   next_hop_group,
+                                         unsigned short * bucket_cnt_list_p,
+                                         unsigned short * next_hop_cnt_p,
+                                         void * router_next_hop_group_vs_ext
+                                         );
+
 
 /**
  *  This function allocates/deallocates a router interface
- *  counter.
+ *  counter. The counter has a cache line per CPU, so that the
+ *  data path of each CPU counts on a line of its own.
  *
  * @param[in] access_cmd - ADD /DELETE . 
  * @param[in] vrid - Virtual Router ID. 
@@ -485,8 +1058,12 @@ oes_api_router_uc_route_get(
  * @return OES_STATUS_SUCCESS if operation completes successfully
  * @return OES_STATUS_PARAM_ERROR f any input parameter is 
  *         invalid.
- * @return OES_STATUS_NO_RESOURCES if no counter is available to 
- *         create.
+ * @return OES_STATUS_ENTRY_ALREADY_EXISTS if the counter is
+ *         already allocated.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if the counter to
+ *         deallocate is not allocated.
+ * @return OES_STATUS_NO_MEMORY if the router reached its memory
+ *         limit.
  * @return OES_STATUS_ERROR general error.
  */
 oes_status_e 
@@ -497,7 +1074,10 @@ oes_api_router_interface_cntr_enable_set(
                                         void * router_interface_cntr_vs_ext
                                         );
 /**
- * This function reads router interface counter 
+ * This function reads router interface counter, the sum of the
+ * lines of all the CPUs. READ CLEAR does not write the lines the
+ * data path counts on: the sums it reads become the baseline
+ * later reads start from.
  *
  * @param[in] access_cmd - READ/READ CLEAR. 
  * @param[in] vrid - Virtual Router ID. 
@@ -508,6 +1088,8 @@ oes_api_router_interface_cntr_enable_set(
  *
  * @return OES_STATUS_SUCCESS if operation completes successfully. 
  * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid. 
+ * @return OES_STATUS_ENTRY_NOT_FOUND if the counter is not allocated.
+ * @return OES_STATUS_CMD_UNSUPPORTED if access command isn't supported.
  * @return OES_STATUS_ERROR general error.
  */
 
@@ -520,12 +1102,74 @@ oes_api_router_interface_cntr_get(
                                  void * router_interface_cntr_vs_ext
                                  );
 
+/**
+ * This function counts packets of a router interface, for a
+ * software data path. They are added to the counter line of the
+ * CPU it runs on, without the router lock, alongside the reads.
+ *
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] rif - Router Interface ID.
+ * @param[in] cntr_p - packets and bytes to add
+ * @param[in,out] router_interface_cntr_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_ENTRY_NOT_FOUND if the counter is not allocated.
+ */
+oes_status_e
+oes_api_router_interface_cntr_update(
+                                    const unsigned int vrid,
+                                    const unsigned int rif,
+                                    const struct oes_router_cntr * cntr_p,
+                                    void * router_interface_cntr_vs_ext
+                                    );
+
+/**
+ * This function reads the counters of the router interfaces of
+ * a virtual router, in ascending rif order, from first_rif on.
+ * When *rif_cnt_p is 0, it only returns the number of counters
+ * allocated from first_rif on. Otherwise up to *rif_cnt_p
+ * counters are read like oes_api_router_interface_cntr_get(),
+ * and *rif_cnt_p is set to the number read; reading again from
+ * the last rif + 1 continues the list.
+ *
+ * @param[in] access_cmd - READ/READ CLEAR.
+ * @param[in] vrid - Virtual Router ID.
+ * @param[in] first_rif - Router Interface ID to start from.
+ * @param[out] rif_list_p - Router Interface IDs
+ * @param[out] cntr_list_p - their counters
+ * @param[in,out] rif_cnt_p - array size, then number read
+ * @param[in,out] router_interface_cntr_vs_ext- vendor specific
+ *       extension
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully.
+ * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+ * @return OES_STATUS_CMD_UNSUPPORTED if access command isn't supported.
+ */
+oes_status_e
+oes_api_router_interface_cntr_bulk_get(
+                                      const enum oes_access_cmd access_cmd,
+                                      const unsigned int vrid,
+                                      const unsigned int first_rif,
+                                      unsigned int * rif_list_p,
+                                      struct oes_router_cntr * cntr_list_p,
+                                      unsigned int * rif_cnt_p,
+                                      void * router_interface_cntr_vs_ext
+                                      );
+
 
 /**
 *  This function adds/ deletes a multicast route into/from the
-*  MC routing table.
+*  MC routing table. Routes are hashed on (sender, group,
+*  ingress rif); a (*,G) route with ingress rif
+*  OES_ROUTER_INTERFACE_INVALID takes the packets of any ingress
+*  interface. ADD replaces the action and egress rif list of a
+*  route which exists, EDIT only changes an existing one.
+*  DELETE_ALL frees the table of the vrid at once. Routes with
+*  the same egress rifs share one copy of the list.
 * 
-* @param[in] access_cmd - ADD/DELETE/DELETE_ALL
+* @param[in] access_cmd - ADD/EDIT/DELETE/DELETE_ALL
 *       	   DELETE_ALL command deletes all multicast routes associated
 *       	   with vrid.
 * @param[in] vrid - Virtual Router ID.
@@ -538,7 +1182,8 @@ oes_api_router_interface_cntr_get(
 *
 * @return OES_STATUS_SUCCESS if operation completes successfully. 
 * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
-* @return OES_STATUS_NO_RESOURCES if no routes is available to create.
+* @return OES_STATUS_ENTRY_NOT_FOUND if the route to edit or delete does not exist.
+* @return OES_STATUS_NO_MEMORY if the router reached its memory limit.
 * @return OES_STATUS_ERROR general error.
 */
 
@@ -581,7 +1226,9 @@ oes_api_router_mc_route_set(
 *       *.G rule sender IP should be 0.0.0.0)
 * @param[out] mc_route_data_list_p  -array of mc_route_data 
 *       each mc_route_data element includes mc route action ,
-*       egress rif list
+*       egress rif list: up to rif_cnt rifs are copied into
+*       rif_list when it is given, rif_cnt is set to the number
+*       the route has
 * @param[in,out] mc_route_cnt_p  - array size  
 * @param[in,out] router_mc_route_vs_ext- vendor specific 
 *       extension
@@ -598,15 +1245,70 @@ oes_api_router_mc_route_get(
                            const enum oes_access_cmd access_cmd,
                            const unsigned int   vrid,
                            struct oes_mc_route_key * mc_route_key_list_p,
-                           struct oes_mc_rout e_data * mc_route_data_list_p,
+                           struct oes_mc_route_data * mc_route_data_list_p,
                            unsigned short  * mc_route_cnt_p,
                            void * router_mc_route_vs_ext
                            );
 
+/**
+*  This function looks up the multicast route of a packet: the
+*  (S,G) route of its sender, group and ingress rif, else the
+*  (*,G) route of its ingress rif, else the (*,G) route of any
+*  ingress rif.
+*
+* @param[in] vrid - Virtual Router ID.
+* @param[in] mc_route_key_p - group IP, sender IP and ingress rif
+*       of the packet
+* @param[out] lookup_p - lookup result
+* @param[in,out] router_mc_route_vs_ext- vendor specific
+*       extension
+*
+* @return OES_STATUS_SUCCESS if operation completes successfully,
+*         valid is cleared when no route matches.
+* @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+* @return OES_STATUS_ERROR general error.
+*/
+oes_status_e
+oes_api_router_mc_route_lookup(
+                              const unsigned int   vrid,
+                              const struct oes_mc_route_key * mc_route_key_p,
+                              struct oes_mc_route_lookup * lookup_p,
+                              void * router_mc_route_vs_ext
+                              );
+
+/**
+*  This function looks up the multicast routes of a list of
+*  packets like oes_api_router_mc_route_lookup. The hash chains
+*  of the packets of the list are fetched together so that their
+*  memory accesses overlap. Keys which are not valid get a
+*  result with valid cleared.
+*
+* @param[in] vrid - Virtual Router ID.
+* @param[in] mc_route_key_list_p - group IP, sender IP and
+*       ingress rif array, one per packet
+* @param[out] lookup_list_p - lookup result array, one per key
+* @param[in] key_cnt - array size
+* @param[in,out] router_mc_route_vs_ext- vendor specific
+*       extension
+*
+* @return OES_STATUS_SUCCESS if operation completes successfully.
+* @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+* @return OES_STATUS_ERROR general error.
+*/
+oes_status_e
+oes_api_router_mc_route_lookup_batch(
+                                    const unsigned int   vrid,
+                                    const struct oes_mc_route_key * mc_route_key_list_p,
+                                    struct oes_mc_route_lookup * lookup_list_p,
+                                    const unsigned int   key_cnt,
+                                    void * router_mc_route_vs_ext
+                                    );
+
 
 /**
 *  This function adds/deletes an egress l3 interfaces to/from 
-*  multicast route.
+*  multicast route. The route takes its own copy of the changed
+*  list, the other routes sharing the list it had keep it.
 *
 * @param[in] access_cmd - ADD/DELETE
 * @param[in] vrid - Virtual Router ID. 
@@ -619,6 +1321,9 @@ oes_api_router_mc_route_get(
 *  
 * @return OES_STATUS_SUCCESS if operation completes successfully. 
 * @return OES_STATUS_PARAM_ERROR if any input parameter is invalid.
+* @return OES_STATUS_ENTRY_NOT_FOUND if the route does not exist.
+* @return OES_STATUS_PARAM_EXCEEDS_RANGE if the route would get more than 65535 rifs.
+* @return OES_STATUS_NO_MEMORY if the router reached its memory limit.
 * @return OES_STATUS_NO_RESOURCES if no routes is available to create.
 * @return OES_STATUS_ERROR general error.
 */
@@ -637,7 +1342,10 @@ oes_api_router_mc_egress_rif_set(
 *  This function get a list of  egress l3 interfaces from
 *  multicast route. When egress_rif_num is 0 , the API will
 *  return a counter of the number of egress rifs , and rif_list
-*  will remain empty.
+*  will remain empty. Otherwise up to rif_cnt rifs are copied,
+*  in ascending order, and rif_cnt is set to the number the
+*  route has. The count is kept with the list, a count only get
+*  takes constant time.
 *  
 * @param[in] vrid - Virtual Router ID. 
 * @param[in] mc_route_key_p  -  mc_route_key  element includs 
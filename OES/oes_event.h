@@ -0,0 +1,103 @@
+/* This software is available to you under a choice of one of two
+* licenses.  You may choose to be licensed under the terms of the GNU
+* General Public License (GPL) Version 2, available from the file
+* COPYING, or the Open Ethernet BSD license below:
+*
+*     Redistribution and use in source and binary forms, with or
+*     without modification, are permitted provided that the following
+*     conditions are met:
+*
+*      - Redistributions of source code must retain the above
+*        copyright notice, this list of conditions and the following
+*        disclaimer.
+*
+*      - Redistributions in binary form must reproduce the above
+*        copyright notice, this list of conditions and the following
+*        disclaimer in the documentation and/or other materials
+*        provided with the distribution.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE. 
+*/
+
+#ifndef __OES_EVENT_H__
+#define __OES_EVENT_H__
+
+#include <oes_types.h>
+
+/************************************************
+ *  Internal functions, used by event producers
+ ***********************************************/
+
+/**
+ * This function publishes an event to all the channels
+ * registered for it. Events are written once into a broadcast
+ * ring shared by all channels, the call never blocks on slow
+ * consumers.
+ *
+ * @param[in] br_id - Bridge id, virtual router ID for neighbour
+ *       events
+ * @param[in] event_info_p - event information
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_ERROR if any input parameters is
+ *         invalid
+ */
+oes_status_e
+oes_event_post(
+              const int  br_id,
+              const struct oes_event_info * event_info_p
+              );
+
+/*
+ * Snapshot iterator of an event ID, provided by the module which
+ * owns the entries. It copies up to *event_cnt_p events
+ * describing the entries which sort after after_p (from the
+ * first entry when after_p is NULL) and sets *event_cnt_p to the
+ * number copied; fewer than requested means the end was reached.
+ * *seq_p must be read with oes_event_seq_get() while holding the
+ * lock the module holds when posting events for these entries.
+ *
+ * FDB entries are reported as OES_FDB_EVENT_LEARN events ordered
+ * by (vid, mac), ports as port events ordered by log_port.
+ */
+typedef oes_status_e (*oes_event_snapshot_iter_t)(
+                                                 const int  br_id,
+                                                 const struct oes_event_info * after_p,
+                                                 struct oes_event_info * event_list_p,
+                                                 unsigned int * event_cnt_p,
+                                                 unsigned long long * seq_p
+                                                 );
+
+/**
+ * This function sets the snapshot iterator of an event ID.
+ *
+ * @param[in] event_id - FDB/PORT
+ * @param[in] iter - snapshot iterator, NULL to remove it
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_ERROR if any input parameters is
+ *         invalid
+ */
+oes_status_e
+oes_event_snapshot_iter_set(
+                           const enum oes_event event_id,
+                           oes_event_snapshot_iter_t iter
+                           );
+
+/**
+ * This function returns the sequence number the next posted
+ * event will get.
+ *
+ * @return event sequence number
+ */
+unsigned long long
+oes_event_seq_get(void);
+
+#endif /* __OES_EVENT_H__ */
@@ -0,0 +1,492 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_api_event.h"
+#include "oes_event.h"
+
+/*
+ * Event pipeline benchmark and soak harness. A producer thread
+ * publishes synthetic FDB learn/age/flush and port events at the
+ * configured rates (0 = as fast as possible), N channels receive
+ * them through oes_api_event_recv_batch. Reported per run:
+ * publish and delivery throughput, drops per lane, latency
+ * percentiles per event ID and CPU time per million delivered
+ * events. Soak mode (-d) prints the same figures every interval.
+ *
+ * usage: oes_event_bench [-n events] [-d seconds] [-f fdb_rate]
+ *                        [-p port_rate] [-c consumers[,consumers...]]
+ *                        [-b batch] [-s] [-i interval]
+ */
+
+#define BENCH_BR_ID        0
+#define BENCH_BATCH_MAX    1024
+#define BENCH_STOP_PORT    0xffffffff
+#define BENCH_PORT_CNT     64
+#define BENCH_FLUSH_EVERY  100000
+#define BENCH_TICK_NS      1000000ULL
+#define BENCH_CONSUMER_MAX 64
+
+struct bench_params {
+    unsigned long long events;      /**< events to publish, 0 = run for duration */
+    unsigned int duration;          /**< seconds, 0 = publish events */
+    unsigned long long fdb_rate;    /**< FDB events per second, 0 = unpaced */
+    unsigned long long port_rate;   /**< port events per second */
+    unsigned int batch;
+    unsigned int interval;          /**< soak report interval in seconds */
+    int snapshot;                   /**< register with snapshot */
+};
+
+struct bench_consumer {
+    pthread_t thread;
+    int fd;
+    unsigned int batch;
+    unsigned long long received;
+    unsigned long long snapshot_entries;
+    struct oes_event_channel_stats stats;
+};
+
+struct bench_totals {
+    unsigned long long published;
+    unsigned long long received;
+    unsigned long long dropped[OES_EVENT_LANE_MAX + 1];
+    double cpu;
+    double wall;
+};
+
+static volatile int bench_producer_done;
+static struct oes_event_latency_histogram bench_latency;
+
+static double
+bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+bench_cpu(void)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+static unsigned long long
+bench_percentile(const struct oes_event_latency_histogram *histogram_p,
+                 const double percentile)
+{
+    unsigned long long target = histogram_p->count * percentile / 100.0, seen = 0;
+    unsigned int b;
+
+    for (b = 0; b < OES_EVENT_LATENCY_BUCKET_CNT; b++) {
+        seen += histogram_p->buckets[b];
+        if (seen > target) {
+            break;
+        }
+    }
+    if (b < (1 << OES_EVENT_LATENCY_SUB_BITS)) {
+        return b;
+    }
+    if (b == OES_EVENT_LATENCY_BUCKET_CNT) {
+        return histogram_p->max_ns;
+    }
+    return ((1ULL << OES_EVENT_LATENCY_SUB_BITS) + (b & 7)) <<
+           ((b >> OES_EVENT_LATENCY_SUB_BITS) - 1);
+}
+
+/*
+ * Synthetic FDB table for snapshot registrations: every vid has
+ * one MAC per port.
+ */
+static oes_status_e
+bench_fdb_snapshot_iter(const int br_id,
+                        const struct oes_event_info *after_p,
+                        struct oes_event_info *event_list_p,
+                        unsigned int *event_cnt_p,
+                        unsigned long long *seq_p)
+{
+    const struct oes_fdb_uc_mac_addr_params *key_p;
+    struct oes_fdb_uc_mac_addr_params *entry_p;
+    unsigned int idx = 0, cnt = 0;
+
+    if (after_p != NULL) {
+        key_p = &after_p->event_info.fdb_event.fdb_event_data.fdb_entry.fdb_entry;
+        idx = key_p->vid * BENCH_PORT_CNT + key_p->mac_addr.ether_addr_octet[5] + 1;
+    }
+    *seq_p = oes_event_seq_get();
+    while ((cnt < *event_cnt_p) && (idx < 4096 * BENCH_PORT_CNT)) {
+        memset(&event_list_p[cnt], 0, sizeof(event_list_p[cnt]));
+        event_list_p[cnt].event_info.fdb_event.fbd_event_type = OES_FDB_EVENT_LEARN;
+        entry_p = &event_list_p[cnt].event_info.fdb_event.fdb_event_data.fdb_entry.fdb_entry;
+        entry_p->vid = idx / BENCH_PORT_CNT;
+        entry_p->mac_addr.ether_addr_octet[5] = idx % BENCH_PORT_CNT;
+        entry_p->log_port = idx % BENCH_PORT_CNT;
+        cnt++;
+        idx++;
+    }
+    *event_cnt_p = cnt;
+    return OES_STATUS_SUCCESS;
+}
+
+static void *
+bench_consumer_run(void *arg)
+{
+    struct bench_consumer *consumer_p = arg;
+    struct oes_event_info events[BENCH_BATCH_MAX];
+    struct oes_event_channel_stats stats;
+    unsigned int cnt, i;
+
+    for (;;) {
+        if (bench_producer_done) {
+            /* the stop event may overtake the FDB lane, drain it first */
+            oes_api_event_stats_get(consumer_p->fd, &stats, NULL);
+            if (stats.lag == 0) {
+                break;
+            }
+        }
+        cnt = consumer_p->batch;
+        if (oes_api_event_recv_batch(consumer_p->fd, events, &cnt, NULL) !=
+            OES_STATUS_SUCCESS) {
+            break;
+        }
+        for (i = 0; i < cnt; i++) {
+            if ((events[i].event_id == OES_EVENT_ID_PORT) &&
+                (events[i].event_info.port_event.log_port == BENCH_STOP_PORT)) {
+                continue;
+            }
+            if (events[i].event_id == OES_EVENT_ID_SNAPSHOT_END) {
+                consumer_p->snapshot_entries += events[i].event_info.snapshot_end.entry_cnt;
+                continue;
+            }
+            __atomic_add_fetch(&consumer_p->received, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+static void
+bench_fdb_event(struct oes_event_info *event_info_p,
+                const unsigned long long i)
+{
+    struct oes_fdb_uc_mac_addr_params *entry_p;
+
+    memset(event_info_p, 0, sizeof(*event_info_p));
+    event_info_p->event_id = OES_EVENT_ID_FDB;
+    if ((i % BENCH_FLUSH_EVERY) == BENCH_FLUSH_EVERY - 1) {
+        event_info_p->event_info.fdb_event.fbd_event_type = OES_FDB_EVENT_FLUSH_PORT;
+        event_info_p->event_info.fdb_event.fdb_event_data.fdb_port.port = i % BENCH_PORT_CNT;
+        return;
+    }
+    event_info_p->event_info.fdb_event.fbd_event_type =
+        (i & 1) ? OES_FDB_EVENT_AGE : OES_FDB_EVENT_LEARN;
+    entry_p = &event_info_p->event_info.fdb_event.fdb_event_data.fdb_entry.fdb_entry;
+    entry_p->vid = (i >> 1) & 0xfff;
+    entry_p->mac_addr.ether_addr_octet[5] = (i >> 13) & 0xff;
+    entry_p->mac_addr.ether_addr_octet[4] = (i >> 21) & 0xff;
+    entry_p->log_port = (i >> 1) % BENCH_PORT_CNT;
+}
+
+static void
+bench_port_event(struct oes_event_info *event_info_p,
+                 const unsigned long long i)
+{
+    memset(event_info_p, 0, sizeof(*event_info_p));
+    event_info_p->event_id = OES_EVENT_ID_PORT;
+    event_info_p->event_info.port_event.log_port = i % BENCH_PORT_CNT;
+    event_info_p->event_info.port_event.port_state = (i & 1) ? OES_PORT_DOWN : OES_PORT_UP;
+}
+
+static void
+bench_report(const char *title,
+             const struct bench_totals *totals_p,
+             const int consumer_cnt)
+{
+    static const char *lane_names[] = { "port", "flush", "learn", "neigh" };
+    unsigned long long dropped = 0;
+    int lane, event_id;
+
+    for (lane = OES_EVENT_LANE_MIN; lane <= OES_EVENT_LANE_MAX; lane++) {
+        dropped += totals_p->dropped[lane];
+    }
+    printf("%s consumers %2d: published %.2f Mev/s, delivered %.2f Mev/s, "
+           "dropped %.2f%% (", title, consumer_cnt,
+           totals_p->published / totals_p->wall / 1e6,
+           totals_p->received / totals_p->wall / 1e6,
+           totals_p->published ?
+           100.0 * dropped / ((double)totals_p->published * consumer_cnt) : 0.0);
+    for (lane = OES_EVENT_LANE_MIN; lane <= OES_EVENT_LANE_MAX; lane++) {
+        printf("%s%s %llu", lane ? ", " : "", lane_names[lane], totals_p->dropped[lane]);
+    }
+    printf("), cpu %.3f s/Mev\n",
+           totals_p->received ? totals_p->cpu / (totals_p->received / 1e6) : 0.0);
+
+    for (event_id = OES_EVENT_ID_FDB; event_id <= OES_EVENT_ID_PORT; event_id++) {
+        oes_api_event_latency_get(OES_ACCESS_CMD_READ_CLEAR, event_id, &bench_latency, NULL);
+        if (bench_latency.count == 0) {
+            continue;
+        }
+        printf("    %-4s latency: p50 %llu ns, p99 %llu ns, p99.9 %llu ns, max %llu ns\n",
+               (event_id == OES_EVENT_ID_FDB) ? "fdb" : "port",
+               bench_percentile(&bench_latency, 50), bench_percentile(&bench_latency, 99),
+               bench_percentile(&bench_latency, 99.9), bench_latency.max_ns);
+    }
+}
+
+static void
+bench_totals_sample(struct bench_totals *totals_p,
+                    struct bench_consumer *consumers,
+                    const int consumer_cnt,
+                    const unsigned long long published)
+{
+    int c, lane;
+
+    memset(totals_p, 0, sizeof(*totals_p));
+    totals_p->published = published;
+    for (c = 0; c < consumer_cnt; c++) {
+        oes_api_event_stats_get(consumers[c].fd, &consumers[c].stats, NULL);
+        totals_p->received += __atomic_load_n(&consumers[c].received, __ATOMIC_RELAXED);
+        for (lane = OES_EVENT_LANE_MIN; lane <= OES_EVENT_LANE_MAX; lane++) {
+            totals_p->dropped[lane] += consumers[c].stats.lane_dropped[lane];
+        }
+    }
+    totals_p->wall = bench_now();
+    totals_p->cpu = bench_cpu();
+}
+
+static void
+bench_totals_diff(struct bench_totals *diff_p,
+                  const struct bench_totals *now_p,
+                  const struct bench_totals *before_p)
+{
+    int lane;
+
+    diff_p->published = now_p->published - before_p->published;
+    diff_p->received = now_p->received - before_p->received;
+    for (lane = OES_EVENT_LANE_MIN; lane <= OES_EVENT_LANE_MAX; lane++) {
+        diff_p->dropped[lane] = now_p->dropped[lane] - before_p->dropped[lane];
+    }
+    diff_p->wall = now_p->wall - before_p->wall;
+    diff_p->cpu = now_p->cpu - before_p->cpu;
+}
+
+static int
+bench_run(const struct bench_params *params_p,
+          const int consumer_cnt)
+{
+    struct oes_event_register_params register_params;
+    struct bench_consumer consumers[BENCH_CONSUMER_MAX];
+    struct bench_totals start, last, now, diff;
+    struct oes_event_info event_info;
+    unsigned long long fdb_cnt = 0, port_cnt = 0, fdb_due, port_due, elapsed_ns;
+    double t0, next_report;
+    int c;
+
+    memset(consumers, 0, sizeof(consumers));
+    memset(&register_params, 0, sizeof(register_params));
+    register_params.enable_snapshot = params_p->snapshot;
+    bench_producer_done = 0;
+
+    for (c = 0; c < consumer_cnt; c++) {
+        consumers[c].batch = params_p->batch;
+        if ((oes_api_event_fd_set(OES_ACCESS_CMD_CREATE, &consumers[c].fd, NULL) != OES_STATUS_SUCCESS) ||
+            (oes_api_event_register_set(OES_ACCESS_CMD_ADD, BENCH_BR_ID, OES_EVENT_ID_FDB,
+                                        consumers[c].fd, &register_params) != OES_STATUS_SUCCESS) ||
+            (oes_api_event_register_set(OES_ACCESS_CMD_ADD, BENCH_BR_ID, OES_EVENT_ID_PORT,
+                                        consumers[c].fd, NULL) != OES_STATUS_SUCCESS)) {
+            fprintf(stderr, "failed to open event channel %d\n", c);
+            return -1;
+        }
+    }
+    /* start every run with empty latency histograms */
+    for (c = OES_EVENT_ID_FDB; c <= OES_EVENT_ID_PORT; c++) {
+        oes_api_event_latency_get(OES_ACCESS_CMD_READ_CLEAR, c, &bench_latency, NULL);
+    }
+    for (c = 0; c < consumer_cnt; c++) {
+        pthread_create(&consumers[c].thread, NULL, bench_consumer_run, &consumers[c]);
+    }
+
+    bench_totals_sample(&start, consumers, consumer_cnt, 0);
+    last = start;
+    t0 = start.wall;
+    next_report = t0 + params_p->interval;
+
+    for (;;) {
+        now.wall = bench_now();
+        elapsed_ns = (now.wall - t0) * 1e9;
+        if (params_p->duration ? (elapsed_ns >= params_p->duration * 1000000000ULL) :
+            (fdb_cnt + port_cnt >= params_p->events)) {
+            break;
+        }
+
+        /* publish what is due for this tick, unpaced lanes get a burst */
+        fdb_due = params_p->fdb_rate ? elapsed_ns * params_p->fdb_rate / 1000000000ULL :
+                  fdb_cnt + BENCH_TICK_NS / 1000;
+        port_due = params_p->port_rate ? elapsed_ns * params_p->port_rate / 1000000000ULL : 0;
+        if ((fdb_cnt >= fdb_due) && (port_cnt >= port_due)) {
+            struct timespec tick = { 0, BENCH_TICK_NS / 10 };
+            nanosleep(&tick, NULL);
+        }
+        while (port_cnt < port_due) {
+            bench_port_event(&event_info, port_cnt++);
+            oes_event_post(BENCH_BR_ID, &event_info);
+        }
+        while ((fdb_cnt < fdb_due) &&
+               (params_p->duration || (fdb_cnt + port_cnt < params_p->events))) {
+            bench_fdb_event(&event_info, fdb_cnt++);
+            oes_event_post(BENCH_BR_ID, &event_info);
+        }
+
+        if (params_p->duration && (now.wall >= next_report)) {
+            bench_totals_sample(&now, consumers, consumer_cnt, fdb_cnt + port_cnt);
+            bench_totals_diff(&diff, &now, &last);
+            bench_report("  soak", &diff, consumer_cnt);
+            last = now;
+            next_report += params_p->interval;
+        }
+    }
+
+    memset(&event_info, 0, sizeof(event_info));
+    event_info.event_id = OES_EVENT_ID_PORT;
+    event_info.event_info.port_event.log_port = BENCH_STOP_PORT;
+    bench_producer_done = 1;
+    oes_event_post(BENCH_BR_ID, &event_info);
+    for (c = 0; c < consumer_cnt; c++) {
+        pthread_join(consumers[c].thread, NULL);
+    }
+
+    bench_totals_sample(&now, consumers, consumer_cnt, fdb_cnt + port_cnt);
+    bench_totals_diff(&diff, &now, params_p->duration ? &last : &start);
+    if (params_p->duration) {
+        bench_report("  soak", &diff, consumer_cnt);
+        bench_totals_diff(&diff, &now, &start);
+        bench_report("total", &diff, consumer_cnt);
+    } else {
+        bench_report("total", &diff, consumer_cnt);
+    }
+    if (params_p->snapshot) {
+        printf("    snapshot entries delivered per channel: %llu\n",
+               consumers[0].snapshot_entries);
+    }
+
+    for (c = 0; c < consumer_cnt; c++) {
+        oes_api_event_fd_set(OES_ACCESS_CMD_DESTROY, &consumers[c].fd, NULL);
+    }
+    return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct bench_params params = {
+        .events = 10000000,
+        .batch = 64,
+        .interval = 1,
+    };
+    int consumer_cnts[BENCH_CONSUMER_MAX] = { 1, 4, 16 };
+    int consumer_runs = 3, opt, i;
+    char *token;
+
+    while ((opt = getopt(argc, argv, "n:d:f:p:c:b:si:")) != -1) {
+        switch (opt) {
+        case 'n':
+            params.events = strtoull(optarg, NULL, 0);
+            break;
+
+        case 'd':
+            params.duration = atoi(optarg);
+            break;
+
+        case 'f':
+            params.fdb_rate = strtoull(optarg, NULL, 0);
+            break;
+
+        case 'p':
+            params.port_rate = strtoull(optarg, NULL, 0);
+            break;
+
+        case 'c':
+            consumer_runs = 0;
+            for (token = strtok(optarg, ","); (token != NULL) && (consumer_runs < BENCH_CONSUMER_MAX);
+                 token = strtok(NULL, ",")) {
+                consumer_cnts[consumer_runs++] = atoi(token);
+            }
+            break;
+
+        case 'b':
+            params.batch = atoi(optarg);
+            break;
+
+        case 's':
+            params.snapshot = 1;
+            break;
+
+        case 'i':
+            params.interval = atoi(optarg);
+            break;
+
+        default:
+            fprintf(stderr, "usage: %s [-n events] [-d seconds] [-f fdb_rate] [-p port_rate] "
+                    "[-c consumers[,consumers...]] [-b batch] [-s] [-i interval]\n", argv[0]);
+            return 1;
+        }
+    }
+    if ((params.batch == 0) || (params.batch > BENCH_BATCH_MAX) || (params.interval == 0)) {
+        fprintf(stderr, "batch must be 1..%d, interval at least 1\n", BENCH_BATCH_MAX);
+        return 1;
+    }
+    if (params.snapshot) {
+        oes_event_snapshot_iter_set(OES_EVENT_ID_FDB, bench_fdb_snapshot_iter);
+    }
+
+    for (i = 0; i < consumer_runs; i++) {
+        if ((consumer_cnts[i] < 1) || (consumer_cnts[i] > BENCH_CONSUMER_MAX) ||
+            (bench_run(&params, consumer_cnts[i]) != 0)) {
+            return 1;
+        }
+    }
+    return 0;
+}
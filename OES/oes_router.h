@@ -0,0 +1,2465 @@
+/* This software is available to you under a choice of one of two
+* licenses.  You may choose to be licensed under the terms of the GNU
+* General Public License (GPL) Version 2, available from the file
+* COPYING, or the Open Ethernet BSD license below:
+*
+*     Redistribution and use in source and binary forms, with or
+*     without modification, are permitted provided that the following
+*     conditions are met:
+*
+*      - Redistributions of source code must retain the above
+*        copyright notice, this list of conditions and the following
+*        disclaimer.
+*
+*      - Redistributions in binary form must reproduce the above
+*        copyright notice, this list of conditions and the following
+*        disclaimer in the documentation and/or other materials
+*        provided with the distribution.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE. 
+*/
+
+#ifndef __OES_ROUTER_H__
+#define __OES_ROUTER_H__
+
+#include <string.h>
+#include <oes_types.h>
+
+/*
+ * Bulk lookups take at most OES_ROUTER_LPM_BULK_MAX addresses and
+ * report a miss with depth OES_ROUTER_LPM_MISS.
+ */
+#define OES_ROUTER_LPM_BULK_MAX         64
+#define OES_ROUTER_LPM_MISS             0xff
+
+/*
+ * Bulk builds split the address space in partitions, handed out
+ * one at a time to up to OES_ROUTER_BULK_THREAD_MAX threads.
+ */
+#define OES_ROUTER_BULK_THREAD_MAX      16
+
+/**
+ * This function returns the number of threads bulk builds use,
+ * one per online CPU up to OES_ROUTER_BULK_THREAD_MAX.
+ *
+ * @return thread count
+ */
+unsigned int
+oes_router_bulk_thread_cnt(
+                          void
+                          );
+
+/**
+ * This function runs work_fn on each partition, on up to
+ * thread_cnt threads, the calling one included. It returns once
+ * all partitions are done.
+ *
+ * @param[in] thread_cnt - thread count
+ * @param[in] part_cnt - number of partitions
+ * @param[in] work_fn - partition worker
+ * @param[in] ctx_p - worker context
+ */
+void
+oes_router_bulk_run(
+                   const unsigned int  thread_cnt,
+                   const unsigned int  part_cnt,
+                   void (*work_fn)(void *ctx_p, const unsigned int part),
+                   void * ctx_p
+                   );
+
+/************************************************
+ *  RCU
+ ***********************************************/
+
+/*
+ * Lookups run without the router lock, in read sections which
+ * only publish the epoch they started in. Writers, serialized by
+ * the router lock, patch the tables with single atomic stores,
+ * ordered so that a reader sees either the old or the new entry,
+ * never a half built one, and hand what they unlink over to
+ * oes_router_rcu_defer(). It is released once every reader is
+ * outside a read section or in a later epoch: by
+ * oes_router_rcu_reclaim() after each update, or by
+ * oes_router_rcu_barrier(), which waits for the readers, before a
+ * table is torn down. Threads beyond OES_ROUTER_RCU_READER_MAX get
+ * no reader slot and fall back to the router read lock.
+ */
+#define OES_ROUTER_RCU_READER_MAX       256
+
+/**
+ * This function enters a read section. The calling thread takes
+ * a reader slot on its first call. Read sections do not nest.
+ *
+ * @return 1 in a read section, 0 when all reader slots are taken
+ */
+int
+oes_router_rcu_read_lock(
+                        void
+                        );
+
+/**
+ * This function leaves a read section.
+ */
+void
+oes_router_rcu_read_unlock(
+                          void
+                          );
+
+/**
+ * This function waits until all the read sections in progress
+ * are over.
+ */
+void
+oes_router_rcu_synchronize(
+                          void
+                          );
+
+/**
+ * This function hands an object, already unlinked from the
+ * tables, over to be released by fn(ctx_p, arg) once no reader
+ * can still see it. When the deferred list cannot grow, it waits
+ * for the readers and releases the object at once.
+ *
+ * @param[in] fn - release function
+ * @param[in] ctx_p - release context
+ * @param[in] arg - release argument
+ */
+void
+oes_router_rcu_defer(
+                    void (*fn)(void *ctx_p, const unsigned int arg),
+                    void * ctx_p,
+                    const unsigned int  arg
+                    );
+
+/**
+ * This function releases the deferred objects no reader can see
+ * anymore, without waiting for the others.
+ */
+void
+oes_router_rcu_reclaim(
+                      void
+                      );
+
+/**
+ * This function waits for the read sections in progress and
+ * releases all the objects deferred before the call.
+ */
+void
+oes_router_rcu_barrier(
+                      void
+                      );
+
+/************************************************
+ *  Memory pools
+ ***********************************************/
+
+/*
+ * Each virtual router allocates its tables from a pool of its
+ * own, which counts the bytes in use against an optional limit,
+ * so that one VR cannot run the others out of memory and its
+ * usage can be reported. Callers pass the size back on free, the
+ * pool keeps no headers. The counters are atomic since bulk
+ * builds allocate from several threads. A table may take a pool
+ * of its own under the one of its router: its memory is counted
+ * in both, against the limits of both, so that the usage of
+ * each table can be reported too.
+ */
+struct oes_router_pool {
+    unsigned long long       bytes;          /**< in use */
+    unsigned long long       peak_bytes;
+    unsigned long long       limit;          /**< 0 for no limit */
+    struct oes_router_pool * parent;         /**< pool also charged, NULL for none */
+};
+
+/**
+ * This function allocates memory from a pool.
+ *
+ * @param[in] pool_p - pool
+ * @param[in] size - bytes
+ *
+ * @return the memory, NULL when out of memory or past the limit
+ */
+void *
+oes_router_pool_alloc(
+                     struct oes_router_pool * pool_p,
+                     const size_t  size
+                     );
+
+/**
+ * This function allocates zeroed memory from a pool.
+ *
+ * @param[in] pool_p - pool
+ * @param[in] cnt - number of elements
+ * @param[in] size - element size
+ *
+ * @return the memory, NULL when out of memory or past the limit
+ */
+void *
+oes_router_pool_calloc(
+                      struct oes_router_pool * pool_p,
+                      const size_t  cnt,
+                      const size_t  size
+                      );
+
+/**
+ * This function resizes memory of a pool. On failure the memory
+ * is left as it was.
+ *
+ * @param[in] pool_p - pool
+ * @param[in] mem_p - memory, NULL to allocate
+ * @param[in] old_size - current size
+ * @param[in] size - new size
+ *
+ * @return the memory, NULL when out of memory or past the limit
+ */
+void *
+oes_router_pool_realloc(
+                       struct oes_router_pool * pool_p,
+                       void * mem_p,
+                       const size_t  old_size,
+                       const size_t  size
+                       );
+
+/**
+ * This function allocates memory from a pool aligned to a power
+ * of 2, such as a cache line. It is freed like the rest.
+ *
+ * @param[in] pool_p - pool
+ * @param[in] align - alignment, a power of 2 multiple of the
+ *       pointer size
+ * @param[in] size - bytes
+ *
+ * @return the memory, NULL when out of memory or past the limit
+ */
+void *
+oes_router_pool_alloc_aligned(
+                             struct oes_router_pool * pool_p,
+                             const size_t  align,
+                             const size_t  size
+                             );
+
+/**
+ * This function frees memory of a pool.
+ *
+ * @param[in] pool_p - pool
+ * @param[in] mem_p - memory, NULL is ignored
+ * @param[in] size - size it was allocated with
+ */
+void
+oes_router_pool_free(
+                    struct oes_router_pool * pool_p,
+                    void * mem_p,
+                    const size_t  size
+                    );
+
+/**
+ * This function frees memory of a pool lookups may still read,
+ * once they are done. It stops counting at once.
+ *
+ * @param[in] pool_p - pool
+ * @param[in] mem_p - memory, NULL is ignored
+ * @param[in] size - size it was allocated with
+ */
+void
+oes_router_pool_retire(
+                      struct oes_router_pool * pool_p,
+                      void * mem_p,
+                      const size_t  size
+                      );
+
+/**
+ * This function returns the bytes of a mapping backed by memory,
+ * the pages a table mapped with MAP_NORESERVE actually uses.
+ *
+ * @param[in] mem_p - mapping, page aligned
+ * @param[in] size - mapping size
+ *
+ * @return resident bytes
+ */
+unsigned long long
+oes_router_map_resident(
+                       const void * mem_p,
+                       const size_t  size
+                       );
+
+/*
+ * A lookup reading a page of a table mapped with MAP_NORESERVE
+ * maps the zero page, which mincore() takes as resident. The
+ * tables rather keep a bit per granule they wrote, set before the
+ * write, to tell the pages which hold memory.
+ */
+#define OES_ROUTER_MAP_GRANULE  4096
+#define OES_ROUTER_MAP_WRITTEN_WORDS(size) \
+    (((size) / OES_ROUTER_MAP_GRANULE + 63) / 64)
+
+static inline int
+oes_router_map_written_get(
+                          const unsigned long long * written_p,
+                          const size_t  offset
+                          )
+{
+    return (__atomic_load_n(&written_p[offset / OES_ROUTER_MAP_GRANULE / 64], __ATOMIC_RELAXED) >>
+            (offset / OES_ROUTER_MAP_GRANULE % 64)) & 1;
+}
+
+/* bulk adds write parts of a table from several threads */
+static inline void
+oes_router_map_written_set(
+                          unsigned long long * written_p,
+                          const size_t  offset
+                          )
+{
+    if (!oes_router_map_written_get(written_p, offset)) {
+        __atomic_fetch_or(&written_p[offset / OES_ROUTER_MAP_GRANULE / 64],
+                          1ULL << (offset / OES_ROUTER_MAP_GRANULE % 64), __ATOMIC_RELAXED);
+    }
+}
+
+typedef void (*oes_router_map_page_fn)(void *ctx_p, void *page_p, const size_t page_size);
+
+/**
+ * This function calls page_fn on each page of a mapping its
+ * table wrote to since the page was last dropped, in address
+ * order. The others are left alone: they are not backed, or only
+ * by the zero page lookups read.
+ *
+ * @param[in] mem_p - mapping, page aligned
+ * @param[in] size - mapping size
+ * @param[in] written_p - written granules of the mapping
+ * @param[in] page_fn - called on each written page
+ * @param[in] ctx_p - passed to page_fn
+ */
+void
+oes_router_map_walk(
+                   void                     * mem_p,
+                   const size_t               size,
+                   const unsigned long long * written_p,
+                   oes_router_map_page_fn     page_fn,
+                   void                     * ctx_p
+                   );
+
+/**
+ * This function returns the bytes of the pages of a mapping its
+ * table wrote to, the memory it holds.
+ *
+ * @param[in] size - mapping size
+ * @param[in] written_p - written granules of the mapping
+ *
+ * @return written bytes
+ */
+unsigned long long
+oes_router_map_written_bytes(
+                            const size_t  size,
+                            const unsigned long long * written_p
+                            );
+
+/**
+ * This function gives a page of a mapping back to the system and
+ * forgets it was written. Lookups reading it see zeros.
+ *
+ * @param[in] mem_p - mapping, page aligned
+ * @param[in,out] written_p - written granules of the mapping
+ * @param[in] page_p - page
+ * @param[in] page_size - page size
+ *
+ * @return bytes given back
+ */
+unsigned long long
+oes_router_map_drop(
+                   void * mem_p,
+                   unsigned long long * written_p,
+                   void * page_p,
+                   const size_t  page_size
+                   );
+
+/**
+ * This function returns whether a page of a mapping holds only
+ * zeros, the state it is dropped to by madvise(MADV_DONTNEED).
+ *
+ * @param[in] page_p - page
+ * @param[in] page_size - page size
+ *
+ * @return 1 if the page is all zeros, 0 otherwise
+ */
+int
+oes_router_map_zero(
+                   const void * page_p,
+                   const size_t  page_size
+                   );
+
+/************************************************
+ *  IPv4 LPM, DIR-24-8
+ ***********************************************/
+
+/*
+ * tbl24 is indexed by the upper 24 bits of the address. An entry
+ * either holds the result of the longest prefix of length <= 24
+ * covering the /24, or points to a tbl8 group of 256 entries
+ * indexed by the low 8 bits, used once a longer prefix exists in
+ * that /24. Entry layout:
+ *   [31]    extended, [24:0] is a tbl8 group
+ *   [30:25] depth of the prefix, 0 for an empty entry
+ *   [24:0]  value of the prefix
+ * The default route is kept out of the tables. A tbl8 group is
+ * set before the tbl24 entry pointing to it, and a group folded
+ * back into tbl24 is only reused once no lookup can be in it.
+ */
+#define OES_ROUTER_LPM4_TBL24_CNT       (1 << 24)
+#define OES_ROUTER_LPM4_TBL8_GROUP_CNT  (1 << 16)
+#define OES_ROUTER_LPM4_EXT             0x80000000
+#define OES_ROUTER_LPM4_DEPTH_SHIFT     25
+#define OES_ROUTER_LPM4_VALUE_MASK      0x01ffffff
+#define OES_ROUTER_LPM4_VALUE_MAX       OES_ROUTER_LPM4_VALUE_MASK
+
+/* a prefix of a bulk build */
+struct oes_router_lpm4_rule {
+    unsigned int   addr;            /**< host order */
+    unsigned int   value;
+    unsigned char  depth;
+    unsigned char  failed;          /**< set when the build could not add it */
+};
+
+struct oes_router_lpm4 {
+    unsigned int * tbl24;
+    unsigned int * tbl8;
+    unsigned long long * tbl24_written; /**< tbl24 granules written, see OES_ROUTER_MAP_GRANULE */
+    unsigned int   tbl8_hwm;        /**< tbl8 groups ever handed out */
+    unsigned int   tbl8_free;       /**< free group list, linked through entry 0, + 1 */
+    unsigned int   tbl8_used;
+    unsigned char  default_valid;
+    unsigned int   default_value;
+};
+
+/**
+ * This function maps the tables of an IPv4 LPM. Pages are only
+ * backed once a route touches them. The LPM may be created
+ * lazily while lookups run on it: they see no tables, and miss,
+ * until tbl24 is published.
+ *
+ * @param[in,out] lpm_p - LPM, zeroed
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the tables cannot be mapped
+ */
+oes_status_e
+oes_router_lpm4_init(
+                    struct oes_router_lpm4 * lpm_p
+                    );
+
+/**
+ * This function unmaps the tables of an IPv4 LPM. The caller
+ * waits for the lookups and the deferred group frees with
+ * oes_router_rcu_barrier() first.
+ *
+ * @param[in] lpm_p - LPM
+ */
+void
+oes_router_lpm4_deinit(
+                      struct oes_router_lpm4 * lpm_p
+                      );
+
+/**
+ * This function returns the bytes of the tables of an IPv4 LPM
+ * backed by memory: the tbl24 pages written and the resident
+ * tbl8 pages.
+ *
+ * @param[in] lpm_p - LPM
+ *
+ * @return resident bytes, 0 when the LPM is not mapped
+ */
+unsigned long long
+oes_router_lpm4_table_bytes(
+                           const struct oes_router_lpm4 * lpm_p
+                           );
+
+/**
+ * This function reports the memory of an IPv4 LPM. Its entries
+ * are the tbl8 groups, its free bytes what compaction gives
+ * back: the tbl8 tail past the used count and the written tbl24
+ * pages left empty.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[out] usage_p - usage, ratios left to the caller
+ */
+void
+oes_router_lpm4_usage(
+                     const struct oes_router_lpm4 * lpm_p,
+                     struct oes_router_table_usage * usage_p
+                     );
+
+/**
+ * This function gives back the memory an IPv4 LPM no longer
+ * needs. The tbl8 groups past the used count are moved into the
+ * free ones below it, so that the groups in use are dense again
+ * and the tail can be unmapped, and the empty tbl24 pages are
+ * dropped. Lookups go on meanwhile; the caller excludes updates.
+ *
+ * @param[in] lpm_p - LPM
+ *
+ * @return resident bytes given back
+ */
+unsigned long long
+oes_router_lpm4_compact(
+                       struct oes_router_lpm4 * lpm_p
+                       );
+
+/**
+ * This function adds a prefix or replaces its value.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in] addr - prefix, host order
+ * @param[in] depth - prefix length 0..32
+ * @param[in] value - value returned by lookups, up to
+ *       OES_ROUTER_LPM4_VALUE_MAX
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_RESOURCES if no tbl8 group is left
+ */
+oes_status_e
+oes_router_lpm4_add(
+                   struct oes_router_lpm4 * lpm_p,
+                   const unsigned int  addr,
+                   const unsigned int  depth,
+                   const unsigned int  value
+                   );
+
+/**
+ * This function deletes a prefix. Addresses it covered fall
+ * back to the closest shorter prefix, which the caller passes
+ * since the LPM does not keep the rules.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in] addr - prefix, host order
+ * @param[in] depth - prefix length 0..32
+ * @param[in] parent_valid - a shorter prefix covers this one
+ * @param[in] parent_depth - length of the covering prefix
+ * @param[in] parent_value - value of the covering prefix
+ */
+void
+oes_router_lpm4_delete(
+                      struct oes_router_lpm4 * lpm_p,
+                      const unsigned int  addr,
+                      const unsigned int  depth,
+                      const int  parent_valid,
+                      const unsigned int  parent_depth,
+                      const unsigned int  parent_value
+                      );
+
+/**
+ * This function adds a list of prefixes at once. Prefixes up to
+ * /24 are spread over the threads by their first byte, each
+ * thread owning that part of tbl24 and the tbl8 groups hanging
+ * off it. Prefixes longer than /24 take tbl8 groups and are added
+ * last, by the calling thread.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in,out] rule_list_p - prefixes, failed is set on the
+ *       ones left out
+ * @param[in] cnt - list size
+ * @param[in] thread_cnt - thread count
+ *
+ * @return OES_STATUS_SUCCESS if all prefixes were added
+ * @return OES_STATUS_NO_MEMORY if the work list cannot be
+ *         allocated, no prefix is added
+ * @return OES_STATUS_NO_RESOURCES if tbl8 groups ran out
+ */
+oes_status_e
+oes_router_lpm4_add_bulk(
+                        struct oes_router_lpm4 * lpm_p,
+                        struct oes_router_lpm4_rule * rule_list_p,
+                        const unsigned int  cnt,
+                        const unsigned int  thread_cnt
+                        );
+
+/**
+ * This function looks up a list of addresses. All tbl24 entries
+ * are prefetched, then read (with AVX2 gathers when the CPU has
+ * them), then the tbl8 entries they point to are prefetched and
+ * read, so that the misses of the whole list overlap.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in] addr_list_p - addresses, host order
+ * @param[in] cnt - list size, up to OES_ROUTER_LPM_BULK_MAX
+ * @param[out] depth_list_p - matched prefix lengths
+ * @param[out] value_list_p - matched values
+ */
+void
+oes_router_lpm4_lookup_bulk(
+                           const struct oes_router_lpm4 * lpm_p,
+                           const unsigned int * addr_list_p,
+                           const unsigned int  cnt,
+                           unsigned char * depth_list_p,
+                           unsigned int * value_list_p
+                           );
+
+/*
+ * Longest prefix match, one tbl24 access plus one tbl8 access
+ * for addresses under a prefix longer than 24. Returns 0 when
+ * no prefix matches.
+ */
+static inline int
+oes_router_lpm4_lookup(
+                      const struct oes_router_lpm4 * lpm_p,
+                      const unsigned int  addr,
+                      unsigned int * depth_p,
+                      unsigned int * value_p
+                      )
+{
+    unsigned int entry = __atomic_load_n(&lpm_p->tbl24[addr >> 8], __ATOMIC_ACQUIRE);
+
+    if (entry & OES_ROUTER_LPM4_EXT) {
+        entry = __atomic_load_n(&lpm_p->tbl8[((entry & OES_ROUTER_LPM4_VALUE_MASK) << 8) | (addr & 0xff)],
+                                __ATOMIC_ACQUIRE);
+    }
+    if (entry == 0) {
+        if (!__atomic_load_n(&lpm_p->default_valid, __ATOMIC_ACQUIRE)) {
+            return 0;
+        }
+        *depth_p = 0;
+        *value_p = __atomic_load_n(&lpm_p->default_value, __ATOMIC_RELAXED);
+        return 1;
+    }
+    *depth_p = entry >> OES_ROUTER_LPM4_DEPTH_SHIFT;
+    *value_p = entry & OES_ROUTER_LPM4_VALUE_MASK;
+    return 1;
+}
+
+/************************************************
+ *  IPv6 LPM, tree bitmap
+ ***********************************************/
+
+/*
+ * The upper 16 bits index a direct table expanded like tbl24 for
+ * prefixes up to /16. Longer prefixes live in a tree bitmap of
+ * stride 8 hanging off the direct entries. A node at depth d
+ * holds the prefixes of length d+1..d+8 ending in it (the 510 bit
+ * internal bitmap, position (1 << r) - 2 + v for the r bit value
+ * v) and the children for the next 8 bits (the 256 bit external
+ * bitmap). /48 and /64 prefixes thus end in the node above their
+ * boundary instead of taking a node of their own. Results and
+ * children are stored inline, in bitmap order, and found by
+ * popcount.
+ *
+ * Nodes are never resized in place: a node whose bitmaps change
+ * is copied and the copy is linked with a single pointer store,
+ * the old one freed once no lookup can be in it.
+ *
+ * A small LPM has no direct table: all its prefixes hang off a
+ * root node at depth 0, so that it takes its nodes only, not a
+ * page of the direct table per /16 it touches. Expanding it maps
+ * the direct table and moves the nodes below /16 under it.
+ */
+#define OES_ROUTER_LPM6_DIRECT_BITS     16
+#define OES_ROUTER_LPM6_DIRECT_CNT      (1 << OES_ROUTER_LPM6_DIRECT_BITS)
+
+struct oes_router_lpm6_node {
+    unsigned long long  external[4];
+    unsigned short      child_cnt;
+    unsigned short      result_cnt;  /**< lookups skip internal, a line apart, when 0 */
+    unsigned long long  internal[8];
+    void              * slots[];     /**< children, then results packed as unsigned int */
+};
+
+struct oes_router_lpm6_direct {
+    unsigned int                  entry;    /**< depth and value as tbl24 entries, depth <= 16 */
+    struct oes_router_lpm6_node * node;
+};
+
+/* a prefix of a bulk build */
+struct oes_router_lpm6_rule {
+    struct in6_addr  addr;
+    unsigned int     value;
+    unsigned char    depth;
+    unsigned char    failed;        /**< set when the build could not add it */
+};
+
+struct oes_router_lpm6 {
+    struct oes_router_lpm6_direct * direct; /**< NULL until expanded */
+    struct oes_router_lpm6_node   * root;   /**< all the prefixes but /0 while not expanded */
+    unsigned long long            * direct_written; /**< direct granules written, see OES_ROUTER_MAP_GRANULE */
+    struct oes_router_pool        * pool;   /**< nodes are allocated from */
+    unsigned long long              node_bytes;
+    unsigned int                    node_cnt;
+    unsigned char                   default_valid;
+    unsigned int                    default_value;
+};
+
+/**
+ * This function sets up an IPv6 LPM, small: its prefixes are
+ * kept in nodes from the root until it is expanded. The LPM may
+ * be created lazily while lookups run on it, they miss until its
+ * first prefix.
+ *
+ * @param[in,out] lpm_p - LPM, zeroed
+ * @param[in] pool_p - pool the nodes are allocated from
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ */
+oes_status_e
+oes_router_lpm6_init(
+                    struct oes_router_lpm6 * lpm_p,
+                    struct oes_router_pool * pool_p
+                    );
+
+/**
+ * This function frees the nodes and unmaps the direct table of
+ * an IPv6 LPM. The caller waits for the lookups with
+ * oes_router_rcu_barrier() first.
+ *
+ * @param[in] lpm_p - LPM
+ */
+void
+oes_router_lpm6_deinit(
+                      struct oes_router_lpm6 * lpm_p
+                      );
+
+/**
+ * This function maps the direct table of a small IPv6 LPM. The
+ * prefixes up to /16 are expanded into it and the nodes below
+ * /16 linked from it as they are, the nodes above are freed once
+ * no lookup can be in them. Lookups go on meanwhile, on the tree
+ * until the direct table is published; the caller excludes
+ * updates.
+ *
+ * @param[in] lpm_p - LPM, not expanded
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the table cannot be mapped
+ */
+oes_status_e
+oes_router_lpm6_expand(
+                      struct oes_router_lpm6 * lpm_p
+                      );
+
+/**
+ * This function returns the bytes of the direct table of an IPv6 LPM
+ * backed by memory, the pages written.
+ *
+ * @param[in] lpm_p - LPM
+ *
+ * @return resident bytes, 0 when the LPM is not mapped
+ */
+unsigned long long
+oes_router_lpm6_table_bytes(
+                           const struct oes_router_lpm6 * lpm_p
+                           );
+
+/**
+ * This function reports the memory of an IPv6 LPM. Its entries
+ * are the direct table entries holding a prefix or a node, none
+ * while it is small, its free bytes the written direct table
+ * pages left empty, what compaction gives back. Nodes are sized to their contents and count as used.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[out] usage_p - usage, ratios left to the caller
+ */
+void
+oes_router_lpm6_usage(
+                     const struct oes_router_lpm6 * lpm_p,
+                     struct oes_router_table_usage * usage_p
+                     );
+
+/**
+ * This function drops the empty pages of the direct table of an
+ * IPv6 LPM. Lookups go on meanwhile; the caller excludes
+ * updates.
+ *
+ * @param[in] lpm_p - LPM
+ *
+ * @return resident bytes given back
+ */
+unsigned long long
+oes_router_lpm6_compact(
+                       struct oes_router_lpm6 * lpm_p
+                       );
+
+/**
+ * This function adds a prefix or replaces its value.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in] addr_p - prefix
+ * @param[in] depth - prefix length 0..128
+ * @param[in] value - value returned by lookups, up to
+ *       OES_ROUTER_LPM4_VALUE_MAX
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if a node cannot be allocated
+ */
+oes_status_e
+oes_router_lpm6_add(
+                   struct oes_router_lpm6 * lpm_p,
+                   const struct in6_addr * addr_p,
+                   const unsigned int  depth,
+                   const unsigned int  value
+                   );
+
+/**
+ * This function deletes a prefix. The closest shorter prefix is
+ * only needed for prefixes up to /16, expanded in the direct
+ * table.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in] addr_p - prefix
+ * @param[in] depth - prefix length 0..128
+ * @param[in] parent_valid - a shorter prefix covers this one
+ * @param[in] parent_depth - length of the covering prefix
+ * @param[in] parent_value - value of the covering prefix
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if a node cannot be allocated
+ */
+oes_status_e
+oes_router_lpm6_delete(
+                      struct oes_router_lpm6 * lpm_p,
+                      const struct in6_addr * addr_p,
+                      const unsigned int  depth,
+                      const int  parent_valid,
+                      const unsigned int  parent_depth,
+                      const unsigned int  parent_value
+                      );
+
+/**
+ * This function adds a list of prefixes at once. Prefixes longer
+ * than /16 are spread over the threads by direct entry. The tree
+ * of an entry without one is built bottom up from its sorted
+ * prefixes, each node allocated once at its final size, instead
+ * of being copied on every insert. A small LPM takes them one by
+ * one.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in,out] rule_list_p - prefixes, failed is set on the
+ *       ones left out
+ * @param[in] cnt - list size
+ * @param[in] thread_cnt - thread count
+ *
+ * @return OES_STATUS_SUCCESS if all prefixes were added
+ * @return OES_STATUS_NO_MEMORY if the work lists or some nodes
+ *         cannot be allocated
+ */
+oes_status_e
+oes_router_lpm6_add_bulk(
+                        struct oes_router_lpm6 * lpm_p,
+                        struct oes_router_lpm6_rule * rule_list_p,
+                        const unsigned int  cnt,
+                        const unsigned int  thread_cnt
+                        );
+
+/**
+ * This function looks up a list of addresses. The lookups walk
+ * the tree level by level together, each one prefetching its next
+ * node while the others are processed.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in] addr_list_p - addresses
+ * @param[in] cnt - list size, up to OES_ROUTER_LPM_BULK_MAX
+ * @param[out] depth_list_p - matched prefix lengths
+ * @param[out] value_list_p - matched values
+ */
+void
+oes_router_lpm6_lookup_bulk(
+                           const struct oes_router_lpm6 * lpm_p,
+                           const struct in6_addr * const * addr_list_p,
+                           const unsigned int  cnt,
+                           unsigned char * depth_list_p,
+                           unsigned int * value_list_p
+                           );
+
+static inline unsigned int
+oes_router_lpm6_rank(
+                    const unsigned long long * bitmap_p,
+                    const unsigned int  pos
+                    )
+{
+    unsigned int rank = 0, i;
+
+    for (i = 0; i < pos / 64; i++) {
+        rank += __builtin_popcountll(bitmap_p[i]);
+    }
+    if (pos % 64) {
+        rank += __builtin_popcountll(bitmap_p[pos / 64] & ((1ULL << (pos % 64)) - 1));
+    }
+    return rank;
+}
+
+static inline int
+oes_router_lpm6_bit(
+                   const unsigned long long * bitmap_p,
+                   const unsigned int  pos
+                   )
+{
+    return (bitmap_p[pos / 64] >> (pos % 64)) & 1;
+}
+
+/*
+ * Longest prefix match, one direct table access and one node per
+ * 8 bits below /16, or one node per 8 bits from the root while
+ * the LPM is small. Returns 0 when no prefix matches.
+ */
+static inline int
+oes_router_lpm6_lookup(
+                      const struct oes_router_lpm6 * lpm_p,
+                      const struct in6_addr * addr_p,
+                      unsigned int * depth_p,
+                      unsigned int * value_p
+                      )
+{
+    /* the root is cleared after the direct table is published */
+    const struct oes_router_lpm6_node *node_p = __atomic_load_n(&lpm_p->root, __ATOMIC_ACQUIRE);
+    const struct oes_router_lpm6_direct *direct_p = __atomic_load_n(&lpm_p->direct, __ATOMIC_ACQUIRE);
+    const struct oes_router_lpm6_node *best_p = NULL;
+    unsigned int depth = 0, best_pos = 0, best_depth = 0, byte, r, pos, entry;
+
+    if (direct_p != NULL) {
+        direct_p = &direct_p[(addr_p->s6_addr[0] << 8) | addr_p->s6_addr[1]];
+        node_p = __atomic_load_n(&direct_p->node, __ATOMIC_ACQUIRE);
+        depth = OES_ROUTER_LPM6_DIRECT_BITS;
+    }
+
+    while (node_p != NULL) {
+        byte = addr_p->s6_addr[depth / 8];
+        for (r = node_p->result_cnt ? 8 : 0; r > 0; r--) {
+            pos = (1 << r) - 2 + (byte >> (8 - r));
+            if (oes_router_lpm6_bit(node_p->internal, pos)) {
+                best_p = node_p;
+                best_pos = pos;
+                best_depth = depth + r;
+                break;
+            }
+        }
+        if ((depth == 120) || !oes_router_lpm6_bit(node_p->external, byte)) {
+            break;
+        }
+        node_p = __atomic_load_n(&node_p->slots[oes_router_lpm6_rank(node_p->external, byte)],
+                                 __ATOMIC_ACQUIRE);
+        depth += 8;
+    }
+
+    if (best_p != NULL) {
+        *depth_p = best_depth;
+        *value_p = __atomic_load_n(&((const unsigned int *)&best_p->slots[best_p->child_cnt])
+                                   [oes_router_lpm6_rank(best_p->internal, best_pos)], __ATOMIC_RELAXED);
+        return 1;
+    }
+    entry = (direct_p != NULL) ? __atomic_load_n(&direct_p->entry, __ATOMIC_RELAXED) : 0;
+    if (entry) {
+        *depth_p = entry >> OES_ROUTER_LPM4_DEPTH_SHIFT;
+        *value_p = entry & OES_ROUTER_LPM4_VALUE_MASK;
+        return 1;
+    }
+    if (__atomic_load_n(&lpm_p->default_valid, __ATOMIC_ACQUIRE)) {
+        *depth_p = 0;
+        *value_p = __atomic_load_n(&lpm_p->default_value, __ATOMIC_RELAXED);
+        return 1;
+    }
+    return 0;
+}
+
+/************************************************
+ *  Ordered routes
+ ***********************************************/
+
+/*
+ * The routes of a virtual router in key order, IP version, then
+ * address, then prefix length, so that GET_NEXT pages through
+ * the table from any prefix. A sorted array of route indexes cut
+ * into leaves, with the first key of each leaf alongside: a seek
+ * is a binary search over the first keys, then one in a leaf,
+ * and a change moves a leaf's entries only. Leaves split when
+ * full and merge with the next one when both run low. The keys
+ * are the caller's, read through key_get.
+ */
+#define OES_ROUTER_ORDER_LEAF 256
+
+struct oes_router_order_leaf {
+    unsigned int    cnt;
+    unsigned int    idx_list[OES_ROUTER_ORDER_LEAF];
+};
+
+struct oes_router_order_slot {
+    struct oes_ip_prefix            first;      /**< key of the leaf's first route */
+    struct oes_router_order_leaf  * leaf_p;
+};
+
+struct oes_router_order {
+    struct oes_router_pool          * pool;
+    const struct oes_ip_prefix    * (* key_get)(const void *ctx_p, const unsigned int idx);
+    const void                      * ctx_p;
+    struct oes_router_order_slot    * slots;    /**< leaves in key order */
+    unsigned int                      leaf_cnt;
+    unsigned int                      leaf_size;
+    unsigned int                      cnt;
+};
+
+/**
+ * This function sets up an empty order.
+ *
+ * @param[out] order_p - route order
+ * @param[in] pool_p - pool the leaves are allocated from
+ * @param[in] key_get - returns the key of a route index
+ * @param[in] ctx_p - key_get context
+ */
+void
+oes_router_order_init(
+                     struct oes_router_order * order_p,
+                     struct oes_router_pool * pool_p,
+                     const struct oes_ip_prefix * (*key_get)(const void *ctx_p, const unsigned int idx),
+                     const void * ctx_p
+                     );
+
+/**
+ * This function frees all the leaves of an order.
+ *
+ * @param[in] order_p - route order
+ */
+void
+oes_router_order_deinit(
+                       struct oes_router_order * order_p
+                       );
+
+/**
+ * This function builds an empty order from a list of routes, in
+ * any order, sorting them once. Leaves are filled to three
+ * quarters, leaving room for the routes added next.
+ *
+ * @param[in] order_p - route order, empty
+ * @param[in] idx_list_p - route indexes
+ * @param[in] cnt - number of routes
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the order cannot be allocated
+ */
+oes_status_e
+oes_router_order_build(
+                      struct oes_router_order * order_p,
+                      const unsigned int * idx_list_p,
+                      const unsigned int  cnt
+                      );
+
+/**
+ * This function adds a route to an order, its key set already.
+ *
+ * @param[in] order_p - route order
+ * @param[in] idx - route index
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if a leaf cannot be split
+ */
+oes_status_e
+oes_router_order_insert(
+                       struct oes_router_order * order_p,
+                       const unsigned int  idx
+                       );
+
+/**
+ * This function deletes a route from an order, its key still
+ * set.
+ *
+ * @param[in] order_p - route order
+ * @param[in] idx - route index
+ */
+void
+oes_router_order_remove(
+                       struct oes_router_order * order_p,
+                       const unsigned int  idx
+                       );
+
+/**
+ * This function lists, in key order, the first routes after a
+ * key, which need not be a route's.
+ *
+ * @param[in] order_p - route order
+ * @param[in] after_p - key, NULL to start from the first route
+ * @param[out] idx_list_p - route indexes
+ * @param[in] cnt - list size
+ *
+ * @return number of routes listed
+ */
+unsigned int
+oes_router_order_list(
+                     const struct oes_router_order * order_p,
+                     const struct oes_ip_prefix * after_p,
+                     unsigned int * idx_list_p,
+                     const unsigned int  cnt
+                     );
+
+/************************************************
+ *  Next-hop groups
+ ***********************************************/
+
+/*
+ * Next-hop sets are interned: routes with the same next hops, in
+ * any order, share one refcounted group found through a hash of
+ * the sorted list, so memory scales with distinct groups rather
+ * than with routes. A route stores the group ID only, changing
+ * the members of a group changes the next hops of all its routes.
+ *
+ * A resilient group maps the hash to one of bucket_cnt buckets,
+ * each bucket holding a member. When a member leaves, only its
+ * buckets move. Buckets of members above their share move to the
+ * members below it once they have been idle for idle_timer ms,
+ * so flows in progress keep their next hop. Forwarded flows mark
+ * their bucket used, a periodic upkeep moves the idle ones.
+ *
+ * A group counts its members with a neighbor, routes forwarding
+ * to it trap while there is none. The router records each member
+ * of a group with the neighbor entry of its address. Routes do
+ * not store what the group resolves to: lookups read it from the
+ * fwd array, one byte per group, so that adding or deleting a
+ * neighbor, or changing the members of a group, updates the
+ * groups depending on it whatever the number of their routes.
+ * The array is replaced when the table grows, lookups may still
+ * read the old one until they are done.
+ */
+#define OES_ROUTER_NHG_BUCKET_MEMBER_MASK 0xffff
+#define OES_ROUTER_NHG_BUCKET_TIME_SHIFT  16
+
+struct oes_router_nhg_dep {
+    unsigned int    neigh_idx;          /**< neighbor entry of the member's address */
+    unsigned int    pos;                /**< position in the entry's dependents */
+};
+
+struct oes_router_nhg {
+    unsigned int          ref_cnt;        /**< routes using the group, 0 for a free group */
+    unsigned int          hash_next;      /**< next group of the hash chain or free list, + 1 */
+    unsigned int          hash;           /**< hash of the member list */
+    unsigned short        next_hop_cnt;
+    unsigned short        bucket_cnt;     /**< 0 for plain hashing */
+    unsigned int          idle_timer;     /**< ms */
+    struct oes_ip_addr  * next_hop_list;  /**< sorted by oes_router_ip_addr_cmp */
+    unsigned long long  * buckets;        /**< member index and last use in ms */
+    unsigned int        * occupancy;      /**< buckets per member */
+    unsigned int          resolved_cnt;   /**< members with a neighbor */
+    struct oes_router_nhg_dep * deps;     /**< per member */
+};
+
+struct oes_router_nhg_table {
+    struct oes_router_pool* pool;
+    struct oes_router_nhg * nhgs;
+    unsigned int            nhg_size;
+    unsigned int            nhg_cnt;
+    unsigned int            nhg_free;     /**< free group list, + 1 */
+    unsigned int          * hash;         /**< chain heads, group ID + 1 */
+    unsigned int            hash_size;
+    unsigned char         * fwd;          /**< per group, action of its FORWARD routes */
+};
+
+static inline int
+oes_router_ip_addr_cmp(
+                      const struct oes_ip_addr * a_p,
+                      const struct oes_ip_addr * b_p
+                      )
+{
+    if (a_p->version != b_p->version) {
+        return (a_p->version < b_p->version) ? -1 : 1;
+    }
+    if (a_p->version == OES_IPV4) {
+        return memcmp(&a_p->addr.ipv4, &b_p->addr.ipv4, sizeof(struct in_addr));
+    }
+    return memcmp(&a_p->addr.ipv6, &b_p->addr.ipv6, sizeof(struct in6_addr));
+}
+
+/*
+ * The action a FORWARD route of a group takes, read by lookups
+ * without the lock. The group ID must have been loaded with
+ * acquire ordering, so that the array holds it.
+ */
+static inline enum oes_router_action
+oes_router_nhg_action(
+                     const struct oes_router_nhg_table * table_p,
+                     const unsigned int  nhg_id
+                     )
+{
+    const unsigned char *fwd_p = __atomic_load_n(&table_p->fwd, __ATOMIC_ACQUIRE);
+
+    return (enum oes_router_action)__atomic_load_n(&fwd_p[nhg_id], __ATOMIC_RELAXED);
+}
+
+/**
+ * This function sets up an empty table.
+ *
+ * @param[out] table_p - next-hop group table
+ * @param[in] pool_p - pool the groups are allocated from
+ */
+void
+oes_router_nhg_table_init(
+                         struct oes_router_nhg_table * table_p,
+                         struct oes_router_pool * pool_p
+                         );
+
+/**
+ * This function frees all the groups of a table.
+ *
+ * @param[in] table_p - next-hop group table
+ */
+void
+oes_router_nhg_table_deinit(
+                           struct oes_router_nhg_table * table_p
+                           );
+
+/**
+ * This function takes a reference on the group of a next-hop
+ * set, creating it when the set is new.
+ *
+ * @param[in] table_p - next-hop group table
+ * @param[in] next_hop_list_p - next hops, in any order
+ * @param[in] next_hop_cnt - number of next hops, 0 gives
+ *       OES_ROUTER_NEXT_HOP_GROUP_INVALID
+ * @param[in] bucket_cnt - resilient hashing buckets, 0 for plain
+ *       hashing
+ * @param[in] idle_timer - ms before an idle bucket moves
+ * @param[out] nhg_id_p - group ID
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_ERROR if a next hop is repeated or the
+ *         next hops mix IP versions
+ * @return OES_STATUS_NO_MEMORY if the group cannot be allocated
+ */
+oes_status_e
+oes_router_nhg_get(
+                  struct oes_router_nhg_table * table_p,
+                  const struct oes_ip_addr * next_hop_list_p,
+                  const unsigned short  next_hop_cnt,
+                  const unsigned short  bucket_cnt,
+                  const unsigned int  idle_timer,
+                  unsigned int * nhg_id_p
+                  );
+
+/**
+ * This function drops a reference on a group, freeing it with
+ * the last one.
+ *
+ * @param[in] table_p - next-hop group table
+ * @param[in] nhg_id - group ID, OES_ROUTER_NEXT_HOP_GROUP_INVALID
+ *       is ignored
+ */
+void
+oes_router_nhg_put(
+                  struct oes_router_nhg_table * table_p,
+                  const unsigned int  nhg_id
+                  );
+
+/**
+ * This function returns a group in use, NULL for an invalid or
+ * free group ID.
+ *
+ * @param[in] table_p - next-hop group table
+ * @param[in] nhg_id - group ID
+ *
+ * @return the group
+ */
+struct oes_router_nhg *
+oes_router_nhg_find(
+                   const struct oes_router_nhg_table * table_p,
+                   const unsigned int  nhg_id
+                   );
+
+/**
+ * This function sets the action the FORWARD routes of a group
+ * take from its resolved members, lookups see it at once.
+ *
+ * @param[in] table_p - next-hop group table
+ * @param[in] nhg_id - group ID
+ */
+void
+oes_router_nhg_fwd_update(
+                         struct oes_router_nhg_table * table_p,
+                         const unsigned int  nhg_id
+                         );
+
+/**
+ * This function adds, deletes or replaces the members of a group
+ * in place. A group whose members become equal to another group's
+ * keeps its ID, new routes with that set share the older group.
+ *
+ * @param[in] table_p - next-hop group table
+ * @param[in] access_cmd - ADD/DELETE/EDIT
+ * @param[in] nhg_id - group ID
+ * @param[in] next_hop_list_p - next hops to add, delete or set
+ * @param[in] next_hop_cnt - number of next hops
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_ERROR if the group would be left empty,
+ *         with more members than buckets, with a member twice or
+ *         with members of both IP versions
+ * @return OES_STATUS_ENTRY_NOT_FOUND if a deleted next hop is not a
+ *         member
+ * @return OES_STATUS_NO_MEMORY if the list cannot be allocated
+ */
+oes_status_e
+oes_router_nhg_members_set(
+                          struct oes_router_nhg_table * table_p,
+                          const enum oes_access_cmd  access_cmd,
+                          const unsigned int  nhg_id,
+                          const struct oes_ip_addr * next_hop_list_p,
+                          const unsigned short  next_hop_cnt
+                          );
+
+/**
+ * This function returns the member of a group a flow hash
+ * selects. It does not record the use of the bucket, see
+ * oes_router_nhg_bucket_use.
+ *
+ * @param[in] nhg_p - group
+ * @param[in] hash - flow hash
+ *
+ * @return index in the next-hop list
+ */
+unsigned int
+oes_router_nhg_member_select(
+                            const struct oes_router_nhg * nhg_p,
+                            const unsigned int  hash
+                            );
+
+/**
+ * This function records traffic on the bucket of a flow hash in
+ * a resilient group, which keeps the bucket on its member for
+ * the idle timer. Only the time of the bucket changes. Runs
+ * under the read lock.
+ *
+ * @param[in] nhg_p - group
+ * @param[in] hash - flow hash
+ * @param[in] now - time in ms, oes_router_nhg_now
+ */
+void
+oes_router_nhg_bucket_use(
+                         struct oes_router_nhg * nhg_p,
+                         const unsigned int  hash,
+                         const unsigned long long  now
+                         );
+
+/**
+ * This function moves the idle buckets of the members above their
+ * share to the members below it, in all the resilient groups of
+ * a table. Runs under the write lock.
+ *
+ * @param[in] table_p - next-hop group table
+ *
+ * @return number of buckets moved
+ */
+unsigned int
+oes_router_nhg_buckets_upkeep(
+                             struct oes_router_nhg_table * table_p
+                             );
+
+/**
+ * This function returns the time of the bucket tables, in ms.
+ *
+ * @return monotonic time in ms
+ */
+unsigned long long
+oes_router_nhg_now(void);
+
+/************************************************
+ *  Neighbors
+ ***********************************************/
+
+/*
+ * Neighbors of a virtual router, in an array of entries reused
+ * through a free list and found through a chained hash of their
+ * address. The table is allocated on the first neighbor.
+ *
+ * An entry also lists the next-hop group members with its
+ * address, the dependents. An address which is a next hop but
+ * was not added as a neighbor keeps an unresolved entry holding
+ * its dependents only.
+ *
+ * Traffic to a neighbor sets its bit in a dense activity bitmap
+ * indexed like the entries, apart from them, so that a sweep of
+ * the activity scans bits rather than entries. The activity reads
+ * and the aging both consume it: its bits are moved into a
+ * bitmap of each reader, so that neither clears the traffic the
+ * other has not seen.
+ */
+struct oes_router_neigh_dep {
+    unsigned int    nhg_id;
+    unsigned int  * pos_p;                  /**< where the group keeps the position of the entry */
+};
+
+struct oes_router_neigh {
+    struct oes_ip_addr              addr;
+    struct ether_addr               mac;
+    unsigned char                   in_use;
+    unsigned char                   resolved;   /**< added as a neighbor */
+    enum oes_router_action          action;
+    unsigned int                    rif;
+    unsigned int                    hash;
+    unsigned int                    hash_next;  /**< next neighbor of the hash chain or free list, + 1 */
+    struct oes_router_neigh_dep   * dep_list;
+    unsigned int                    dep_cnt;
+    unsigned int                    dep_size;
+    unsigned char                   aging;      /**< on the aging wheel */
+    unsigned int                    age_prev;   /**< previous neighbor of the wheel slot, + 1 */
+    unsigned int                    age_next;   /**< next neighbor of the wheel slot, + 1 */
+    unsigned long long              age_tick;   /**< wheel tick the neighbor is due at */
+    unsigned int                    refresh_cnt;/**< refresh events since the last traffic */
+};
+
+struct oes_router_neigh_table {
+    struct oes_router_pool  * pool;
+    struct oes_router_neigh * neighs;
+    unsigned int              neigh_size;
+    unsigned int              neigh_cnt;
+    unsigned int              neigh_free;   /**< free neighbor list, + 1 */
+    unsigned int              resolved_cnt;
+    unsigned int            * hash;         /**< chain heads, neighbor index + 1 */
+    unsigned int              hash_size;
+    unsigned long long      * activity;     /**< a bit per entry, set by traffic since it was moved */
+    unsigned long long      * activity_read;/**< traffic the activity reads have not cleared */
+    unsigned long long      * activity_age; /**< traffic the aging has not cleared */
+};
+
+/**
+ * This function sets up an empty table.
+ *
+ * @param[out] table_p - neighbor table
+ * @param[in] pool_p - pool the neighbors are allocated from
+ */
+void
+oes_router_neigh_table_init(
+                           struct oes_router_neigh_table * table_p,
+                           struct oes_router_pool * pool_p
+                           );
+
+/**
+ * This function frees all the neighbors of a table.
+ *
+ * @param[in] table_p - neighbor table
+ */
+void
+oes_router_neigh_table_deinit(
+                             struct oes_router_neigh_table * table_p
+                             );
+
+/**
+ * This function returns the entry of an address, resolved or
+ * not, NULL if there is none.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] addr_p - neighbor address
+ *
+ * @return the neighbor
+ */
+struct oes_router_neigh *
+oes_router_neigh_find(
+                     const struct oes_router_neigh_table * table_p,
+                     const struct oes_ip_addr * addr_p
+                     );
+
+/**
+ * This function adds an unresolved entry with an address not in
+ * the table yet. The caller sets its data.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] addr_p - neighbor address
+ * @param[out] neigh_pp - neighbor
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the table cannot grow
+ */
+oes_status_e
+oes_router_neigh_add(
+                    struct oes_router_neigh_table * table_p,
+                    const struct oes_ip_addr * addr_p,
+                    struct oes_router_neigh ** neigh_pp
+                    );
+
+/**
+ * This function deletes an entry, with its dependents.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ */
+void
+oes_router_neigh_delete(
+                       struct oes_router_neigh_table * table_p,
+                       struct oes_router_neigh * neigh_p
+                       );
+
+/**
+ * This function marks an entry resolved or not. An unresolved
+ * entry has no activity.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ * @param[in] resolved - 1 once added as a neighbor, 0 once deleted
+ */
+void
+oes_router_neigh_resolved_set(
+                             struct oes_router_neigh_table * table_p,
+                             struct oes_router_neigh * neigh_p,
+                             const int  resolved
+                             );
+
+/**
+ * This function records traffic to a neighbor. Runs under the
+ * read lock.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] idx - entry index
+ */
+void
+oes_router_neigh_activity_set(
+                             struct oes_router_neigh_table * table_p,
+                             const unsigned int  idx
+                             );
+
+/**
+ * This function returns whether a neighbor had traffic, and
+ * clears its activity if asked. Runs under the read lock.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ * @param[in] clear - clear the activity read
+ *
+ * @return 1 if the neighbor had traffic, 0 otherwise
+ */
+int
+oes_router_neigh_activity_get(
+                             struct oes_router_neigh_table * table_p,
+                             const struct oes_router_neigh * neigh_p,
+                             const int  clear
+                             );
+
+/**
+ * This function returns whether a neighbor had traffic since the
+ * aging last asked, and clears it for the aging only.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ *
+ * @return 1 if the neighbor had traffic, 0 otherwise
+ */
+int
+oes_router_neigh_activity_age(
+                             struct oes_router_neigh_table * table_p,
+                             const struct oes_router_neigh * neigh_p
+                             );
+
+/**
+ * This function lists the resolved neighbors which had traffic,
+ * or those which had none, in entry order. It scans the activity
+ * bitmap, the entries of the inactive neighbors only. The
+ * activity is cleared when all neighbors found fit in the list,
+ * traffic during the sweep is kept for the next one. Runs under
+ * the read lock.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] active - 1 for the neighbors with traffic, 0 for
+ *       those without
+ * @param[in] clear - clear the activity swept
+ * @param[out] neigh_list_pp - neighbors
+ * @param[in] cnt - list size
+ *
+ * @return number of neighbors found, the list holds up to cnt
+ */
+unsigned int
+oes_router_neigh_activity_sweep(
+                               struct oes_router_neigh_table * table_p,
+                               const int  active,
+                               const int  clear,
+                               struct oes_router_neigh ** neigh_list_pp,
+                               const unsigned int  cnt
+                               );
+
+/**
+ * This function records a group member depending on an entry.
+ * Its position in the dependents is kept at pos_p, and updated
+ * when it moves.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ * @param[in] nhg_id - group ID
+ * @param[out] pos_p - position of the dependent
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the dependents cannot grow
+ */
+oes_status_e
+oes_router_neigh_dep_add(
+                        struct oes_router_neigh_table * table_p,
+                        struct oes_router_neigh * neigh_p,
+                        const unsigned int  nhg_id,
+                        unsigned int * pos_p
+                        );
+
+/**
+ * This function removes a dependent of an entry.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ * @param[in] pos - position of the dependent
+ */
+void
+oes_router_neigh_dep_delete(
+                           struct oes_router_neigh_table * table_p,
+                           struct oes_router_neigh * neigh_p,
+                           const unsigned int  pos
+                           );
+
+/**
+ * This function lists, in address order, the first resolved
+ * neighbors after an address. It walks the whole table.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] after_p - address, NULL to start from the first
+ *       neighbor
+ * @param[out] neigh_list_pp - neighbors
+ * @param[in] cnt - list size
+ *
+ * @return number of neighbors listed
+ */
+unsigned int
+oes_router_neigh_list(
+                     const struct oes_router_neigh_table * table_p,
+                     const struct oes_ip_addr * after_p,
+                     struct oes_router_neigh ** neigh_list_pp,
+                     const unsigned int  cnt
+                     );
+
+/************************************************
+ *  Multicast routes
+ ***********************************************/
+
+/*
+ * Multicast routes of a virtual router, keyed on (source, group,
+ * ingress interface), in an array of entries reused through a
+ * free list and found through a chained hash. A (*,G) route has
+ * a zero source; one for any ingress interface has
+ * OES_ROUTER_INTERFACE_INVALID. A lookup takes the (S,G) route,
+ * else the (*,G) route of the ingress interface, else the one of
+ * any interface. The table is allocated on the first route and
+ * freed as a whole by DELETE_ALL.
+ *
+ * Egress interface lists are interned: the routes with the same
+ * interfaces, such as the (S,G) routes of the senders of a
+ * group, share one refcounted list, kept sorted so that equal
+ * lists hash alike. A shared list is never written, a change
+ * makes the route take the list it changes to, interned in turn,
+ * and drops its hold on the old one.
+ */
+struct oes_router_mc_key {
+    struct oes_ip_addr          group;
+    struct oes_ip_addr          source;         /**< zero for (*,G) */
+    unsigned int                ingress_rif;
+};
+
+struct oes_router_mc_rifs {
+    struct oes_router_mc_rifs * hash_next;
+    unsigned int                hash;
+    unsigned int                ref_cnt;        /**< routes holding the list */
+    unsigned int                rif_cnt;
+    unsigned int                rif_list[];     /**< ascending */
+};
+
+struct oes_router_mc_route {
+    struct oes_router_mc_key    key;
+    struct oes_mc_router_action action;
+    struct oes_router_mc_rifs * rifs;           /**< NULL for none */
+    unsigned int                hash;
+    unsigned int                hash_next;      /**< next route of the hash chain or free list, + 1 */
+    unsigned char               in_use;
+};
+
+struct oes_router_mc_table {
+    struct oes_router_pool      * pool;
+    struct oes_router_mc_route  * routes;
+    unsigned int                  route_size;
+    unsigned int                  route_cnt;
+    unsigned int                  route_free;   /**< free route list, + 1 */
+    unsigned int                * hash;         /**< chain heads, route index + 1 */
+    unsigned int                  hash_size;
+    unsigned int                  any_rif_cnt;  /**< (*,G) routes of any ingress interface */
+    struct oes_router_mc_rifs  ** rifs_hash;    /**< interned egress interface lists */
+    unsigned int                  rifs_hash_size;
+    unsigned int                  rifs_cnt;
+};
+
+/* the number of egress interfaces of a route */
+static inline unsigned int
+oes_router_mc_rif_cnt(const struct oes_router_mc_route *route_p)
+{
+    return (route_p->rifs != NULL) ? route_p->rifs->rif_cnt : 0;
+}
+
+/* whether an interface is an egress interface of a route */
+static inline int
+oes_router_mc_rif_has(const struct oes_router_mc_route *route_p, const unsigned int rif)
+{
+    unsigned int low = 0, high = oes_router_mc_rif_cnt(route_p), mid;
+
+    while (low < high) {
+        mid = (low + high) / 2;
+        if (route_p->rifs->rif_list[mid] == rif) {
+            return 1;
+        }
+        if (route_p->rifs->rif_list[mid] < rif) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return 0;
+}
+
+/**
+ * This function sets up an empty table.
+ *
+ * @param[out] table_p - multicast route table
+ * @param[in] pool_p - pool the routes are allocated from
+ */
+void
+oes_router_mc_table_init(
+                        struct oes_router_mc_table * table_p,
+                        struct oes_router_pool * pool_p
+                        );
+
+/**
+ * This function frees all the routes of a table at once.
+ *
+ * @param[in] table_p - multicast route table
+ */
+void
+oes_router_mc_table_deinit(
+                          struct oes_router_mc_table * table_p
+                          );
+
+/**
+ * This function returns the route of a key, NULL if there is
+ * none.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] key_p - route key
+ *
+ * @return the route
+ */
+struct oes_router_mc_route *
+oes_router_mc_find(
+                  const struct oes_router_mc_table * table_p,
+                  const struct oes_router_mc_key * key_p
+                  );
+
+/**
+ * This function looks up the route of a packet: its (S,G) route,
+ * else the (*,G) route of its ingress interface, else the (*,G)
+ * route of any interface.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] key_p - source, group and ingress interface of the
+ *       packet
+ *
+ * @return the route, NULL if none matches
+ */
+const struct oes_router_mc_route *
+oes_router_mc_lookup(
+                    const struct oes_router_mc_table * table_p,
+                    const struct oes_router_mc_key * key_p
+                    );
+
+/**
+ * This function looks up the routes of a list of packets like
+ * oes_router_mc_lookup(). The chain heads of all of them are
+ * fetched before any chain is walked, so that the cache misses
+ * overlap.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] key_list_p - packet keys
+ * @param[in] cnt - number of keys, up to OES_ROUTER_MC_BULK_MAX
+ * @param[out] route_list_pp - routes, NULL if none matches
+ */
+#define OES_ROUTER_MC_BULK_MAX 64
+
+void
+oes_router_mc_lookup_bulk(
+                         const struct oes_router_mc_table * table_p,
+                         const struct oes_router_mc_key * key_list_p,
+                         const unsigned int  cnt,
+                         const struct oes_router_mc_route ** route_list_pp
+                         );
+
+/**
+ * This function adds a route with a key not in the table yet,
+ * without egress interfaces. The caller sets its action.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] key_p - route key
+ * @param[out] route_pp - route
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the table cannot grow
+ */
+oes_status_e
+oes_router_mc_add(
+                 struct oes_router_mc_table * table_p,
+                 const struct oes_router_mc_key * key_p,
+                 struct oes_router_mc_route ** route_pp
+                 );
+
+/**
+ * This function deletes a route.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] route_p - route
+ */
+void
+oes_router_mc_delete(
+                    struct oes_router_mc_table * table_p,
+                    struct oes_router_mc_route * route_p
+                    );
+
+/**
+ * This function sets the egress interfaces of a route, taking
+ * the interned list of them. Duplicates are dropped. The route
+ * is left as it was on failure.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] route_p - route
+ * @param[in] rif_list_p - egress interfaces, in any order
+ * @param[in] rif_cnt - number of interfaces
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_EXCEEDS_RANGE if the route would get
+ *         more than 65535 interfaces
+ * @return OES_STATUS_NO_MEMORY if the list cannot be allocated
+ */
+oes_status_e
+oes_router_mc_rifs_set(
+                      struct oes_router_mc_table * table_p,
+                      struct oes_router_mc_route * route_p,
+                      const unsigned int * rif_list_p,
+                      const unsigned int  rif_cnt
+                      );
+
+/**
+ * This function adds egress interfaces to a route, or deletes
+ * them from it. Interfaces the route has already, or has not
+ * for a delete, are skipped. The route takes the interned list
+ * it changes to, the list it had is left to the other routes
+ * holding it.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] route_p - route
+ * @param[in] add - 1 to add, 0 to delete
+ * @param[in] rif_list_p - egress interfaces
+ * @param[in] rif_cnt - number of interfaces
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_EXCEEDS_RANGE if the route would get
+ *         more than 65535 interfaces
+ * @return OES_STATUS_NO_MEMORY if the list cannot be allocated
+ */
+oes_status_e
+oes_router_mc_rifs_update(
+                         struct oes_router_mc_table * table_p,
+                         struct oes_router_mc_route * route_p,
+                         const int  add,
+                         const unsigned int * rif_list_p,
+                         const unsigned int  rif_cnt
+                         );
+
+/**
+ * This function empties the egress interfaces of a route. It
+ * allocates nothing and cannot fail.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] route_p - route
+ */
+void
+oes_router_mc_rifs_clear(
+                        struct oes_router_mc_table * table_p,
+                        struct oes_router_mc_route * route_p
+                        );
+
+/**
+ * This function lists, in key order, the first routes after a
+ * key. It walks the whole table.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] after_p - key, NULL to start from the first route
+ * @param[out] route_list_pp - routes
+ * @param[in] cnt - list size
+ *
+ * @return number of routes listed
+ */
+unsigned int
+oes_router_mc_list(
+                  const struct oes_router_mc_table * table_p,
+                  const struct oes_router_mc_key * after_p,
+                  struct oes_router_mc_route ** route_list_pp,
+                  const unsigned int  cnt
+                  );
+
+/************************************************
+ *  Router interfaces
+ ***********************************************/
+
+/*
+ * Router interfaces of all the virtual routers, in a dense array
+ * indexed by rif and reused through a free list, so that rifs
+ * stay small and finding one is an array access. An L2
+ * interface, a (bridge, VLAN) or a port, has at most one router
+ * interface: a chained hash of the L2 interfaces finds it.
+ *
+ * The MACs frames are routed for, the one of the interface
+ * attributes and those added to it, are entries of a second
+ * chained hash keyed on (L2 interface, MAC), which answers the
+ * "is this my router MAC" check of the data path in one probe.
+ * An entry is kept while it is either the interface MAC or
+ * added, so that both can name the same MAC.
+ */
+#define OES_ROUTER_RIF_MAX      (1 << 16)
+#define OES_ROUTER_RIF_MAC_MAX  0xffff
+
+struct oes_router_rif {
+    struct oes_l3_interface             ifc;
+    struct oes_l3_interface_attributes  attr;
+    struct oes_l3_interface_admin_state admin_state;
+    unsigned char                       in_use;
+    unsigned int                        vrid;
+    unsigned int                        hash_next;  /**< next interface of the L2 hash chain or free list, + 1 */
+    unsigned int                        mac_head;   /**< first MAC entry of the interface, + 1 */
+    unsigned int                        mac_added;  /**< MACs added to the interface */
+};
+
+struct oes_router_rif_mac {
+    unsigned long long  l2;         /**< L2 interface key */
+    struct ether_addr   mac;
+    unsigned char       primary;    /**< MAC of the interface attributes */
+    unsigned char       added;      /**< added to the interface */
+    unsigned int        rif;
+    unsigned int        hash;
+    unsigned int        hash_next;  /**< next entry of the hash chain or free list, + 1 */
+    unsigned int        rif_next;   /**< next entry of the interface, + 1 */
+};
+
+struct oes_router_rif_table {
+    struct oes_router_pool    * pool;
+    struct oes_router_rif     * rifs;
+    unsigned int                rif_size;
+    unsigned int                rif_cnt;
+    unsigned int                rif_free;   /**< free interface list, + 1 */
+    unsigned int              * l2_hash;    /**< chain heads, rif + 1 */
+    struct oes_router_rif_mac * macs;
+    unsigned int                mac_size;
+    unsigned int                mac_cnt;
+    unsigned int                mac_free;   /**< free entry list, + 1 */
+    unsigned int              * mac_hash;   /**< chain heads, entry index + 1 */
+};
+
+/**
+ * This function sets up an empty table.
+ *
+ * @param[out] table_p - router interface table
+ * @param[in] pool_p - pool the interfaces are allocated from
+ */
+void
+oes_router_rif_table_init(
+                         struct oes_router_rif_table * table_p,
+                         struct oes_router_pool * pool_p
+                         );
+
+/**
+ * This function frees all the interfaces of a table.
+ *
+ * @param[in] table_p - router interface table
+ */
+void
+oes_router_rif_table_deinit(
+                           struct oes_router_rif_table * table_p
+                           );
+
+/* interface of a rif, NULL if there is none */
+static inline struct oes_router_rif *
+oes_router_rif_get(
+                  const struct oes_router_rif_table * table_p,
+                  const unsigned int  rif
+                  )
+{
+    return ((rif < table_p->rif_size) && table_p->rifs[rif].in_use) ? &table_p->rifs[rif] : NULL;
+}
+
+/**
+ * This function adds an interface on an L2 interface without
+ * one, with its MAC. Its admin state is down for both IP
+ * versions.
+ *
+ * @param[in] table_p - router interface table
+ * @param[in] vrid - virtual router of the interface
+ * @param[in] ifc_p - L2 interface
+ * @param[in] attr_p - interface attributes
+ * @param[out] rif_p - rif
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_ERROR if the L2 interface is invalid
+ * @return OES_STATUS_ENTRY_ALREADY_EXISTS if the L2 interface has
+ *         a router interface
+ * @return OES_STATUS_NO_RESOURCES if there are
+ *         OES_ROUTER_RIF_MAX interfaces
+ * @return OES_STATUS_NO_MEMORY if the table cannot grow
+ */
+oes_status_e
+oes_router_rif_add(
+                  struct oes_router_rif_table * table_p,
+                  const unsigned int  vrid,
+                  const struct oes_l3_interface * ifc_p,
+                  const struct oes_l3_interface_attributes * attr_p,
+                  unsigned int * rif_p
+                  );
+
+/**
+ * This function deletes an interface, with its MACs.
+ *
+ * @param[in] table_p - router interface table
+ * @param[in] rif_p - interface
+ */
+void
+oes_router_rif_delete(
+                     struct oes_router_rif_table * table_p,
+                     struct oes_router_rif * rif_p
+                     );
+
+/**
+ * This function sets the attributes of an interface, moving its
+ * MAC in the hash when it changes.
+ *
+ * @param[in] table_p - router interface table
+ * @param[in] rif_p - interface
+ * @param[in] attr_p - interface attributes
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the table cannot grow
+ */
+oes_status_e
+oes_router_rif_attr_set(
+                       struct oes_router_rif_table * table_p,
+                       struct oes_router_rif * rif_p,
+                       const struct oes_l3_interface_attributes * attr_p
+                       );
+
+/**
+ * This function adds MACs to an interface, or deletes them from
+ * it. MACs the interface has already, or has not for a delete,
+ * are skipped. The table grows first, an add changes all the
+ * MACs or none.
+ *
+ * @param[in] table_p - router interface table
+ * @param[in] rif_p - interface
+ * @param[in] add - 1 to add, 0 to delete
+ * @param[in] mac_list_p - MACs
+ * @param[in] mac_cnt - number of MACs
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_EXCEEDS_RANGE if the interface would
+ *         get more than OES_ROUTER_RIF_MAC_MAX MACs
+ * @return OES_STATUS_NO_MEMORY if the table cannot grow
+ */
+oes_status_e
+oes_router_rif_macs_update(
+                          struct oes_router_rif_table * table_p,
+                          struct oes_router_rif * rif_p,
+                          const int  add,
+                          const struct ether_addr * mac_list_p,
+                          const unsigned int  mac_cnt
+                          );
+
+/**
+ * This function deletes all the MACs added to an interface, its
+ * own MAC stays.
+ *
+ * @param[in] table_p - router interface table
+ * @param[in] rif_p - interface
+ */
+void
+oes_router_rif_macs_clear(
+                         struct oes_router_rif_table * table_p,
+                         struct oes_router_rif * rif_p
+                         );
+
+/**
+ * This function lists the MACs added to an interface, the
+ * latest first.
+ *
+ * @param[in] table_p - router interface table
+ * @param[in] rif_p - interface
+ * @param[out] mac_list_p - MACs
+ * @param[in] cnt - list size
+ *
+ * @return number of MACs listed
+ */
+unsigned int
+oes_router_rif_macs_list(
+                        const struct oes_router_rif_table * table_p,
+                        const struct oes_router_rif * rif_p,
+                        struct ether_addr * mac_list_p,
+                        const unsigned int  cnt
+                        );
+
+/**
+ * This function returns the interface of an L2 interface which
+ * has a MAC, NULL if there is none.
+ *
+ * @param[in] table_p - router interface table
+ * @param[in] ifc_p - L2 interface
+ * @param[in] mac_p - MAC
+ *
+ * @return the interface
+ */
+struct oes_router_rif *
+oes_router_rif_lookup(
+                     const struct oes_router_rif_table * table_p,
+                     const struct oes_l3_interface * ifc_p,
+                     const struct ether_addr * mac_p
+                     );
+
+/************************************************
+ *  Router interface counters
+ ***********************************************/
+
+/*
+ * Counters of the router interfaces of a virtual router they are
+ * enabled for. An interface has a cache line of counters per CPU,
+ * which the data path adds to on the CPU it runs on, so that the
+ * cores counting one interface do not bounce a line between
+ * them. A read sums the lines of all the CPUs. READ_CLEAR leaves
+ * the lines alone: it keeps the sums it read as a baseline, which
+ * later reads subtract. The counters are found through a table
+ * indexed by rif, in chunks allocated on first use and kept
+ * until the router goes: enabling the counters of an interface
+ * publishes its own, disabling them retires its own through
+ * RCU, so that the data path finds them without the router lock.
+ * Walking the chunks lists the interfaces in rif order.
+ */
+#define OES_ROUTER_CNTR_LINE        64
+#define OES_ROUTER_CNTR_CHUNK_BITS  8
+#define OES_ROUTER_CNTR_CHUNK_SIZE  (1 << OES_ROUTER_CNTR_CHUNK_BITS)
+#define OES_ROUTER_CNTR_CHUNK_CNT   (OES_ROUTER_RIF_MAX / OES_ROUTER_CNTR_CHUNK_SIZE)
+
+struct oes_router_rif_cntr {
+    unsigned int                rif;
+    struct oes_router_cntr    * cpu_cntrs;  /**< a line per CPU */
+    struct oes_router_cntr      baseline;   /**< sums at the last READ_CLEAR */
+};
+
+struct oes_router_cntr_table {
+    struct oes_router_pool       * pool;
+    struct oes_router_rif_cntr  ** chunks[OES_ROUTER_CNTR_CHUNK_CNT]; /**< by rif, NULL until used */
+    unsigned int                   cnt;
+    unsigned int                   cpu_cnt;
+};
+
+/**
+ * This function sets up a table without counters.
+ *
+ * @param[out] table_p - counter table
+ * @param[in] pool_p - pool the counters are allocated from
+ */
+void
+oes_router_cntr_table_init(
+                          struct oes_router_cntr_table * table_p,
+                          struct oes_router_pool * pool_p
+                          );
+
+/**
+ * This function frees all the counters of a table at once, with
+ * no reader left.
+ *
+ * @param[in] table_p - counter table
+ */
+void
+oes_router_cntr_table_deinit(
+                            struct oes_router_cntr_table * table_p
+                            );
+
+/**
+ * This function returns the counters of an interface, NULL if
+ * they are not enabled. Without the router lock, the caller must
+ * be in a read section.
+ *
+ * @param[in] table_p - counter table
+ * @param[in] rif - router interface
+ *
+ * @return the counters
+ */
+struct oes_router_rif_cntr *
+oes_router_cntr_find(
+                    const struct oes_router_cntr_table * table_p,
+                    const unsigned int  rif
+                    );
+
+/**
+ * This function returns the counters of the first interface
+ * from a rif on which has them enabled, NULL if there is none.
+ * The caller holds the router lock.
+ *
+ * @param[in] table_p - counter table
+ * @param[in] rif - router interface
+ *
+ * @return the counters
+ */
+struct oes_router_rif_cntr *
+oes_router_cntr_next(
+                    const struct oes_router_cntr_table * table_p,
+                    const unsigned int  rif
+                    );
+
+/**
+ * This function enables the counters of an interface, from zero.
+ *
+ * @param[in] table_p - counter table
+ * @param[in] rif - router interface
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_ERROR if rif is out of range
+ * @return OES_STATUS_ENTRY_ALREADY_EXISTS if they are enabled
+ * @return OES_STATUS_NO_MEMORY if they cannot be allocated
+ */
+oes_status_e
+oes_router_cntr_enable(
+                      struct oes_router_cntr_table * table_p,
+                      const unsigned int  rif
+                      );
+
+/**
+ * This function disables the counters of an interface. They are
+ * freed once the data path is done with them.
+ *
+ * @param[in] table_p - counter table
+ * @param[in] rif - router interface
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_ENTRY_NOT_FOUND if they are not enabled
+ */
+oes_status_e
+oes_router_cntr_disable(
+                       struct oes_router_cntr_table * table_p,
+                       const unsigned int  rif
+                       );
+
+/**
+ * This function adds to the counters of an interface on the line
+ * of the calling CPU.
+ *
+ * @param[in] table_p - counter table
+ * @param[in] cntr_p - counters of the interface
+ * @param[in] delta_p - packets and bytes to add
+ */
+void
+oes_router_cntr_add(
+                   const struct oes_router_cntr_table * table_p,
+                   struct oes_router_rif_cntr * cntr_p,
+                   const struct oes_router_cntr * delta_p
+                   );
+
+/**
+ * This function reads the counters of an interface since the
+ * last clear, and clears them if asked to. Clears are
+ * serialized by the router lock.
+ *
+ * @param[in] table_p - counter table
+ * @param[in] cntr_p - counters of the interface
+ * @param[in] clear - 1 to clear them
+ * @param[out] sum_p - counters
+ */
+void
+oes_router_cntr_read(
+                    const struct oes_router_cntr_table * table_p,
+                    struct oes_router_rif_cntr * cntr_p,
+                    const int  clear,
+                    struct oes_router_cntr * sum_p
+                    );
+
+/************************************************
+ *  Neighbor aging
+ ***********************************************/
+
+/*
+ * Timing wheel of the neighbors being aged. A slot lists the
+ * neighbors due at the ticks mapping to it; one due a turn
+ * later stays in its slot until then. The tick is sized for a
+ * turn to cover the longest delay, so that a neighbor is looked
+ * at once per delay. Delays are shortened at random by the
+ * jitter, spreading the neighbors added together.
+ */
+#define OES_ROUTER_AGE_SLOT_CNT 256
+
+struct oes_router_age_wheel {
+    struct oes_router_pool  * pool;
+    unsigned int            * slots;    /**< neighbor lists, index + 1, NULL while aging is off */
+    unsigned int              tick_ms;
+    unsigned long long        tick;     /**< next tick to expire */
+    unsigned int              cnt;      /**< neighbors on the wheel */
+    unsigned long long        seed;     /**< jitter generator state */
+};
+
+/**
+ * This function returns the time the wheel runs on, in ms.
+ *
+ * @return monotonic time
+ */
+unsigned long long
+oes_router_age_now(void);
+
+/**
+ * This function sets up an empty wheel with a turn covering a
+ * delay.
+ *
+ * @param[out] wheel_p - aging wheel
+ * @param[in] pool_p - pool the slots are allocated from
+ * @param[in] delay_ms - longest delay
+ * @param[in] seed - jitter generator seed
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the slots cannot be allocated
+ */
+oes_status_e
+oes_router_age_wheel_init(
+                         struct oes_router_age_wheel * wheel_p,
+                         struct oes_router_pool * pool_p,
+                         const unsigned int  delay_ms,
+                         const unsigned long long  seed
+                         );
+
+/**
+ * This function takes all the neighbors off a wheel and frees
+ * its slots.
+ *
+ * @param[in] wheel_p - aging wheel
+ * @param[in] table_p - neighbor table
+ */
+void
+oes_router_age_wheel_deinit(
+                           struct oes_router_age_wheel * wheel_p,
+                           struct oes_router_neigh_table * table_p
+                           );
+
+/**
+ * This function returns a delay shortened by up to jitter
+ * percent at random.
+ *
+ * @param[in] wheel_p - aging wheel
+ * @param[in] delay_ms - delay
+ * @param[in] jitter - percent
+ *
+ * @return jittered delay
+ */
+unsigned int
+oes_router_age_delay(
+                    struct oes_router_age_wheel * wheel_p,
+                    const unsigned int  delay_ms,
+                    const unsigned int  jitter
+                    );
+
+/**
+ * This function puts a neighbor on the wheel, or moves it, due
+ * at a time. A time already passed is due at the next tick.
+ *
+ * @param[in] wheel_p - aging wheel
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ * @param[in] due_ms - time the neighbor is due at
+ */
+void
+oes_router_age_schedule(
+                       struct oes_router_age_wheel * wheel_p,
+                       struct oes_router_neigh_table * table_p,
+                       struct oes_router_neigh * neigh_p,
+                       const unsigned long long  due_ms
+                       );
+
+/**
+ * This function takes a neighbor off the wheel, if it is on it.
+ *
+ * @param[in] wheel_p - aging wheel
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ */
+void
+oes_router_age_cancel(
+                     struct oes_router_age_wheel * wheel_p,
+                     struct oes_router_neigh_table * table_p,
+                     struct oes_router_neigh * neigh_p
+                     );
+
+/**
+ * This function takes the neighbors due off the wheel, up to
+ * cnt of them. The wheel stops at the first tick with neighbors
+ * left, the next call goes on from there.
+ *
+ * @param[in] wheel_p - aging wheel
+ * @param[in] table_p - neighbor table
+ * @param[in] now_ms - current time
+ * @param[out] neigh_list_pp - neighbors due
+ * @param[in] cnt - list size
+ *
+ * @return number of neighbors listed
+ */
+unsigned int
+oes_router_age_expire(
+                     struct oes_router_age_wheel * wheel_p,
+                     struct oes_router_neigh_table * table_p,
+                     const unsigned long long  now_ms,
+                     struct oes_router_neigh ** neigh_list_pp,
+                     const unsigned int  cnt
+                     );
+
+/***********************************************
+ *  ECMP hash
+ ***********************************************/
+
+/*
+ * The hash key holds the enabled fields only: source and
+ * destination addresses, a word with the traffic class and the
+ * protocol, the IPv6 flow label and a word with the L4 ports.
+ */
+#define OES_ROUTER_ECMP_KEY_WORDS 11
+
+/**
+ * This function computes the ECMP hash of a flow, a CRC32C of
+ * its key followed by a 32-bit finalizer.
+ *
+ * @param[in] fields_p - enabled hash fields
+ * @param[in] flow_p - packet header fields
+ *
+ * @return the hash
+ */
+unsigned int
+oes_router_ecmp_hash(
+                    const struct oes_router_ecmp_hash_fields * fields_p,
+                    const struct oes_router_flow * flow_p
+                    );
+
+/**
+ * This function computes the ECMP hashes of a list of flows,
+ * interleaving the CRCs of four flows at a time. The hashes are
+ * the ones oes_router_ecmp_hash() returns.
+ *
+ * @param[in] fields_p - enabled hash fields
+ * @param[in] flow_list_p - packet header fields
+ * @param[in] cnt - number of flows
+ * @param[out] hash_list_p - hashes
+ */
+void
+oes_router_ecmp_hash_bulk(
+                         const struct oes_router_ecmp_hash_fields * fields_p,
+                         const struct oes_router_flow * flow_list_p,
+                         const unsigned int  cnt,
+                         unsigned int * hash_list_p
+                         );
+
+/* member of a group of member_cnt a hash selects, from the high bits */
+static inline unsigned int
+oes_router_ecmp_member(
+                      const unsigned int  hash,
+                      const unsigned int  member_cnt
+                      )
+{
+    return (unsigned int)(((unsigned long long)hash * member_cnt) >> 32);
+}
+
+#endif /* __OES_ROUTER_H__ */
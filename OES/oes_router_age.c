@@ -0,0 +1,270 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_router.h"
+
+#define OES_ROUTER_AGE_SLOT_MASK (OES_ROUTER_AGE_SLOT_CNT - 1)
+
+static void
+oes_router_age_link(struct oes_router_age_wheel *wheel_p,
+                    struct oes_router_neigh_table *table_p,
+                    struct oes_router_neigh *neigh_p)
+{
+    unsigned int *slot_p = &wheel_p->slots[neigh_p->age_tick & OES_ROUTER_AGE_SLOT_MASK];
+    unsigned int idx = neigh_p - table_p->neighs;
+
+    neigh_p->age_prev = 0;
+    neigh_p->age_next = *slot_p;
+    if (*slot_p) {
+        table_p->neighs[*slot_p - 1].age_prev = idx + 1;
+    }
+    *slot_p = idx + 1;
+    neigh_p->aging = 1;
+    wheel_p->cnt++;
+}
+
+static void
+oes_router_age_unlink(struct oes_router_age_wheel *wheel_p,
+                      struct oes_router_neigh_table *table_p,
+                      struct oes_router_neigh *neigh_p)
+{
+    if (neigh_p->age_prev) {
+        table_p->neighs[neigh_p->age_prev - 1].age_next = neigh_p->age_next;
+    } else {
+        wheel_p->slots[neigh_p->age_tick & OES_ROUTER_AGE_SLOT_MASK] = neigh_p->age_next;
+    }
+    if (neigh_p->age_next) {
+        table_p->neighs[neigh_p->age_next - 1].age_prev = neigh_p->age_prev;
+    }
+    neigh_p->aging = 0;
+    wheel_p->cnt--;
+}
+
+/**
+ * This function returns the time the wheel runs on, in ms.
+ *
+ * @return monotonic time
+ */
+unsigned long long
+oes_router_age_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+/**
+ * This function sets up an empty wheel with a turn covering a
+ * delay.
+ *
+ * @param[out] wheel_p - aging wheel
+ * @param[in] pool_p - pool the slots are allocated from
+ * @param[in] delay_ms - longest delay
+ * @param[in] seed - jitter generator seed
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the slots cannot be allocated
+ */
+oes_status_e
+oes_router_age_wheel_init(struct oes_router_age_wheel *wheel_p,
+                          struct oes_router_pool *pool_p,
+                          const unsigned int delay_ms,
+                          const unsigned long long seed)
+{
+    memset(wheel_p, 0, sizeof(*wheel_p));
+    wheel_p->pool = pool_p;
+    wheel_p->slots = oes_router_pool_calloc(pool_p, OES_ROUTER_AGE_SLOT_CNT, sizeof(*wheel_p->slots));
+    if (wheel_p->slots == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    /* a delay ends at most a turn ahead, in the slot before the current one */
+    wheel_p->tick_ms = (delay_ms + OES_ROUTER_AGE_SLOT_CNT - 2) / (OES_ROUTER_AGE_SLOT_CNT - 1);
+    if (wheel_p->tick_ms == 0) {
+        wheel_p->tick_ms = 1;
+    }
+    wheel_p->tick = oes_router_age_now() / wheel_p->tick_ms;
+    wheel_p->seed = seed | 1;
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function takes all the neighbors off a wheel and frees
+ * its slots.
+ *
+ * @param[in] wheel_p - aging wheel
+ * @param[in] table_p - neighbor table
+ */
+void
+oes_router_age_wheel_deinit(struct oes_router_age_wheel *wheel_p,
+                            struct oes_router_neigh_table *table_p)
+{
+    unsigned int slot, next;
+
+    if (wheel_p->slots != NULL) {
+        for (slot = 0; slot < OES_ROUTER_AGE_SLOT_CNT; slot++) {
+            for (next = wheel_p->slots[slot]; next; next = table_p->neighs[next - 1].age_next) {
+                table_p->neighs[next - 1].aging = 0;
+            }
+        }
+        oes_router_pool_free(wheel_p->pool, wheel_p->slots, OES_ROUTER_AGE_SLOT_CNT * sizeof(*wheel_p->slots));
+    }
+    wheel_p->slots = NULL;
+    wheel_p->cnt = 0;
+}
+
+/**
+ * This function returns a delay shortened by up to jitter
+ * percent at random.
+ *
+ * @param[in] wheel_p - aging wheel
+ * @param[in] delay_ms - delay
+ * @param[in] jitter - percent
+ *
+ * @return jittered delay
+ */
+unsigned int
+oes_router_age_delay(struct oes_router_age_wheel *wheel_p,
+                     const unsigned int delay_ms,
+                     const unsigned int jitter)
+{
+    unsigned long long span = (unsigned long long)delay_ms * jitter / 100;
+
+    if (span == 0) {
+        return delay_ms;
+    }
+    /* xorshift64*, the high bits are the better ones */
+    wheel_p->seed ^= wheel_p->seed >> 12;
+    wheel_p->seed ^= wheel_p->seed << 25;
+    wheel_p->seed ^= wheel_p->seed >> 27;
+    return delay_ms - (unsigned int)(((wheel_p->seed * 0x2545f4914f6cdd1dULL) >> 32) % (span + 1));
+}
+
+/**
+ * This function puts a neighbor on the wheel, or moves it, due
+ * at a time. A time already passed is due at the next tick.
+ *
+ * @param[in] wheel_p - aging wheel
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ * @param[in] due_ms - time the neighbor is due at
+ */
+void
+oes_router_age_schedule(struct oes_router_age_wheel *wheel_p,
+                        struct oes_router_neigh_table *table_p,
+                        struct oes_router_neigh *neigh_p,
+                        const unsigned long long due_ms)
+{
+    unsigned long long tick = (due_ms + wheel_p->tick_ms - 1) / wheel_p->tick_ms;
+
+    if (neigh_p->aging) {
+        oes_router_age_unlink(wheel_p, table_p, neigh_p);
+    }
+    neigh_p->age_tick = (tick < wheel_p->tick) ? wheel_p->tick : tick;
+    oes_router_age_link(wheel_p, table_p, neigh_p);
+}
+
+/**
+ * This function takes a neighbor off the wheel, if it is on it.
+ *
+ * @param[in] wheel_p - aging wheel
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ */
+void
+oes_router_age_cancel(struct oes_router_age_wheel *wheel_p,
+                      struct oes_router_neigh_table *table_p,
+                      struct oes_router_neigh *neigh_p)
+{
+    if (neigh_p->aging) {
+        oes_router_age_unlink(wheel_p, table_p, neigh_p);
+    }
+}
+
+/**
+ * This function takes the neighbors due off the wheel, up to
+ * cnt of them. The wheel stops at the first tick with neighbors
+ * left, the next call goes on from there.
+ *
+ * @param[in] wheel_p - aging wheel
+ * @param[in] table_p - neighbor table
+ * @param[in] now_ms - current time
+ * @param[out] neigh_list_pp - neighbors due
+ * @param[in] cnt - list size
+ *
+ * @return number of neighbors listed
+ */
+unsigned int
+oes_router_age_expire(struct oes_router_age_wheel *wheel_p,
+                      struct oes_router_neigh_table *table_p,
+                      const unsigned long long now_ms,
+                      struct oes_router_neigh **neigh_list_pp,
+                      const unsigned int cnt)
+{
+    unsigned long long now_tick = now_ms / wheel_p->tick_ms;
+    struct oes_router_neigh *neigh_p;
+    unsigned int found = 0, next;
+
+    if ((wheel_p->slots == NULL) || (now_tick < wheel_p->tick)) {
+        return 0;
+    }
+    /* after a pause, one turn visits every slot */
+    if (now_tick - wheel_p->tick >= OES_ROUTER_AGE_SLOT_CNT) {
+        wheel_p->tick = now_tick - OES_ROUTER_AGE_SLOT_CNT + 1;
+    }
+    for (; wheel_p->tick <= now_tick; wheel_p->tick++) {
+        if (wheel_p->cnt == 0) {
+            wheel_p->tick = now_tick + 1;
+            break;
+        }
+        next = wheel_p->slots[wheel_p->tick & OES_ROUTER_AGE_SLOT_MASK];
+        while (next) {
+            neigh_p = &table_p->neighs[next - 1];
+            next = neigh_p->age_next;
+            if (neigh_p->age_tick > now_tick) {
+                continue;
+            }
+            if (found == cnt) {
+                return found;
+            }
+            oes_router_age_unlink(wheel_p, table_p, neigh_p);
+            neigh_list_pp[found++] = neigh_p;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,2885 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include <pthread.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_api_router.h"
+
+/*
+ * Router module benchmark. Builds a synthetic full table whose
+ * prefix length mix follows the public Internet tables and
+ * measures route load and delete rates, lookup throughput and
+ * the memory the table takes. Tables are generated from a seed,
+ * runs with the same seed see the same routes.
+ *
+ * usage: oes_router_bench [-m mode] [-n routes] [-l lookups] [-s seed]
+ *   mode lpm4: IPv4 load, lookup and delete, 1M routes by default
+ *   mode lpm6: IPv6 load, lookup and delete, 200K routes by default
+ *   mode batch: single against batched lookups, 1M IPv4 and 200K
+ *               IPv6 routes by default
+ *   mode bulk: route by route against bulk load of 1M IPv4 and
+ *              200K IPv6 routes by default
+ *   mode rcu: lookups on all CPUs checked while routes churn,
+ *             1M IPv4 and 200K IPv6 routes by default
+ *   mode ecmp: ECMP hash rate, single and batched, member
+ *              distribution, next-hop prediction and flows moved
+ *              by a next-hop change with and without resilient
+ *              hashing
+ *   mode vrf: hundreds of tenant VRFs with small tables, memory
+ *             per VRF, 200 IPv4 and 50 IPv6 routes each by default
+ *   mode neigh: neighbor activity sweep against getting each
+ *               neighbor's activity, then neighbors aged all at
+ *               once and with jitter, 100K neighbors by default
+ *   mode mc: multicast route load, single against batched
+ *            lookups with (*,G) fallback, 50K groups by default
+ *   mode cntr: interface counters updated from a thread per CPU,
+ *              shared against per CPU, then read one by one
+ *              against a bulk read, 4K interfaces by default
+ *   mode page: unicast routes paged through in key order, the
+ *              first walk sorting them, then pages seeked after
+ *              random addresses, 1M IPv4 routes by default
+ *   mode churn: a BGP-like stream of path changes, withdrawals,
+ *               announcements, flaps and peers going down
+ *               replayed alone and during lookups on all CPUs,
+ *               1M IPv4 and 200K IPv6 routes by default
+ *   mode pic: convergence of routes sharing next hops when a
+ *             neighbor goes down and up and when their next-hop
+ *             group moves, against setting the routes again,
+ *             10K routes and up by 10 to 1M IPv4 routes by default
+ *   mode rif: router interfaces resolved from the VLAN and the
+ *             destination MAC of frames, routed or bridged, then
+ *             half of them deleted and added again, 1K SVIs and
+ *             up by 10 to 50K by default
+ *   mode compact: memory per table of a full table, then after
+ *                 most routes are withdrawn, and what compacting
+ *                 the LPM tables gives back while lookups are
+ *                 checked, 1M IPv4 and 200K IPv6 routes by
+ *                 default
+ */
+
+#define BENCH_NEXT_HOP_CNT 16
+#define BENCH_V6_ALLOC_SHARE 8     /* routes per allocated /32 */
+#define BENCH_ECMP_FLOWS (1 << 20)
+#define BENCH_ECMP_BATCH 64
+#define BENCH_ECMP_RESILIENT_FLOWS (1 << 16)
+#define BENCH_RCU_ADDR_MAX (1 << 20)  /* per IP version */
+#define BENCH_RCU_BATCH 64
+#define BENCH_RCU_MISS 0xff         /* prefix length of a lookup miss */
+#define BENCH_RCU_READER_MAX 64
+#define BENCH_RCU_CHURN_SHARE 8     /* one route in 8 churns */
+#define BENCH_RCU_UPDATES (1 << 20)
+#define BENCH_RCU_BULK_EVERY (1 << 16)
+#define BENCH_VRF_CNT 512
+#define BENCH_VRF_ROUTE_MAX 4000      /* IPv4 routes per VRF, for all of them to fit in memory */
+#define BENCH_NEIGH_ACTIVE_SHARE 10   /* one neighbor in 10 has traffic */
+#define BENCH_NEIGH_AGE_TIME 200      /* ms */
+#define BENCH_NEIGH_AGE_JITTER 25     /* percent */
+#define BENCH_NEIGH_AGE_POLL 1000     /* us between aging runs */
+#define BENCH_MC_BATCH 64
+#define BENCH_MC_SOURCES 1024
+#define BENCH_MC_RIFS 64
+#define BENCH_MC_JOIN_GROUPS 64
+#define BENCH_MC_JOIN_SOURCES 256     /* (S,G) routes per group */
+#define BENCH_MC_JOIN_RIFS 512        /* egress interfaces of each */
+#define BENCH_CNTR_PACKET 512         /* bytes */
+#define BENCH_CNTR_THREAD_MAX 64
+#define BENCH_PAGE_SIZE 1000
+#define BENCH_CHURN_UPDATES (1 << 20)
+#define BENCH_CHURN_EVENT_SHARES 2000   /* one event in 2000 is a peer going down */
+#define BENCH_CHURN_BURST_MAX 4000      /* routes moved when a peer goes down */
+#define BENCH_CHURN_WITHDRAWN_SHARE 20  /* at most one route in 20 withdrawn */
+#define BENCH_CHURN_LOOKUP_TIME 1000000 /* us of lookups alone */
+#define BENCH_PIC_ROUTES_MIN 10000
+#define BENCH_RIF_MIN 1000
+#define BENCH_RIF_MAX 65536
+#define BENCH_RIF_VLANS 4094
+#define BENCH_RIF_FRAMES (1 << 20)
+#define BENCH_COMPACT_KEEP_SHARE 10   /* one route in 10 is kept */
+
+struct bench_params {
+    const char       * mode;
+    unsigned int       routes;
+    unsigned int       lookups;
+    unsigned long long seed;
+};
+
+/* cumulative share, in 1/10000, of each IPv4 prefix length */
+static const struct {
+    unsigned int len;
+    unsigned int share;
+} bench_v4_len_mix[] = {
+    { 8, 2 }, { 10, 5 }, { 12, 15 }, { 13, 25 }, { 14, 45 }, { 15, 70 },
+    { 16, 210 }, { 17, 310 }, { 18, 460 }, { 19, 760 }, { 20, 1210 },
+    { 21, 1660 }, { 22, 2810 }, { 23, 3760 }, { 24, 9950 }, { 25, 9965 },
+    { 26, 9975 }, { 27, 9982 }, { 28, 9988 }, { 29, 9993 }, { 30, 9997 },
+    { 32, 10000 },
+};
+
+/* IPv6, mostly /48 customer and /64 link prefixes */
+static const struct {
+    unsigned int len;
+    unsigned int share;
+} bench_v6_len_mix[] = {
+    { 29, 300 }, { 32, 1500 }, { 36, 1800 }, { 40, 2400 }, { 44, 3100 },
+    { 46, 3300 }, { 47, 3450 }, { 48, 8450 }, { 56, 8800 }, { 64, 9950 },
+    { 128, 10000 },
+};
+
+static unsigned long long bench_rand_state;
+
+static unsigned long long
+bench_rand(void)
+{
+    /* xorshift64* */
+    bench_rand_state ^= bench_rand_state >> 12;
+    bench_rand_state ^= bench_rand_state << 25;
+    bench_rand_state ^= bench_rand_state >> 27;
+    return bench_rand_state * 0x2545f4914f6cdd1dULL;
+}
+
+static void
+bench_seed(const unsigned long long seed)
+{
+    bench_rand_state = seed ? seed : 1;
+}
+
+static double
+bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+bench_rss_mb(void)
+{
+    unsigned long size = 0, resident = 0;
+    FILE *file_p = fopen("/proc/self/statm", "r");
+
+    if (file_p != NULL) {
+        if (fscanf(file_p, "%lu %lu", &size, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(file_p);
+    }
+    return resident * (double)sysconf(_SC_PAGESIZE) / (1 << 20);
+}
+
+static int
+bench_prefix_cmp(const void *a_p, const void *b_p)
+{
+    const struct oes_ip_prefix *a = a_p, *b = b_p;
+    unsigned int a_addr, b_addr;
+    int cmp;
+
+    if (a->prefix.version == OES_IPV6) {
+        cmp = memcmp(&a->prefix.addr.ipv6, &b->prefix.addr.ipv6, sizeof(struct in6_addr));
+        if (cmp) {
+            return cmp;
+        }
+    } else {
+        a_addr = ntohl(a->prefix.addr.ipv4.s_addr);
+        b_addr = ntohl(b->prefix.addr.ipv4.s_addr);
+        if (a_addr != b_addr) {
+            return (a_addr < b_addr) ? -1 : 1;
+        }
+    }
+    return (int)a->prefix_len - (int)b->prefix_len;
+}
+
+static void
+bench_v4_prefix(struct oes_ip_prefix *prefix_p)
+{
+    unsigned int j, len, share, addr;
+
+    share = bench_rand() % 10000;
+    for (j = 0; bench_v4_len_mix[j].share <= share; j++) {
+    }
+    len = bench_v4_len_mix[j].len;
+    /* 1.0.0.0 - 223.255.255.255 */
+    addr = (unsigned int)(bench_rand() % (223U << 24)) + (1U << 24);
+    memset(prefix_p, 0, sizeof(*prefix_p));
+    prefix_p->prefix.version = OES_IPV4;
+    prefix_p->prefix.addr.ipv4.s_addr = htonl(addr & (0xffffffff << (32 - len)));
+    prefix_p->prefix_len = len;
+}
+
+/*
+ * IPv6 prefixes are drawn under a pool of allocated /32s of
+ * 2000::/3, so that they share their upper levels as in the real
+ * table.
+ */
+static void
+bench_v6_prefix(struct oes_ip_prefix *prefix_p, const unsigned int alloc_cnt)
+{
+    unsigned int i, j, len, share, alloc;
+    unsigned char *addr_p;
+
+    share = bench_rand() % 10000;
+    for (j = 0; bench_v6_len_mix[j].share <= share; j++) {
+    }
+    len = bench_v6_len_mix[j].len;
+    memset(prefix_p, 0, sizeof(*prefix_p));
+    prefix_p->prefix.version = OES_IPV6;
+    prefix_p->prefix_len = len;
+    addr_p = prefix_p->prefix.addr.ipv6.s6_addr;
+    alloc = (unsigned int)(bench_rand() % alloc_cnt) * 0x9e3779b1;
+    addr_p[0] = 0x20 | ((alloc >> 24) & 0x1f);
+    addr_p[1] = alloc >> 16;
+    addr_p[2] = alloc >> 8;
+    addr_p[3] = alloc;
+    for (i = 4; i < 16; i++) {
+        addr_p[i] = bench_rand();
+    }
+    for (i = 0; i < 16; i++) {
+        if (len <= i * 8) {
+            addr_p[i] = 0;
+        } else if (len < (i + 1) * 8) {
+            addr_p[i] &= 0xff << ((i + 1) * 8 - len);
+        }
+    }
+}
+
+/*
+ * Distinct unicast prefixes, returned in random order.
+ */
+static unsigned int
+bench_table(const enum oes_ip_version version,
+            struct oes_ip_prefix *prefix_list_p,
+            const unsigned int cnt)
+{
+    unsigned int i, j, uniq = 0;
+    struct oes_ip_prefix tmp;
+
+    for (i = 0; i < cnt; i++) {
+        if (version == OES_IPV4) {
+            bench_v4_prefix(&prefix_list_p[i]);
+        } else {
+            bench_v6_prefix(&prefix_list_p[i], cnt / BENCH_V6_ALLOC_SHARE + 1);
+        }
+    }
+    qsort(prefix_list_p, cnt, sizeof(*prefix_list_p), bench_prefix_cmp);
+    for (i = 0; i < cnt; i++) {
+        if ((uniq == 0) || bench_prefix_cmp(&prefix_list_p[uniq - 1], &prefix_list_p[i])) {
+            prefix_list_p[uniq++] = prefix_list_p[i];
+        }
+    }
+    for (i = uniq; i > 1; i--) {
+        j = bench_rand() % i;
+        tmp = prefix_list_p[i - 1];
+        prefix_list_p[i - 1] = prefix_list_p[j];
+        prefix_list_p[j] = tmp;
+    }
+    return uniq;
+}
+
+static void
+bench_next_hop(struct oes_ip_addr *next_hop_p,
+               const enum oes_ip_version version,
+               const unsigned int id)
+{
+    memset(next_hop_p, 0, sizeof(*next_hop_p));
+    next_hop_p->version = version;
+    if (version == OES_IPV4) {
+        next_hop_p->addr.ipv4.s_addr = htonl(0x0a000001 + id);
+    } else {
+        next_hop_p->addr.ipv6.s6_addr[0] = 0xfe;
+        next_hop_p->addr.ipv6.s6_addr[1] = 0x80;
+        next_hop_p->addr.ipv6.s6_addr[15] = 1 + id;
+    }
+}
+
+/*
+ * Addresses under random routes of the table, so that lookups
+ * hit with the table's prefix length mix.
+ */
+static void
+bench_addrs(const struct oes_ip_prefix *prefix_list_p,
+            const unsigned int prefix_cnt,
+            struct oes_ip_addr *addr_list_p,
+            const unsigned int cnt)
+{
+    const struct oes_ip_prefix *prefix_p;
+    unsigned int i, b, host;
+
+    for (i = 0; i < cnt; i++) {
+        prefix_p = &prefix_list_p[bench_rand() % prefix_cnt];
+        addr_list_p[i] = prefix_p->prefix;
+        if (prefix_p->prefix.version == OES_IPV4) {
+            host = (prefix_p->prefix_len == 32) ? 0 :
+                   (unsigned int)bench_rand() & (0xffffffff >> prefix_p->prefix_len);
+            addr_list_p[i].addr.ipv4.s_addr |= htonl(host);
+            continue;
+        }
+        for (b = prefix_p->prefix_len; b < 128; b++) {
+            if (bench_rand() & 1) {
+                addr_list_p[i].addr.ipv6.s6_addr[b / 8] |= 0x80 >> (b % 8);
+            }
+        }
+    }
+}
+
+static int
+bench_load(const unsigned int vrid,
+           const struct oes_ip_prefix *prefix_list_p,
+           const unsigned int cnt)
+{
+    struct oes_ip_addr next_hops[4];
+    struct oes_uc_route_data data;
+    unsigned int i, j;
+
+    memset(&data, 0, sizeof(data));
+    data.action = OES_ROUTER_ACTION_FORWARD;
+    data.next_hop_list = next_hops;
+    for (i = 0; i < cnt; i++) {
+        /* one route in ten is ECMP over 2-4 next hops */
+        data.next_hop_cnt = (i % 10) ? 1 : 2 + i % 3;
+        for (j = 0; j < data.next_hop_cnt; j++) {
+            bench_next_hop(&next_hops[j], prefix_list_p[i].prefix.version, (i + j) % BENCH_NEXT_HOP_CNT);
+        }
+        if (oes_api_router_uc_route_set(OES_ACCESS_CMD_ADD, vrid, &prefix_list_p[i], &data, NULL) !=
+            OES_STATUS_SUCCESS) {
+            fprintf(stderr, "route %u add failed\n", i);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int
+bench_router_add(unsigned int *vrid_p)
+{
+    struct oes_router_attributes attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.enable_ipv4 = 1;
+    attr.enable_ipv6 = 1;
+    if (oes_api_router_set(OES_ACCESS_CMD_ADD, vrid_p, &attr, NULL) != OES_STATUS_SUCCESS) {
+        fprintf(stderr, "router add failed\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* router port interfaces, each on a port of its own */
+static int
+bench_rifs_add(const unsigned int vrid, const unsigned int cnt, unsigned int *rif_list_p)
+{
+    static unsigned long port;
+    struct oes_l3_interface_attributes attr;
+    struct oes_l3_interface ifc;
+    unsigned int i;
+
+    memset(&attr, 0, sizeof(attr));
+    memset(&ifc, 0, sizeof(ifc));
+    attr.mtu = 1500;
+    ifc.type = OES_INTERFACE_TYPE_ROUTER_PORT;
+    for (i = 0; i < cnt; i++) {
+        ifc.ifc.port.port = port++;
+        if (oes_api_router_interface_set(OES_ACCESS_CMD_ADD, vrid, &rif_list_p[i], &ifc, &attr, NULL) !=
+            OES_STATUS_SUCCESS) {
+            fprintf(stderr, "interface %u add failed\n", i);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* a router with its interfaces, and what refers to them */
+static void
+bench_router_delete(unsigned int vrid)
+{
+    oes_api_router_interface_set(OES_ACCESS_CMD_DELETE_ALL, vrid, NULL, NULL, NULL, NULL);
+    oes_api_router_set(OES_ACCESS_CMD_DELETE, &vrid, NULL, NULL);
+}
+
+/*
+ * Neighbors for the next hops of both IP versions, without them
+ * routes trap.
+ */
+static int
+bench_neighs_add(const unsigned int vrid)
+{
+    struct oes_neigh_data data;
+    struct oes_ip_addr addr;
+    struct ether_addr mac;
+    unsigned int v, i;
+
+    memset(&data, 0, sizeof(data));
+    memset(&mac, 0, sizeof(mac));
+    if (bench_rifs_add(vrid, 1, &data.rif) != 0) {
+        return -1;
+    }
+    data.mac_addr = &mac;
+    data.action = OES_ROUTER_ACTION_FORWARD;
+    for (v = 0; v < 2; v++) {
+        for (i = 0; i < BENCH_NEXT_HOP_CNT; i++) {
+            bench_next_hop(&addr, (v == 0) ? OES_IPV4 : OES_IPV6, i);
+            mac.ether_addr_octet[4] = vrid;
+            mac.ether_addr_octet[5] = i;
+            if (oes_api_router_neigh_set(OES_ACCESS_CMD_ADD, vrid, &addr, &data, NULL) != OES_STATUS_SUCCESS) {
+                fprintf(stderr, "neighbor %u add failed\n", i);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * Generates a table of routes prefixes and lookups addresses
+ * under it, returns the number of distinct prefixes.
+ */
+static unsigned int
+bench_prepare(const struct bench_params *params_p,
+              const enum oes_ip_version version,
+              const unsigned int routes,
+              struct oes_ip_prefix **prefix_list_pp,
+              struct oes_ip_addr **addr_list_pp)
+{
+    unsigned int cnt;
+
+    *prefix_list_pp = malloc(routes * sizeof(**prefix_list_pp));
+    *addr_list_pp = malloc(params_p->lookups * sizeof(**addr_list_pp));
+    if ((*prefix_list_pp == NULL) || (*addr_list_pp == NULL)) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    bench_seed(params_p->seed);
+    cnt = bench_table(version, *prefix_list_pp, routes);
+    bench_addrs(*prefix_list_pp, cnt, *addr_list_pp, params_p->lookups);
+    return cnt;
+}
+
+static int
+bench_lpm(const struct bench_params *params_p, const enum oes_ip_version version)
+{
+    const char *name = (version == OES_IPV4) ? "lpm4" : "lpm6";
+    struct oes_uc_route_lookup lookup;
+    struct oes_ip_prefix *prefix_list_p;
+    struct oes_ip_addr *addr_list_p;
+    unsigned int vrid, cnt, i, misses = 0;
+    double t0, t1, rss0;
+
+    cnt = bench_prepare(params_p, version, params_p->routes, &prefix_list_p, &addr_list_p);
+    if (bench_router_add(&vrid) != 0) {
+        return -1;
+    }
+
+    rss0 = bench_rss_mb();
+    t0 = bench_now();
+    if (bench_load(vrid, prefix_list_p, cnt) != 0) {
+        return -1;
+    }
+    t1 = bench_now();
+    printf("%s load:   %u routes in %.3f s, %.2f Mroutes/s, %.1f MB (%.1f B/route)\n",
+           name, cnt, t1 - t0, cnt / (t1 - t0) / 1e6, bench_rss_mb() - rss0,
+           (bench_rss_mb() - rss0) * (1 << 20) / cnt);
+
+    t0 = bench_now();
+    for (i = 0; i < params_p->lookups; i++) {
+        if (oes_api_router_uc_route_lookup(vrid, &addr_list_p[i], &lookup, NULL) != OES_STATUS_SUCCESS) {
+            misses++;
+        }
+    }
+    t1 = bench_now();
+    printf("%s lookup: %u lookups in %.3f s, %.2f Mlookups/s, %.1f ns/lookup, %u misses\n",
+           name, params_p->lookups, t1 - t0, params_p->lookups / (t1 - t0) / 1e6,
+           (t1 - t0) * 1e9 / params_p->lookups, misses);
+
+    t0 = bench_now();
+    for (i = 0; i < cnt; i++) {
+        if (oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE, vrid, &prefix_list_p[i], NULL, NULL) !=
+            OES_STATUS_SUCCESS) {
+            fprintf(stderr, "route %u delete failed\n", i);
+            return -1;
+        }
+    }
+    t1 = bench_now();
+    printf("%s delete: %u routes in %.3f s, %.2f Mroutes/s\n",
+           name, cnt, t1 - t0, cnt / (t1 - t0) / 1e6);
+
+    bench_router_delete(vrid);
+    free(prefix_list_p);
+    free(addr_list_p);
+    return (misses == 0) ? 0 : -1;
+}
+
+/*
+ * Single lookups against batches of 1 to 256 addresses,
+ * on an IPv4 and an IPv6 table. Batch results are checked against
+ * the single ones.
+ */
+static int
+bench_batch(const struct bench_params *params_p)
+{
+    static const unsigned int batch_sizes[] = { 1, 2, 4, 8, 16, 64, 256 };
+    static struct oes_uc_route_lookup lookups[256];
+    unsigned char *prefix_len_list_p;
+    struct oes_ip_prefix *prefix_list_p;
+    struct oes_ip_addr *addr_list_p;
+    unsigned int vrid, cnt, i, j, b, batch, mismatches = 0;
+    enum oes_ip_version version;
+    double t0, t1, single;
+
+    prefix_len_list_p = malloc(params_p->lookups);
+    if ((prefix_len_list_p == NULL) || (bench_router_add(&vrid) != 0)) {
+        return -1;
+    }
+    for (version = OES_IPV4; version <= OES_IPV6; version++) {
+        cnt = bench_prepare(params_p, version,
+                            (version == OES_IPV4) ? params_p->routes : params_p->routes / 5,
+                            &prefix_list_p, &addr_list_p);
+        if (bench_load(vrid, prefix_list_p, cnt) != 0) {
+            return -1;
+        }
+
+        t0 = bench_now();
+        for (i = 0; i < params_p->lookups; i++) {
+            oes_api_router_uc_route_lookup(vrid, &addr_list_p[i], &lookups[0], NULL);
+            prefix_len_list_p[i] = lookups[0].prefix_len;
+        }
+        t1 = bench_now();
+        single = params_p->lookups / (t1 - t0) / 1e6;
+        printf("%s %u routes, single:    %6.2f Mlookups/s\n",
+               (version == OES_IPV4) ? "ipv4" : "ipv6", cnt, single);
+
+        for (b = 0; b < sizeof(batch_sizes) / sizeof(batch_sizes[0]); b++) {
+            batch = batch_sizes[b];
+            t0 = bench_now();
+            for (i = 0; i + batch <= params_p->lookups; i += batch) {
+                oes_api_router_uc_route_lookup_batch(vrid, &addr_list_p[i], lookups, batch, NULL);
+                for (j = 0; j < batch; j++) {
+                    mismatches += (lookups[j].prefix_len != prefix_len_list_p[i + j]);
+                }
+            }
+            t1 = bench_now();
+            printf("%s %u routes, batch %3u: %6.2f Mlookups/s, x%.2f\n",
+                   (version == OES_IPV4) ? "ipv4" : "ipv6", cnt, batch,
+                   i / (t1 - t0) / 1e6, i / (t1 - t0) / 1e6 / single);
+        }
+        oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE_ALL, vrid, NULL, NULL, NULL);
+        free(prefix_list_p);
+        free(addr_list_p);
+    }
+    bench_router_delete(vrid);
+    free(prefix_len_list_p);
+    if (mismatches) {
+        fprintf(stderr, "%u batch results differ from single lookups\n", mismatches);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Full IPv4 and IPv6 tables loaded route by route, then again
+ * inside a bulk load. Lookups after the bulk load are checked
+ * against the ones after the route by route load.
+ */
+static int
+bench_bulk(const struct bench_params *params_p)
+{
+    struct oes_ip_prefix *prefix_list_p[2];
+    struct oes_ip_addr *addr_list_p[2];
+    struct oes_uc_route_lookup lookup;
+    unsigned char *prefix_len_list_p[2];
+    unsigned int vrid, cnt[2], i, v, pass, mismatches = 0;
+    double t0, t1, t2, rss0;
+
+    if (bench_router_add(&vrid) != 0) {
+        return -1;
+    }
+    for (v = 0; v < 2; v++) {
+        cnt[v] = bench_prepare(params_p, (v == 0) ? OES_IPV4 : OES_IPV6,
+                               (v == 0) ? params_p->routes : params_p->routes / 5,
+                               &prefix_list_p[v], &addr_list_p[v]);
+        prefix_len_list_p[v] = malloc(params_p->lookups);
+        if (prefix_len_list_p[v] == NULL) {
+            fprintf(stderr, "out of memory\n");
+            return -1;
+        }
+    }
+
+    for (pass = 0; pass < 2; pass++) {
+        rss0 = bench_rss_mb();
+        t0 = bench_now();
+        if ((pass == 1) &&
+            (oes_api_router_uc_route_bulk_set(OES_ACCESS_CMD_CREATE, vrid, NULL) != OES_STATUS_SUCCESS)) {
+            fprintf(stderr, "bulk load open failed\n");
+            return -1;
+        }
+        for (v = 0; v < 2; v++) {
+            if (bench_load(vrid, prefix_list_p[v], cnt[v]) != 0) {
+                return -1;
+            }
+        }
+        t1 = bench_now();
+        if ((pass == 1) &&
+            (oes_api_router_uc_route_bulk_set(OES_ACCESS_CMD_APPLY, vrid, NULL) != OES_STATUS_SUCCESS)) {
+            fprintf(stderr, "bulk load apply failed\n");
+            return -1;
+        }
+        t2 = bench_now();
+        printf("%s: %u ipv4 + %u ipv6 routes in %.3f s (stage %.3f s, build %.3f s), "
+               "%.2f Mroutes/s, %.1f MB\n",
+               (pass == 0) ? "route by route" : "bulk load     ", cnt[0], cnt[1], t2 - t0,
+               t1 - t0, t2 - t1, (cnt[0] + cnt[1]) / (t2 - t0) / 1e6, bench_rss_mb() - rss0);
+
+        for (v = 0; v < 2; v++) {
+            for (i = 0; i < params_p->lookups; i++) {
+                if (oes_api_router_uc_route_lookup(vrid, &addr_list_p[v][i], &lookup, NULL) !=
+                    OES_STATUS_SUCCESS) {
+                    lookup.prefix_len = 0xff;
+                }
+                if (pass == 0) {
+                    prefix_len_list_p[v][i] = lookup.prefix_len;
+                } else {
+                    mismatches += (prefix_len_list_p[v][i] != lookup.prefix_len);
+                }
+            }
+        }
+        oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE_ALL, vrid, NULL, NULL, NULL);
+    }
+
+    bench_router_delete(vrid);
+    for (v = 0; v < 2; v++) {
+        free(prefix_list_p[v]);
+        free(addr_list_p[v]);
+        free(prefix_len_list_p[v]);
+    }
+    if (mismatches) {
+        fprintf(stderr, "%u lookups differ after the bulk load\n", mismatches);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Concurrent lookups during route churn. A share of the table
+ * is withdrawn and announced again, one route at a time and in
+ * bulk loads, while a lookup thread per CPU checks every result:
+ * a stable route must be the longest stable match, a churned one
+ * must lie between it and the longest match of the full table.
+ * Stable routes have resolved next hops and forward, churned ones
+ * trap. Once the churn stops, results must equal those of a table
+ * loaded from scratch with the routes left.
+ */
+struct bench_rcu_ctx {
+    unsigned int                 vrid;
+    const struct oes_ip_addr   * addr_list_p;
+    const unsigned char        * stable_len_list_p;  /**< longest stable match, BENCH_RCU_MISS if none */
+    const unsigned char        * full_len_list_p;    /**< longest match with all routes */
+    unsigned int                 addr_cnt;
+    int                          done;
+};
+
+struct bench_rcu_reader {
+    struct bench_rcu_ctx  * ctx_p;
+    pthread_t               thread;
+    unsigned int            first;
+    unsigned long long      lookups;
+    unsigned long long      violations;
+    double                  max_batch;          /**< s, slowest batch of lookups */
+};
+
+static int
+bench_rcu_check(const struct bench_rcu_ctx *ctx_p,
+                const unsigned int i,
+                const struct oes_uc_route_lookup *lookup_p)
+{
+    unsigned int stable = ctx_p->stable_len_list_p[i];
+
+    if (!lookup_p->valid) {
+        return stable == BENCH_RCU_MISS;
+    }
+    if (lookup_p->action == OES_ROUTER_ACTION_FORWARD) {
+        return lookup_p->prefix_len == stable;
+    }
+    return ((stable == BENCH_RCU_MISS) || (lookup_p->prefix_len > stable)) &&
+           (lookup_p->prefix_len <= ctx_p->full_len_list_p[i]);
+}
+
+static void *
+bench_rcu_reader(void *arg_p)
+{
+    struct bench_rcu_reader *reader_p = arg_p;
+    struct bench_rcu_ctx *ctx_p = reader_p->ctx_p;
+    struct oes_uc_route_lookup lookups[BENCH_RCU_BATCH];
+    unsigned int i = reader_p->first, j, cnt, batch = 0;
+    double t0, t1;
+
+    while (!__atomic_load_n(&ctx_p->done, __ATOMIC_RELAXED)) {
+        cnt = (ctx_p->addr_cnt - i < BENCH_RCU_BATCH) ? ctx_p->addr_cnt - i : BENCH_RCU_BATCH;
+        t0 = bench_now();
+        /* single and batched lookups in turn */
+        if (batch) {
+            oes_api_router_uc_route_lookup_batch(ctx_p->vrid, &ctx_p->addr_list_p[i], lookups, cnt, NULL);
+        } else {
+            for (j = 0; j < cnt; j++) {
+                oes_api_router_uc_route_lookup(ctx_p->vrid, &ctx_p->addr_list_p[i + j], &lookups[j], NULL);
+            }
+        }
+        t1 = bench_now();
+        if (t1 - t0 > reader_p->max_batch) {
+            reader_p->max_batch = t1 - t0;
+        }
+        for (j = 0; j < cnt; j++) {
+            reader_p->violations += !bench_rcu_check(ctx_p, i + j, &lookups[j]);
+        }
+        reader_p->lookups += cnt;
+        batch = !batch;
+        i = (i + cnt == ctx_p->addr_cnt) ? 0 : i + cnt;
+    }
+    return NULL;
+}
+
+static int
+bench_rcu_route_set(const unsigned int vrid,
+                    const enum oes_access_cmd access_cmd,
+                    const struct oes_ip_prefix *prefix_p)
+{
+    struct oes_uc_route_data data;
+
+    memset(&data, 0, sizeof(data));
+    data.action = OES_ROUTER_ACTION_TRAP;
+    if (oes_api_router_uc_route_set(access_cmd, vrid, prefix_p,
+                                    (access_cmd == OES_ACCESS_CMD_ADD) ? &data : NULL, NULL) !=
+        OES_STATUS_SUCCESS) {
+        fprintf(stderr, "churn route %s failed\n", (access_cmd == OES_ACCESS_CMD_ADD) ? "add" : "delete");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Loads the stable routes and the churned ones flagged in
+ * installed_p, in a bulk load.
+ */
+static int
+bench_rcu_load(const unsigned int vrid,
+               const struct oes_ip_prefix *prefix_list_p,
+               const unsigned int stable_cnt,
+               const unsigned int cnt,
+               const unsigned char *installed_p)
+{
+    unsigned int i;
+
+    if ((oes_api_router_uc_route_bulk_set(OES_ACCESS_CMD_CREATE, vrid, NULL) != OES_STATUS_SUCCESS) ||
+        (bench_load(vrid, prefix_list_p, stable_cnt) != 0)) {
+        return -1;
+    }
+    for (i = stable_cnt; i < cnt; i++) {
+        if (installed_p[i - stable_cnt] &&
+            (bench_rcu_route_set(vrid, OES_ACCESS_CMD_ADD, &prefix_list_p[i]) != 0)) {
+            return -1;
+        }
+    }
+    return (oes_api_router_uc_route_bulk_set(OES_ACCESS_CMD_APPLY, vrid, NULL) == OES_STATUS_SUCCESS) ? 0 : -1;
+}
+
+static void
+bench_rcu_lens(const unsigned int vrid,
+               const struct oes_ip_addr *addr_list_p,
+               const unsigned int cnt,
+               unsigned char *len_list_p,
+               unsigned char *action_list_p)
+{
+    struct oes_uc_route_lookup lookup;
+    unsigned int i;
+
+    for (i = 0; i < cnt; i++) {
+        oes_api_router_uc_route_lookup(vrid, &addr_list_p[i], &lookup, NULL);
+        len_list_p[i] = lookup.valid ? lookup.prefix_len : BENCH_RCU_MISS;
+        if (action_list_p != NULL) {
+            action_list_p[i] = lookup.action;
+        }
+    }
+}
+
+static int
+bench_rcu(const struct bench_params *params_p)
+{
+    struct oes_ip_prefix *prefix_list_p, *prefix4_list_p, *prefix6_list_p;
+    struct oes_ip_addr *addr_list_p, *addr4_list_p, *addr6_list_p;
+    unsigned char *stable_len_list_p, *full_len_list_p, *installed_p;
+    unsigned char *len_list_p, *action_list_p, *ref_len_list_p, *ref_action_list_p;
+    struct bench_rcu_reader readers[BENCH_RCU_READER_MAX];
+    struct bench_params params = *params_p;
+    struct bench_rcu_ctx ctx;
+    unsigned int cnt, cnt4, cnt6, churn4, churn6, stable_cnt, churn_cnt, addr_cnt, reader_cnt, ref_vrid;
+    unsigned int i, j, k, op, mismatches = 0;
+    unsigned long long lookups = 0, violations = 0;
+    double t0, t1, max_batch = 0;
+    long cpu_cnt = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (params.lookups > BENCH_RCU_ADDR_MAX) {
+        params.lookups = BENCH_RCU_ADDR_MAX;
+    }
+    cnt4 = bench_prepare(&params, OES_IPV4, params.routes, &prefix4_list_p, &addr4_list_p);
+    cnt6 = bench_prepare(&params, OES_IPV6, params.routes / 5, &prefix6_list_p, &addr6_list_p);
+    cnt = cnt4 + cnt6;
+    addr_cnt = 2 * params.lookups;
+    prefix_list_p = malloc(cnt * sizeof(*prefix_list_p));
+    addr_list_p = malloc(addr_cnt * sizeof(*addr_list_p));
+    stable_len_list_p = malloc(addr_cnt);
+    full_len_list_p = malloc(addr_cnt);
+    len_list_p = malloc(addr_cnt);
+    action_list_p = malloc(addr_cnt);
+    ref_len_list_p = malloc(addr_cnt);
+    ref_action_list_p = malloc(addr_cnt);
+    installed_p = calloc(cnt, 1);
+    if ((prefix_list_p == NULL) || (addr_list_p == NULL) || (stable_len_list_p == NULL) ||
+        (full_len_list_p == NULL) || (len_list_p == NULL) || (action_list_p == NULL) ||
+        (ref_len_list_p == NULL) || (ref_action_list_p == NULL) || (installed_p == NULL)) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    /* stable routes of both versions, then the churned ones, the tables are in random order */
+    churn4 = cnt4 / BENCH_RCU_CHURN_SHARE;
+    churn6 = cnt6 / BENCH_RCU_CHURN_SHARE;
+    stable_cnt = cnt - churn4 - churn6;
+    churn_cnt = churn4 + churn6;
+    memcpy(prefix_list_p, prefix4_list_p, (cnt4 - churn4) * sizeof(*prefix_list_p));
+    memcpy(&prefix_list_p[cnt4 - churn4], prefix6_list_p, (cnt6 - churn6) * sizeof(*prefix_list_p));
+    memcpy(&prefix_list_p[stable_cnt], &prefix4_list_p[cnt4 - churn4], churn4 * sizeof(*prefix_list_p));
+    memcpy(&prefix_list_p[stable_cnt + churn4], &prefix6_list_p[cnt6 - churn6], churn6 * sizeof(*prefix_list_p));
+    for (i = 0; i < params.lookups; i++) {
+        addr_list_p[2 * i] = addr4_list_p[i];
+        addr_list_p[2 * i + 1] = addr6_list_p[i];
+    }
+
+    /* longest matches without the churned routes and with all of them */
+    if ((bench_router_add(&ctx.vrid) != 0) || (bench_neighs_add(ctx.vrid) != 0) ||
+        (bench_rcu_load(ctx.vrid, prefix_list_p, stable_cnt, cnt, installed_p) != 0)) {
+        return -1;
+    }
+    bench_rcu_lens(ctx.vrid, addr_list_p, addr_cnt, stable_len_list_p, NULL);
+    memset(installed_p, 1, churn_cnt);
+    oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE_ALL, ctx.vrid, NULL, NULL, NULL);
+    if (bench_rcu_load(ctx.vrid, prefix_list_p, stable_cnt, cnt, installed_p) != 0) {
+        return -1;
+    }
+    bench_rcu_lens(ctx.vrid, addr_list_p, addr_cnt, full_len_list_p, NULL);
+
+    ctx.addr_list_p = addr_list_p;
+    ctx.stable_len_list_p = stable_len_list_p;
+    ctx.full_len_list_p = full_len_list_p;
+    ctx.addr_cnt = addr_cnt;
+    ctx.done = 0;
+    reader_cnt = (cpu_cnt < 1) ? 1 : (cpu_cnt > BENCH_RCU_READER_MAX) ? BENCH_RCU_READER_MAX : cpu_cnt;
+    memset(readers, 0, sizeof(readers));
+    for (i = 0; i < reader_cnt; i++) {
+        readers[i].ctx_p = &ctx;
+        readers[i].first = (unsigned long long)addr_cnt * i / reader_cnt;
+        if (pthread_create(&readers[i].thread, NULL, bench_rcu_reader, &readers[i]) != 0) {
+            fprintf(stderr, "lookup thread start failed\n");
+            return -1;
+        }
+    }
+
+    /* withdrawals and announcements, now and then a bulk load of the withdrawn routes */
+    t0 = bench_now();
+    for (op = 0; op < BENCH_RCU_UPDATES; op++) {
+        if (op % BENCH_RCU_BULK_EVERY == BENCH_RCU_BULK_EVERY - 1) {
+            oes_api_router_uc_route_bulk_set(OES_ACCESS_CMD_CREATE, ctx.vrid, NULL);
+            for (k = 0, j = bench_rand() % churn_cnt; k < churn_cnt; k++, j = (j + 1) % churn_cnt) {
+                if (!installed_p[j]) {
+                    if (bench_rcu_route_set(ctx.vrid, OES_ACCESS_CMD_ADD, &prefix_list_p[stable_cnt + j]) != 0) {
+                        return -1;
+                    }
+                    installed_p[j] = 1;
+                }
+            }
+            if (oes_api_router_uc_route_bulk_set(OES_ACCESS_CMD_APPLY, ctx.vrid, NULL) != OES_STATUS_SUCCESS) {
+                fprintf(stderr, "churn bulk load failed\n");
+                return -1;
+            }
+            continue;
+        }
+        j = bench_rand() % churn_cnt;
+        if (bench_rcu_route_set(ctx.vrid, installed_p[j] ? OES_ACCESS_CMD_DELETE : OES_ACCESS_CMD_ADD,
+                                &prefix_list_p[stable_cnt + j]) != 0) {
+            return -1;
+        }
+        installed_p[j] = !installed_p[j];
+    }
+    t1 = bench_now();
+    __atomic_store_n(&ctx.done, 1, __ATOMIC_RELAXED);
+    for (i = 0; i < reader_cnt; i++) {
+        pthread_join(readers[i].thread, NULL);
+        lookups += readers[i].lookups;
+        violations += readers[i].violations;
+        if (readers[i].max_batch > max_batch) {
+            max_batch = readers[i].max_batch;
+        }
+    }
+    printf("churn:  %u updates on %u of %u routes in %.3f s, %.2f Mupdates/s\n",
+           BENCH_RCU_UPDATES, churn_cnt, cnt, t1 - t0, BENCH_RCU_UPDATES / (t1 - t0) / 1e6);
+    printf("lookup: %u threads, %llu lookups, %.2f Mlookups/s, slowest batch of %u %.1f us, "
+           "%llu wrong results\n", reader_cnt, lookups, lookups / (t1 - t0) / 1e6, BENCH_RCU_BATCH,
+           max_batch * 1e6, violations);
+
+    /* the routes left, loaded from scratch */
+    bench_rcu_lens(ctx.vrid, addr_list_p, addr_cnt, len_list_p, action_list_p);
+    if ((bench_router_add(&ref_vrid) != 0) || (bench_neighs_add(ref_vrid) != 0) ||
+        (bench_rcu_load(ref_vrid, prefix_list_p, stable_cnt, cnt, installed_p) != 0)) {
+        return -1;
+    }
+    bench_rcu_lens(ref_vrid, addr_list_p, addr_cnt, ref_len_list_p, ref_action_list_p);
+    for (i = 0; i < addr_cnt; i++) {
+        mismatches += (len_list_p[i] != ref_len_list_p[i]) || (action_list_p[i] != ref_action_list_p[i]);
+    }
+    printf("final:  %u lookups, %u differ from a table loaded from scratch\n", addr_cnt, mismatches);
+
+    oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE_ALL, ctx.vrid, NULL, NULL, NULL);
+    oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE_ALL, ref_vrid, NULL, NULL, NULL);
+    bench_router_delete(ctx.vrid);
+    bench_router_delete(ref_vrid);
+    free(prefix_list_p);
+    free(prefix4_list_p);
+    free(prefix6_list_p);
+    free(addr_list_p);
+    free(addr4_list_p);
+    free(addr6_list_p);
+    free(stable_len_list_p);
+    free(full_len_list_p);
+    free(len_list_p);
+    free(action_list_p);
+    free(ref_len_list_p);
+    free(ref_action_list_p);
+    free(installed_p);
+    return (violations || mismatches) ? -1 : 0;
+}
+
+static void
+bench_flows(struct oes_router_flow *flow_list_p, const unsigned int cnt, const int sequential)
+{
+    unsigned int i;
+
+    memset(flow_list_p, 0, cnt * sizeof(*flow_list_p));
+    for (i = 0; i < cnt; i++) {
+        flow_list_p[i].src_ip.version = OES_IPV4;
+        flow_list_p[i].dst_ip.version = OES_IPV4;
+        flow_list_p[i].protocol = IPPROTO_TCP;
+        if (sequential) {
+            /* one host pair, the source port alone changes */
+            flow_list_p[i].src_ip.addr.ipv4.s_addr = htonl(0xc0a80001);
+            flow_list_p[i].dst_ip.addr.ipv4.s_addr = htonl(0x0a000001);
+            flow_list_p[i].src_port = 1024 + i % 64512;
+            flow_list_p[i].dst_port = 80 + i / 64512;
+            continue;
+        }
+        flow_list_p[i].src_ip.addr.ipv4.s_addr = (unsigned int)bench_rand();
+        flow_list_p[i].dst_ip.addr.ipv4.s_addr = htonl(0x0a000000 | ((unsigned int)bench_rand() & 0xffffff));
+        flow_list_p[i].src_port = bench_rand();
+        flow_list_p[i].dst_port = bench_rand();
+        flow_list_p[i].protocol = (bench_rand() & 1) ? IPPROTO_TCP : IPPROTO_UDP;
+    }
+}
+
+/*
+ * Chi-square of the member counts against a uniform spread,
+ * printed with its distance from the expected value in standard
+ * deviations. Returns that distance.
+ */
+static double
+bench_chi_square(const char *name_p, const unsigned int *count_list_p,
+                 const unsigned int member_cnt, const unsigned int total)
+{
+    double expected = (double)total / member_cnt, chi = 0, dof = member_cnt - 1, z;
+    unsigned int i;
+
+    for (i = 0; i < member_cnt; i++) {
+        chi += (count_list_p[i] - expected) * (count_list_p[i] - expected) / expected;
+    }
+    z = (chi - dof) / sqrt(2 * dof);
+    printf("ecmp %-10s %3u members: chi2 %8.1f, %3.0f dof, %+5.2f sd\n", name_p, member_cnt, chi, dof, z);
+    return z;
+}
+
+/*
+ * Share of the flows whose predicted next hop changes when
+ * one next hop of a 16-way group leaves and comes back, with
+ * plain hashing and with resilient bucket tables. The flows are
+ * forwarded after each prediction and the bucket upkeep runs,
+ * active buckets must not move.
+ */
+static int
+bench_ecmp_resilient(const unsigned int vrid, const struct oes_router_flow *flow_list_p)
+{
+    static const struct {
+        unsigned short bucket_cnt;
+        unsigned int   idle_timer;
+    } configs[] = { { 0, 0 }, { 1024, 0 }, { 1024, 60000 } };
+    static unsigned int before[BENCH_ECMP_RESILIENT_FLOWS];
+    struct oes_ip_addr next_hops[BENCH_NEXT_HOP_CNT], next_hop;
+    unsigned short buckets[BENCH_NEXT_HOP_CNT], bucket_min, bucket_max;
+    unsigned int c, i, step, moved, member, upkeep_moved;
+    struct oes_uc_route_lookup lookup;
+    struct oes_uc_route_data data;
+    struct oes_ip_prefix prefix;
+    unsigned short cnt;
+
+    memset(&prefix, 0, sizeof(prefix));
+    prefix.prefix.version = OES_IPV4;
+    prefix.prefix.addr.ipv4.s_addr = htonl(0x0a000000);
+    prefix.prefix_len = 8;
+    memset(&data, 0, sizeof(data));
+    data.action = OES_ROUTER_ACTION_FORWARD;
+    data.next_hop_list = next_hops;
+    data.next_hop_cnt = BENCH_NEXT_HOP_CNT;
+    for (i = 0; i < BENCH_NEXT_HOP_CNT; i++) {
+        bench_next_hop(&next_hops[i], OES_IPV4, i);
+    }
+
+    for (c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        data.ecmp_bucket_cnt = configs[c].bucket_cnt;
+        data.ecmp_idle_timer = configs[c].idle_timer;
+        if ((oes_api_router_uc_route_set(OES_ACCESS_CMD_ADD, vrid, &prefix, &data, NULL) != OES_STATUS_SUCCESS) ||
+            (oes_api_router_uc_route_lookup(vrid, &prefix.prefix, &lookup, NULL) != OES_STATUS_SUCCESS)) {
+            return -1;
+        }
+        for (step = 0; step < 3; step++) {
+            /* step 1 takes next hop 5 out, step 2 puts it back */
+            if (step && (oes_api_router_next_hop_group_set((step == 1) ? OES_ACCESS_CMD_DELETE : OES_ACCESS_CMD_ADD,
+                                                           vrid, lookup.next_hop_group, &next_hops[5], 1, NULL) !=
+                         OES_STATUS_SUCCESS)) {
+                return -1;
+            }
+            moved = 0;
+            for (i = 0; i < BENCH_ECMP_RESILIENT_FLOWS; i++) {
+                if (oes_api_router_ecmp_next_hop_get(vrid, &flow_list_p[i], &next_hop, NULL) != OES_STATUS_SUCCESS) {
+                    return -1;
+                }
+                member = ntohl(next_hop.addr.ipv4.s_addr);
+                moved += (step && (member != before[i]));
+                before[i] = member;
+            }
+            if ((oes_api_router_ecmp_flow_update(vrid, flow_list_p, BENCH_ECMP_RESILIENT_FLOWS, NULL) !=
+                 OES_STATUS_SUCCESS) ||
+                (oes_api_router_ecmp_bucket_process(vrid, &upkeep_moved, NULL) != OES_STATUS_SUCCESS)) {
+                return -1;
+            }
+            if (step == 0) {
+                continue;
+            }
+            bucket_min = bucket_max = 0;
+            cnt = BENCH_NEXT_HOP_CNT;
+            if (configs[c].bucket_cnt &&
+                (oes_api_router_next_hop_group_buckets_get(vrid, lookup.next_hop_group, buckets, &cnt, NULL) ==
+                 OES_STATUS_SUCCESS)) {
+                bucket_min = bucket_max = buckets[0];
+                for (i = 1; i < cnt; i++) {
+                    bucket_min = (buckets[i] < bucket_min) ? buckets[i] : bucket_min;
+                    bucket_max = (buckets[i] > bucket_max) ? buckets[i] : bucket_max;
+                }
+            }
+            printf("ecmp %4u buckets, idle %5u ms, next hop %s: %5.2f%% flows moved, %u-%u buckets per next hop, "
+                   "upkeep moved %u\n",
+                   configs[c].bucket_cnt, configs[c].idle_timer, (step == 1) ? "removed" : "added  ",
+                   100.0 * moved / BENCH_ECMP_RESILIENT_FLOWS, bucket_min, bucket_max, upkeep_moved);
+        }
+    }
+    return 0;
+}
+
+/*
+ * Hash rate of single flows against batches, member spread of
+ * random and sequential port flows, and next-hop prediction over
+ * an ECMP route.
+ */
+static int
+bench_ecmp(const struct bench_params *params_p)
+{
+    static const unsigned int member_cnts[] = { 2, 3, 4, 8, 16, 64 };
+    static const char * const set_names[] = { "random", "sequential" };
+    struct oes_router_ecmp_hash_fields fields;
+    struct oes_ip_addr next_hops[BENCH_NEXT_HOP_CNT], next_hop;
+    struct oes_router_flow *flow_list_p;
+    struct oes_uc_route_data data;
+    struct oes_ip_prefix prefix;
+    unsigned int *hash_list_p, hashes[BENCH_ECMP_BATCH], counts[64];
+    unsigned int vrid, i, j, m, set, n, mismatches = 0, skewed = 0;
+    double t0, t1, single;
+
+    flow_list_p = malloc(BENCH_ECMP_FLOWS * sizeof(*flow_list_p));
+    hash_list_p = malloc(BENCH_ECMP_FLOWS * sizeof(*hash_list_p));
+    if ((flow_list_p == NULL) || (hash_list_p == NULL) || (bench_router_add(&vrid) != 0)) {
+        return -1;
+    }
+    memset(&fields, 0, sizeof(fields));
+    fields.enable_src_ip = 1;
+    fields.enable_dst_ip = 1;
+    fields.enable_tcp_udp = 1;
+    fields.enable_udp_src_port = 1;
+    fields.enable_dst_src_port = 1;
+    oes_api_router_ecmp_hash_params_set(vrid, &fields, NULL);
+    bench_seed(params_p->seed);
+
+    for (set = 0; set < 2; set++) {
+        bench_flows(flow_list_p, BENCH_ECMP_FLOWS, set);
+        if (set == 0) {
+            t0 = bench_now();
+            for (i = 0; i < params_p->lookups; i++) {
+                oes_api_router_ecmp_hash_get(vrid, &flow_list_p[i % BENCH_ECMP_FLOWS],
+                                             &hash_list_p[i % BENCH_ECMP_FLOWS], 1, NULL);
+            }
+            t1 = bench_now();
+            single = params_p->lookups / (t1 - t0) / 1e6;
+            printf("ecmp hash single:   %6.2f Mhashes/s\n", single);
+            t0 = bench_now();
+            for (i = 0; i + BENCH_ECMP_BATCH <= params_p->lookups; i += BENCH_ECMP_BATCH) {
+                n = i % BENCH_ECMP_FLOWS;
+                oes_api_router_ecmp_hash_get(vrid, &flow_list_p[n], hashes, BENCH_ECMP_BATCH, NULL);
+                for (j = 0; j < BENCH_ECMP_BATCH; j++) {
+                    mismatches += (hashes[j] != hash_list_p[n + j]);
+                }
+            }
+            t1 = bench_now();
+            printf("ecmp hash batch %2u: %6.2f Mhashes/s, x%.2f\n", BENCH_ECMP_BATCH,
+                   i / (t1 - t0) / 1e6, i / (t1 - t0) / 1e6 / single);
+        }
+        oes_api_router_ecmp_hash_get(vrid, flow_list_p, hash_list_p, BENCH_ECMP_FLOWS, NULL);
+        for (m = 0; m < sizeof(member_cnts) / sizeof(member_cnts[0]); m++) {
+            memset(counts, 0, sizeof(counts));
+            for (i = 0; i < BENCH_ECMP_FLOWS; i++) {
+                counts[(unsigned int)(((unsigned long long)hash_list_p[i] * member_cnts[m]) >> 32)]++;
+            }
+            skewed += (bench_chi_square(set_names[set], counts, member_cnts[m], BENCH_ECMP_FLOWS) > 4);
+        }
+    }
+
+    /* every flow of the random set goes through 10.0.0.0/8 */
+    memset(&prefix, 0, sizeof(prefix));
+    prefix.prefix.version = OES_IPV4;
+    prefix.prefix.addr.ipv4.s_addr = htonl(0x0a000000);
+    prefix.prefix_len = 8;
+    memset(&data, 0, sizeof(data));
+    data.action = OES_ROUTER_ACTION_FORWARD;
+    data.next_hop_list = next_hops;
+    data.next_hop_cnt = BENCH_NEXT_HOP_CNT;
+    for (j = 0; j < BENCH_NEXT_HOP_CNT; j++) {
+        bench_next_hop(&next_hops[j], OES_IPV4, j);
+    }
+    if (oes_api_router_uc_route_set(OES_ACCESS_CMD_ADD, vrid, &prefix, &data, NULL) != OES_STATUS_SUCCESS) {
+        return -1;
+    }
+    bench_flows(flow_list_p, BENCH_ECMP_FLOWS, 0);
+    memset(counts, 0, sizeof(counts));
+    t0 = bench_now();
+    for (i = 0; i < BENCH_ECMP_FLOWS; i++) {
+        if (oes_api_router_ecmp_next_hop_get(vrid, &flow_list_p[i], &next_hop, NULL) != OES_STATUS_SUCCESS) {
+            return -1;
+        }
+        counts[ntohl(next_hop.addr.ipv4.s_addr) - 0x0a000001]++;
+    }
+    t1 = bench_now();
+    printf("ecmp predict:       %6.2f Mflows/s\n", BENCH_ECMP_FLOWS / (t1 - t0) / 1e6);
+    skewed += (bench_chi_square("next hops", counts, BENCH_NEXT_HOP_CNT, BENCH_ECMP_FLOWS) > 4);
+    if (bench_ecmp_resilient(vrid, flow_list_p) != 0) {
+        fprintf(stderr, "resilient hashing run failed\n");
+        return -1;
+    }
+
+    oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE_ALL, vrid, NULL, NULL, NULL);
+    bench_router_delete(vrid);
+    free(flow_list_p);
+    free(hash_list_p);
+    if (mismatches || skewed) {
+        fprintf(stderr, "%u batch hashes differ from single ones, %u skewed spreads\n", mismatches, skewed);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Tenant VRFs, each with its own small table and neighbors of
+ * its next hops. Reports what one VRF costs, empty and loaded,
+ * and checks lookups of every VRF hit its own table.
+ */
+static int
+bench_vrf(const struct bench_params *params_p)
+{
+    struct oes_ip_prefix *prefix_list_p[2];
+    struct oes_ip_addr *addr_list_p[2];
+    struct oes_router_memory memory, empty;
+    struct oes_uc_route_lookup lookup;
+    unsigned int vrids[BENCH_VRF_CNT], cnt[2], i, v, misses = 0;
+    unsigned long long pool_bytes = 0, pool_peak_bytes = 0, table_bytes = 0;
+    double t0, t1, t2, t3, rss0, rss1;
+
+    for (v = 0; v < 2; v++) {
+        cnt[v] = bench_prepare(params_p, (v == 0) ? OES_IPV4 : OES_IPV6,
+                               (v == 0) ? params_p->routes : params_p->routes / 4,
+                               &prefix_list_p[v], &addr_list_p[v]);
+    }
+
+    rss0 = bench_rss_mb();
+    t0 = bench_now();
+    for (i = 0; i < BENCH_VRF_CNT; i++) {
+        if (bench_router_add(&vrids[i]) != 0) {
+            return -1;
+        }
+    }
+    t1 = bench_now();
+    if (oes_api_router_memory_get(vrids[0], &empty, NULL) != OES_STATUS_SUCCESS) {
+        fprintf(stderr, "memory get failed\n");
+        return -1;
+    }
+    printf("create: %u VRFs in %.3f ms, %.1f us each, %llu B pool and %llu B tables each\n",
+           BENCH_VRF_CNT, (t1 - t0) * 1e3, (t1 - t0) * 1e6 / BENCH_VRF_CNT, empty.pool_bytes,
+           empty.table_bytes);
+
+    for (i = 0; i < BENCH_VRF_CNT; i++) {
+        if (bench_neighs_add(vrids[i]) != 0) {
+            return -1;
+        }
+        for (v = 0; v < 2; v++) {
+            if (bench_load(vrids[i], prefix_list_p[v], cnt[v]) != 0) {
+                return -1;
+            }
+        }
+    }
+    t2 = bench_now();
+    rss1 = bench_rss_mb();
+    for (i = 0; i < BENCH_VRF_CNT; i++) {
+        if (oes_api_router_memory_get(vrids[i], &memory, NULL) != OES_STATUS_SUCCESS) {
+            fprintf(stderr, "memory get failed\n");
+            return -1;
+        }
+        pool_bytes += memory.pool_bytes;
+        pool_peak_bytes += memory.pool_peak_bytes;
+        table_bytes += memory.table_bytes;
+    }
+    printf("load:   %u ipv4 + %u ipv6 routes and %u neighbors per VRF in %.3f s, %.2f Mroutes/s\n",
+           cnt[0], cnt[1], 2 * BENCH_NEXT_HOP_CNT, t2 - t1,
+           (double)(cnt[0] + cnt[1]) * BENCH_VRF_CNT / (t2 - t1) / 1e6);
+    printf("memory: %.1f KB pool (peak %.1f KB) and %.1f KB tables per VRF, %.1f MB RSS for all\n",
+           pool_bytes / 1024.0 / BENCH_VRF_CNT, pool_peak_bytes / 1024.0 / BENCH_VRF_CNT,
+           table_bytes / 1024.0 / BENCH_VRF_CNT, rss1 - rss0);
+
+    t2 = bench_now();
+    for (i = 0; i < params_p->lookups; i++) {
+        v = i & 1;
+        if (oes_api_router_uc_route_lookup(vrids[i % BENCH_VRF_CNT], &addr_list_p[v][i / 2],
+                                           &lookup, NULL) != OES_STATUS_SUCCESS) {
+            misses++;
+        }
+    }
+    t3 = bench_now();
+    printf("lookup: %u lookups over all VRFs, %.1f ns each, %u missed\n",
+           params_p->lookups, (t3 - t2) * 1e9 / params_p->lookups, misses);
+
+    t0 = bench_now();
+    for (i = 0; i < BENCH_VRF_CNT; i++) {
+        oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE_ALL, vrids[i], NULL, NULL, NULL);
+        oes_api_router_neigh_set(OES_ACCESS_CMD_DELETE_ALL, vrids[i], NULL, NULL, NULL);
+        bench_router_delete(vrids[i]);
+    }
+    t1 = bench_now();
+    printf("delete: %u VRFs in %.3f ms, %.1f MB RSS left\n", BENCH_VRF_CNT, (t1 - t0) * 1e3,
+           bench_rss_mb() - rss0);
+
+    for (v = 0; v < 2; v++) {
+        free(prefix_list_p[v]);
+        free(addr_list_p[v]);
+    }
+    return misses ? -1 : 0;
+}
+
+/*
+ * Ages out the neighbors of a VR started together, polling the
+ * aging, but for the first live ones which get traffic between
+ * the runs. Returns the number of neighbors aged, with the most
+ * aged by a single run and the time spent aging.
+ */
+static unsigned int
+bench_neigh_age(const unsigned int vrid,
+                const unsigned int jitter,
+                const unsigned int live,
+                unsigned int *peak_p,
+                double *secs_p)
+{
+    struct oes_router_neigh_age_params age_params;
+    struct oes_ip_addr addr;
+    unsigned int aged, total = 0, polls, i;
+    double t0;
+
+    memset(&age_params, 0, sizeof(age_params));
+    age_params.age_time = BENCH_NEIGH_AGE_TIME;
+    age_params.jitter = jitter;
+    *peak_p = 0;
+    *secs_p = 0;
+    if (oes_api_router_neigh_age_params_set(vrid, &age_params, NULL) != OES_STATUS_SUCCESS) {
+        return 0;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.version = OES_IPV4;
+    for (polls = 0; polls < 4 * BENCH_NEIGH_AGE_TIME * 1000 / BENCH_NEIGH_AGE_POLL; polls++) {
+        usleep(BENCH_NEIGH_AGE_POLL);
+        for (i = 0; i < live; i++) {
+            addr.addr.ipv4.s_addr = htonl(0x0a000000 + i);
+            oes_api_router_neigh_activity_update(vrid, &addr, 1, NULL);
+        }
+        t0 = bench_now();
+        oes_api_router_neigh_age_process(vrid, &aged, NULL);
+        *secs_p += bench_now() - t0;
+        total += aged;
+        if (aged > *peak_p) {
+            *peak_p = aged;
+        }
+    }
+    memset(&age_params, 0, sizeof(age_params));
+    oes_api_router_neigh_age_params_set(vrid, &age_params, NULL);
+    return total;
+}
+
+/* one packet to a neighbor, reported as such or as a forwarded flow */
+static void
+bench_neigh_traffic(const unsigned int vrid,
+                    struct oes_router_flow *flow_p,
+                    const unsigned int addr,
+                    const int routed)
+{
+    flow_p->dst_ip.addr.ipv4.s_addr = htonl(addr);
+    if (routed) {
+        oes_api_router_ecmp_flow_update(vrid, flow_p, 1, NULL);
+    } else {
+        oes_api_router_neigh_activity_update(vrid, &flow_p->dst_ip, 1, NULL);
+    }
+}
+
+/*
+ * Activity of IPv4 neighbors, each the next hop of a host route,
+ * a share of which get traffic. A sweep of the activity bitmap
+ * against a GET_ACTIVITY call per neighbor. The neighbors are
+ * then aged out, all due together and with jitter: the jitter
+ * spreads the deletions, and the refresh probes they stand for,
+ * over many runs of the aging. The share with traffic during
+ * the aging is kept.
+ */
+static int
+bench_neigh(const struct bench_params *params_p)
+{
+    struct oes_ip_addr *addr_list_p, next_hop;
+    struct oes_uc_route_data route_data;
+    struct oes_neigh_data data;
+    struct oes_router_flow flow;
+    struct oes_ip_prefix prefix;
+    struct ether_addr mac;
+    unsigned int vrid, i, j, cnt, active = 0, inactive = 0, got = 0, aged = 0, peak;
+    unsigned int live = params_p->routes / BENCH_NEIGH_ACTIVE_SHARE;
+    unsigned short one;
+    double t0, t1, t2, t3, secs;
+
+    memset(&data, 0, sizeof(data));
+    addr_list_p = malloc(params_p->routes * sizeof(*addr_list_p));
+    if ((addr_list_p == NULL) || (bench_router_add(&vrid) != 0) || (bench_rifs_add(vrid, 1, &data.rif) != 0)) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    memset(&mac, 0, sizeof(mac));
+    memset(&route_data, 0, sizeof(route_data));
+    memset(&prefix, 0, sizeof(prefix));
+    data.mac_addr = &mac;
+    data.action = OES_ROUTER_ACTION_FORWARD;
+    route_data.action = OES_ROUTER_ACTION_FORWARD;
+    route_data.next_hop_list = &next_hop;
+    route_data.next_hop_cnt = 1;
+    prefix.prefix_len = 32;
+    t0 = bench_now();
+    for (i = 0; i < params_p->routes; i++) {
+        memset(&next_hop, 0, sizeof(next_hop));
+        next_hop.version = OES_IPV4;
+        next_hop.addr.ipv4.s_addr = htonl(0x0a000000 + i);
+        prefix.prefix = next_hop;
+        if ((oes_api_router_neigh_set(OES_ACCESS_CMD_ADD, vrid, &next_hop, &data, NULL) != OES_STATUS_SUCCESS) ||
+            (oes_api_router_uc_route_set(OES_ACCESS_CMD_ADD, vrid, &prefix, &route_data, NULL) !=
+             OES_STATUS_SUCCESS)) {
+            fprintf(stderr, "neighbor %u add failed\n", i);
+            return -1;
+        }
+    }
+    t1 = bench_now();
+    printf("add:    %u neighbors with a host route each in %.3f s\n", params_p->routes, t1 - t0);
+
+    /* traffic reported by the data path, half to the hosts, half through their routes */
+    memset(&flow, 0, sizeof(flow));
+    flow.src_ip.version = OES_IPV4;
+    flow.dst_ip.version = OES_IPV4;
+    bench_seed(params_p->seed);
+    for (i = 0; i < params_p->routes / BENCH_NEIGH_ACTIVE_SHARE; i++) {
+        bench_neigh_traffic(vrid, &flow, 0x0a000000 + bench_rand() % params_p->routes, i & 1);
+    }
+
+    /* the inactive ones, then the active ones read and cleared */
+    t2 = bench_now();
+    cnt = params_p->routes;
+    oes_api_router_neigh_activity_get(OES_ACCESS_CMD_READ, vrid, 0, addr_list_p, &cnt, NULL);
+    inactive = cnt;
+    t0 = bench_now();
+    cnt = params_p->routes;
+    oes_api_router_neigh_activity_get(OES_ACCESS_CMD_READ_CLEAR, vrid, 1, addr_list_p, &cnt, NULL);
+    active = cnt;
+    t1 = bench_now();
+    printf("sweep:  %u active in %.1f us, %u inactive in %.1f us\n", active, (t1 - t0) * 1e6, inactive,
+           (t0 - t2) * 1e6);
+
+    for (i = 0; i < params_p->routes / BENCH_NEIGH_ACTIVE_SHARE; i++) {
+        bench_neigh_traffic(vrid, &flow, 0x0a000000 + bench_rand() % params_p->routes, i & 1);
+    }
+    t2 = bench_now();
+    for (i = 0; i < params_p->routes; i++) {
+        memset(&next_hop, 0, sizeof(next_hop));
+        next_hop.version = OES_IPV4;
+        next_hop.addr.ipv4.s_addr = htonl(0x0a000000 + i);
+        one = 1;
+        if (oes_api_router_neigh_get(OES_ACCESS_CMD_GET_ACTIVITY, vrid, &next_hop, &data, &one, NULL) ==
+            OES_STATUS_SUCCESS) {
+            got += data.activity;
+        }
+    }
+    t3 = bench_now();
+    printf("get:    %u active of %u by GET_ACTIVITY in %.1f us, %.1fx the active sweep\n", got,
+           params_p->routes, (t3 - t2) * 1e6, (t3 - t2) / (t1 - t0));
+
+    for (j = 0; j <= BENCH_NEIGH_AGE_JITTER; j += BENCH_NEIGH_AGE_JITTER) {
+        /* the aged neighbors are added back, idle */
+        for (i = live; j && (i < params_p->routes); i++) {
+            memset(&next_hop, 0, sizeof(next_hop));
+            next_hop.version = OES_IPV4;
+            next_hop.addr.ipv4.s_addr = htonl(0x0a000000 + i);
+            oes_api_router_neigh_set(OES_ACCESS_CMD_ADD, vrid, &next_hop, &data, NULL);
+        }
+        cnt = bench_neigh_age(vrid, j, live, &peak, &secs);
+        printf("age:    jitter %2u%%: %u aged, %u with traffic kept, in %.1f ms of aging, at most %u by one run every "
+               "%u us\n", j, cnt, live, secs * 1e3, peak, BENCH_NEIGH_AGE_POLL);
+        aged += cnt;
+    }
+
+    oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE_ALL, vrid, NULL, NULL, NULL);
+    bench_router_delete(vrid);
+    free(addr_list_p);
+    return ((active + inactive == params_p->routes) && (aged == 2 * (params_p->routes - live))) ? 0 : -1;
+}
+
+/*
+ * Joins a receiver interface to groups whose (S,G) routes all
+ * share a large egress list, of the interfaces after the
+ * ingress one of the routes.
+ */
+static int
+bench_mc_join(const unsigned int vrid, const unsigned int *rif_list_p)
+{
+    struct oes_ip_addr group, source;
+    struct oes_mc_route_key key;
+    struct oes_mc_route_data data;
+    struct oes_router_memory memory;
+    unsigned int join = rif_list_p[BENCH_MC_JOIN_RIFS + 1], g, i;
+    unsigned long long pool0, pool1, pool2;
+    unsigned short cnt;
+    double t0, t1;
+
+    memset(&group, 0, sizeof(group));
+    group.version = OES_IPV4;
+    source = group;
+    key.mc_gruop_ip = &group;
+    key.sender_ip = &source;
+    key.ingress_rif = rif_list_p[0];
+    memset(&data, 0, sizeof(data));
+    data.action.action = OES_ROUTER_ACTION_FORWARD;
+    data.rif_list = (unsigned int *)&rif_list_p[1];
+    data.rif_cnt = BENCH_MC_JOIN_RIFS;
+
+    oes_api_router_memory_get(vrid, &memory, NULL);
+    pool0 = memory.pool_bytes;
+    for (g = 0; g < BENCH_MC_JOIN_GROUPS; g++) {
+        group.addr.ipv4.s_addr = htonl(0xe8000000 + g);
+        for (i = 0; i < BENCH_MC_JOIN_SOURCES; i++) {
+            source.addr.ipv4.s_addr = htonl(0x0b000000 + i);
+            if (oes_api_router_mc_route_set(OES_ACCESS_CMD_ADD, vrid, &key, &data, NULL) != OES_STATUS_SUCCESS) {
+                fprintf(stderr, "mc route add failed\n");
+                return -1;
+            }
+        }
+    }
+    oes_api_router_memory_get(vrid, &memory, NULL);
+    pool1 = memory.pool_bytes;
+
+    t0 = bench_now();
+    for (g = 0; g < BENCH_MC_JOIN_GROUPS; g++) {
+        group.addr.ipv4.s_addr = htonl(0xe8000000 + g);
+        for (i = 0; i < BENCH_MC_JOIN_SOURCES; i++) {
+            source.addr.ipv4.s_addr = htonl(0x0b000000 + i);
+            if (oes_api_router_mc_egress_rif_set(OES_ACCESS_CMD_ADD, vrid, &key, &join, 1, NULL) !=
+                OES_STATUS_SUCCESS) {
+                fprintf(stderr, "mc egress rif add failed\n");
+                return -1;
+            }
+        }
+    }
+    t1 = bench_now();
+    oes_api_router_memory_get(vrid, &memory, NULL);
+    pool2 = memory.pool_bytes;
+    cnt = 0;
+    oes_api_router_mc_egress_rif_get(vrid, &key, NULL, &cnt, NULL);
+    printf("join:   %u routes of %u rifs in %.1f KB, one rif joined to each in %.1f us per route, %.1f KB more\n",
+           BENCH_MC_JOIN_GROUPS * BENCH_MC_JOIN_SOURCES, BENCH_MC_JOIN_RIFS, (pool1 - pool0) / 1024.0,
+           (t1 - t0) * 1e6 / (BENCH_MC_JOIN_GROUPS * BENCH_MC_JOIN_SOURCES), ((double)pool2 - pool1) / 1024.0);
+    return (cnt == BENCH_MC_JOIN_RIFS + 1) ? 0 : -1;
+}
+
+/*
+ * Multicast routes: one (S,G,iif) route per group and a (*,G)
+ * route for every other group, so that lookups from unknown
+ * senders fall back. Measures the insert rate, then single
+ * against batched lookups, half of them from unknown senders.
+ * Then groups with many senders and a large egress list shared
+ * by their routes get a receiver interface joined, one route
+ * after the other, against the memory that takes.
+ */
+static int
+bench_mc(const struct bench_params *params_p)
+{
+    struct oes_ip_addr *group_list_p, *source_list_p, any;
+    struct oes_mc_route_key *key_list_p;
+    struct oes_mc_route_lookup *lookup_list_p;
+    struct oes_mc_route_data data;
+    struct oes_router_memory memory;
+    unsigned int vrid, rifs[BENCH_MC_JOIN_RIFS + 2], rif_list[4], i, hits = 0, batch_hits = 0, routes = 0;
+    double t0, t1, t2, t3;
+
+    group_list_p = malloc(params_p->lookups * sizeof(*group_list_p));
+    source_list_p = malloc(params_p->lookups * sizeof(*source_list_p));
+    key_list_p = malloc(params_p->lookups * sizeof(*key_list_p));
+    lookup_list_p = malloc(BENCH_MC_BATCH * sizeof(*lookup_list_p));
+    if ((group_list_p == NULL) || (source_list_p == NULL) || (key_list_p == NULL) || (lookup_list_p == NULL) ||
+        (bench_router_add(&vrid) != 0) || (bench_rifs_add(vrid, BENCH_MC_JOIN_RIFS + 2, rifs) != 0)) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    memset(&any, 0, sizeof(any));
+    any.version = OES_IPV4;
+    memset(&data, 0, sizeof(data));
+    data.action.action = OES_ROUTER_ACTION_FORWARD;
+    data.rif_list = rif_list;
+    for (i = 0; i < 4; i++) {
+        rif_list[i] = rifs[i + 1];
+    }
+
+    t0 = bench_now();
+    for (i = 0; i < params_p->routes; i++) {
+        memset(&group_list_p[0], 0, sizeof(group_list_p[0]));
+        group_list_p[0].version = OES_IPV4;
+        group_list_p[0].addr.ipv4.s_addr = htonl(0xe1000000 + i);
+        source_list_p[0] = any;
+        source_list_p[0].addr.ipv4.s_addr = htonl(0x0a000000 + i % BENCH_MC_SOURCES);
+        key_list_p[0].mc_gruop_ip = &group_list_p[0];
+        key_list_p[0].sender_ip = &source_list_p[0];
+        key_list_p[0].ingress_rif = rifs[i % BENCH_MC_RIFS];
+        data.rif_cnt = 1 + i % 4;
+        if (oes_api_router_mc_route_set(OES_ACCESS_CMD_ADD, vrid, &key_list_p[0], &data, NULL) !=
+            OES_STATUS_SUCCESS) {
+            fprintf(stderr, "mc route %u add failed\n", i);
+            return -1;
+        }
+        routes++;
+        if (i & 1) {
+            continue;
+        }
+        key_list_p[0].sender_ip = &any;
+        if (oes_api_router_mc_route_set(OES_ACCESS_CMD_ADD, vrid, &key_list_p[0], &data, NULL) !=
+            OES_STATUS_SUCCESS) {
+            fprintf(stderr, "mc route %u add failed\n", i);
+            return -1;
+        }
+        routes++;
+    }
+    t1 = bench_now();
+    oes_api_router_memory_get(vrid, &memory, NULL);
+    printf("load:   %u routes for %u groups in %.3f s, %.2f Mroutes/s, %.1f B pool each\n", routes,
+           params_p->routes, t1 - t0, routes / (t1 - t0) / 1e6, (double)memory.pool_bytes / routes);
+
+    /* one lookup in two from an unknown sender */
+    bench_seed(params_p->seed);
+    for (i = 0; i < params_p->lookups; i++) {
+        unsigned int idx = bench_rand() % params_p->routes;
+
+        memset(&group_list_p[i], 0, sizeof(group_list_p[i]));
+        group_list_p[i].version = OES_IPV4;
+        group_list_p[i].addr.ipv4.s_addr = htonl(0xe1000000 + idx);
+        source_list_p[i] = any;
+        source_list_p[i].addr.ipv4.s_addr = htonl(0x0a000000 + ((i & 1) ? idx % BENCH_MC_SOURCES :
+                                                                BENCH_MC_SOURCES + idx));
+        key_list_p[i].mc_gruop_ip = &group_list_p[i];
+        key_list_p[i].sender_ip = &source_list_p[i];
+        key_list_p[i].ingress_rif = rifs[idx % BENCH_MC_RIFS];
+    }
+
+    t0 = bench_now();
+    for (i = 0; i < params_p->lookups; i++) {
+        if (oes_api_router_mc_route_lookup(vrid, &key_list_p[i], &lookup_list_p[0], NULL) !=
+            OES_STATUS_SUCCESS) {
+            return -1;
+        }
+        hits += lookup_list_p[0].valid;
+    }
+    t1 = bench_now();
+    for (i = 0; i < params_p->lookups; i += BENCH_MC_BATCH) {
+        unsigned int cnt = (params_p->lookups - i < BENCH_MC_BATCH) ? params_p->lookups - i : BENCH_MC_BATCH;
+        unsigned int j;
+
+        if (oes_api_router_mc_route_lookup_batch(vrid, &key_list_p[i], lookup_list_p, cnt, NULL) !=
+            OES_STATUS_SUCCESS) {
+            return -1;
+        }
+        for (j = 0; j < cnt; j++) {
+            batch_hits += lookup_list_p[j].valid;
+        }
+    }
+    t2 = bench_now();
+    printf("lookup: single %.1f ns, batched by %u %.1f ns, %u of %u found\n",
+           (t1 - t0) * 1e9 / params_p->lookups, BENCH_MC_BATCH, (t2 - t1) * 1e9 / params_p->lookups, hits,
+           params_p->lookups);
+
+    if (bench_mc_join(vrid, rifs) != 0) {
+        return -1;
+    }
+
+    t2 = bench_now();
+    oes_api_router_mc_route_set(OES_ACCESS_CMD_DELETE_ALL, vrid, NULL, NULL, NULL);
+    t3 = bench_now();
+    printf("delete: all routes in %.3f ms\n", (t3 - t2) * 1e3);
+
+    bench_router_delete(vrid);
+    free(group_list_p);
+    free(source_list_p);
+    free(key_list_p);
+    free(lookup_list_p);
+    return (hits == batch_hits) ? 0 : -1;
+}
+
+struct bench_cntr_ctx {
+    unsigned int              vrid;
+    const unsigned int      * rif_list_p;
+    unsigned int              rif_cnt;
+    unsigned int              updates;      /**< per thread */
+    struct oes_router_cntr  * shared_p;     /**< NULL to count per CPU */
+};
+
+/* counts updates packets, over all the interfaces in turn */
+static void *
+bench_cntr_thread(void *arg_p)
+{
+    const struct bench_cntr_ctx *ctx_p = arg_p;
+    struct oes_router_cntr delta;
+    unsigned int i, idx;
+
+    memset(&delta, 0, sizeof(delta));
+    delta.router_ingress_unicast_packets = 1;
+    delta.router_ingress_unicast_bytes = BENCH_CNTR_PACKET;
+    for (i = 0; i < ctx_p->updates; i++) {
+        idx = i % ctx_p->rif_cnt;
+        if (ctx_p->shared_p == NULL) {
+            oes_api_router_interface_cntr_update(ctx_p->vrid, ctx_p->rif_list_p[idx], &delta, NULL);
+            continue;
+        }
+        __atomic_fetch_add(&ctx_p->shared_p[idx].router_ingress_unicast_packets, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&ctx_p->shared_p[idx].router_ingress_unicast_bytes, BENCH_CNTR_PACKET,
+                           __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+/*
+ * Router interface counters: the packets of all the CPUs counted
+ * with bare atomic adds on counters shared by all, the cost of
+ * the cache lines bouncing without that of the interface lookup,
+ * then on the per CPU counters through the API, then
+ * the counters of all the interfaces read one by one against a
+ * bulk read, and cleared.
+ */
+static int
+bench_cntr(const struct bench_params *params_p)
+{
+    long cpu_cnt = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int thread_cnt = (cpu_cnt > 1) ? cpu_cnt : 2, rif_cnt = params_p->routes, i, v, cnt;
+    struct bench_cntr_ctx ctx;
+    struct oes_router_cntr *shared_p, *cntr_list_p, cntr;
+    unsigned int *rif_list_p, *cntr_rif_list_p;
+    unsigned long long packets = 0, cleared = 0;
+    pthread_t *thread_list_p;
+    double t0, t1, secs[2];
+
+    if (thread_cnt > BENCH_CNTR_THREAD_MAX) {
+        thread_cnt = BENCH_CNTR_THREAD_MAX;
+    }
+    shared_p = calloc(rif_cnt, sizeof(*shared_p));
+    cntr_list_p = malloc(rif_cnt * sizeof(*cntr_list_p));
+    rif_list_p = malloc(rif_cnt * sizeof(*rif_list_p));
+    cntr_rif_list_p = malloc(rif_cnt * sizeof(*cntr_rif_list_p));
+    thread_list_p = malloc(thread_cnt * sizeof(*thread_list_p));
+    if ((shared_p == NULL) || (cntr_list_p == NULL) || (rif_list_p == NULL) || (cntr_rif_list_p == NULL) ||
+        (thread_list_p == NULL) || (bench_router_add(&ctx.vrid) != 0) ||
+        (bench_rifs_add(ctx.vrid, rif_cnt, cntr_rif_list_p) != 0)) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    for (i = 0; i < rif_cnt; i++) {
+        if (oes_api_router_interface_cntr_enable_set(OES_ACCESS_CMD_ADD, ctx.vrid, cntr_rif_list_p[i], NULL) !=
+            OES_STATUS_SUCCESS) {
+            fprintf(stderr, "counter %u enable failed\n", i);
+            return -1;
+        }
+    }
+    ctx.rif_list_p = cntr_rif_list_p;
+    ctx.rif_cnt = rif_cnt;
+    ctx.updates = params_p->lookups / thread_cnt;
+
+    /* shared first, then per CPU */
+    for (v = 0; v < 2; v++) {
+        ctx.shared_p = v ? NULL : shared_p;
+        t0 = bench_now();
+        for (i = 0; i < thread_cnt; i++) {
+            pthread_create(&thread_list_p[i], NULL, bench_cntr_thread, &ctx);
+        }
+        for (i = 0; i < thread_cnt; i++) {
+            pthread_join(thread_list_p[i], NULL);
+        }
+        t1 = bench_now();
+        secs[v] = t1 - t0;
+    }
+    printf("count:  %u threads over %u rifs, bare atomics on shared counters %.1f ns, per CPU counters "
+           "through the API %.1f ns per update\n",
+           thread_cnt, rif_cnt, secs[0] * 1e9 / ((double)ctx.updates * thread_cnt),
+           secs[1] * 1e9 / ((double)ctx.updates * thread_cnt));
+
+    t0 = bench_now();
+    for (i = 0; i < rif_cnt; i++) {
+        oes_api_router_interface_cntr_get(OES_ACCESS_CMD_READ, ctx.vrid, cntr_rif_list_p[i], &cntr, NULL);
+        packets += cntr.router_ingress_unicast_packets;
+    }
+    t1 = bench_now();
+    cnt = rif_cnt;
+    oes_api_router_interface_cntr_bulk_get(OES_ACCESS_CMD_READ_CLEAR, ctx.vrid, 0, rif_list_p, cntr_list_p, &cnt,
+                                           NULL);
+    secs[0] = bench_now() - t1;
+    for (i = 0; i < cnt; i++) {
+        cleared += cntr_list_p[i].router_ingress_unicast_packets;
+    }
+    printf("read:   %u rifs one by one in %.1f us, bulk read and clear in %.1f us, %llu packets\n", rif_cnt,
+           (t1 - t0) * 1e6, secs[0] * 1e6, cleared);
+
+    for (i = 0; i < rif_cnt; i++) {
+        oes_api_router_interface_cntr_get(OES_ACCESS_CMD_READ, ctx.vrid, cntr_rif_list_p[i], &cntr, NULL);
+        cleared += cntr.router_ingress_unicast_packets;
+    }
+    bench_router_delete(ctx.vrid);
+    free(shared_p);
+    free(cntr_list_p);
+    free(rif_list_p);
+    free(cntr_rif_list_p);
+    free(thread_list_p);
+    return ((packets == (unsigned long long)ctx.updates * thread_cnt) && (cleared == packets)) ? 0 : -1;
+}
+
+/* pages of a walk, timing each page */
+static int
+bench_page_walk(const unsigned int vrid,
+                struct oes_ip_prefix *key_list_p,
+                struct oes_uc_route_data *data_list_p,
+                double *max_p)
+{
+    enum oes_access_cmd cmd = OES_ACCESS_CMD_GET_FIRST;
+    unsigned short cnt;
+    unsigned int i, listed = 0;
+    double t0, t1;
+
+    *max_p = 0;
+    do {
+        cnt = BENCH_PAGE_SIZE;
+        for (i = 0; i < cnt; i++) {
+            data_list_p[i].next_hop_list = NULL;
+            data_list_p[i].next_hop_cnt = 0;
+        }
+        if (listed) {
+            key_list_p[0] = key_list_p[BENCH_PAGE_SIZE - 1];
+        }
+        t0 = bench_now();
+        if (oes_api_router_uc_route_get(cmd, vrid, key_list_p, data_list_p, &cnt, NULL) != OES_STATUS_SUCCESS) {
+            return -1;
+        }
+        t1 = bench_now();
+        if (t1 - t0 > *max_p) {
+            *max_p = t1 - t0;
+        }
+        cmd = OES_ACCESS_CMD_GET_NEXT;
+        listed += cnt;
+    } while (cnt == BENCH_PAGE_SIZE);
+    return listed;
+}
+
+static int
+bench_page(const struct bench_params *params_p)
+{
+    struct oes_ip_prefix *prefix_list_p, *key_list_p;
+    struct oes_uc_route_data *data_list_p;
+    struct oes_router_memory memory;
+    struct oes_ip_addr *addr_list_p;
+    unsigned long long pool_bytes;
+    unsigned int vrid, cnt, churn, seeks, i;
+    unsigned short page;
+    int listed;
+    double t0, t1, max;
+
+    cnt = bench_prepare(params_p, OES_IPV4, params_p->routes, &prefix_list_p, &addr_list_p);
+    key_list_p = malloc(BENCH_PAGE_SIZE * sizeof(*key_list_p));
+    data_list_p = malloc(BENCH_PAGE_SIZE * sizeof(*data_list_p));
+    if ((key_list_p == NULL) || (data_list_p == NULL) || (bench_router_add(&vrid) != 0) ||
+        (bench_load(vrid, prefix_list_p, cnt) != 0)) {
+        return -1;
+    }
+    oes_api_router_memory_get(vrid, &memory, NULL);
+    pool_bytes = memory.pool_bytes;
+
+    /* the first page sorts the table */
+    t0 = bench_now();
+    listed = bench_page_walk(vrid, key_list_p, data_list_p, &max);
+    t1 = bench_now();
+    oes_api_router_memory_get(vrid, &memory, NULL);
+    printf("walk:   %d routes in pages of %u, %.3f s, first page %.1f ms, index %.1f B per route\n", listed,
+           BENCH_PAGE_SIZE, t1 - t0, max * 1e3, (double)(memory.pool_bytes - pool_bytes) / cnt);
+    if (listed != (int)cnt) {
+        return -1;
+    }
+    t0 = bench_now();
+    listed = bench_page_walk(vrid, key_list_p, data_list_p, &max);
+    t1 = bench_now();
+    printf("walk:   again %.3f s, %.1f us per page, slowest %.1f us\n", t1 - t0,
+           (t1 - t0) * 1e6 * BENCH_PAGE_SIZE / cnt, max * 1e6);
+
+    /* one route in 100 deleted and added back, the order kept up to date */
+    churn = cnt / 100;
+    t0 = bench_now();
+    for (i = 0; i < churn; i++) {
+        oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE, vrid, &prefix_list_p[i], NULL, NULL);
+    }
+    if (bench_load(vrid, prefix_list_p, churn) != 0) {
+        return -1;
+    }
+    t1 = bench_now();
+    printf("churn:  %u deletes and adds, %.2f us each\n", churn, (t1 - t0) * 1e6 / (2 * churn));
+
+    /* pages after addresses, as /32 most are not routes */
+    seeks = (params_p->lookups < 100000) ? params_p->lookups : 100000;
+    t0 = bench_now();
+    for (i = 0; i < seeks; i++) {
+        key_list_p[0].prefix = addr_list_p[i];
+        key_list_p[0].prefix_len = 32;
+        page = 1;
+        data_list_p[0].next_hop_list = NULL;
+        data_list_p[0].next_hop_cnt = 0;
+        if (oes_api_router_uc_route_get(OES_ACCESS_CMD_GET_NEXT, vrid, key_list_p, data_list_p, &page, NULL) !=
+            OES_STATUS_SUCCESS) {
+            return -1;
+        }
+    }
+    t1 = bench_now();
+    printf("seek:   %u GET_NEXT of one route after an address, %.1f ns each\n", seeks, (t1 - t0) * 1e9 / seeks);
+
+    oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE_ALL, vrid, NULL, NULL, NULL);
+    bench_router_delete(vrid);
+    free(prefix_list_p);
+    free(addr_list_p);
+    free(key_list_p);
+    free(data_list_p);
+    return (listed == (int)cnt) ? 0 : -1;
+}
+
+/*
+ * BGP-like update stream, generated from the seed before it is
+ * replayed so that runs with the same seed replay the same
+ * updates. Most updates are path changes, moving a route to
+ * other next hops, the others withdraw and announce routes
+ * again, some flap: withdrawn and announced back to back. Now
+ * and then a peer goes down and a run of routes moves at once.
+ */
+enum bench_churn_op {
+    BENCH_CHURN_NEXT_HOP,
+    BENCH_CHURN_WITHDRAW,
+    BENCH_CHURN_ANNOUNCE,
+};
+
+struct bench_churn_update {
+    unsigned int    route;
+    unsigned char   op;
+    unsigned char   next_hop;
+};
+
+struct bench_churn_stream {
+    struct bench_churn_update * update_list_p;
+    unsigned int                cnt;
+    unsigned int                op_cnt[3];
+    unsigned int                flaps;
+    unsigned int                bursts;
+};
+
+struct bench_churn_reader {
+    unsigned int                vrid;
+    const struct oes_ip_addr  * addr_list_p;
+    unsigned int                addr_cnt;
+    unsigned int                first;
+    const int                 * done_p;
+    pthread_t                   thread;
+    unsigned long long          lookups;
+};
+
+static void
+bench_churn_push(struct bench_churn_stream *stream_p,
+                 const unsigned int route,
+                 const enum bench_churn_op op,
+                 const unsigned int next_hop)
+{
+    struct bench_churn_update *update_p = &stream_p->update_list_p[stream_p->cnt++];
+
+    update_p->route = route;
+    update_p->op = op;
+    update_p->next_hop = next_hop;
+    stream_p->op_cnt[op]++;
+}
+
+/* a random route announced, or withdrawn */
+static unsigned int
+bench_churn_pick(const unsigned char *installed_p, const unsigned int cnt, const int installed)
+{
+    unsigned int route = bench_rand() % cnt;
+
+    while (installed_p[route] != installed) {
+        route = (route + 1) % cnt;
+    }
+    return route;
+}
+
+static int
+bench_churn_stream(struct bench_churn_stream *stream_p, const unsigned int route_cnt)
+{
+    unsigned char *installed_p = malloc(route_cnt);
+    unsigned int withdrawn = 0, route, len, k, next_hop, r;
+
+    memset(stream_p, 0, sizeof(*stream_p));
+    stream_p->update_list_p = malloc(BENCH_CHURN_UPDATES * sizeof(*stream_p->update_list_p));
+    if ((installed_p == NULL) || (stream_p->update_list_p == NULL)) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    memset(installed_p, 1, route_cnt);
+    while (stream_p->cnt < BENCH_CHURN_UPDATES - 1) {
+        next_hop = bench_rand() % BENCH_NEXT_HOP_CNT;
+        r = bench_rand() % BENCH_CHURN_EVENT_SHARES;
+        if (r == 0) {
+            /* the routes of a peer gone down move to another one */
+            route = bench_rand() % route_cnt;
+            len = 1 + bench_rand() % BENCH_CHURN_BURST_MAX;
+            for (k = 0; (k < len) && (stream_p->cnt < BENCH_CHURN_UPDATES); k++, route = (route + 1) % route_cnt) {
+                if (installed_p[route]) {
+                    bench_churn_push(stream_p, route, BENCH_CHURN_NEXT_HOP, next_hop);
+                }
+            }
+            stream_p->bursts++;
+            continue;
+        }
+        r = bench_rand() % 100;
+        if ((r < 55) || ((r < 95) && (r >= 75) && (withdrawn == 0))) {
+            bench_churn_push(stream_p, bench_churn_pick(installed_p, route_cnt, 1), BENCH_CHURN_NEXT_HOP,
+                             next_hop);
+        } else if ((r < 75) && (withdrawn < route_cnt / BENCH_CHURN_WITHDRAWN_SHARE)) {
+            route = bench_churn_pick(installed_p, route_cnt, 1);
+            bench_churn_push(stream_p, route, BENCH_CHURN_WITHDRAW, 0);
+            installed_p[route] = 0;
+            withdrawn++;
+        } else if ((r < 95) && withdrawn) {
+            route = bench_churn_pick(installed_p, route_cnt, 0);
+            bench_churn_push(stream_p, route, BENCH_CHURN_ANNOUNCE, next_hop);
+            installed_p[route] = 1;
+            withdrawn--;
+        } else {
+            route = bench_churn_pick(installed_p, route_cnt, 1);
+            bench_churn_push(stream_p, route, BENCH_CHURN_WITHDRAW, 0);
+            bench_churn_push(stream_p, route, BENCH_CHURN_ANNOUNCE, next_hop);
+            stream_p->flaps++;
+        }
+    }
+    free(installed_p);
+    return 0;
+}
+
+/* replays updates, returns the slowest one */
+static double
+bench_churn_replay(const unsigned int vrid,
+                   const struct oes_ip_prefix *prefix_list_p,
+                   const struct bench_churn_update *update_list_p,
+                   const unsigned int cnt)
+{
+    const struct bench_churn_update *update_p;
+    struct oes_ip_addr next_hops[2];
+    struct oes_uc_route_data data;
+    unsigned int i, j;
+    double t0, t1, max = 0;
+    oes_status_e status;
+
+    memset(&data, 0, sizeof(data));
+    data.action = OES_ROUTER_ACTION_FORWARD;
+    data.next_hop_list = next_hops;
+    for (i = 0; i < cnt; i++) {
+        update_p = &update_list_p[i];
+        t0 = bench_now();
+        if (update_p->op == BENCH_CHURN_WITHDRAW) {
+            status = oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE, vrid, &prefix_list_p[update_p->route],
+                                                 NULL, NULL);
+        } else {
+            /* one route in ten is ECMP, as loaded */
+            data.next_hop_cnt = (update_p->route % 10) ? 1 : 2;
+            for (j = 0; j < data.next_hop_cnt; j++) {
+                bench_next_hop(&next_hops[j], prefix_list_p[update_p->route].prefix.version,
+                               (update_p->next_hop + j) % BENCH_NEXT_HOP_CNT);
+            }
+            status = oes_api_router_uc_route_set((update_p->op == BENCH_CHURN_NEXT_HOP) ?
+                                                 OES_ACCESS_CMD_EDIT : OES_ACCESS_CMD_ADD,
+                                                 vrid, &prefix_list_p[update_p->route], &data, NULL);
+        }
+        t1 = bench_now();
+        if (status != OES_STATUS_SUCCESS) {
+            fprintf(stderr, "update %u of route %u failed\n", i, update_p->route);
+            return -1;
+        }
+        if (t1 - t0 > max) {
+            max = t1 - t0;
+        }
+    }
+    return max;
+}
+
+static void *
+bench_churn_reader(void *arg_p)
+{
+    struct bench_churn_reader *reader_p = arg_p;
+    struct oes_uc_route_lookup lookups[BENCH_RCU_BATCH];
+    unsigned int i = reader_p->first, cnt;
+
+    while (!__atomic_load_n(reader_p->done_p, __ATOMIC_RELAXED)) {
+        cnt = (reader_p->addr_cnt - i < BENCH_RCU_BATCH) ? reader_p->addr_cnt - i : BENCH_RCU_BATCH;
+        oes_api_router_uc_route_lookup_batch(reader_p->vrid, &reader_p->addr_list_p[i], lookups, cnt, NULL);
+        reader_p->lookups += cnt;
+        i = (i + cnt == reader_p->addr_cnt) ? 0 : i + cnt;
+    }
+    return NULL;
+}
+
+static int
+bench_churn_readers_start(struct bench_churn_reader *reader_list_p,
+                          const unsigned int reader_cnt,
+                          const unsigned int vrid,
+                          const struct oes_ip_addr *addr_list_p,
+                          const unsigned int addr_cnt,
+                          const int *done_p)
+{
+    unsigned int i;
+
+    for (i = 0; i < reader_cnt; i++) {
+        memset(&reader_list_p[i], 0, sizeof(reader_list_p[i]));
+        reader_list_p[i].vrid = vrid;
+        reader_list_p[i].addr_list_p = addr_list_p;
+        reader_list_p[i].addr_cnt = addr_cnt;
+        reader_list_p[i].first = (unsigned long long)addr_cnt * i / reader_cnt;
+        reader_list_p[i].done_p = done_p;
+        if (pthread_create(&reader_list_p[i].thread, NULL, bench_churn_reader, &reader_list_p[i]) != 0) {
+            fprintf(stderr, "lookup thread start failed\n");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static unsigned long long
+bench_churn_readers_stop(struct bench_churn_reader *reader_list_p, const unsigned int reader_cnt, int *done_p)
+{
+    unsigned long long lookups = 0;
+    unsigned int i;
+
+    __atomic_store_n(done_p, 1, __ATOMIC_RELAXED);
+    for (i = 0; i < reader_cnt; i++) {
+        pthread_join(reader_list_p[i].thread, NULL);
+        lookups += reader_list_p[i].lookups;
+    }
+    *done_p = 0;
+    return lookups;
+}
+
+/*
+ * Route churn. Loads a full table of both IP versions, then
+ * replays the update stream, its first half alone and its second
+ * half while a lookup thread per CPU runs, against lookups alone.
+ */
+static int
+bench_churn(const struct bench_params *params_p)
+{
+    struct oes_ip_prefix *prefix_list_p, *prefix4_list_p, *prefix6_list_p;
+    struct oes_ip_addr *addr_list_p, *addr4_list_p, *addr6_list_p;
+    struct bench_churn_reader readers[BENCH_RCU_READER_MAX];
+    struct bench_params params = *params_p;
+    struct bench_churn_stream stream;
+    struct oes_router_memory memory, load_memory;
+    struct oes_uc_route_data data;
+    unsigned int vrid, cnt, cnt4, cnt6, addr_cnt, reader_cnt, half, i, found = 0;
+    unsigned short one;
+    unsigned long long lookups;
+    double t0, t1, rss0, load_rss, max, lookup_rate;
+    long cpu_cnt = sysconf(_SC_NPROCESSORS_ONLN);
+    int done = 0;
+
+    if (params.lookups > BENCH_RCU_ADDR_MAX) {
+        params.lookups = BENCH_RCU_ADDR_MAX;
+    }
+    cnt4 = bench_prepare(&params, OES_IPV4, params.routes, &prefix4_list_p, &addr4_list_p);
+    cnt6 = bench_prepare(&params, OES_IPV6, params.routes / 5, &prefix6_list_p, &addr6_list_p);
+    cnt = cnt4 + cnt6;
+    addr_cnt = 2 * params.lookups;
+    prefix_list_p = malloc(cnt * sizeof(*prefix_list_p));
+    addr_list_p = malloc(addr_cnt * sizeof(*addr_list_p));
+    if ((prefix_list_p == NULL) || (addr_list_p == NULL)) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    memcpy(prefix_list_p, prefix4_list_p, cnt4 * sizeof(*prefix_list_p));
+    memcpy(&prefix_list_p[cnt4], prefix6_list_p, cnt6 * sizeof(*prefix_list_p));
+    for (i = 0; i < params.lookups; i++) {
+        addr_list_p[2 * i] = addr4_list_p[i];
+        addr_list_p[2 * i + 1] = addr6_list_p[i];
+    }
+    bench_seed(params.seed);
+    if (bench_churn_stream(&stream, cnt) != 0) {
+        return -1;
+    }
+    printf("stream: %u updates, %u path changes, %u withdrawals, %u announcements, %u flaps, "
+           "%u peers down\n", stream.cnt, stream.op_cnt[BENCH_CHURN_NEXT_HOP],
+           stream.op_cnt[BENCH_CHURN_WITHDRAW], stream.op_cnt[BENCH_CHURN_ANNOUNCE], stream.flaps, stream.bursts);
+
+    rss0 = bench_rss_mb();
+    if ((bench_router_add(&vrid) != 0) || (bench_neighs_add(vrid) != 0)) {
+        return -1;
+    }
+    t0 = bench_now();
+    if (bench_load(vrid, prefix_list_p, cnt) != 0) {
+        return -1;
+    }
+    t1 = bench_now();
+    load_rss = bench_rss_mb();
+    oes_api_router_memory_get(vrid, &load_memory, NULL);
+    printf("load:   %u routes in %.3f s, %.2f Mroutes/s, pool %.1f MB, tables %.1f MB, RSS %.1f MB\n", cnt,
+           t1 - t0, cnt / (t1 - t0) / 1e6, load_memory.pool_bytes / 1048576.0,
+           load_memory.table_bytes / 1048576.0, load_rss - rss0);
+
+    reader_cnt = (cpu_cnt < 1) ? 1 : (cpu_cnt > BENCH_RCU_READER_MAX) ? BENCH_RCU_READER_MAX : cpu_cnt;
+    if (bench_churn_readers_start(readers, reader_cnt, vrid, addr_list_p, addr_cnt, &done) != 0) {
+        return -1;
+    }
+    t0 = bench_now();
+    usleep(BENCH_CHURN_LOOKUP_TIME);
+    lookups = bench_churn_readers_stop(readers, reader_cnt, &done);
+    t1 = bench_now();
+    lookup_rate = lookups / (t1 - t0);
+    printf("lookup: %u threads alone, %.2f Mlookups/s\n", reader_cnt, lookup_rate / 1e6);
+
+    half = stream.cnt / 2;
+    t0 = bench_now();
+    max = bench_churn_replay(vrid, prefix_list_p, stream.update_list_p, half);
+    t1 = bench_now();
+    if (max < 0) {
+        return -1;
+    }
+    printf("churn:  %u updates alone, %.3f s, %.1f Kupdates/s, slowest %.1f us\n", half, t1 - t0,
+           half / (t1 - t0) / 1e3, max * 1e6);
+
+    if (bench_churn_readers_start(readers, reader_cnt, vrid, addr_list_p, addr_cnt, &done) != 0) {
+        return -1;
+    }
+    t0 = bench_now();
+    max = bench_churn_replay(vrid, prefix_list_p, &stream.update_list_p[half], stream.cnt - half);
+    lookups = bench_churn_readers_stop(readers, reader_cnt, &done);
+    t1 = bench_now();
+    if (max < 0) {
+        return -1;
+    }
+    printf("churn:  %u updates with lookups, %.3f s, %.1f Kupdates/s, slowest %.1f us\n", stream.cnt - half,
+           t1 - t0, (stream.cnt - half) / (t1 - t0) / 1e3, max * 1e6);
+    printf("lookup: %u threads during churn, %.2f Mlookups/s, %.1f%% below lookups alone\n", reader_cnt,
+           lookups / (t1 - t0) / 1e6, 100.0 * (1 - lookups / (t1 - t0) / lookup_rate));
+
+    oes_api_router_memory_get(vrid, &memory, NULL);
+    printf("memory: pool %.1f MB (%+.1f), peak %.1f MB, tables %.1f MB (%+.1f), RSS %+.1f MB since load\n",
+           memory.pool_bytes / 1048576.0,
+           ((double)memory.pool_bytes - load_memory.pool_bytes) / 1048576.0, memory.pool_peak_bytes / 1048576.0,
+           memory.table_bytes / 1048576.0,
+           ((double)memory.table_bytes - load_memory.table_bytes) / 1048576.0, bench_rss_mb() - load_rss);
+
+    /* the routes left are those the stream leaves announced */
+    memset(&data, 0, sizeof(data));
+    for (i = 0; i < cnt; i++) {
+        one = 1;
+        found += oes_api_router_uc_route_get(OES_ACCESS_CMD_GET, vrid, &prefix_list_p[i], &data, &one, NULL) ==
+                 OES_STATUS_SUCCESS;
+    }
+    printf("final:  %u routes, %u withdrawn\n", found, cnt - found);
+
+    oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE_ALL, vrid, NULL, NULL, NULL);
+    bench_router_delete(vrid);
+    free(stream.update_list_p);
+    free(prefix_list_p);
+    free(prefix4_list_p);
+    free(prefix6_list_p);
+    free(addr_list_p);
+    free(addr4_list_p);
+    free(addr6_list_p);
+    return (found + stream.op_cnt[BENCH_CHURN_WITHDRAW] - stream.op_cnt[BENCH_CHURN_ANNOUNCE] == cnt) ? 0 : -1;
+}
+
+/*
+ * Prefix-independent convergence. Half the routes forward to one
+ * next hop, the others to it and a second one over ECMP, so that
+ * they share two next-hop groups. The first next hop's neighbor
+ * is deleted and added back, then the single next-hop group is
+ * moved to a third next hop, each time against setting every
+ * route again. All but the latter should not depend on the
+ * number of routes.
+ */
+static int
+bench_pic_neigh(const unsigned int vrid,
+                const unsigned int rif,
+                const enum oes_access_cmd access_cmd,
+                const unsigned int next_hop,
+                double *time_p)
+{
+    struct oes_neigh_data data;
+    struct oes_ip_addr addr;
+    struct ether_addr mac;
+    double t0;
+
+    memset(&data, 0, sizeof(data));
+    memset(&mac, 0, sizeof(mac));
+    mac.ether_addr_octet[5] = next_hop;
+    data.rif = rif;
+    data.mac_addr = &mac;
+    data.action = OES_ROUTER_ACTION_FORWARD;
+    bench_next_hop(&addr, OES_IPV4, next_hop);
+    t0 = bench_now();
+    if (oes_api_router_neigh_set(access_cmd, vrid, &addr, &data, NULL) != OES_STATUS_SUCCESS) {
+        fprintf(stderr, "neighbor %u set failed\n", next_hop);
+        return -1;
+    }
+    *time_p = bench_now() - t0;
+    return 0;
+}
+
+/*
+ * Routes of the single next-hop group without the action
+ * expected, of those the address under them matches.
+ */
+static unsigned int
+bench_pic_check(const unsigned int vrid,
+                const struct oes_ip_prefix *prefix_list_p,
+                const struct oes_ip_addr *addr_list_p,
+                const unsigned int cnt,
+                const enum oes_router_action action)
+{
+    struct oes_uc_route_lookup lookup;
+    unsigned int i, wrong = 0;
+
+    for (i = 0; i < cnt; i += 2) {
+        if ((oes_api_router_uc_route_lookup(vrid, &addr_list_p[i], &lookup, NULL) == OES_STATUS_SUCCESS) &&
+            (lookup.prefix_len == prefix_list_p[i].prefix_len)) {
+            wrong += (lookup.action != action);
+        }
+    }
+    return wrong;
+}
+
+static int
+bench_pic_run(const struct oes_ip_prefix *prefix_list_p,
+              const struct oes_ip_addr *addr_list_p,
+              const unsigned int cnt)
+{
+    struct oes_ip_addr next_hops[2];
+    struct oes_uc_route_lookup lookup;
+    struct oes_uc_route_data data;
+    unsigned int vrid, rif, i, wrong;
+    double down, up, t0, group, routes;
+
+    if ((bench_router_add(&vrid) != 0) || (bench_rifs_add(vrid, 1, &rif) != 0) ||
+        (bench_pic_neigh(vrid, rif, OES_ACCESS_CMD_ADD, 0, &t0) != 0) ||
+        (bench_pic_neigh(vrid, rif, OES_ACCESS_CMD_ADD, 1, &t0) != 0) ||
+        (bench_pic_neigh(vrid, rif, OES_ACCESS_CMD_ADD, 2, &t0) != 0)) {
+        return -1;
+    }
+    bench_next_hop(&next_hops[0], OES_IPV4, 0);
+    bench_next_hop(&next_hops[1], OES_IPV4, 1);
+    memset(&data, 0, sizeof(data));
+    data.action = OES_ROUTER_ACTION_FORWARD;
+    data.next_hop_list = next_hops;
+    for (i = 0; i < cnt; i++) {
+        data.next_hop_cnt = 1 + (i & 1);
+        if (oes_api_router_uc_route_set(OES_ACCESS_CMD_ADD, vrid, &prefix_list_p[i], &data, NULL) !=
+            OES_STATUS_SUCCESS) {
+            fprintf(stderr, "route %u add failed\n", i);
+            return -1;
+        }
+    }
+
+    if (bench_pic_neigh(vrid, rif, OES_ACCESS_CMD_DELETE, 0, &down) != 0) {
+        return -1;
+    }
+    wrong = bench_pic_check(vrid, prefix_list_p, addr_list_p, cnt, OES_ROUTER_ACTION_TRAP);
+    if (bench_pic_neigh(vrid, rif, OES_ACCESS_CMD_ADD, 0, &up) != 0) {
+        return -1;
+    }
+    wrong += bench_pic_check(vrid, prefix_list_p, addr_list_p, cnt, OES_ROUTER_ACTION_FORWARD);
+
+    /* the group of the first next hop alone moves to the third */
+    oes_api_router_uc_route_lookup(vrid, &addr_list_p[0], &lookup, NULL);
+    bench_next_hop(&next_hops[0], OES_IPV4, 2);
+    t0 = bench_now();
+    if (oes_api_router_next_hop_group_set(OES_ACCESS_CMD_EDIT, vrid, lookup.next_hop_group, next_hops, 1, NULL) !=
+        OES_STATUS_SUCCESS) {
+        fprintf(stderr, "next-hop group set failed\n");
+        return -1;
+    }
+    group = bench_now() - t0;
+
+    /* the same move, route by route */
+    bench_next_hop(&next_hops[0], OES_IPV4, 0);
+    data.next_hop_cnt = 1;
+    t0 = bench_now();
+    for (i = 0; i < cnt; i += 2) {
+        if (oes_api_router_uc_route_set(OES_ACCESS_CMD_EDIT, vrid, &prefix_list_p[i], &data, NULL) !=
+            OES_STATUS_SUCCESS) {
+            fprintf(stderr, "route %u edit failed\n", i);
+            return -1;
+        }
+    }
+    routes = bench_now() - t0;
+
+    printf("%8u routes: neighbor down %7.1f us, up %7.1f us, group moved %7.1f us, "
+           "routes set again %9.1f us\n", cnt, down * 1e6, up * 1e6, group * 1e6, routes * 1e6);
+
+    oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE_ALL, vrid, NULL, NULL, NULL);
+    oes_api_router_neigh_set(OES_ACCESS_CMD_DELETE_ALL, vrid, NULL, NULL, NULL);
+    bench_router_delete(vrid);
+    if (wrong) {
+        fprintf(stderr, "%u routes with a wrong action\n", wrong);
+        return -1;
+    }
+    return 0;
+}
+
+static int
+bench_pic(const struct bench_params *params_p)
+{
+    struct oes_ip_prefix *prefix_list_p;
+    struct oes_ip_addr *addr_list_p;
+    unsigned int cnt, routes;
+
+    /* prefixes, and an address under each of them */
+    prefix_list_p = malloc(params_p->routes * sizeof(*prefix_list_p));
+    addr_list_p = malloc(params_p->routes * sizeof(*addr_list_p));
+    if ((prefix_list_p == NULL) || (addr_list_p == NULL)) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    bench_seed(params_p->seed);
+    cnt = bench_table(OES_IPV4, prefix_list_p, params_p->routes);
+    for (routes = 0; routes < cnt; routes++) {
+        bench_addrs(&prefix_list_p[routes], 1, &addr_list_p[routes], 1);
+    }
+    for (routes = BENCH_PIC_ROUTES_MIN; routes < cnt; routes *= 10) {
+        if (bench_pic_run(prefix_list_p, addr_list_p, routes) != 0) {
+            return -1;
+        }
+    }
+    if (bench_pic_run(prefix_list_p, addr_list_p, cnt) != 0) {
+        return -1;
+    }
+    free(prefix_list_p);
+    free(addr_list_p);
+    return 0;
+}
+
+/* the L2 interface of a SVI and the MAC of a frame on it, by kind */
+static void
+bench_rif_frame(const unsigned int svi,
+                const unsigned int kind,
+                struct oes_l3_interface *ifc_p,
+                struct ether_addr *mac_p)
+{
+    static const unsigned char system_mac[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+    static const unsigned char vrrp_mac[ETH_ALEN] = { 0x00, 0x00, 0x5e, 0x00, 0x01, 0x00 };
+
+    memset(ifc_p, 0, sizeof(*ifc_p));
+    ifc_p->type = OES_INTERFACE_TYPE_VLAN;
+    ifc_p->ifc.vlan.br_id = svi / BENCH_RIF_VLANS;
+    ifc_p->ifc.vlan.vlan = 1 + svi % BENCH_RIF_VLANS;
+    switch (kind) {
+    case 0:
+        memcpy(mac_p->ether_addr_octet, system_mac, ETH_ALEN);
+        break;
+
+    case 1:
+        memcpy(mac_p->ether_addr_octet, vrrp_mac, ETH_ALEN);
+        mac_p->ether_addr_octet[5] = svi & 0xff;
+        break;
+
+    default:
+        /* a host on the VLAN, bridged */
+        mac_p->ether_addr_octet[0] = 0x02;
+        mac_p->ether_addr_octet[1] = 0x10;
+        mac_p->ether_addr_octet[2] = kind;
+        mac_p->ether_addr_octet[3] = svi >> 16;
+        mac_p->ether_addr_octet[4] = svi >> 8;
+        mac_p->ether_addr_octet[5] = svi;
+        break;
+    }
+}
+
+static int
+bench_rif_run(const struct bench_params *params_p,
+              const unsigned int cnt,
+              struct oes_l3_interface *ifc_list_p,
+              struct ether_addr *mac_list_p,
+              unsigned int *svi_list_p,
+              unsigned int *rif_list_p)
+{
+    struct oes_l3_interface_attributes attr;
+    struct oes_l3_interface_lookup lookup;
+    struct oes_l3_interface ifc;
+    struct ether_addr vrrp_mac;
+    unsigned int vrid, i, svi, hits = 0, wrong = 0, rif_max = 0, readds = 0;
+    double t0, t1, t2, t3, t4, t5, t6;
+
+    if (bench_router_add(&vrid) != 0) {
+        return -1;
+    }
+    memset(&attr, 0, sizeof(attr));
+    attr.mtu = 1500;
+
+    /* all the SVIs route the system MAC, each its VRRP MAC too */
+    t0 = bench_now();
+    for (i = 0; i < cnt; i++) {
+        bench_rif_frame(i, 0, &ifc, &attr.mac_addr);
+        if (oes_api_router_interface_set(OES_ACCESS_CMD_ADD, vrid, &rif_list_p[i], &ifc, &attr, NULL) !=
+            OES_STATUS_SUCCESS) {
+            fprintf(stderr, "interface %u add failed\n", i);
+            return -1;
+        }
+    }
+    t1 = bench_now();
+    for (i = 0; i < cnt; i++) {
+        bench_rif_frame(i, 1, &ifc, &vrrp_mac);
+        if (oes_api_router_interface_mac_set(OES_ACCESS_CMD_ADD, vrid, rif_list_p[i], &vrrp_mac, 1, NULL) !=
+            OES_STATUS_SUCCESS) {
+            fprintf(stderr, "interface %u MAC add failed\n", i);
+            return -1;
+        }
+    }
+    t2 = bench_now();
+
+    /* frames to the system MAC, a VRRP MAC and two hosts, in turn */
+    bench_seed(params_p->seed);
+    for (i = 0; i < BENCH_RIF_FRAMES; i++) {
+        svi_list_p[i] = bench_rand() % cnt;
+        bench_rif_frame(svi_list_p[i], i % 4, &ifc_list_p[i], &mac_list_p[i]);
+    }
+    t3 = bench_now();
+    for (i = 0; i < params_p->lookups; i++) {
+        unsigned int frame = i % BENCH_RIF_FRAMES;
+
+        if (oes_api_router_interface_mac_lookup(&ifc_list_p[frame], &mac_list_p[frame], &lookup, NULL) ==
+            OES_STATUS_SUCCESS) {
+            hits++;
+            wrong += (frame % 4 > 1) || (lookup.rif != rif_list_p[svi_list_p[frame]]) || (lookup.vrid != vrid);
+        } else {
+            wrong += (frame % 4 < 2);
+        }
+    }
+    t4 = bench_now();
+
+    /* half the SVIs go and come back, their rifs are reused */
+    for (i = 0; i < cnt; i += 2) {
+        if (oes_api_router_interface_set(OES_ACCESS_CMD_DELETE, vrid, &rif_list_p[i], NULL, NULL, NULL) !=
+            OES_STATUS_SUCCESS) {
+            return -1;
+        }
+    }
+    for (i = 0; i < cnt; i += 2, readds++) {
+        bench_rif_frame(i, 0, &ifc, &attr.mac_addr);
+        if (oes_api_router_interface_set(OES_ACCESS_CMD_ADD, vrid, &rif_list_p[i], &ifc, &attr, NULL) !=
+            OES_STATUS_SUCCESS) {
+            return -1;
+        }
+    }
+    for (svi = 0; svi < cnt; svi++) {
+        rif_max = (rif_list_p[svi] > rif_max) ? rif_list_p[svi] : rif_max;
+    }
+
+    t5 = bench_now();
+    oes_api_router_interface_set(OES_ACCESS_CMD_DELETE_ALL, vrid, NULL, NULL, NULL, NULL);
+    t6 = bench_now();
+    printf("%6u SVIs: add %.0f ns, MAC add %.0f ns, lookup %.1f ns, %u routed of %u, "
+           "%u readded up to rif %u, delete all %.3f ms\n", cnt, (t1 - t0) * 1e9 / cnt, (t2 - t1) * 1e9 / cnt,
+           (t4 - t3) * 1e9 / params_p->lookups, hits, params_p->lookups, readds, rif_max, (t6 - t5) * 1e3);
+    bench_router_delete(vrid);
+    if (wrong || (rif_max >= cnt)) {
+        fprintf(stderr, "%u frames with a wrong interface, rifs up to %u\n", wrong, rif_max);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Router interfaces resolved from the ingress VLAN and the
+ * destination MAC of frames, 1K SVIs and up by 10 to 50K by
+ * default.
+ */
+static int
+bench_rif(const struct bench_params *params_p)
+{
+    struct oes_l3_interface *ifc_list_p;
+    struct ether_addr *mac_list_p;
+    unsigned int *svi_list_p, *rif_list_p, cnt;
+
+    if ((params_p->routes == 0) || (params_p->routes > BENCH_RIF_MAX)) {
+        fprintf(stderr, "SVIs must be 1 to %u\n", BENCH_RIF_MAX);
+        return -1;
+    }
+    ifc_list_p = malloc(BENCH_RIF_FRAMES * sizeof(*ifc_list_p));
+    mac_list_p = malloc(BENCH_RIF_FRAMES * sizeof(*mac_list_p));
+    svi_list_p = malloc(BENCH_RIF_FRAMES * sizeof(*svi_list_p));
+    rif_list_p = malloc(params_p->routes * sizeof(*rif_list_p));
+    if ((ifc_list_p == NULL) || (mac_list_p == NULL) || (svi_list_p == NULL) || (rif_list_p == NULL)) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    for (cnt = BENCH_RIF_MIN; cnt < params_p->routes; cnt *= 10) {
+        if (bench_rif_run(params_p, cnt, ifc_list_p, mac_list_p, svi_list_p, rif_list_p) != 0) {
+            return -1;
+        }
+    }
+    if (bench_rif_run(params_p, params_p->routes, ifc_list_p, mac_list_p, svi_list_p, rif_list_p) != 0) {
+        return -1;
+    }
+    free(ifc_list_p);
+    free(mac_list_p);
+    free(svi_list_p);
+    free(rif_list_p);
+    return 0;
+}
+
+struct bench_compact_reader {
+    unsigned int                        vrid;
+    const struct oes_ip_addr          * addr_list_p;
+    const struct oes_uc_route_lookup  * expected_list_p;
+    unsigned int                        addr_cnt;
+    const int                         * done_p;
+    pthread_t                           thread;
+    unsigned long long                  lookups;
+    unsigned long long                  wrong;
+};
+
+static int
+bench_compact_differ(const struct oes_uc_route_lookup *a_p, const struct oes_uc_route_lookup *b_p)
+{
+    return (a_p->valid != b_p->valid) ||
+           (a_p->valid && ((a_p->prefix_len != b_p->prefix_len) || (a_p->next_hop_group != b_p->next_hop_group)));
+}
+
+/* checks the lookups against the results before the compaction */
+static void *
+bench_compact_reader(void *arg_p)
+{
+    struct bench_compact_reader *reader_p = arg_p;
+    struct oes_uc_route_lookup lookups[BENCH_RCU_BATCH];
+    unsigned int i = 0, j, cnt;
+
+    while (!__atomic_load_n(reader_p->done_p, __ATOMIC_RELAXED)) {
+        cnt = (reader_p->addr_cnt - i < BENCH_RCU_BATCH) ? reader_p->addr_cnt - i : BENCH_RCU_BATCH;
+        oes_api_router_uc_route_lookup_batch(reader_p->vrid, &reader_p->addr_list_p[i], lookups, cnt, NULL);
+        for (j = 0; j < cnt; j++) {
+            reader_p->wrong += bench_compact_differ(&lookups[j], &reader_p->expected_list_p[i + j]);
+        }
+        reader_p->lookups += cnt;
+        i = (i + cnt == reader_p->addr_cnt) ? 0 : i + cnt;
+    }
+    return NULL;
+}
+
+static void
+bench_compact_print(const char *name_p, const struct oes_router_memory_stats *stats_p)
+{
+    const struct {
+        const char                          * name_p;
+        const struct oes_router_table_usage * usage_p;
+    } tables[] = {
+        { "routes", &stats_p->routes },
+        { "lpm4", &stats_p->lpm4 },
+        { "lpm6", &stats_p->lpm6 },
+        { "nhgs", &stats_p->nhgs },
+        { "neighs", &stats_p->neighs },
+    };
+    unsigned int i;
+
+    printf("%s: %u IPv4 and %u IPv6 routes\n", name_p, stats_p->ipv4_route_cnt, stats_p->ipv6_route_cnt);
+    for (i = 0; i < sizeof(tables) / sizeof(tables[0]); i++) {
+        printf("  %-6s %9.2f MB, %8u of %8u entries, fill %5.1f%%, fragmentation %5.1f%% (%.2f MB)\n",
+               tables[i].name_p, tables[i].usage_p->bytes / 1048576.0, tables[i].usage_p->entry_cnt,
+               tables[i].usage_p->entry_max, tables[i].usage_p->fill / 100.0,
+               tables[i].usage_p->fragmentation / 100.0, tables[i].usage_p->free_bytes / 1048576.0);
+    }
+}
+
+/*
+ * LPM compaction. Loads a full table of both IP versions, then
+ * withdraws all but one route in BENCH_COMPACT_KEEP_SHARE and
+ * compacts the LPM tables while a lookup thread checks that the
+ * results do not change.
+ */
+static int
+bench_compact(const struct bench_params *params_p)
+{
+    struct oes_ip_prefix *prefix4_list_p, *prefix6_list_p;
+    struct oes_ip_addr *addr4_list_p, *addr6_list_p, *addr_list_p;
+    struct oes_uc_route_lookup *expected_list_p, lookup;
+    struct oes_router_memory_stats stats;
+    struct bench_compact_reader reader;
+    unsigned long long reclaimed;
+    unsigned int vrid, cnt4, cnt6, addr_cnt, i, wrong = 0;
+    int done = 0;
+    double t0, t1, rss0, rss1;
+
+    cnt6 = bench_prepare(params_p, OES_IPV6, params_p->routes / 5, &prefix6_list_p, &addr6_list_p);
+    cnt4 = bench_prepare(params_p, OES_IPV4, params_p->routes, &prefix4_list_p, &addr4_list_p);
+    addr_cnt = 2 * params_p->lookups;
+    addr_list_p = malloc(addr_cnt * sizeof(*addr_list_p));
+    expected_list_p = malloc(addr_cnt * sizeof(*expected_list_p));
+    if ((addr_list_p == NULL) || (expected_list_p == NULL)) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    memcpy(addr_list_p, addr4_list_p, params_p->lookups * sizeof(*addr_list_p));
+    memcpy(&addr_list_p[params_p->lookups], addr6_list_p, params_p->lookups * sizeof(*addr_list_p));
+    if ((bench_router_add(&vrid) != 0) || (bench_load(vrid, prefix4_list_p, cnt4) != 0) ||
+        (bench_load(vrid, prefix6_list_p, cnt6) != 0)) {
+        return -1;
+    }
+    oes_api_router_memory_stats_get(vrid, &stats, NULL);
+    bench_compact_print("loaded", &stats);
+
+    /* the prefixes are shuffled, the ones kept are spread over the table */
+    for (i = cnt4 / BENCH_COMPACT_KEEP_SHARE; i < cnt4; i++) {
+        oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE, vrid, &prefix4_list_p[i], NULL, NULL);
+    }
+    for (i = cnt6 / BENCH_COMPACT_KEEP_SHARE; i < cnt6; i++) {
+        oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE, vrid, &prefix6_list_p[i], NULL, NULL);
+    }
+    oes_api_router_memory_stats_get(vrid, &stats, NULL);
+    bench_compact_print("withdrawn", &stats);
+
+    for (i = 0; i < addr_cnt; i++) {
+        memset(&expected_list_p[i], 0, sizeof(expected_list_p[i]));
+        oes_api_router_uc_route_lookup(vrid, &addr_list_p[i], &expected_list_p[i], NULL);
+    }
+    memset(&reader, 0, sizeof(reader));
+    reader.vrid = vrid;
+    reader.addr_list_p = addr_list_p;
+    reader.expected_list_p = expected_list_p;
+    reader.addr_cnt = addr_cnt;
+    reader.done_p = &done;
+    if (pthread_create(&reader.thread, NULL, bench_compact_reader, &reader) != 0) {
+        fprintf(stderr, "lookup thread start failed\n");
+        return -1;
+    }
+    rss0 = bench_rss_mb();
+    t0 = bench_now();
+    if (oes_api_router_memory_compact(vrid, 0, &reclaimed, NULL) != OES_STATUS_SUCCESS) {
+        return -1;
+    }
+    t1 = bench_now();
+    rss1 = bench_rss_mb();
+    __atomic_store_n(&done, 1, __ATOMIC_RELAXED);
+    pthread_join(reader.thread, NULL);
+    oes_api_router_memory_stats_get(vrid, &stats, NULL);
+    bench_compact_print("compacted", &stats);
+    for (i = 0; i < addr_cnt; i++) {
+        memset(&lookup, 0, sizeof(lookup));
+        oes_api_router_uc_route_lookup(vrid, &addr_list_p[i], &lookup, NULL);
+        wrong += bench_compact_differ(&lookup, &expected_list_p[i]);
+    }
+    printf("compact: %.2f MB given back in %.1f ms, RSS %.1f MB less, %llu lookups meanwhile, "
+           "%llu wrong, %u wrong after\n", reclaimed / 1048576.0, (t1 - t0) * 1e3, rss0 - rss1,
+           reader.lookups, reader.wrong, wrong);
+
+    oes_api_router_uc_route_set(OES_ACCESS_CMD_DELETE_ALL, vrid, NULL, NULL, NULL);
+    bench_router_delete(vrid);
+    free(prefix4_list_p);
+    free(prefix6_list_p);
+    free(addr4_list_p);
+    free(addr6_list_p);
+    free(addr_list_p);
+    free(expected_list_p);
+    return (reader.wrong || wrong) ? -1 : 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct bench_params params = {
+        .mode = "lpm4",
+        .lookups = 10000000,
+        .seed = 1,
+    };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "m:n:l:s:")) != -1) {
+        switch (opt) {
+        case 'm':
+            params.mode = optarg;
+            break;
+
+        case 'n':
+            params.routes = strtoul(optarg, NULL, 0);
+            break;
+
+        case 'l':
+            params.lookups = strtoul(optarg, NULL, 0);
+            break;
+
+        case 's':
+            params.seed = strtoull(optarg, NULL, 0);
+            break;
+
+        default:
+            fprintf(stderr, "usage: %s [-m lpm4|lpm6|batch|bulk|rcu|ecmp|vrf|neigh|mc|cntr|page|churn|pic|rif|compact] [-n routes] [-l lookups] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (params.lookups == 0) {
+        fprintf(stderr, "lookups must be positive\n");
+        return 1;
+    }
+
+    if (strcmp(params.mode, "lpm4") == 0) {
+        params.routes = params.routes ? params.routes : 1000000;
+        return (bench_lpm(&params, OES_IPV4) == 0) ? 0 : 1;
+    }
+    if (strcmp(params.mode, "lpm6") == 0) {
+        params.routes = params.routes ? params.routes : 200000;
+        return (bench_lpm(&params, OES_IPV6) == 0) ? 0 : 1;
+    }
+    if (strcmp(params.mode, "batch") == 0) {
+        params.routes = params.routes ? params.routes : 1000000;
+        return (bench_batch(&params) == 0) ? 0 : 1;
+    }
+    if (strcmp(params.mode, "bulk") == 0) {
+        params.routes = params.routes ? params.routes : 1000000;
+        return (bench_bulk(&params) == 0) ? 0 : 1;
+    }
+    if (strcmp(params.mode, "rcu") == 0) {
+        params.routes = params.routes ? params.routes : 1000000;
+        return (bench_rcu(&params) == 0) ? 0 : 1;
+    }
+    if (strcmp(params.mode, "ecmp") == 0) {
+        return (bench_ecmp(&params) == 0) ? 0 : 1;
+    }
+    if (strcmp(params.mode, "vrf") == 0) {
+        params.routes = params.routes ? params.routes : 200;
+        if (params.routes > BENCH_VRF_ROUTE_MAX) {
+            fprintf(stderr, "at most %u routes per VRF\n", BENCH_VRF_ROUTE_MAX);
+            return 1;
+        }
+        return (bench_vrf(&params) == 0) ? 0 : 1;
+    }
+    if (strcmp(params.mode, "neigh") == 0) {
+        params.routes = params.routes ? params.routes : 100000;
+        return (bench_neigh(&params) == 0) ? 0 : 1;
+    }
+    if (strcmp(params.mode, "mc") == 0) {
+        params.routes = params.routes ? params.routes : 50000;
+        return (bench_mc(&params) == 0) ? 0 : 1;
+    }
+    if (strcmp(params.mode, "cntr") == 0) {
+        params.routes = params.routes ? params.routes : 4096;
+        if (params.routes > BENCH_RIF_MAX) {
+            fprintf(stderr, "at most %u rifs\n", BENCH_RIF_MAX);
+            return 1;
+        }
+        return (bench_cntr(&params) == 0) ? 0 : 1;
+    }
+    if (strcmp(params.mode, "page") == 0) {
+        params.routes = params.routes ? params.routes : 1000000;
+        return (bench_page(&params) == 0) ? 0 : 1;
+    }
+    if (strcmp(params.mode, "churn") == 0) {
+        params.routes = params.routes ? params.routes : 1000000;
+        return (bench_churn(&params) == 0) ? 0 : 1;
+    }
+    if (strcmp(params.mode, "pic") == 0) {
+        params.routes = params.routes ? params.routes : 1000000;
+        return (bench_pic(&params) == 0) ? 0 : 1;
+    }
+    if (strcmp(params.mode, "rif") == 0) {
+        params.routes = params.routes ? params.routes : 50000;
+        return (bench_rif(&params) == 0) ? 0 : 1;
+    }
+    if (strcmp(params.mode, "compact") == 0) {
+        params.routes = params.routes ? params.routes : 1000000;
+        return (bench_compact(&params) == 0) ? 0 : 1;
+    }
+    fprintf(stderr, "unknown mode %s\n", params.mode);
+    return 1;
+}
@@ -0,0 +1,110 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_router.h"
+
+struct oes_router_bulk_ctx {
+    unsigned int    part_cnt;
+    unsigned int    next;           /**< next partition to hand out */
+    void         (* work_fn)(void *ctx_p, const unsigned int part);
+    void          * ctx_p;
+};
+
+static void *
+oes_router_bulk_worker(void *arg_p)
+{
+    struct oes_router_bulk_ctx *ctx_p = arg_p;
+    unsigned int part;
+
+    while ((part = __atomic_fetch_add(&ctx_p->next, 1, __ATOMIC_RELAXED)) < ctx_p->part_cnt) {
+        ctx_p->work_fn(ctx_p->ctx_p, part);
+    }
+    return NULL;
+}
+
+/**
+ * This function returns the number of threads bulk builds use,
+ * one per online CPU up to OES_ROUTER_BULK_THREAD_MAX.
+ *
+ * @return thread count
+ */
+unsigned int
+oes_router_bulk_thread_cnt(void)
+{
+    long cpu_cnt = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (cpu_cnt < 1) {
+        return 1;
+    }
+    return (cpu_cnt < OES_ROUTER_BULK_THREAD_MAX) ? cpu_cnt : OES_ROUTER_BULK_THREAD_MAX;
+}
+
+/**
+ * This function runs work_fn on each partition, on up to
+ * thread_cnt threads, the calling one included. It returns once
+ * all partitions are done.
+ *
+ * @param[in] thread_cnt - thread count
+ * @param[in] part_cnt - number of partitions
+ * @param[in] work_fn - partition worker
+ * @param[in] ctx_p - worker context
+ */
+void
+oes_router_bulk_run(const unsigned int thread_cnt,
+                    const unsigned int part_cnt,
+                    void (*work_fn)(void *ctx_p, const unsigned int part),
+                    void *ctx_p)
+{
+    pthread_t threads[OES_ROUTER_BULK_THREAD_MAX];
+    struct oes_router_bulk_ctx ctx = {
+        .part_cnt = part_cnt,
+        .work_fn = work_fn,
+        .ctx_p = ctx_p,
+    };
+    unsigned int i, started = 0;
+
+    /* a thread that cannot be started leaves its share to the others */
+    for (i = 1; (i < thread_cnt) && (i < OES_ROUTER_BULK_THREAD_MAX); i++) {
+        if (pthread_create(&threads[started], NULL, oes_router_bulk_worker, &ctx) == 0) {
+            started++;
+        }
+    }
+    oes_router_bulk_worker(&ctx);
+    for (i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
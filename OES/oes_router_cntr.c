@@ -0,0 +1,294 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _GNU_SOURCE     /* sched_getcpu() */
+#include <sys/types.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_router.h"
+
+#define OES_ROUTER_CNTR_WORDS (sizeof(struct oes_router_cntr) / sizeof(unsigned long long))
+
+_Static_assert(sizeof(struct oes_router_cntr) == OES_ROUTER_CNTR_LINE, "the counters of a CPU are one line");
+
+/* slot of an interface in the table, NULL if its chunk is not there */
+static struct oes_router_rif_cntr **
+oes_router_cntr_slot(const struct oes_router_cntr_table *table_p, const unsigned int rif)
+{
+    struct oes_router_rif_cntr **chunk_p;
+
+    if (rif >= OES_ROUTER_RIF_MAX) {
+        return NULL;
+    }
+    chunk_p = __atomic_load_n(&table_p->chunks[rif >> OES_ROUTER_CNTR_CHUNK_BITS], __ATOMIC_ACQUIRE);
+    return (chunk_p != NULL) ? &chunk_p[rif & (OES_ROUTER_CNTR_CHUNK_SIZE - 1)] : NULL;
+}
+
+static void
+oes_router_cntr_free(struct oes_router_cntr_table *table_p, struct oes_router_rif_cntr *cntr_p)
+{
+    oes_router_pool_free(table_p->pool, cntr_p->cpu_cntrs, table_p->cpu_cnt * sizeof(struct oes_router_cntr));
+    oes_router_pool_free(table_p->pool, cntr_p, sizeof(*cntr_p));
+}
+
+/**
+ * This function sets up a table without counters.
+ *
+ * @param[out] table_p - counter table
+ * @param[in] pool_p - pool the counters are allocated from
+ */
+void
+oes_router_cntr_table_init(struct oes_router_cntr_table *table_p, struct oes_router_pool *pool_p)
+{
+    long cpu_cnt = sysconf(_SC_NPROCESSORS_CONF);
+
+    memset(table_p, 0, sizeof(*table_p));
+    table_p->pool = pool_p;
+    table_p->cpu_cnt = (cpu_cnt > 0) ? cpu_cnt : 1;
+}
+
+/**
+ * This function frees all the counters of a table at once, with
+ * no reader left.
+ *
+ * @param[in] table_p - counter table
+ */
+void
+oes_router_cntr_table_deinit(struct oes_router_cntr_table *table_p)
+{
+    unsigned int chunk, i;
+
+    for (chunk = 0; chunk < OES_ROUTER_CNTR_CHUNK_CNT; chunk++) {
+        if (table_p->chunks[chunk] == NULL) {
+            continue;
+        }
+        for (i = 0; i < OES_ROUTER_CNTR_CHUNK_SIZE; i++) {
+            if (table_p->chunks[chunk][i] != NULL) {
+                oes_router_cntr_free(table_p, table_p->chunks[chunk][i]);
+            }
+        }
+        oes_router_pool_free(table_p->pool, table_p->chunks[chunk],
+                             OES_ROUTER_CNTR_CHUNK_SIZE * sizeof(*table_p->chunks[chunk]));
+    }
+    oes_router_cntr_table_init(table_p, table_p->pool);
+}
+
+/**
+ * This function returns the counters of an interface, NULL if
+ * they are not enabled. Without the router lock, the caller must
+ * be in a read section.
+ *
+ * @param[in] table_p - counter table
+ * @param[in] rif - router interface
+ *
+ * @return the counters
+ */
+struct oes_router_rif_cntr *
+oes_router_cntr_find(const struct oes_router_cntr_table *table_p, const unsigned int rif)
+{
+    struct oes_router_rif_cntr **slot_p = oes_router_cntr_slot(table_p, rif);
+
+    return (slot_p != NULL) ? __atomic_load_n(slot_p, __ATOMIC_ACQUIRE) : NULL;
+}
+
+/**
+ * This function returns the counters of the first interface
+ * from a rif on which has them enabled, NULL if there is none.
+ * The caller holds the router lock.
+ *
+ * @param[in] table_p - counter table
+ * @param[in] rif - router interface
+ *
+ * @return the counters
+ */
+struct oes_router_rif_cntr *
+oes_router_cntr_next(const struct oes_router_cntr_table *table_p, const unsigned int rif)
+{
+    unsigned int chunk = rif >> OES_ROUTER_CNTR_CHUNK_BITS, i = rif & (OES_ROUTER_CNTR_CHUNK_SIZE - 1);
+
+    for (; chunk < OES_ROUTER_CNTR_CHUNK_CNT; chunk++, i = 0) {
+        if (table_p->chunks[chunk] == NULL) {
+            continue;
+        }
+        for (; i < OES_ROUTER_CNTR_CHUNK_SIZE; i++) {
+            if (table_p->chunks[chunk][i] != NULL) {
+                return table_p->chunks[chunk][i];
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * This function enables the counters of an interface, from zero.
+ *
+ * @param[in] table_p - counter table
+ * @param[in] rif - router interface
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_ERROR if rif is out of range
+ * @return OES_STATUS_ENTRY_ALREADY_EXISTS if they are enabled
+ * @return OES_STATUS_NO_MEMORY if they cannot be allocated
+ */
+oes_status_e
+oes_router_cntr_enable(struct oes_router_cntr_table *table_p, const unsigned int rif)
+{
+    size_t cpu_size = table_p->cpu_cnt * sizeof(struct oes_router_cntr);
+    struct oes_router_rif_cntr **chunk_p, *cntr_p;
+    unsigned int chunk = rif >> OES_ROUTER_CNTR_CHUNK_BITS;
+
+    if (rif >= OES_ROUTER_RIF_MAX) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    if (oes_router_cntr_find(table_p, rif) != NULL) {
+        return OES_STATUS_ENTRY_ALREADY_EXISTS;
+    }
+    /* chunks stay until the table goes, the data path never sees one go */
+    chunk_p = table_p->chunks[chunk];
+    if (chunk_p == NULL) {
+        chunk_p = oes_router_pool_calloc(table_p->pool, OES_ROUTER_CNTR_CHUNK_SIZE, sizeof(*chunk_p));
+        if (chunk_p == NULL) {
+            return OES_STATUS_NO_MEMORY;
+        }
+        __atomic_store_n(&table_p->chunks[chunk], chunk_p, __ATOMIC_RELEASE);
+    }
+    cntr_p = oes_router_pool_calloc(table_p->pool, 1, sizeof(*cntr_p));
+    if (cntr_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    cntr_p->cpu_cntrs = oes_router_pool_alloc_aligned(table_p->pool, OES_ROUTER_CNTR_LINE, cpu_size);
+    if (cntr_p->cpu_cntrs == NULL) {
+        oes_router_pool_free(table_p->pool, cntr_p, sizeof(*cntr_p));
+        return OES_STATUS_NO_MEMORY;
+    }
+    memset(cntr_p->cpu_cntrs, 0, cpu_size);
+    cntr_p->rif = rif;
+    __atomic_store_n(&chunk_p[rif & (OES_ROUTER_CNTR_CHUNK_SIZE - 1)], cntr_p, __ATOMIC_RELEASE);
+    table_p->cnt++;
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function disables the counters of an interface. They are
+ * freed once the data path is done with them.
+ *
+ * @param[in] table_p - counter table
+ * @param[in] rif - router interface
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_ENTRY_NOT_FOUND if they are not enabled
+ */
+oes_status_e
+oes_router_cntr_disable(struct oes_router_cntr_table *table_p, const unsigned int rif)
+{
+    struct oes_router_rif_cntr **slot_p = oes_router_cntr_slot(table_p, rif), *cntr_p;
+
+    if ((slot_p == NULL) || (*slot_p == NULL)) {
+        return OES_STATUS_ENTRY_NOT_FOUND;
+    }
+    cntr_p = *slot_p;
+    __atomic_store_n(slot_p, NULL, __ATOMIC_RELEASE);
+    table_p->cnt--;
+    oes_router_pool_retire(table_p->pool, cntr_p->cpu_cntrs, table_p->cpu_cnt * sizeof(struct oes_router_cntr));
+    oes_router_pool_retire(table_p->pool, cntr_p, sizeof(*cntr_p));
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function adds to the counters of an interface on the line
+ * of the calling CPU.
+ *
+ * @param[in] table_p - counter table
+ * @param[in] cntr_p - counters of the interface
+ * @param[in] delta_p - packets and bytes to add
+ */
+void
+oes_router_cntr_add(const struct oes_router_cntr_table *table_p,
+                    struct oes_router_rif_cntr *cntr_p,
+                    const struct oes_router_cntr *delta_p)
+{
+    const unsigned long long *delta_words_p = (const unsigned long long *)delta_p;
+    unsigned long long *words_p;
+    int cpu = sched_getcpu();
+    unsigned int i;
+
+    /*
+     * Still an atomic add: a thread preempted on the line of its
+     * CPU may race the one the CPU runs next. Nothing else writes
+     * the line, it stays in the cache of its core.
+     */
+    words_p = (unsigned long long *)&cntr_p->cpu_cntrs[(cpu > 0) ? (unsigned int)cpu % table_p->cpu_cnt : 0];
+    for (i = 0; i < OES_ROUTER_CNTR_WORDS; i++) {
+        if (delta_words_p[i]) {
+            __atomic_fetch_add(&words_p[i], delta_words_p[i], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * This function reads the counters of an interface since the
+ * last clear, and clears them if asked to. Clears are
+ * serialized by the router lock.
+ *
+ * @param[in] table_p - counter table
+ * @param[in] cntr_p - counters of the interface
+ * @param[in] clear - 1 to clear them
+ * @param[out] sum_p - counters
+ */
+void
+oes_router_cntr_read(const struct oes_router_cntr_table *table_p,
+                     struct oes_router_rif_cntr *cntr_p,
+                     const int clear,
+                     struct oes_router_cntr *sum_p)
+{
+    unsigned long long sums[OES_ROUTER_CNTR_WORDS], *words_p, *base_p = (unsigned long long *)&cntr_p->baseline;
+    unsigned int cpu, i;
+
+    memset(sums, 0, sizeof(sums));
+    for (cpu = 0; cpu < table_p->cpu_cnt; cpu++) {
+        words_p = (unsigned long long *)&cntr_p->cpu_cntrs[cpu];
+        for (i = 0; i < OES_ROUTER_CNTR_WORDS; i++) {
+            sums[i] += __atomic_load_n(&words_p[i], __ATOMIC_RELAXED);
+        }
+    }
+    words_p = (unsigned long long *)sum_p;
+    for (i = 0; i < OES_ROUTER_CNTR_WORDS; i++) {
+        words_p[i] = sums[i] - base_p[i];
+        if (clear) {
+            base_p[i] = sums[i];
+        }
+    }
+}
@@ -0,0 +1,241 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <pthread.h>
+#include <immintrin.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_router.h"
+
+#define OES_ROUTER_ECMP_CRC32C_POLY 0x82f63b78   /* reflected */
+#define OES_ROUTER_ECMP_LANES       4
+
+static unsigned int oes_router_ecmp_crc_table[256];
+static pthread_once_t oes_router_ecmp_crc_once = PTHREAD_ONCE_INIT;
+static int oes_router_ecmp_sse42 = -1;
+
+static void
+oes_router_ecmp_crc_table_init(void)
+{
+    unsigned int i, j, crc;
+
+    for (i = 0; i < 256; i++) {
+        crc = i;
+        for (j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? OES_ROUTER_ECMP_CRC32C_POLY : 0);
+        }
+        oes_router_ecmp_crc_table[i] = crc;
+    }
+    oes_router_ecmp_sse42 = __builtin_cpu_supports("sse4.2");
+}
+
+static unsigned int
+oes_router_ecmp_crc_sw(unsigned int crc, const unsigned int word)
+{
+    unsigned int i;
+
+    crc ^= word;
+    for (i = 0; i < 4; i++) {
+        crc = oes_router_ecmp_crc_table[crc & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+__attribute__((target("sse4.2")))
+static unsigned int
+oes_router_ecmp_crc_sse42(unsigned int crc, const unsigned int *key_p, const unsigned int len)
+{
+    unsigned int i;
+
+    for (i = 0; i < len; i++) {
+        crc = _mm_crc32_u32(crc, key_p[i]);
+    }
+    return crc;
+}
+
+/*
+ * One crc32 instruction has a latency of three cycles and a
+ * throughput of one, four independent CRCs keep it busy.
+ */
+__attribute__((target("sse4.2")))
+static void
+oes_router_ecmp_crc4_sse42(unsigned int key_list[][OES_ROUTER_ECMP_KEY_WORDS],
+                           const unsigned int *len_list_p,
+                           unsigned int *crc_list_p)
+{
+    unsigned int crc0 = ~0u, crc1 = ~0u, crc2 = ~0u, crc3 = ~0u, i, len;
+
+    len = len_list_p[0];
+    for (i = 1; i < OES_ROUTER_ECMP_LANES; i++) {
+        len = (len_list_p[i] < len) ? len_list_p[i] : len;
+    }
+    for (i = 0; i < len; i++) {
+        crc0 = _mm_crc32_u32(crc0, key_list[0][i]);
+        crc1 = _mm_crc32_u32(crc1, key_list[1][i]);
+        crc2 = _mm_crc32_u32(crc2, key_list[2][i]);
+        crc3 = _mm_crc32_u32(crc3, key_list[3][i]);
+    }
+    /* mixed IPv4 and IPv6 flows finish one at a time */
+    crc_list_p[0] = oes_router_ecmp_crc_sse42(crc0, &key_list[0][len], len_list_p[0] - len);
+    crc_list_p[1] = oes_router_ecmp_crc_sse42(crc1, &key_list[1][len], len_list_p[1] - len);
+    crc_list_p[2] = oes_router_ecmp_crc_sse42(crc2, &key_list[2][len], len_list_p[2] - len);
+    crc_list_p[3] = oes_router_ecmp_crc_sse42(crc3, &key_list[3][len], len_list_p[3] - len);
+}
+
+static unsigned int
+oes_router_ecmp_crc(const unsigned int *key_p, const unsigned int len)
+{
+    unsigned int crc = ~0u, i;
+
+    if (oes_router_ecmp_sse42) {
+        return oes_router_ecmp_crc_sse42(crc, key_p, len);
+    }
+    for (i = 0; i < len; i++) {
+        crc = oes_router_ecmp_crc_sw(crc, key_p[i]);
+    }
+    return crc;
+}
+
+/*
+ * CRC is linear, close flows differ in a few bits of the CRC.
+ * Members are selected from the high bits, the finalizer spreads
+ * every input bit over them.
+ */
+static unsigned int
+oes_router_ecmp_finalize(unsigned int crc)
+{
+    crc = ~crc;
+    crc ^= crc >> 16;
+    crc *= 0x85ebca6b;
+    crc ^= crc >> 13;
+    crc *= 0xc2b2ae35;
+    crc ^= crc >> 16;
+    return crc;
+}
+
+static unsigned int
+oes_router_ecmp_addr_key(const struct oes_ip_addr *addr_p, unsigned int *key_p)
+{
+    if (addr_p->version == OES_IPV4) {
+        key_p[0] = addr_p->addr.ipv4.s_addr;
+        return 1;
+    }
+    memcpy(key_p, &addr_p->addr.ipv6, sizeof(addr_p->addr.ipv6));
+    return 4;
+}
+
+static unsigned int
+oes_router_ecmp_key(const struct oes_router_ecmp_hash_fields *fields_p,
+                    const struct oes_router_flow *flow_p,
+                    unsigned int *key_p)
+{
+    unsigned int len = 0;
+
+    if (fields_p->enable_src_ip) {
+        len += oes_router_ecmp_addr_key(&flow_p->src_ip, &key_p[len]);
+    }
+    if (fields_p->enable_dst_ip) {
+        len += oes_router_ecmp_addr_key(&flow_p->dst_ip, &key_p[len]);
+    }
+    if (fields_p->enable_tc || fields_p->enable_tcp_udp) {
+        key_p[len++] = (fields_p->enable_tc ? flow_p->tc : 0) |
+                       (fields_p->enable_tcp_udp ? flow_p->protocol << 8 : 0);
+    }
+    if (fields_p->enable_flow_label && (flow_p->dst_ip.version == OES_IPV6)) {
+        key_p[len++] = flow_p->flow_label & 0xfffff;
+    }
+    if (fields_p->enable_udp_src_port || fields_p->enable_dst_src_port) {
+        key_p[len++] = (fields_p->enable_udp_src_port ? flow_p->src_port << 16 : 0) |
+                       (fields_p->enable_dst_src_port ? flow_p->dst_port : 0);
+    }
+    return len;
+}
+
+/**
+ * This function computes the ECMP hash of a flow, a CRC32C of
+ * its key followed by a 32-bit finalizer.
+ *
+ * @param[in] fields_p - enabled hash fields
+ * @param[in] flow_p - packet header fields
+ *
+ * @return the hash
+ */
+unsigned int
+oes_router_ecmp_hash(const struct oes_router_ecmp_hash_fields *fields_p,
+                     const struct oes_router_flow *flow_p)
+{
+    unsigned int key[OES_ROUTER_ECMP_KEY_WORDS], len;
+
+    pthread_once(&oes_router_ecmp_crc_once, oes_router_ecmp_crc_table_init);
+    len = oes_router_ecmp_key(fields_p, flow_p, key);
+    return oes_router_ecmp_finalize(oes_router_ecmp_crc(key, len));
+}
+
+/**
+ * This function computes the ECMP hashes of a list of flows,
+ * interleaving the CRCs of four flows at a time. The hashes are
+ * the ones oes_router_ecmp_hash() returns.
+ *
+ * @param[in] fields_p - enabled hash fields
+ * @param[in] flow_list_p - packet header fields
+ * @param[in] cnt - number of flows
+ * @param[out] hash_list_p - hashes
+ */
+void
+oes_router_ecmp_hash_bulk(const struct oes_router_ecmp_hash_fields *fields_p,
+                          const struct oes_router_flow *flow_list_p,
+                          const unsigned int cnt,
+                          unsigned int *hash_list_p)
+{
+    unsigned int keys[OES_ROUTER_ECMP_LANES][OES_ROUTER_ECMP_KEY_WORDS];
+    unsigned int lens[OES_ROUTER_ECMP_LANES];
+    unsigned int i = 0, j;
+
+    pthread_once(&oes_router_ecmp_crc_once, oes_router_ecmp_crc_table_init);
+    if (oes_router_ecmp_sse42) {
+        for (; i + OES_ROUTER_ECMP_LANES <= cnt; i += OES_ROUTER_ECMP_LANES) {
+            for (j = 0; j < OES_ROUTER_ECMP_LANES; j++) {
+                lens[j] = oes_router_ecmp_key(fields_p, &flow_list_p[i + j], keys[j]);
+            }
+            oes_router_ecmp_crc4_sse42(keys, lens, &hash_list_p[i]);
+            for (j = 0; j < OES_ROUTER_ECMP_LANES; j++) {
+                hash_list_p[i + j] = oes_router_ecmp_finalize(hash_list_p[i + j]);
+            }
+        }
+    }
+    for (; i < cnt; i++) {
+        lens[0] = oes_router_ecmp_key(fields_p, &flow_list_p[i], keys[0]);
+        hash_list_p[i] = oes_router_ecmp_finalize(oes_router_ecmp_crc(keys[0], lens[0]));
+    }
+}
@@ -0,0 +1,679 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <immintrin.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_router.h"
+
+#define OES_ROUTER_LPM4_TBL8_ENTRIES 256
+#define OES_ROUTER_LPM4_BULK_PARTS   256     /* by first byte */
+
+struct oes_router_lpm4_bulk {
+    struct oes_router_lpm4        * lpm_p;
+    struct oes_router_lpm4_rule  ** order;  /**< /8 to /24 prefixes, grouped by partition */
+    unsigned int                    start[OES_ROUTER_LPM4_BULK_PARTS + 1];
+};
+
+struct oes_router_lpm4_compact {
+    struct oes_router_lpm4        * lpm_p;
+    unsigned int                    free;   /**< free groups below the used count, + 1 */
+    unsigned long long              dropped;
+};
+
+static unsigned int
+oes_router_lpm4_depth(const unsigned int entry)
+{
+    return (entry >> OES_ROUTER_LPM4_DEPTH_SHIFT) & 0x3f;
+}
+
+static unsigned int
+oes_router_lpm4_entry(const unsigned int depth, const unsigned int value)
+{
+    return (depth << OES_ROUTER_LPM4_DEPTH_SHIFT) | value;
+}
+
+/* entries readers may be walking are only written whole */
+static void
+oes_router_lpm4_store(unsigned int *entry_p, const unsigned int entry)
+{
+    __atomic_store_n(entry_p, entry, __ATOMIC_RELEASE);
+}
+
+/* marks the page of the entry written before the store backs it */
+static void
+oes_router_lpm4_tbl24_store(struct oes_router_lpm4 *lpm_p, const unsigned int idx24, const unsigned int entry)
+{
+    oes_router_map_written_set(lpm_p->tbl24_written, idx24 * sizeof(unsigned int));
+    oes_router_lpm4_store(&lpm_p->tbl24[idx24], entry);
+}
+
+static void *
+oes_router_lpm4_map(const size_t size)
+{
+    void *mem_p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    return (mem_p == MAP_FAILED) ? NULL : mem_p;
+}
+
+/**
+ * This function maps the tables of an IPv4 LPM. Pages are only
+ * backed once a route touches them. The LPM may be created
+ * lazily while lookups run on it: they see no tables, and miss,
+ * until tbl24 is published.
+ *
+ * @param[in,out] lpm_p - LPM, zeroed
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the tables cannot be mapped
+ */
+oes_status_e
+oes_router_lpm4_init(struct oes_router_lpm4 *lpm_p)
+{
+    unsigned int *tbl24_p;
+
+    lpm_p->tbl8 = oes_router_lpm4_map((size_t)OES_ROUTER_LPM4_TBL8_GROUP_CNT *
+                                      OES_ROUTER_LPM4_TBL8_ENTRIES * sizeof(unsigned int));
+    tbl24_p = oes_router_lpm4_map(OES_ROUTER_LPM4_TBL24_CNT * sizeof(unsigned int));
+    lpm_p->tbl24_written = calloc(OES_ROUTER_MAP_WRITTEN_WORDS(OES_ROUTER_LPM4_TBL24_CNT * sizeof(unsigned int)),
+                                  sizeof(*lpm_p->tbl24_written));
+    if ((lpm_p->tbl8 == NULL) || (tbl24_p == NULL) || (lpm_p->tbl24_written == NULL)) {
+        if (tbl24_p != NULL) {
+            munmap(tbl24_p, OES_ROUTER_LPM4_TBL24_CNT * sizeof(unsigned int));
+        }
+        oes_router_lpm4_deinit(lpm_p);
+        return OES_STATUS_NO_MEMORY;
+    }
+    __atomic_store_n(&lpm_p->tbl24, tbl24_p, __ATOMIC_RELEASE);
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function unmaps the tables of an IPv4 LPM.
+ *
+ * @param[in] lpm_p - LPM
+ */
+void
+oes_router_lpm4_deinit(struct oes_router_lpm4 *lpm_p)
+{
+    if (lpm_p->tbl24 != NULL) {
+        munmap(lpm_p->tbl24, OES_ROUTER_LPM4_TBL24_CNT * sizeof(unsigned int));
+    }
+    if (lpm_p->tbl8 != NULL) {
+        munmap(lpm_p->tbl8, (size_t)OES_ROUTER_LPM4_TBL8_GROUP_CNT *
+               OES_ROUTER_LPM4_TBL8_ENTRIES * sizeof(unsigned int));
+    }
+    free(lpm_p->tbl24_written);
+    memset(lpm_p, 0, sizeof(*lpm_p));
+}
+
+/**
+ * This function returns the bytes of the tables of an IPv4 LPM
+ * backed by memory: the tbl24 pages written and the resident
+ * tbl8 pages.
+ *
+ * @param[in] lpm_p - LPM
+ *
+ * @return resident bytes, 0 when the LPM is not mapped
+ */
+unsigned long long
+oes_router_lpm4_table_bytes(const struct oes_router_lpm4 *lpm_p)
+{
+    if (lpm_p->tbl24 == NULL) {
+        return 0;
+    }
+    return oes_router_map_written_bytes(OES_ROUTER_LPM4_TBL24_CNT * sizeof(unsigned int), lpm_p->tbl24_written) +
+           oes_router_map_resident(lpm_p->tbl8, (size_t)OES_ROUTER_LPM4_TBL8_GROUP_CNT *
+                                   OES_ROUTER_LPM4_TBL8_ENTRIES * sizeof(unsigned int));
+}
+
+/*
+ * The resident part of the tbl8 tail compaction unmaps: the
+ * groups from the used count, page aligned, to the high water
+ * mark.
+ */
+static unsigned long long
+oes_router_lpm4_tbl8_tail_bytes(const struct oes_router_lpm4 *lpm_p, const size_t page_size)
+{
+    size_t start, end;
+
+    start = ((size_t)lpm_p->tbl8_used * OES_ROUTER_LPM4_TBL8_ENTRIES * sizeof(unsigned int) + page_size - 1) &
+            ~(page_size - 1);
+    end = (size_t)lpm_p->tbl8_hwm * OES_ROUTER_LPM4_TBL8_ENTRIES * sizeof(unsigned int);
+    if (end <= start) {
+        return 0;
+    }
+    return oes_router_map_resident((char *)lpm_p->tbl8 + start, end - start);
+}
+
+static void
+oes_router_lpm4_usage_page(void *ctx_p, void *page_p, const size_t page_size)
+{
+    unsigned long long *free_bytes_p = ctx_p;
+
+    if (oes_router_map_zero(page_p, page_size)) {
+        *free_bytes_p += page_size;
+    }
+}
+
+/**
+ * This function reports the memory of an IPv4 LPM. Its entries
+ * are the tbl8 groups, its free bytes what compaction gives
+ * back: the tbl8 tail past the used count and the written tbl24
+ * pages left empty.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[out] usage_p - usage, ratios left to the caller
+ */
+void
+oes_router_lpm4_usage(const struct oes_router_lpm4 *lpm_p, struct oes_router_table_usage *usage_p)
+{
+    memset(usage_p, 0, sizeof(*usage_p));
+    usage_p->entry_max = OES_ROUTER_LPM4_TBL8_GROUP_CNT;
+    if (lpm_p->tbl24 == NULL) {
+        return;
+    }
+    usage_p->bytes = oes_router_lpm4_table_bytes(lpm_p);
+    usage_p->entry_cnt = lpm_p->tbl8_used;
+    usage_p->free_bytes = oes_router_lpm4_tbl8_tail_bytes(lpm_p, sysconf(_SC_PAGESIZE));
+    oes_router_map_walk(lpm_p->tbl24, OES_ROUTER_LPM4_TBL24_CNT * sizeof(unsigned int), lpm_p->tbl24_written,
+                        oes_router_lpm4_usage_page, &usage_p->free_bytes);
+}
+
+/*
+ * Moves the groups the entries of a tbl24 page point to past the
+ * used count into free ones below it, then drops the page if it
+ * is empty. A moved group is filled before the entry is pointed
+ * at it, lookups see either copy.
+ */
+static void
+oes_router_lpm4_compact_page(void *ctx_p, void *page_p, const size_t page_size)
+{
+    struct oes_router_lpm4_compact *compact_p = ctx_p;
+    struct oes_router_lpm4 *lpm_p = compact_p->lpm_p;
+    unsigned int *entry_p = page_p, group, i;
+
+    for (i = 0; i < page_size / sizeof(*entry_p); i++) {
+        if (!(entry_p[i] & OES_ROUTER_LPM4_EXT) ||
+            ((entry_p[i] & OES_ROUTER_LPM4_VALUE_MASK) < lpm_p->tbl8_used) || !compact_p->free) {
+            continue;
+        }
+        group = compact_p->free - 1;
+        compact_p->free = lpm_p->tbl8[group * OES_ROUTER_LPM4_TBL8_ENTRIES];
+        memcpy(&lpm_p->tbl8[group * OES_ROUTER_LPM4_TBL8_ENTRIES],
+               &lpm_p->tbl8[(entry_p[i] & OES_ROUTER_LPM4_VALUE_MASK) * OES_ROUTER_LPM4_TBL8_ENTRIES],
+               OES_ROUTER_LPM4_TBL8_ENTRIES * sizeof(unsigned int));
+        oes_router_lpm4_store(&entry_p[i], OES_ROUTER_LPM4_EXT | group);
+    }
+    if (oes_router_map_zero(page_p, page_size)) {
+        compact_p->dropped += oes_router_map_drop(lpm_p->tbl24, lpm_p->tbl24_written, page_p, page_size);
+    }
+}
+
+/**
+ * This function gives back the memory an IPv4 LPM no longer
+ * needs. The tbl8 groups past the used count are moved into the
+ * free ones below it, so that the groups in use are dense again
+ * and the tail can be unmapped, and the empty tbl24 pages are
+ * dropped. Lookups go on meanwhile; the caller excludes updates.
+ *
+ * @param[in] lpm_p - LPM
+ *
+ * @return resident bytes given back
+ */
+unsigned long long
+oes_router_lpm4_compact(struct oes_router_lpm4 *lpm_p)
+{
+    struct oes_router_lpm4_compact compact = { .lpm_p = lpm_p };
+    size_t page_size = sysconf(_SC_PAGESIZE), start, end;
+    unsigned long long tail;
+    unsigned int group, next;
+
+    if (lpm_p->tbl24 == NULL) {
+        return 0;
+    }
+    /* the groups folded back are all on the free list after it */
+    oes_router_rcu_barrier();
+    tail = oes_router_lpm4_tbl8_tail_bytes(lpm_p, page_size);
+
+    /* as many groups are free below the used count as are used past it */
+    for (group = lpm_p->tbl8_free; group; group = next) {
+        next = lpm_p->tbl8[(group - 1) * OES_ROUTER_LPM4_TBL8_ENTRIES];
+        if (group - 1 < lpm_p->tbl8_used) {
+            lpm_p->tbl8[(group - 1) * OES_ROUTER_LPM4_TBL8_ENTRIES] = compact.free;
+            compact.free = group;
+        }
+    }
+    oes_router_map_walk(lpm_p->tbl24, OES_ROUTER_LPM4_TBL24_CNT * sizeof(unsigned int), lpm_p->tbl24_written,
+                        oes_router_lpm4_compact_page, &compact);
+    start = ((size_t)lpm_p->tbl8_used * OES_ROUTER_LPM4_TBL8_ENTRIES * sizeof(unsigned int) + page_size - 1) &
+            ~(page_size - 1);
+    end = (size_t)lpm_p->tbl8_hwm * OES_ROUTER_LPM4_TBL8_ENTRIES * sizeof(unsigned int);
+    lpm_p->tbl8_free = 0;
+    lpm_p->tbl8_hwm = lpm_p->tbl8_used;
+
+    /* lookups may still be in the groups moved */
+    oes_router_rcu_synchronize();
+    if (end > start) {
+        madvise((char *)lpm_p->tbl8 + start, end - start, MADV_DONTNEED);
+    }
+    return tail + compact.dropped;
+}
+
+static int
+oes_router_lpm4_tbl8_alloc(struct oes_router_lpm4 *lpm_p, unsigned int *group_p)
+{
+    /* groups folded back wait for the readers before they are free */
+    if (!lpm_p->tbl8_free && (lpm_p->tbl8_hwm == OES_ROUTER_LPM4_TBL8_GROUP_CNT) &&
+        (lpm_p->tbl8_used < OES_ROUTER_LPM4_TBL8_GROUP_CNT)) {
+        oes_router_rcu_barrier();
+    }
+    if (lpm_p->tbl8_free) {
+        *group_p = lpm_p->tbl8_free - 1;
+        lpm_p->tbl8_free = lpm_p->tbl8[*group_p * OES_ROUTER_LPM4_TBL8_ENTRIES];
+    } else if (lpm_p->tbl8_hwm < OES_ROUTER_LPM4_TBL8_GROUP_CNT) {
+        *group_p = lpm_p->tbl8_hwm++;
+    } else {
+        return 0;
+    }
+    lpm_p->tbl8_used++;
+    return 1;
+}
+
+static void
+oes_router_lpm4_tbl8_free(void *ctx_p, const unsigned int group)
+{
+    struct oes_router_lpm4 *lpm_p = ctx_p;
+
+    lpm_p->tbl8[group * OES_ROUTER_LPM4_TBL8_ENTRIES] = lpm_p->tbl8_free;
+    lpm_p->tbl8_free = group + 1;
+    lpm_p->tbl8_used--;
+}
+
+/*
+ * Overwrites the entries of a tbl8 group range which are covered
+ * by a prefix not longer than depth.
+ */
+static void
+oes_router_lpm4_tbl8_set(unsigned int *group_p,
+                         const unsigned int first,
+                         const unsigned int cnt,
+                         const unsigned int depth,
+                         const unsigned int entry)
+{
+    unsigned int i;
+
+    for (i = first; i < first + cnt; i++) {
+        if (oes_router_lpm4_depth(group_p[i]) <= depth) {
+            oes_router_lpm4_store(&group_p[i], entry);
+        }
+    }
+}
+
+/*
+ * Folds a tbl8 group back into its tbl24 entry once no prefix
+ * longer than 24 is left in it. Lookups which read the tbl24
+ * entry before may still be reading the group, it is freed after
+ * them.
+ */
+static void
+oes_router_lpm4_tbl8_recycle(struct oes_router_lpm4 *lpm_p, const unsigned int idx24)
+{
+    unsigned int group = lpm_p->tbl24[idx24] & OES_ROUTER_LPM4_VALUE_MASK;
+    unsigned int *group_p = &lpm_p->tbl8[group * OES_ROUTER_LPM4_TBL8_ENTRIES];
+    unsigned int i;
+
+    if (oes_router_lpm4_depth(group_p[0]) > 24) {
+        return;
+    }
+    for (i = 1; i < OES_ROUTER_LPM4_TBL8_ENTRIES; i++) {
+        if (group_p[i] != group_p[0]) {
+            return;
+        }
+    }
+    oes_router_lpm4_tbl24_store(lpm_p, idx24, group_p[0]);
+    oes_router_rcu_defer(oes_router_lpm4_tbl8_free, lpm_p, group);
+}
+
+/**
+ * This function adds a prefix or replaces its value.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in] addr - prefix, host order
+ * @param[in] depth - prefix length 0..32
+ * @param[in] value - value returned by lookups, up to
+ *       OES_ROUTER_LPM4_VALUE_MAX
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_RESOURCES if no tbl8 group is left
+ */
+oes_status_e
+oes_router_lpm4_add(struct oes_router_lpm4 *lpm_p,
+                    const unsigned int addr,
+                    const unsigned int depth,
+                    const unsigned int value)
+{
+    unsigned int entry = oes_router_lpm4_entry(depth, value);
+    unsigned int idx24, cnt, i, group, tbl24_entry;
+    unsigned int *group_p;
+
+    if (depth == 0) {
+        __atomic_store_n(&lpm_p->default_value, value, __ATOMIC_RELAXED);
+        __atomic_store_n(&lpm_p->default_valid, 1, __ATOMIC_RELEASE);
+        return OES_STATUS_SUCCESS;
+    }
+
+    if (depth <= 24) {
+        idx24 = addr >> 8;
+        cnt = 1 << (24 - depth);
+        for (i = idx24; i < idx24 + cnt; i++) {
+            tbl24_entry = lpm_p->tbl24[i];
+            if (tbl24_entry & OES_ROUTER_LPM4_EXT) {
+                group = tbl24_entry & OES_ROUTER_LPM4_VALUE_MASK;
+                oes_router_lpm4_tbl8_set(&lpm_p->tbl8[group * OES_ROUTER_LPM4_TBL8_ENTRIES],
+                                         0, OES_ROUTER_LPM4_TBL8_ENTRIES, depth, entry);
+            } else if (oes_router_lpm4_depth(tbl24_entry) <= depth) {
+                oes_router_lpm4_tbl24_store(lpm_p, i, entry);
+            }
+        }
+        return OES_STATUS_SUCCESS;
+    }
+
+    idx24 = addr >> 8;
+    tbl24_entry = lpm_p->tbl24[idx24];
+    if (tbl24_entry & OES_ROUTER_LPM4_EXT) {
+        group = tbl24_entry & OES_ROUTER_LPM4_VALUE_MASK;
+    } else {
+        /* the new group starts as a copy of the /24 it replaces, and is linked once set */
+        if (!oes_router_lpm4_tbl8_alloc(lpm_p, &group)) {
+            return OES_STATUS_NO_RESOURCES;
+        }
+        group_p = &lpm_p->tbl8[group * OES_ROUTER_LPM4_TBL8_ENTRIES];
+        for (i = 0; i < OES_ROUTER_LPM4_TBL8_ENTRIES; i++) {
+            group_p[i] = tbl24_entry;
+        }
+    }
+    group_p = &lpm_p->tbl8[group * OES_ROUTER_LPM4_TBL8_ENTRIES];
+    oes_router_lpm4_tbl8_set(group_p, addr & 0xff, 1 << (32 - depth), depth, entry);
+    oes_router_lpm4_tbl24_store(lpm_p, idx24, OES_ROUTER_LPM4_EXT | group);
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function deletes a prefix. Addresses it covered fall
+ * back to the closest shorter prefix, which the caller passes
+ * since the LPM does not keep the rules.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in] addr - prefix, host order
+ * @param[in] depth - prefix length 0..32
+ * @param[in] parent_valid - a shorter prefix covers this one
+ * @param[in] parent_depth - length of the covering prefix
+ * @param[in] parent_value - value of the covering prefix
+ */
+void
+oes_router_lpm4_delete(struct oes_router_lpm4 *lpm_p,
+                       const unsigned int addr,
+                       const unsigned int depth,
+                       const int parent_valid,
+                       const unsigned int parent_depth,
+                       const unsigned int parent_value)
+{
+    unsigned int entry = 0, idx24, cnt, i, j, tbl24_entry;
+    unsigned int *group_p;
+
+    /* the value is left for the lookups which saw the route valid */
+    if (depth == 0) {
+        __atomic_store_n(&lpm_p->default_valid, 0, __ATOMIC_RELEASE);
+        return;
+    }
+    /* the default route is not stored in the tables */
+    if (parent_valid && (parent_depth > 0)) {
+        entry = oes_router_lpm4_entry(parent_depth, parent_value);
+    }
+
+    if (depth <= 24) {
+        idx24 = addr >> 8;
+        cnt = 1 << (24 - depth);
+        for (i = idx24; i < idx24 + cnt; i++) {
+            tbl24_entry = lpm_p->tbl24[i];
+            if (tbl24_entry & OES_ROUTER_LPM4_EXT) {
+                group_p = &lpm_p->tbl8[(tbl24_entry & OES_ROUTER_LPM4_VALUE_MASK) *
+                                       OES_ROUTER_LPM4_TBL8_ENTRIES];
+                for (j = 0; j < OES_ROUTER_LPM4_TBL8_ENTRIES; j++) {
+                    if (oes_router_lpm4_depth(group_p[j]) == depth) {
+                        oes_router_lpm4_store(&group_p[j], entry);
+                    }
+                }
+                oes_router_lpm4_tbl8_recycle(lpm_p, i);
+            } else if (oes_router_lpm4_depth(tbl24_entry) == depth) {
+                oes_router_lpm4_tbl24_store(lpm_p, i, entry);
+            }
+        }
+        return;
+    }
+
+    idx24 = addr >> 8;
+    tbl24_entry = lpm_p->tbl24[idx24];
+    if (!(tbl24_entry & OES_ROUTER_LPM4_EXT)) {
+        return;
+    }
+    group_p = &lpm_p->tbl8[(tbl24_entry & OES_ROUTER_LPM4_VALUE_MASK) * OES_ROUTER_LPM4_TBL8_ENTRIES];
+    cnt = 1 << (32 - depth);
+    for (i = addr & 0xff; i < (addr & 0xff) + cnt; i++) {
+        if (oes_router_lpm4_depth(group_p[i]) == depth) {
+            oes_router_lpm4_store(&group_p[i], entry);
+        }
+    }
+    oes_router_lpm4_tbl8_recycle(lpm_p, idx24);
+}
+
+/*
+ * Prefixes /8 to /24 only touch the tbl24 entries of their first
+ * byte and the tbl8 groups already hanging off them.
+ */
+static void
+oes_router_lpm4_bulk_part(void *ctx_p, const unsigned int part)
+{
+    struct oes_router_lpm4_bulk *bulk_p = ctx_p;
+    struct oes_router_lpm4_rule *rule_p;
+    unsigned int i;
+
+    for (i = bulk_p->start[part]; i < bulk_p->start[part + 1]; i++) {
+        rule_p = bulk_p->order[i];
+        oes_router_lpm4_add(bulk_p->lpm_p, rule_p->addr, rule_p->depth, rule_p->value);
+    }
+}
+
+/**
+ * This function adds a list of prefixes at once. Prefixes up to
+ * /24 are spread over the threads by their first byte, each
+ * thread owning that part of tbl24 and the tbl8 groups hanging
+ * off it. Prefixes longer than /24 take tbl8 groups and are added
+ * last, by the calling thread.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in,out] rule_list_p - prefixes, failed is set on the
+ *       ones left out
+ * @param[in] cnt - list size
+ * @param[in] thread_cnt - thread count
+ *
+ * @return OES_STATUS_SUCCESS if all prefixes were added
+ * @return OES_STATUS_NO_MEMORY if the work list cannot be
+ *         allocated, no prefix is added
+ * @return OES_STATUS_NO_RESOURCES if tbl8 groups ran out
+ */
+oes_status_e
+oes_router_lpm4_add_bulk(struct oes_router_lpm4 *lpm_p,
+                         struct oes_router_lpm4_rule *rule_list_p,
+                         const unsigned int cnt,
+                         const unsigned int thread_cnt)
+{
+    unsigned int fill[OES_ROUTER_LPM4_BULK_PARTS], i, part;
+    struct oes_router_lpm4_bulk bulk;
+    struct oes_router_lpm4_rule *rule_p;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    memset(&bulk, 0, sizeof(bulk));
+    bulk.lpm_p = lpm_p;
+    bulk.order = malloc((cnt ? cnt : 1) * sizeof(*bulk.order));
+    if (bulk.order == NULL) {
+        for (i = 0; i < cnt; i++) {
+            rule_list_p[i].failed = 1;
+        }
+        return OES_STATUS_NO_MEMORY;
+    }
+    /* counting sort by first byte */
+    for (i = 0; i < cnt; i++) {
+        rule_p = &rule_list_p[i];
+        rule_p->failed = 0;
+        if ((rule_p->depth >= 8) && (rule_p->depth <= 24)) {
+            bulk.start[(rule_p->addr >> 24) + 1]++;
+        }
+    }
+    for (part = 0; part < OES_ROUTER_LPM4_BULK_PARTS; part++) {
+        bulk.start[part + 1] += bulk.start[part];
+        fill[part] = bulk.start[part];
+    }
+    for (i = 0; i < cnt; i++) {
+        rule_p = &rule_list_p[i];
+        if ((rule_p->depth >= 8) && (rule_p->depth <= 24)) {
+            bulk.order[fill[rule_p->addr >> 24]++] = rule_p;
+        }
+    }
+
+    /* the result does not depend on the order prefixes are added in */
+    for (i = 0; i < cnt; i++) {
+        if (rule_list_p[i].depth < 8) {
+            oes_router_lpm4_add(lpm_p, rule_list_p[i].addr, rule_list_p[i].depth, rule_list_p[i].value);
+        }
+    }
+    oes_router_bulk_run(thread_cnt, OES_ROUTER_LPM4_BULK_PARTS, oes_router_lpm4_bulk_part, &bulk);
+    for (i = 0; i < cnt; i++) {
+        rule_p = &rule_list_p[i];
+        if ((rule_p->depth > 24) &&
+            (oes_router_lpm4_add(lpm_p, rule_p->addr, rule_p->depth, rule_p->value) != OES_STATUS_SUCCESS)) {
+            rule_p->failed = 1;
+            status = OES_STATUS_NO_RESOURCES;
+        }
+    }
+    free(bulk.order);
+    return status;
+}
+
+__attribute__((target("avx2")))
+static void
+oes_router_lpm4_tbl24_gather_avx2(const unsigned int *tbl24_p,
+                                  const unsigned int *addr_list_p,
+                                  const unsigned int cnt,
+                                  unsigned int *entry_list_p)
+{
+    __m256i addr, entry;
+    unsigned int i;
+
+    for (i = 0; i + 8 <= cnt; i += 8) {
+        addr = _mm256_loadu_si256((const __m256i *)&addr_list_p[i]);
+        entry = _mm256_i32gather_epi32((const int *)tbl24_p, _mm256_srli_epi32(addr, 8), 4);
+        _mm256_storeu_si256((__m256i *)&entry_list_p[i], entry);
+    }
+    for (; i < cnt; i++) {
+        entry_list_p[i] = tbl24_p[addr_list_p[i] >> 8];
+    }
+}
+
+/**
+ * This function looks up a list of addresses. All tbl24 entries
+ * are prefetched, then read (with AVX2 gathers when the CPU has
+ * them), then the tbl8 entries they point to are prefetched and
+ * read, so that the misses of the whole list overlap.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in] addr_list_p - addresses, host order
+ * @param[in] cnt - list size, up to OES_ROUTER_LPM_BULK_MAX
+ * @param[out] depth_list_p - matched prefix lengths
+ * @param[out] value_list_p - matched values
+ */
+void
+oes_router_lpm4_lookup_bulk(const struct oes_router_lpm4 *lpm_p,
+                            const unsigned int *addr_list_p,
+                            const unsigned int cnt,
+                            unsigned char *depth_list_p,
+                            unsigned int *value_list_p)
+{
+    static int avx2 = -1;
+    unsigned int entries[OES_ROUTER_LPM_BULK_MAX];
+    unsigned int i, entry;
+
+    for (i = 0; i < cnt; i++) {
+        __builtin_prefetch(&lpm_p->tbl24[addr_list_p[i] >> 8]);
+    }
+    if (avx2 < 0) {
+        avx2 = __builtin_cpu_supports("avx2");
+    }
+    /* x86 loads are not reordered with each other, gathers read as acquire loads do */
+    if (avx2) {
+        oes_router_lpm4_tbl24_gather_avx2(lpm_p->tbl24, addr_list_p, cnt, entries);
+    } else {
+        for (i = 0; i < cnt; i++) {
+            entries[i] = __atomic_load_n(&lpm_p->tbl24[addr_list_p[i] >> 8], __ATOMIC_ACQUIRE);
+        }
+    }
+
+    for (i = 0; i < cnt; i++) {
+        if (entries[i] & OES_ROUTER_LPM4_EXT) {
+            __builtin_prefetch(&lpm_p->tbl8[((entries[i] & OES_ROUTER_LPM4_VALUE_MASK) << 8) |
+                                            (addr_list_p[i] & 0xff)]);
+        }
+    }
+    for (i = 0; i < cnt; i++) {
+        entry = entries[i];
+        if (entry & OES_ROUTER_LPM4_EXT) {
+            entry = __atomic_load_n(&lpm_p->tbl8[((entry & OES_ROUTER_LPM4_VALUE_MASK) << 8) |
+                                                 (addr_list_p[i] & 0xff)], __ATOMIC_ACQUIRE);
+        }
+        if (entry) {
+            depth_list_p[i] = entry >> OES_ROUTER_LPM4_DEPTH_SHIFT;
+            value_list_p[i] = entry & OES_ROUTER_LPM4_VALUE_MASK;
+        } else if (__atomic_load_n(&lpm_p->default_valid, __ATOMIC_ACQUIRE)) {
+            depth_list_p[i] = 0;
+            value_list_p[i] = __atomic_load_n(&lpm_p->default_value, __ATOMIC_RELAXED);
+        } else {
+            depth_list_p[i] = OES_ROUTER_LPM_MISS;
+        }
+    }
+}
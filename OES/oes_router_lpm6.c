@@ -0,0 +1,988 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_router.h"
+
+#define OES_ROUTER_LPM6_DIRECT_SIZE (OES_ROUTER_LPM6_DIRECT_CNT * sizeof(struct oes_router_lpm6_direct))
+#define OES_ROUTER_LPM6_BULK_PARTS  256     /* of 256 direct entries each */
+
+struct oes_router_lpm6_bulk {
+    struct oes_router_lpm6        * lpm_p;
+    struct oes_router_lpm6_rule  ** order;  /**< prefixes longer than /16, grouped by direct entry */
+    unsigned int                  * start;  /**< first prefix of each direct entry */
+    int                             failed;
+};
+
+struct oes_router_lpm6_usage {
+    unsigned long long              free_bytes;
+    unsigned int                    entry_cnt;
+};
+
+struct oes_router_lpm6_compact {
+    struct oes_router_lpm6        * lpm_p;
+    unsigned long long              dropped;
+};
+
+enum oes_router_lpm6_op {
+    OES_ROUTER_LPM6_OP_NONE,
+    OES_ROUTER_LPM6_OP_INSERT,
+    OES_ROUTER_LPM6_OP_REMOVE,
+};
+
+static size_t
+oes_router_lpm6_node_size(const unsigned int child_cnt, const unsigned int result_cnt)
+{
+    return sizeof(struct oes_router_lpm6_node) + child_cnt * sizeof(void *) +
+           result_cnt * sizeof(unsigned int);
+}
+
+static unsigned int *
+oes_router_lpm6_results(struct oes_router_lpm6_node *node_p)
+{
+    return (unsigned int *)&node_p->slots[node_p->child_cnt];
+}
+
+static void
+oes_router_lpm6_node_free(struct oes_router_lpm6 *lpm_p, struct oes_router_lpm6_node *node_p)
+{
+    size_t size = oes_router_lpm6_node_size(node_p->child_cnt, node_p->result_cnt);
+
+    lpm_p->node_bytes -= size;
+    lpm_p->node_cnt--;
+    oes_router_pool_free(lpm_p->pool, node_p, size);
+}
+
+/* frees a node lookups may still be in, once they are out */
+static void
+oes_router_lpm6_node_retire(struct oes_router_lpm6 *lpm_p, struct oes_router_lpm6_node *node_p)
+{
+    size_t size = oes_router_lpm6_node_size(node_p->child_cnt, node_p->result_cnt);
+
+    lpm_p->node_bytes -= size;
+    lpm_p->node_cnt--;
+    oes_router_pool_retire(lpm_p->pool, node_p, size);
+}
+
+static void
+oes_router_lpm6_node_destroy(struct oes_router_lpm6 *lpm_p, struct oes_router_lpm6_node *node_p)
+{
+    unsigned int i;
+
+    if (node_p == NULL) {
+        return;
+    }
+    for (i = 0; i < node_p->child_cnt; i++) {
+        oes_router_lpm6_node_destroy(lpm_p, node_p->slots[i]);
+    }
+    oes_router_lpm6_node_free(lpm_p, node_p);
+}
+
+/*
+ * Copies a node (NULL for an empty one) inserting or removing one
+ * result and/or one child. *node_pp is set to NULL when the copy
+ * would be empty.
+ */
+static oes_status_e
+oes_router_lpm6_node_clone(struct oes_router_lpm6 *lpm_p,
+                           struct oes_router_lpm6_node *src_p,
+                           const unsigned int result_pos,
+                           const enum oes_router_lpm6_op result_op,
+                           const unsigned int value,
+                           const unsigned int child_byte,
+                           const enum oes_router_lpm6_op child_op,
+                           struct oes_router_lpm6_node *child_p,
+                           struct oes_router_lpm6_node **node_pp)
+{
+    struct oes_router_lpm6_node *node_p, empty;
+    unsigned int child_cnt, result_cnt, rank, i, j;
+    unsigned int *src_results_p, *results_p;
+
+    if (src_p == NULL) {
+        memset(&empty, 0, sizeof(empty));
+        src_p = &empty;
+    }
+    child_cnt = src_p->child_cnt + (child_op == OES_ROUTER_LPM6_OP_INSERT) -
+                (child_op == OES_ROUTER_LPM6_OP_REMOVE);
+    result_cnt = src_p->result_cnt + (result_op == OES_ROUTER_LPM6_OP_INSERT) -
+                 (result_op == OES_ROUTER_LPM6_OP_REMOVE);
+    if ((child_cnt == 0) && (result_cnt == 0)) {
+        *node_pp = NULL;
+        return OES_STATUS_SUCCESS;
+    }
+
+    node_p = oes_router_pool_alloc(lpm_p->pool, oes_router_lpm6_node_size(child_cnt, result_cnt));
+    if (node_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    memcpy(node_p->internal, src_p->internal, sizeof(node_p->internal));
+    memcpy(node_p->external, src_p->external, sizeof(node_p->external));
+    node_p->child_cnt = child_cnt;
+    node_p->result_cnt = result_cnt;
+
+    rank = oes_router_lpm6_rank(src_p->external, child_byte);
+    for (i = 0, j = 0; i < src_p->child_cnt; i++) {
+        if ((i == rank) && (child_op == OES_ROUTER_LPM6_OP_INSERT)) {
+            node_p->slots[j++] = child_p;
+        }
+        if ((i != rank) || (child_op != OES_ROUTER_LPM6_OP_REMOVE)) {
+            node_p->slots[j++] = src_p->slots[i];
+        }
+    }
+    if ((rank == src_p->child_cnt) && (child_op == OES_ROUTER_LPM6_OP_INSERT)) {
+        node_p->slots[j++] = child_p;
+    }
+    if (child_op == OES_ROUTER_LPM6_OP_INSERT) {
+        node_p->external[child_byte / 64] |= 1ULL << (child_byte % 64);
+    } else if (child_op == OES_ROUTER_LPM6_OP_REMOVE) {
+        node_p->external[child_byte / 64] &= ~(1ULL << (child_byte % 64));
+    }
+
+    src_results_p = (unsigned int *)&src_p->slots[src_p->child_cnt];
+    results_p = oes_router_lpm6_results(node_p);
+    rank = oes_router_lpm6_rank(src_p->internal, result_pos);
+    for (i = 0, j = 0; i < src_p->result_cnt; i++) {
+        if ((i == rank) && (result_op == OES_ROUTER_LPM6_OP_INSERT)) {
+            results_p[j++] = value;
+        }
+        if ((i != rank) || (result_op != OES_ROUTER_LPM6_OP_REMOVE)) {
+            results_p[j++] = src_results_p[i];
+        }
+    }
+    if ((rank == src_p->result_cnt) && (result_op == OES_ROUTER_LPM6_OP_INSERT)) {
+        results_p[j++] = value;
+    }
+    if (result_op == OES_ROUTER_LPM6_OP_INSERT) {
+        node_p->internal[result_pos / 64] |= 1ULL << (result_pos % 64);
+    } else if (result_op == OES_ROUTER_LPM6_OP_REMOVE) {
+        node_p->internal[result_pos / 64] &= ~(1ULL << (result_pos % 64));
+    }
+
+    lpm_p->node_bytes += oes_router_lpm6_node_size(child_cnt, result_cnt);
+    lpm_p->node_cnt++;
+    *node_pp = node_p;
+    return OES_STATUS_SUCCESS;
+}
+
+/*
+ * Adds a prefix below node_p, at depth. *node_pp is set to the
+ * node which replaces node_p in its parent, node_p itself when it
+ * could be updated in place. The caller links the replacement
+ * and then frees node_p.
+ */
+static oes_status_e
+oes_router_lpm6_node_add(struct oes_router_lpm6 *lpm_p,
+                         struct oes_router_lpm6_node *node_p,
+                         const struct in6_addr *addr_p,
+                         const unsigned int depth,
+                         const unsigned int len,
+                         const unsigned int value,
+                         struct oes_router_lpm6_node **node_pp)
+{
+    struct oes_router_lpm6_node *child_p = NULL, *new_child_p;
+    unsigned int byte = addr_p->s6_addr[depth / 8], rel = len - depth, pos, rank;
+    oes_status_e status;
+
+    if (rel <= 8) {
+        pos = (1 << rel) - 2 + (byte >> (8 - rel));
+        if ((node_p != NULL) && oes_router_lpm6_bit(node_p->internal, pos)) {
+            __atomic_store_n(&oes_router_lpm6_results(node_p)[oes_router_lpm6_rank(node_p->internal, pos)],
+                             value, __ATOMIC_RELAXED);
+            *node_pp = node_p;
+            return OES_STATUS_SUCCESS;
+        }
+        return oes_router_lpm6_node_clone(lpm_p, node_p, pos, OES_ROUTER_LPM6_OP_INSERT, value,
+                                          0, OES_ROUTER_LPM6_OP_NONE, NULL, node_pp);
+    }
+
+    if ((node_p != NULL) && oes_router_lpm6_bit(node_p->external, byte)) {
+        rank = oes_router_lpm6_rank(node_p->external, byte);
+        child_p = node_p->slots[rank];
+        status = oes_router_lpm6_node_add(lpm_p, child_p, addr_p, depth + 8, len, value, &new_child_p);
+        if (status != OES_STATUS_SUCCESS) {
+            return status;
+        }
+        if (new_child_p != child_p) {
+            __atomic_store_n(&node_p->slots[rank], new_child_p, __ATOMIC_RELEASE);
+            oes_router_lpm6_node_retire(lpm_p, child_p);
+        }
+        *node_pp = node_p;
+        return OES_STATUS_SUCCESS;
+    }
+
+    /* a new path, built before it is linked */
+    status = oes_router_lpm6_node_add(lpm_p, NULL, addr_p, depth + 8, len, value, &new_child_p);
+    if (status != OES_STATUS_SUCCESS) {
+        return status;
+    }
+    status = oes_router_lpm6_node_clone(lpm_p, node_p, 0, OES_ROUTER_LPM6_OP_NONE, 0,
+                                        byte, OES_ROUTER_LPM6_OP_INSERT, new_child_p, node_pp);
+    if (status != OES_STATUS_SUCCESS) {
+        oes_router_lpm6_node_destroy(lpm_p, new_child_p);
+    }
+    return status;
+}
+
+/*
+ * Deletes a prefix below node_p, at depth. *node_pp is set as by
+ * oes_router_lpm6_node_add, NULL when the node becomes empty.
+ */
+static oes_status_e
+oes_router_lpm6_node_delete(struct oes_router_lpm6 *lpm_p,
+                            struct oes_router_lpm6_node *node_p,
+                            const struct in6_addr *addr_p,
+                            const unsigned int depth,
+                            const unsigned int len,
+                            struct oes_router_lpm6_node **node_pp)
+{
+    struct oes_router_lpm6_node *child_p, *new_child_p;
+    unsigned int byte = addr_p->s6_addr[depth / 8], rel = len - depth, pos, rank;
+    oes_status_e status;
+
+    *node_pp = node_p;
+    if (node_p == NULL) {
+        return OES_STATUS_SUCCESS;
+    }
+    if (rel <= 8) {
+        pos = (1 << rel) - 2 + (byte >> (8 - rel));
+        if (!oes_router_lpm6_bit(node_p->internal, pos)) {
+            return OES_STATUS_SUCCESS;
+        }
+        return oes_router_lpm6_node_clone(lpm_p, node_p, pos, OES_ROUTER_LPM6_OP_REMOVE, 0,
+                                          0, OES_ROUTER_LPM6_OP_NONE, NULL, node_pp);
+    }
+
+    if (!oes_router_lpm6_bit(node_p->external, byte)) {
+        return OES_STATUS_SUCCESS;
+    }
+    rank = oes_router_lpm6_rank(node_p->external, byte);
+    child_p = node_p->slots[rank];
+    status = oes_router_lpm6_node_delete(lpm_p, child_p, addr_p, depth + 8, len, &new_child_p);
+    if ((status != OES_STATUS_SUCCESS) || (new_child_p == child_p)) {
+        return status;
+    }
+    if (new_child_p != NULL) {
+        __atomic_store_n(&node_p->slots[rank], new_child_p, __ATOMIC_RELEASE);
+        oes_router_lpm6_node_retire(lpm_p, child_p);
+        return OES_STATUS_SUCCESS;
+    }
+    status = oes_router_lpm6_node_clone(lpm_p, node_p, 0, OES_ROUTER_LPM6_OP_NONE, 0,
+                                        byte, OES_ROUTER_LPM6_OP_REMOVE, NULL, node_pp);
+    if (status == OES_STATUS_SUCCESS) {
+        oes_router_lpm6_node_retire(lpm_p, child_p);
+    }
+    return status;
+}
+
+/**
+ * This function sets up an IPv6 LPM, small: its prefixes are
+ * kept in nodes from the root until it is expanded. The LPM may
+ * be created lazily while lookups run on it, they miss until its
+ * first prefix.
+ *
+ * @param[in,out] lpm_p - LPM, zeroed
+ * @param[in] pool_p - pool the nodes are allocated from
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ */
+oes_status_e
+oes_router_lpm6_init(struct oes_router_lpm6 *lpm_p, struct oes_router_pool *pool_p)
+{
+    lpm_p->pool = pool_p;
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function frees the nodes and unmaps the direct table of
+ * an IPv6 LPM.
+ *
+ * @param[in] lpm_p - LPM
+ */
+void
+oes_router_lpm6_deinit(struct oes_router_lpm6 *lpm_p)
+{
+    unsigned int i;
+
+    oes_router_lpm6_node_destroy(lpm_p, lpm_p->root);
+    if (lpm_p->direct != NULL) {
+        for (i = 0; i < OES_ROUTER_LPM6_DIRECT_CNT; i++) {
+            oes_router_lpm6_node_destroy(lpm_p, lpm_p->direct[i].node);
+        }
+        munmap(lpm_p->direct, OES_ROUTER_LPM6_DIRECT_SIZE);
+    }
+    free(lpm_p->direct_written);
+    memset(lpm_p, 0, sizeof(*lpm_p));
+}
+
+/*
+ * The longest prefix of a node matching the byte after its depth,
+ * as a direct table entry, 0 when none does.
+ */
+static unsigned int
+oes_router_lpm6_node_entry(const struct oes_router_lpm6_node *node_p,
+                           const unsigned int depth,
+                           const unsigned int byte)
+{
+    unsigned int r, pos;
+
+    for (r = 8; (node_p != NULL) && (r > 0); r--) {
+        pos = (1 << r) - 2 + (byte >> (8 - r));
+        if (oes_router_lpm6_bit(node_p->internal, pos)) {
+            return ((depth + r) << OES_ROUTER_LPM4_DEPTH_SHIFT) |
+                   ((const unsigned int *)&node_p->slots[node_p->child_cnt])
+                   [oes_router_lpm6_rank(node_p->internal, pos)];
+        }
+    }
+    return 0;
+}
+
+/* marks the page of the direct entry written before it is */
+static void
+oes_router_lpm6_direct_written(struct oes_router_lpm6 *lpm_p, const unsigned int idx)
+{
+    oes_router_map_written_set(lpm_p->direct_written, idx * sizeof(struct oes_router_lpm6_direct));
+}
+
+static struct oes_router_lpm6_node *
+oes_router_lpm6_node_child(const struct oes_router_lpm6_node *node_p, const unsigned int byte)
+{
+    if ((node_p == NULL) || !oes_router_lpm6_bit(node_p->external, byte)) {
+        return NULL;
+    }
+    return node_p->slots[oes_router_lpm6_rank(node_p->external, byte)];
+}
+
+/**
+ * This function maps the direct table of a small IPv6 LPM. The
+ * prefixes up to /16 are expanded into it and the nodes below
+ * /16 linked from it as they are, the nodes above are freed once
+ * no lookup can be in them. Lookups go on meanwhile, on the tree
+ * until the direct table is published; the caller excludes
+ * updates.
+ *
+ * @param[in] lpm_p - LPM, not expanded
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the table cannot be mapped
+ */
+oes_status_e
+oes_router_lpm6_expand(struct oes_router_lpm6 *lpm_p)
+{
+    struct oes_router_lpm6_node *root_p = lpm_p->root, *node_p;
+    struct oes_router_lpm6_direct *direct_p;
+    unsigned int hi, lo, entry;
+    void *mem_p;
+
+    lpm_p->direct_written = calloc(OES_ROUTER_MAP_WRITTEN_WORDS(OES_ROUTER_LPM6_DIRECT_SIZE),
+                                   sizeof(*lpm_p->direct_written));
+    if (lpm_p->direct_written == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    mem_p = mmap(NULL, OES_ROUTER_LPM6_DIRECT_SIZE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mem_p == MAP_FAILED) {
+        free(lpm_p->direct_written);
+        lpm_p->direct_written = NULL;
+        return OES_STATUS_NO_MEMORY;
+    }
+    direct_p = mem_p;
+
+    /* only the entries with a prefix or a node are written, the others stay unbacked */
+    for (hi = 0; (root_p != NULL) && (hi < 256); hi++) {
+        entry = oes_router_lpm6_node_entry(root_p, 0, hi);
+        node_p = oes_router_lpm6_node_child(root_p, hi);
+        if (!entry && (node_p == NULL)) {
+            continue;
+        }
+        for (lo = 0; lo < 256; lo++) {
+            oes_router_lpm6_direct_written(lpm_p, (hi << 8) | lo);
+            direct_p[(hi << 8) | lo].node = oes_router_lpm6_node_child(node_p, lo);
+            direct_p[(hi << 8) | lo].entry = oes_router_lpm6_node_entry(node_p, 8, lo);
+            if (!direct_p[(hi << 8) | lo].entry) {
+                direct_p[(hi << 8) | lo].entry = entry;
+            }
+        }
+    }
+    __atomic_store_n(&lpm_p->direct, direct_p, __ATOMIC_RELEASE);
+    __atomic_store_n(&lpm_p->root, NULL, __ATOMIC_RELEASE);
+
+    for (hi = 0; (root_p != NULL) && (hi < root_p->child_cnt); hi++) {
+        oes_router_lpm6_node_retire(lpm_p, root_p->slots[hi]);
+    }
+    if (root_p != NULL) {
+        oes_router_lpm6_node_retire(lpm_p, root_p);
+    }
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function returns the bytes of the direct table of an IPv6
+ * LPM backed by memory, the pages written.
+ *
+ * @param[in] lpm_p - LPM
+ *
+ * @return resident bytes, 0 when the LPM is not mapped
+ */
+unsigned long long
+oes_router_lpm6_table_bytes(const struct oes_router_lpm6 *lpm_p)
+{
+    if (lpm_p->direct == NULL) {
+        return 0;
+    }
+    return oes_router_map_written_bytes(OES_ROUTER_LPM6_DIRECT_SIZE, lpm_p->direct_written);
+}
+
+static void
+oes_router_lpm6_usage_page(void *ctx_p, void *page_p, const size_t page_size)
+{
+    struct oes_router_lpm6_usage *usage_p = ctx_p;
+    const struct oes_router_lpm6_direct *direct_p = page_p;
+    unsigned int i, cnt = 0;
+
+    for (i = 0; i < page_size / sizeof(*direct_p); i++) {
+        cnt += (direct_p[i].entry != 0) || (direct_p[i].node != NULL);
+    }
+    usage_p->entry_cnt += cnt;
+    if (!cnt) {
+        usage_p->free_bytes += page_size;
+    }
+}
+
+/**
+ * This function reports the memory of an IPv6 LPM. Its entries
+ * are the direct table entries holding a prefix or a node, none
+ * while it is small, its free bytes the written direct table
+ * pages left empty, what compaction gives back. Nodes are sized to their contents and count as used.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[out] usage_p - usage, ratios left to the caller
+ */
+void
+oes_router_lpm6_usage(const struct oes_router_lpm6 *lpm_p, struct oes_router_table_usage *usage_p)
+{
+    struct oes_router_lpm6_usage page_usage = { 0 };
+
+    memset(usage_p, 0, sizeof(*usage_p));
+    usage_p->entry_max = OES_ROUTER_LPM6_DIRECT_CNT;
+    if (lpm_p->direct == NULL) {
+        usage_p->bytes = lpm_p->node_bytes;
+        return;
+    }
+    oes_router_map_walk(lpm_p->direct, OES_ROUTER_LPM6_DIRECT_SIZE, lpm_p->direct_written,
+                        oes_router_lpm6_usage_page, &page_usage);
+    usage_p->bytes = oes_router_lpm6_table_bytes(lpm_p) + lpm_p->node_bytes;
+    usage_p->free_bytes = page_usage.free_bytes;
+    usage_p->entry_cnt = page_usage.entry_cnt;
+}
+
+static void
+oes_router_lpm6_compact_page(void *ctx_p, void *page_p, const size_t page_size)
+{
+    struct oes_router_lpm6_compact *compact_p = ctx_p;
+
+    if (oes_router_map_zero(page_p, page_size)) {
+        compact_p->dropped += oes_router_map_drop(compact_p->lpm_p->direct, compact_p->lpm_p->direct_written,
+                                                  page_p, page_size);
+    }
+}
+
+/**
+ * This function drops the empty pages of the direct table of an
+ * IPv6 LPM. Lookups go on meanwhile; the caller excludes
+ * updates.
+ *
+ * @param[in] lpm_p - LPM
+ *
+ * @return resident bytes given back
+ */
+unsigned long long
+oes_router_lpm6_compact(struct oes_router_lpm6 *lpm_p)
+{
+    struct oes_router_lpm6_compact compact = { .lpm_p = lpm_p };
+
+    if (lpm_p->direct == NULL) {
+        return 0;
+    }
+    oes_router_map_walk(lpm_p->direct, OES_ROUTER_LPM6_DIRECT_SIZE, lpm_p->direct_written,
+                        oes_router_lpm6_compact_page, &compact);
+    return compact.dropped;
+}
+
+/**
+ * This function adds a prefix or replaces its value.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in] addr_p - prefix
+ * @param[in] depth - prefix length 0..128
+ * @param[in] value - value returned by lookups, up to
+ *       OES_ROUTER_LPM4_VALUE_MAX
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if a node cannot be allocated
+ */
+oes_status_e
+oes_router_lpm6_add(struct oes_router_lpm6 *lpm_p,
+                    const struct in6_addr *addr_p,
+                    const unsigned int depth,
+                    const unsigned int value)
+{
+    unsigned int idx = (addr_p->s6_addr[0] << 8) | addr_p->s6_addr[1], cnt, i;
+    unsigned int entry = (depth << OES_ROUTER_LPM4_DEPTH_SHIFT) | value;
+    struct oes_router_lpm6_node *node_p, *new_p;
+    oes_status_e status;
+
+    if (depth == 0) {
+        __atomic_store_n(&lpm_p->default_value, value, __ATOMIC_RELAXED);
+        __atomic_store_n(&lpm_p->default_valid, 1, __ATOMIC_RELEASE);
+        return OES_STATUS_SUCCESS;
+    }
+
+    if (lpm_p->direct == NULL) {
+        node_p = lpm_p->root;
+        status = oes_router_lpm6_node_add(lpm_p, node_p, addr_p, 0, depth, value, &new_p);
+        if ((status == OES_STATUS_SUCCESS) && (new_p != node_p)) {
+            __atomic_store_n(&lpm_p->root, new_p, __ATOMIC_RELEASE);
+            if (node_p != NULL) {
+                oes_router_lpm6_node_retire(lpm_p, node_p);
+            }
+        }
+        return status;
+    }
+
+    if (depth <= OES_ROUTER_LPM6_DIRECT_BITS) {
+        cnt = 1 << (OES_ROUTER_LPM6_DIRECT_BITS - depth);
+        for (i = idx; i < idx + cnt; i++) {
+            if ((lpm_p->direct[i].entry >> OES_ROUTER_LPM4_DEPTH_SHIFT) <= depth) {
+                oes_router_lpm6_direct_written(lpm_p, i);
+                __atomic_store_n(&lpm_p->direct[i].entry, entry, __ATOMIC_RELEASE);
+            }
+        }
+        return OES_STATUS_SUCCESS;
+    }
+
+    node_p = lpm_p->direct[idx].node;
+    status = oes_router_lpm6_node_add(lpm_p, node_p, addr_p, OES_ROUTER_LPM6_DIRECT_BITS, depth, value, &new_p);
+    if ((status == OES_STATUS_SUCCESS) && (new_p != node_p)) {
+        oes_router_lpm6_direct_written(lpm_p, idx);
+        __atomic_store_n(&lpm_p->direct[idx].node, new_p, __ATOMIC_RELEASE);
+        if (node_p != NULL) {
+            oes_router_lpm6_node_retire(lpm_p, node_p);
+        }
+    }
+    return status;
+}
+
+/**
+ * This function deletes a prefix. The closest shorter prefix is
+ * only needed for prefixes up to /16, expanded in the direct
+ * table.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in] addr_p - prefix
+ * @param[in] depth - prefix length 0..128
+ * @param[in] parent_valid - a shorter prefix covers this one
+ * @param[in] parent_depth - length of the covering prefix
+ * @param[in] parent_value - value of the covering prefix
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if a node cannot be allocated
+ */
+oes_status_e
+oes_router_lpm6_delete(struct oes_router_lpm6 *lpm_p,
+                       const struct in6_addr *addr_p,
+                       const unsigned int depth,
+                       const int parent_valid,
+                       const unsigned int parent_depth,
+                       const unsigned int parent_value)
+{
+    unsigned int idx = (addr_p->s6_addr[0] << 8) | addr_p->s6_addr[1], entry = 0, cnt, i;
+    struct oes_router_lpm6_node *node_p, *new_p;
+    oes_status_e status;
+
+    /* the value is left for the lookups which saw the route valid */
+    if (depth == 0) {
+        __atomic_store_n(&lpm_p->default_valid, 0, __ATOMIC_RELEASE);
+        return OES_STATUS_SUCCESS;
+    }
+
+    if (lpm_p->direct == NULL) {
+        node_p = lpm_p->root;
+        status = oes_router_lpm6_node_delete(lpm_p, node_p, addr_p, 0, depth, &new_p);
+        if ((status == OES_STATUS_SUCCESS) && (new_p != node_p)) {
+            __atomic_store_n(&lpm_p->root, new_p, __ATOMIC_RELEASE);
+            oes_router_lpm6_node_retire(lpm_p, node_p);
+        }
+        return status;
+    }
+
+    if (depth <= OES_ROUTER_LPM6_DIRECT_BITS) {
+        if (parent_valid && (parent_depth > 0)) {
+            entry = (parent_depth << OES_ROUTER_LPM4_DEPTH_SHIFT) | parent_value;
+        }
+        cnt = 1 << (OES_ROUTER_LPM6_DIRECT_BITS - depth);
+        for (i = idx; i < idx + cnt; i++) {
+            if ((lpm_p->direct[i].entry >> OES_ROUTER_LPM4_DEPTH_SHIFT) == depth) {
+                __atomic_store_n(&lpm_p->direct[i].entry, entry, __ATOMIC_RELEASE);
+            }
+        }
+        return OES_STATUS_SUCCESS;
+    }
+
+    node_p = lpm_p->direct[idx].node;
+    status = oes_router_lpm6_node_delete(lpm_p, node_p, addr_p, OES_ROUTER_LPM6_DIRECT_BITS, depth, &new_p);
+    if ((status == OES_STATUS_SUCCESS) && (new_p != node_p)) {
+        __atomic_store_n(&lpm_p->direct[idx].node, new_p, __ATOMIC_RELEASE);
+        oes_router_lpm6_node_retire(lpm_p, node_p);
+    }
+    return status;
+}
+
+static int
+oes_router_lpm6_rule_cmp(const void *a_p, const void *b_p)
+{
+    const struct oes_router_lpm6_rule *a_rule_p = *(struct oes_router_lpm6_rule * const *)a_p;
+    const struct oes_router_lpm6_rule *b_rule_p = *(struct oes_router_lpm6_rule * const *)b_p;
+    int cmp = memcmp(&a_rule_p->addr, &b_rule_p->addr, sizeof(a_rule_p->addr));
+
+    return cmp ? cmp : (int)a_rule_p->depth - (int)b_rule_p->depth;
+}
+
+/*
+ * Builds the node at depth for a list of prefixes sorted by
+ * address, all longer than depth and sharing its first depth
+ * bits. The list order is lost on return. Nodes are accounted in
+ * acct_p, a per partition copy of the LPM.
+ */
+static oes_status_e
+oes_router_lpm6_node_build(struct oes_router_lpm6 *acct_p,
+                           struct oes_router_lpm6_rule **rule_list_pp,
+                           const unsigned int cnt,
+                           const unsigned int depth,
+                           struct oes_router_lpm6_node **node_pp)
+{
+    unsigned long long internal[8], external[4];
+    unsigned int child_cnt = 0, result_cnt = 0, i, j, k, byte, rel, pos;
+    struct oes_router_lpm6_node *node_p;
+    struct oes_router_lpm6_rule *rule_p;
+    oes_status_e status;
+
+    memset(internal, 0, sizeof(internal));
+    memset(external, 0, sizeof(external));
+    for (i = 0; i < cnt; i++) {
+        rule_p = rule_list_pp[i];
+        byte = rule_p->addr.s6_addr[depth / 8];
+        rel = rule_p->depth - depth;
+        if (rel <= 8) {
+            pos = (1 << rel) - 2 + (byte >> (8 - rel));
+            result_cnt += !oes_router_lpm6_bit(internal, pos);
+            internal[pos / 64] |= 1ULL << (pos % 64);
+        } else {
+            child_cnt += !oes_router_lpm6_bit(external, byte);
+            external[byte / 64] |= 1ULL << (byte % 64);
+        }
+    }
+
+    node_p = oes_router_pool_alloc(acct_p->pool, oes_router_lpm6_node_size(child_cnt, result_cnt));
+    if (node_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    memcpy(node_p->internal, internal, sizeof(internal));
+    memcpy(node_p->external, external, sizeof(external));
+    node_p->child_cnt = 0;
+    node_p->result_cnt = result_cnt;
+    acct_p->node_bytes += oes_router_lpm6_node_size(child_cnt, result_cnt);
+    acct_p->node_cnt++;
+    for (i = 0; i < cnt; i++) {
+        rule_p = rule_list_pp[i];
+        rel = rule_p->depth - depth;
+        if (rel <= 8) {
+            pos = (1 << rel) - 2 + (rule_p->addr.s6_addr[depth / 8] >> (8 - rel));
+            ((unsigned int *)&node_p->slots[child_cnt])[oes_router_lpm6_rank(internal, pos)] = rule_p->value;
+        }
+    }
+
+    /* the prefixes of a child are a run of the list, moved to its front */
+    for (i = 0; i < cnt; i = j) {
+        byte = rule_list_pp[i]->addr.s6_addr[depth / 8];
+        for (j = i, k = i; (j < cnt) && (rule_list_pp[j]->addr.s6_addr[depth / 8] == byte); j++) {
+            if (rule_list_pp[j]->depth > depth + 8) {
+                rule_list_pp[k++] = rule_list_pp[j];
+            }
+        }
+        if (k == i) {
+            continue;
+        }
+        status = oes_router_lpm6_node_build(acct_p, &rule_list_pp[i], k - i, depth + 8,
+                                            (struct oes_router_lpm6_node **)&node_p->slots[node_p->child_cnt]);
+        if (status != OES_STATUS_SUCCESS) {
+            /* results sit after all the children, only the built ones are freed */
+            for (i = 0; i < node_p->child_cnt; i++) {
+                oes_router_lpm6_node_destroy(acct_p, node_p->slots[i]);
+            }
+            acct_p->node_bytes -= oes_router_lpm6_node_size(child_cnt, result_cnt);
+            acct_p->node_cnt--;
+            oes_router_pool_free(acct_p->pool, node_p, oes_router_lpm6_node_size(child_cnt, result_cnt));
+            return status;
+        }
+        node_p->child_cnt++;
+    }
+    /* a whole subtree, linked once built */
+    __atomic_store_n(node_pp, node_p, __ATOMIC_RELEASE);
+    return OES_STATUS_SUCCESS;
+}
+
+static void
+oes_router_lpm6_bulk_part(void *ctx_p, const unsigned int part)
+{
+    struct oes_router_lpm6_bulk *bulk_p = ctx_p;
+    struct oes_router_lpm6_rule **rule_list_pp;
+    struct oes_router_lpm6 acct = *bulk_p->lpm_p;
+    unsigned int idx, cnt, i, last;
+
+    /* nodes are accounted apart and summed once the partition is done */
+    acct.node_bytes = 0;
+    acct.node_cnt = 0;
+    for (idx = part * (OES_ROUTER_LPM6_DIRECT_CNT / OES_ROUTER_LPM6_BULK_PARTS);
+         idx < (part + 1) * (OES_ROUTER_LPM6_DIRECT_CNT / OES_ROUTER_LPM6_BULK_PARTS); idx++) {
+        rule_list_pp = &bulk_p->order[bulk_p->start[idx]];
+        cnt = bulk_p->start[idx + 1] - bulk_p->start[idx];
+        if (cnt == 0) {
+            continue;
+        }
+        if ((acct.direct[idx].node == NULL) && (cnt > 1)) {
+            qsort(rule_list_pp, cnt, sizeof(*rule_list_pp), oes_router_lpm6_rule_cmp);
+            /* the last of equal prefixes wins, as with single adds */
+            for (i = 1, last = 0; i < cnt; i++) {
+                if (oes_router_lpm6_rule_cmp(&rule_list_pp[last], &rule_list_pp[i]) == 0) {
+                    rule_list_pp[last]->value = rule_list_pp[i]->value;
+                } else {
+                    rule_list_pp[++last] = rule_list_pp[i];
+                }
+            }
+            oes_router_lpm6_direct_written(&acct, idx);
+            if (oes_router_lpm6_node_build(&acct, rule_list_pp, last + 1, OES_ROUTER_LPM6_DIRECT_BITS,
+                                           &acct.direct[idx].node) == OES_STATUS_SUCCESS) {
+                continue;
+            }
+            /* out of memory, what single adds can still do */
+            cnt = last + 1;
+        }
+        for (i = 0; i < cnt; i++) {
+            if (oes_router_lpm6_add(&acct, &rule_list_pp[i]->addr, rule_list_pp[i]->depth,
+                                    rule_list_pp[i]->value) != OES_STATUS_SUCCESS) {
+                rule_list_pp[i]->failed = 1;
+                __atomic_store_n(&bulk_p->failed, 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+    __atomic_fetch_add(&bulk_p->lpm_p->node_bytes, acct.node_bytes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&bulk_p->lpm_p->node_cnt, acct.node_cnt, __ATOMIC_RELAXED);
+}
+
+/**
+ * This function adds a list of prefixes at once. Prefixes longer
+ * than /16 are spread over the threads by direct entry. The tree
+ * of an entry without one is built bottom up from its sorted
+ * prefixes, each node allocated once at its final size, instead
+ * of being copied on every insert. A small LPM takes them one by
+ * one.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in,out] rule_list_p - prefixes, failed is set on the
+ *       ones left out
+ * @param[in] cnt - list size
+ * @param[in] thread_cnt - thread count
+ *
+ * @return OES_STATUS_SUCCESS if all prefixes were added
+ * @return OES_STATUS_NO_MEMORY if the work lists or some nodes
+ *         cannot be allocated
+ */
+oes_status_e
+oes_router_lpm6_add_bulk(struct oes_router_lpm6 *lpm_p,
+                         struct oes_router_lpm6_rule *rule_list_p,
+                         const unsigned int cnt,
+                         const unsigned int thread_cnt)
+{
+    struct oes_router_lpm6_bulk bulk;
+    struct oes_router_lpm6_rule *rule_p;
+    unsigned int i, idx, *fill_p;
+    int failed = 0;
+
+    if (lpm_p->direct == NULL) {
+        for (i = 0; i < cnt; i++) {
+            rule_p = &rule_list_p[i];
+            rule_p->failed = (oes_router_lpm6_add(lpm_p, &rule_p->addr, rule_p->depth, rule_p->value) !=
+                              OES_STATUS_SUCCESS);
+            failed |= rule_p->failed;
+        }
+        return failed ? OES_STATUS_NO_MEMORY : OES_STATUS_SUCCESS;
+    }
+
+    memset(&bulk, 0, sizeof(bulk));
+    bulk.lpm_p = lpm_p;
+    bulk.order = malloc((cnt ? cnt : 1) * sizeof(*bulk.order));
+    bulk.start = calloc(OES_ROUTER_LPM6_DIRECT_CNT + 1, sizeof(*bulk.start));
+    fill_p = malloc(OES_ROUTER_LPM6_DIRECT_CNT * sizeof(*fill_p));
+    if ((bulk.order == NULL) || (bulk.start == NULL) || (fill_p == NULL)) {
+        free(bulk.order);
+        free(bulk.start);
+        free(fill_p);
+        for (i = 0; i < cnt; i++) {
+            rule_list_p[i].failed = 1;
+        }
+        return OES_STATUS_NO_MEMORY;
+    }
+    /* counting sort by direct entry */
+    for (i = 0; i < cnt; i++) {
+        rule_p = &rule_list_p[i];
+        rule_p->failed = 0;
+        if (rule_p->depth > OES_ROUTER_LPM6_DIRECT_BITS) {
+            bulk.start[((rule_p->addr.s6_addr[0] << 8) | rule_p->addr.s6_addr[1]) + 1]++;
+        } else {
+            oes_router_lpm6_add(lpm_p, &rule_p->addr, rule_p->depth, rule_p->value);
+        }
+    }
+    for (idx = 0; idx < OES_ROUTER_LPM6_DIRECT_CNT; idx++) {
+        bulk.start[idx + 1] += bulk.start[idx];
+        fill_p[idx] = bulk.start[idx];
+    }
+    for (i = 0; i < cnt; i++) {
+        rule_p = &rule_list_p[i];
+        if (rule_p->depth > OES_ROUTER_LPM6_DIRECT_BITS) {
+            bulk.order[fill_p[(rule_p->addr.s6_addr[0] << 8) | rule_p->addr.s6_addr[1]]++] = rule_p;
+        }
+    }
+    free(fill_p);
+
+    oes_router_bulk_run(thread_cnt, OES_ROUTER_LPM6_BULK_PARTS, oes_router_lpm6_bulk_part, &bulk);
+    free(bulk.order);
+    free(bulk.start);
+    return bulk.failed ? OES_STATUS_NO_MEMORY : OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function looks up a list of addresses. The lookups walk
+ * the tree level by level together, each one prefetching its next
+ * node while the others are processed.
+ *
+ * @param[in] lpm_p - LPM
+ * @param[in] addr_list_p - addresses
+ * @param[in] cnt - list size, up to OES_ROUTER_LPM_BULK_MAX
+ * @param[out] depth_list_p - matched prefix lengths
+ * @param[out] value_list_p - matched values
+ */
+void
+oes_router_lpm6_lookup_bulk(const struct oes_router_lpm6 *lpm_p,
+                            const struct in6_addr * const *addr_list_p,
+                            const unsigned int cnt,
+                            unsigned char *depth_list_p,
+                            unsigned int *value_list_p)
+{
+    const struct oes_router_lpm6_direct *direct_list[OES_ROUTER_LPM_BULK_MAX];
+    const struct oes_router_lpm6_node *node_list[OES_ROUTER_LPM_BULK_MAX];
+    const struct oes_router_lpm6_node *best_list[OES_ROUTER_LPM_BULK_MAX];
+    unsigned short best_pos_list[OES_ROUTER_LPM_BULK_MAX];
+    const struct oes_router_lpm6_node *node_p, *root_p;
+    const struct oes_router_lpm6_direct *direct_p;
+    unsigned int i, r, pos, byte, depth, active;
+    unsigned int entry;
+
+    /* the root is cleared after the direct table is published */
+    root_p = __atomic_load_n(&lpm_p->root, __ATOMIC_ACQUIRE);
+    direct_p = __atomic_load_n(&lpm_p->direct, __ATOMIC_ACQUIRE);
+    for (i = 0; (direct_p != NULL) && (i < cnt); i++) {
+        direct_list[i] = &direct_p[(addr_list_p[i]->s6_addr[0] << 8) | addr_list_p[i]->s6_addr[1]];
+        __builtin_prefetch(direct_list[i]);
+    }
+    active = 0;
+    for (i = 0; i < cnt; i++) {
+        node_list[i] = (direct_p != NULL) ? __atomic_load_n(&direct_list[i]->node, __ATOMIC_ACQUIRE) : root_p;
+        best_list[i] = NULL;
+        if (node_list[i] != NULL) {
+            __builtin_prefetch(node_list[i]);
+            active++;
+        }
+    }
+
+    for (depth = (direct_p != NULL) ? OES_ROUTER_LPM6_DIRECT_BITS : 0; active; depth += 8) {
+        active = 0;
+        for (i = 0; i < cnt; i++) {
+            node_p = node_list[i];
+            if (node_p == NULL) {
+                continue;
+            }
+            byte = addr_list_p[i]->s6_addr[depth / 8];
+            for (r = node_p->result_cnt ? 8 : 0; r > 0; r--) {
+                pos = (1 << r) - 2 + (byte >> (8 - r));
+                if (oes_router_lpm6_bit(node_p->internal, pos)) {
+                    best_list[i] = node_p;
+                    best_pos_list[i] = pos;
+                    depth_list_p[i] = depth + r;
+                    break;
+                }
+            }
+            if ((depth == 120) || !oes_router_lpm6_bit(node_p->external, byte)) {
+                node_list[i] = NULL;
+                continue;
+            }
+            node_list[i] = __atomic_load_n(&node_p->slots[oes_router_lpm6_rank(node_p->external, byte)],
+                                           __ATOMIC_ACQUIRE);
+            __builtin_prefetch(node_list[i]);
+            active++;
+        }
+    }
+
+    for (i = 0; i < cnt; i++) {
+        node_p = best_list[i];
+        if (node_p != NULL) {
+            value_list_p[i] = __atomic_load_n(&((const unsigned int *)&node_p->slots[node_p->child_cnt])
+                                              [oes_router_lpm6_rank(node_p->internal, best_pos_list[i])],
+                                              __ATOMIC_RELAXED);
+            continue;
+        }
+        entry = (direct_p != NULL) ? __atomic_load_n(&direct_list[i]->entry, __ATOMIC_RELAXED) : 0;
+        if (entry) {
+            depth_list_p[i] = entry >> OES_ROUTER_LPM4_DEPTH_SHIFT;
+            value_list_p[i] = entry & OES_ROUTER_LPM4_VALUE_MASK;
+        } else if (__atomic_load_n(&lpm_p->default_valid, __ATOMIC_ACQUIRE)) {
+            depth_list_p[i] = 0;
+            value_list_p[i] = __atomic_load_n(&lpm_p->default_value, __ATOMIC_RELAXED);
+        } else {
+            depth_list_p[i] = OES_ROUTER_LPM_MISS;
+        }
+    }
+}
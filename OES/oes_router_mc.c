@@ -0,0 +1,679 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_router.h"
+
+#define OES_ROUTER_MC_TABLE_MIN 64
+#define OES_ROUTER_MC_RIF_MAX   0xffff
+
+static unsigned int
+oes_router_mc_mix(unsigned int hash, const unsigned int word)
+{
+    hash ^= word;
+    hash *= 0x85ebca6b;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static unsigned int
+oes_router_mc_addr_mix(unsigned int hash, const struct oes_ip_addr *addr_p)
+{
+    unsigned int words[4], i;
+
+    if (addr_p->version == OES_IPV4) {
+        return oes_router_mc_mix(hash, addr_p->addr.ipv4.s_addr);
+    }
+    memcpy(words, &addr_p->addr.ipv6, sizeof(words));
+    for (i = 0; i < 4; i++) {
+        hash = oes_router_mc_mix(hash, words[i]);
+    }
+    return hash;
+}
+
+static unsigned int
+oes_router_mc_hash(const struct oes_router_mc_key *key_p)
+{
+    unsigned int hash = oes_router_mc_addr_mix(key_p->group.version, &key_p->group);
+
+    hash = oes_router_mc_addr_mix(hash, &key_p->source);
+    return oes_router_mc_mix(hash, key_p->ingress_rif);
+}
+
+static int
+oes_router_mc_key_cmp(const struct oes_router_mc_key *a_p, const struct oes_router_mc_key *b_p)
+{
+    int cmp = oes_router_ip_addr_cmp(&a_p->group, &b_p->group);
+
+    if (cmp == 0) {
+        cmp = oes_router_ip_addr_cmp(&a_p->source, &b_p->source);
+    }
+    if ((cmp == 0) && (a_p->ingress_rif != b_p->ingress_rif)) {
+        cmp = (a_p->ingress_rif < b_p->ingress_rif) ? -1 : 1;
+    }
+    return cmp;
+}
+
+/* the (*,G) key of a packet, of its ingress interface or of any */
+static void
+oes_router_mc_any_key(const struct oes_router_mc_key *key_p,
+                      const unsigned int ingress_rif,
+                      struct oes_router_mc_key *any_key_p)
+{
+    any_key_p->group = key_p->group;
+    memset(&any_key_p->source, 0, sizeof(any_key_p->source));
+    any_key_p->source.version = key_p->group.version;
+    any_key_p->ingress_rif = ingress_rif;
+}
+
+static struct oes_router_mc_route *
+oes_router_mc_chain_find(const struct oes_router_mc_table *table_p,
+                         unsigned int next,
+                         const struct oes_router_mc_key *key_p,
+                         const unsigned int hash)
+{
+    for (; next; next = table_p->routes[next - 1].hash_next) {
+        if ((table_p->routes[next - 1].hash == hash) &&
+            (oes_router_mc_key_cmp(&table_p->routes[next - 1].key, key_p) == 0)) {
+            return &table_p->routes[next - 1];
+        }
+    }
+    return NULL;
+}
+
+static void
+oes_router_mc_hash_link(struct oes_router_mc_table *table_p, const unsigned int idx)
+{
+    struct oes_router_mc_route *route_p = &table_p->routes[idx];
+    unsigned int bucket = route_p->hash & (table_p->hash_size - 1);
+
+    route_p->hash_next = table_p->hash[bucket];
+    table_p->hash[bucket] = idx + 1;
+}
+
+static void
+oes_router_mc_hash_unlink(struct oes_router_mc_table *table_p, const unsigned int idx)
+{
+    struct oes_router_mc_route *route_p = &table_p->routes[idx];
+    unsigned int *next_p = &table_p->hash[route_p->hash & (table_p->hash_size - 1)];
+
+    while (*next_p != idx + 1) {
+        next_p = &table_p->routes[*next_p - 1].hash_next;
+    }
+    *next_p = route_p->hash_next;
+}
+
+/*
+ * Grows the route array and the hash together, the hash keeps
+ * one chain per route slot.
+ */
+static oes_status_e
+oes_router_mc_table_grow(struct oes_router_mc_table *table_p)
+{
+    unsigned int size = table_p->route_size ? table_p->route_size * 2 : OES_ROUTER_MC_TABLE_MIN;
+    struct oes_router_mc_route *routes_p;
+    unsigned int *hash_p, idx;
+
+    hash_p = oes_router_pool_calloc(table_p->pool, size, sizeof(*hash_p));
+    if (hash_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    routes_p = oes_router_pool_realloc(table_p->pool, table_p->routes, table_p->route_size * sizeof(*routes_p),
+                                       size * sizeof(*routes_p));
+    if (routes_p == NULL) {
+        oes_router_pool_free(table_p->pool, hash_p, size * sizeof(*hash_p));
+        return OES_STATUS_NO_MEMORY;
+    }
+    memset(&routes_p[table_p->route_size], 0, (size - table_p->route_size) * sizeof(*routes_p));
+    table_p->routes = routes_p;
+    oes_router_pool_free(table_p->pool, table_p->hash, table_p->hash_size * sizeof(*table_p->hash));
+    table_p->hash = hash_p;
+    table_p->hash_size = size;
+    for (idx = 0; idx < table_p->route_size; idx++) {
+        if (routes_p[idx].in_use) {
+            oes_router_mc_hash_link(table_p, idx);
+        }
+    }
+    for (idx = size; idx > table_p->route_size; idx--) {
+        routes_p[idx - 1].hash_next = table_p->route_free;
+        table_p->route_free = idx;
+    }
+    table_p->route_size = size;
+    return OES_STATUS_SUCCESS;
+}
+
+static unsigned int
+oes_router_mc_rifs_hash(const unsigned int *rif_list_p, const unsigned int rif_cnt)
+{
+    unsigned int hash = rif_cnt, i;
+
+    for (i = 0; i < rif_cnt; i++) {
+        hash = oes_router_mc_mix(hash, rif_list_p[i]);
+    }
+    return hash;
+}
+
+static oes_status_e
+oes_router_mc_rifs_hash_grow(struct oes_router_mc_table *table_p)
+{
+    unsigned int size = table_p->rifs_hash_size ? table_p->rifs_hash_size * 2 : OES_ROUTER_MC_TABLE_MIN;
+    struct oes_router_mc_rifs **hash_p, *rifs_p, *next_p;
+    unsigned int idx, bucket;
+
+    hash_p = oes_router_pool_calloc(table_p->pool, size, sizeof(*hash_p));
+    if (hash_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    for (idx = 0; idx < table_p->rifs_hash_size; idx++) {
+        for (rifs_p = table_p->rifs_hash[idx]; rifs_p != NULL; rifs_p = next_p) {
+            next_p = rifs_p->hash_next;
+            bucket = rifs_p->hash & (size - 1);
+            rifs_p->hash_next = hash_p[bucket];
+            hash_p[bucket] = rifs_p;
+        }
+    }
+    oes_router_pool_free(table_p->pool, table_p->rifs_hash, table_p->rifs_hash_size * sizeof(*table_p->rifs_hash));
+    table_p->rifs_hash = hash_p;
+    table_p->rifs_hash_size = size;
+    return OES_STATUS_SUCCESS;
+}
+
+/*
+ * Takes a hold on the interned list of interfaces, sorted and
+ * without duplicates, interning it if no route holds it yet.
+ * The empty list is NULL.
+ */
+static oes_status_e
+oes_router_mc_rifs_get(struct oes_router_mc_table *table_p,
+                       const unsigned int *rif_list_p,
+                       const unsigned int rif_cnt,
+                       struct oes_router_mc_rifs **rifs_pp)
+{
+    unsigned int hash = oes_router_mc_rifs_hash(rif_list_p, rif_cnt);
+    struct oes_router_mc_rifs *rifs_p;
+    unsigned int bucket;
+
+    *rifs_pp = NULL;
+    if (rif_cnt == 0) {
+        return OES_STATUS_SUCCESS;
+    }
+    for (rifs_p = table_p->rifs_hash_size ? table_p->rifs_hash[hash & (table_p->rifs_hash_size - 1)] : NULL;
+         rifs_p != NULL; rifs_p = rifs_p->hash_next) {
+        if ((rifs_p->hash == hash) && (rifs_p->rif_cnt == rif_cnt) &&
+            (memcmp(rifs_p->rif_list, rif_list_p, rif_cnt * sizeof(*rif_list_p)) == 0)) {
+            rifs_p->ref_cnt++;
+            *rifs_pp = rifs_p;
+            return OES_STATUS_SUCCESS;
+        }
+    }
+    if ((table_p->rifs_cnt >= table_p->rifs_hash_size) &&
+        (oes_router_mc_rifs_hash_grow(table_p) != OES_STATUS_SUCCESS)) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    rifs_p = oes_router_pool_alloc(table_p->pool, sizeof(*rifs_p) + rif_cnt * sizeof(*rif_list_p));
+    if (rifs_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    rifs_p->hash = hash;
+    rifs_p->ref_cnt = 1;
+    rifs_p->rif_cnt = rif_cnt;
+    memcpy(rifs_p->rif_list, rif_list_p, rif_cnt * sizeof(*rif_list_p));
+    bucket = hash & (table_p->rifs_hash_size - 1);
+    rifs_p->hash_next = table_p->rifs_hash[bucket];
+    table_p->rifs_hash[bucket] = rifs_p;
+    table_p->rifs_cnt++;
+    *rifs_pp = rifs_p;
+    return OES_STATUS_SUCCESS;
+}
+
+/* drops a hold on an interned list, freeing it with the last one */
+static void
+oes_router_mc_rifs_put(struct oes_router_mc_table *table_p, struct oes_router_mc_rifs *rifs_p)
+{
+    struct oes_router_mc_rifs **next_pp;
+
+    if ((rifs_p == NULL) || --rifs_p->ref_cnt) {
+        return;
+    }
+    next_pp = &table_p->rifs_hash[rifs_p->hash & (table_p->rifs_hash_size - 1)];
+    while (*next_pp != rifs_p) {
+        next_pp = &(*next_pp)->hash_next;
+    }
+    *next_pp = rifs_p->hash_next;
+    oes_router_pool_free(table_p->pool, rifs_p, sizeof(*rifs_p) + rifs_p->rif_cnt * sizeof(rifs_p->rif_list[0]));
+    table_p->rifs_cnt--;
+}
+
+/* makes the route hold the list it changes to */
+static oes_status_e
+oes_router_mc_rifs_replace(struct oes_router_mc_table *table_p,
+                           struct oes_router_mc_route *route_p,
+                           const unsigned int *rif_list_p,
+                           const unsigned int rif_cnt)
+{
+    struct oes_router_mc_rifs *rifs_p;
+    oes_status_e status;
+
+    if (rif_cnt > OES_ROUTER_MC_RIF_MAX) {
+        return OES_STATUS_PARAM_EXCEEDS_RANGE;
+    }
+    status = oes_router_mc_rifs_get(table_p, rif_list_p, rif_cnt, &rifs_p);
+    if (status != OES_STATUS_SUCCESS) {
+        return status;
+    }
+    oes_router_mc_rifs_put(table_p, route_p->rifs);
+    route_p->rifs = rifs_p;
+    return OES_STATUS_SUCCESS;
+}
+
+static int
+oes_router_mc_rif_cmp(const void *a_p, const void *b_p)
+{
+    unsigned int a = *(const unsigned int *)a_p, b = *(const unsigned int *)b_p;
+
+    return (a > b) - (a < b);
+}
+
+/* a copy of a list of interfaces, sorted and without duplicates */
+static unsigned int *
+oes_router_mc_rifs_sorted(const unsigned int *rif_list_p, const unsigned int rif_cnt,
+                          const unsigned int extra, unsigned int *cnt_p)
+{
+    unsigned int *list_p, cnt = 0, i;
+
+    list_p = malloc((rif_cnt + extra + 1) * sizeof(*list_p));
+    if (list_p == NULL) {
+        return NULL;
+    }
+    memcpy(list_p, rif_list_p, rif_cnt * sizeof(*list_p));
+    qsort(list_p, rif_cnt, sizeof(*list_p), oes_router_mc_rif_cmp);
+    for (i = 0; i < rif_cnt; i++) {
+        if ((cnt == 0) || (list_p[cnt - 1] != list_p[i])) {
+            list_p[cnt++] = list_p[i];
+        }
+    }
+    *cnt_p = cnt;
+    return list_p;
+}
+
+/**
+ * This function sets up an empty table.
+ *
+ * @param[out] table_p - multicast route table
+ * @param[in] pool_p - pool the routes are allocated from
+ */
+void
+oes_router_mc_table_init(struct oes_router_mc_table *table_p, struct oes_router_pool *pool_p)
+{
+    memset(table_p, 0, sizeof(*table_p));
+    table_p->pool = pool_p;
+}
+
+/**
+ * This function frees all the routes of a table at once.
+ *
+ * @param[in] table_p - multicast route table
+ */
+void
+oes_router_mc_table_deinit(struct oes_router_mc_table *table_p)
+{
+    struct oes_router_pool *pool_p = table_p->pool;
+    struct oes_router_mc_rifs *rifs_p, *next_p;
+    unsigned int idx;
+
+    for (idx = 0; idx < table_p->rifs_hash_size; idx++) {
+        for (rifs_p = table_p->rifs_hash[idx]; rifs_p != NULL; rifs_p = next_p) {
+            next_p = rifs_p->hash_next;
+            oes_router_pool_free(pool_p, rifs_p, sizeof(*rifs_p) + rifs_p->rif_cnt * sizeof(rifs_p->rif_list[0]));
+        }
+    }
+    oes_router_pool_free(pool_p, table_p->rifs_hash, table_p->rifs_hash_size * sizeof(*table_p->rifs_hash));
+    oes_router_pool_free(pool_p, table_p->routes, table_p->route_size * sizeof(*table_p->routes));
+    oes_router_pool_free(pool_p, table_p->hash, table_p->hash_size * sizeof(*table_p->hash));
+    oes_router_mc_table_init(table_p, pool_p);
+}
+
+/**
+ * This function returns the route of a key, NULL if there is
+ * none.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] key_p - route key
+ *
+ * @return the route
+ */
+struct oes_router_mc_route *
+oes_router_mc_find(const struct oes_router_mc_table *table_p, const struct oes_router_mc_key *key_p)
+{
+    unsigned int hash;
+
+    if (table_p->route_cnt == 0) {
+        return NULL;
+    }
+    hash = oes_router_mc_hash(key_p);
+    return oes_router_mc_chain_find(table_p, table_p->hash[hash & (table_p->hash_size - 1)], key_p, hash);
+}
+
+/* the (*,G) routes a packet falls back to */
+static const struct oes_router_mc_route *
+oes_router_mc_lookup_any(const struct oes_router_mc_table *table_p, const struct oes_router_mc_key *key_p)
+{
+    struct oes_router_mc_key any_key;
+    const struct oes_router_mc_route *route_p;
+
+    oes_router_mc_any_key(key_p, key_p->ingress_rif, &any_key);
+    route_p = oes_router_mc_find(table_p, &any_key);
+    if ((route_p == NULL) && table_p->any_rif_cnt && (key_p->ingress_rif != OES_ROUTER_INTERFACE_INVALID)) {
+        any_key.ingress_rif = OES_ROUTER_INTERFACE_INVALID;
+        route_p = oes_router_mc_find(table_p, &any_key);
+    }
+    return route_p;
+}
+
+/**
+ * This function looks up the route of a packet: its (S,G) route,
+ * else the (*,G) route of its ingress interface, else the (*,G)
+ * route of any interface.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] key_p - source, group and ingress interface of the
+ *       packet
+ *
+ * @return the route, NULL if none matches
+ */
+const struct oes_router_mc_route *
+oes_router_mc_lookup(const struct oes_router_mc_table *table_p, const struct oes_router_mc_key *key_p)
+{
+    const struct oes_router_mc_route *route_p = oes_router_mc_find(table_p, key_p);
+
+    return (route_p != NULL) ? route_p : oes_router_mc_lookup_any(table_p, key_p);
+}
+
+/**
+ * This function looks up the routes of a list of packets like
+ * oes_router_mc_lookup(). The chain heads of all of them are
+ * fetched before any chain is walked, so that the cache misses
+ * overlap.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] key_list_p - packet keys
+ * @param[in] cnt - number of keys, up to OES_ROUTER_MC_BULK_MAX
+ * @param[out] route_list_pp - routes, NULL if none matches
+ */
+void
+oes_router_mc_lookup_bulk(const struct oes_router_mc_table *table_p,
+                          const struct oes_router_mc_key *key_list_p,
+                          const unsigned int cnt,
+                          const struct oes_router_mc_route **route_list_pp)
+{
+    unsigned int hash_list[OES_ROUTER_MC_BULK_MAX], head_list[OES_ROUTER_MC_BULK_MAX], i;
+
+    if (table_p->route_cnt == 0) {
+        memset(route_list_pp, 0, cnt * sizeof(*route_list_pp));
+        return;
+    }
+    for (i = 0; i < cnt; i++) {
+        hash_list[i] = oes_router_mc_hash(&key_list_p[i]);
+        __builtin_prefetch(&table_p->hash[hash_list[i] & (table_p->hash_size - 1)]);
+    }
+    for (i = 0; i < cnt; i++) {
+        head_list[i] = table_p->hash[hash_list[i] & (table_p->hash_size - 1)];
+        if (head_list[i]) {
+            __builtin_prefetch(&table_p->routes[head_list[i] - 1]);
+        }
+    }
+    for (i = 0; i < cnt; i++) {
+        route_list_pp[i] = oes_router_mc_chain_find(table_p, head_list[i], &key_list_p[i], hash_list[i]);
+        if (route_list_pp[i] == NULL) {
+            route_list_pp[i] = oes_router_mc_lookup_any(table_p, &key_list_p[i]);
+        }
+    }
+}
+
+/**
+ * This function adds a route with a key not in the table yet,
+ * without egress interfaces. The caller sets its action.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] key_p - route key
+ * @param[out] route_pp - route
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the table cannot grow
+ */
+oes_status_e
+oes_router_mc_add(struct oes_router_mc_table *table_p,
+                  const struct oes_router_mc_key *key_p,
+                  struct oes_router_mc_route **route_pp)
+{
+    struct oes_router_mc_route *route_p;
+    oes_status_e status;
+    unsigned int idx;
+
+    if (!table_p->route_free) {
+        status = oes_router_mc_table_grow(table_p);
+        if (status != OES_STATUS_SUCCESS) {
+            return status;
+        }
+    }
+    idx = table_p->route_free - 1;
+    route_p = &table_p->routes[idx];
+    table_p->route_free = route_p->hash_next;
+    memset(route_p, 0, sizeof(*route_p));
+    route_p->key = *key_p;
+    route_p->in_use = 1;
+    route_p->hash = oes_router_mc_hash(key_p);
+    oes_router_mc_hash_link(table_p, idx);
+    table_p->route_cnt++;
+    if (key_p->ingress_rif == OES_ROUTER_INTERFACE_INVALID) {
+        table_p->any_rif_cnt++;
+    }
+    *route_pp = route_p;
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function deletes a route.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] route_p - route
+ */
+void
+oes_router_mc_delete(struct oes_router_mc_table *table_p, struct oes_router_mc_route *route_p)
+{
+    unsigned int idx = route_p - table_p->routes;
+
+    oes_router_mc_hash_unlink(table_p, idx);
+    oes_router_mc_rifs_put(table_p, route_p->rifs);
+    route_p->rifs = NULL;
+    if (route_p->key.ingress_rif == OES_ROUTER_INTERFACE_INVALID) {
+        table_p->any_rif_cnt--;
+    }
+    route_p->in_use = 0;
+    route_p->hash_next = table_p->route_free;
+    table_p->route_free = idx + 1;
+    table_p->route_cnt--;
+}
+
+/**
+ * This function sets the egress interfaces of a route, taking
+ * the interned list of them. Duplicates are dropped. The route
+ * is left as it was on failure.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] route_p - route
+ * @param[in] rif_list_p - egress interfaces, in any order
+ * @param[in] rif_cnt - number of interfaces
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_EXCEEDS_RANGE if the route would get
+ *         more than 65535 interfaces
+ * @return OES_STATUS_NO_MEMORY if the list cannot be allocated
+ */
+oes_status_e
+oes_router_mc_rifs_set(struct oes_router_mc_table *table_p,
+                       struct oes_router_mc_route *route_p,
+                       const unsigned int *rif_list_p,
+                       const unsigned int rif_cnt)
+{
+    unsigned int *list_p, cnt;
+    oes_status_e status;
+
+    list_p = oes_router_mc_rifs_sorted(rif_list_p, rif_cnt, 0, &cnt);
+    if (list_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    status = oes_router_mc_rifs_replace(table_p, route_p, list_p, cnt);
+    free(list_p);
+    return status;
+}
+
+/**
+ * This function adds egress interfaces to a route, or deletes
+ * them from it. Interfaces the route has already, or has not
+ * for a delete, are skipped. The route takes the interned list
+ * it changes to, the list it had is left to the other routes
+ * holding it.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] route_p - route
+ * @param[in] add - 1 to add, 0 to delete
+ * @param[in] rif_list_p - egress interfaces
+ * @param[in] rif_cnt - number of interfaces
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_EXCEEDS_RANGE if the route would get
+ *         more than 65535 interfaces
+ * @return OES_STATUS_NO_MEMORY if the list cannot be allocated
+ */
+oes_status_e
+oes_router_mc_rifs_update(struct oes_router_mc_table *table_p,
+                          struct oes_router_mc_route *route_p,
+                          const int add,
+                          const unsigned int *rif_list_p,
+                          const unsigned int rif_cnt)
+{
+    const unsigned int *old_p = (route_p->rifs != NULL) ? route_p->rifs->rif_list : NULL;
+    unsigned int old_cnt = oes_router_mc_rif_cnt(route_p);
+    unsigned int *list_p, *new_p, cnt, new_cnt = 0, i = 0, j = 0;
+    oes_status_e status = OES_STATUS_SUCCESS;
+
+    /* the new list is merged after the sorted changes */
+    list_p = oes_router_mc_rifs_sorted(rif_list_p, rif_cnt, old_cnt + rif_cnt, &cnt);
+    if (list_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    new_p = &list_p[rif_cnt];
+    while ((i < old_cnt) || (j < cnt)) {
+        if ((j == cnt) || ((i < old_cnt) && (old_p[i] < list_p[j]))) {
+            new_p[new_cnt++] = old_p[i++];
+        } else if ((i == old_cnt) || (list_p[j] < old_p[i])) {
+            if (add) {
+                new_p[new_cnt++] = list_p[j];
+            }
+            j++;
+        } else {
+            if (add) {
+                new_p[new_cnt++] = old_p[i];
+            }
+            i++;
+            j++;
+        }
+    }
+    /* a union or a difference of the same size is the same list */
+    if (new_cnt != old_cnt) {
+        status = oes_router_mc_rifs_replace(table_p, route_p, new_p, new_cnt);
+    }
+    free(list_p);
+    return status;
+}
+
+/**
+ * This function empties the egress interfaces of a route. It
+ * allocates nothing and cannot fail.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] route_p - route
+ */
+void
+oes_router_mc_rifs_clear(struct oes_router_mc_table *table_p, struct oes_router_mc_route *route_p)
+{
+    oes_router_mc_rifs_put(table_p, route_p->rifs);
+    route_p->rifs = NULL;
+}
+
+/**
+ * This function lists, in key order, the first routes after a
+ * key. It walks the whole table.
+ *
+ * @param[in] table_p - multicast route table
+ * @param[in] after_p - key, NULL to start from the first route
+ * @param[out] route_list_pp - routes
+ * @param[in] cnt - list size
+ *
+ * @return number of routes listed
+ */
+unsigned int
+oes_router_mc_list(const struct oes_router_mc_table *table_p,
+                   const struct oes_router_mc_key *after_p,
+                   struct oes_router_mc_route **route_list_pp,
+                   const unsigned int cnt)
+{
+    struct oes_router_mc_route *route_p;
+    unsigned int listed = 0, idx, i;
+
+    if (cnt == 0) {
+        return 0;
+    }
+    /* insertion into the list kept sorted, most routes fall past its end */
+    for (idx = 0; idx < table_p->route_size; idx++) {
+        route_p = &table_p->routes[idx];
+        if (!route_p->in_use || ((after_p != NULL) && (oes_router_mc_key_cmp(&route_p->key, after_p) <= 0))) {
+            continue;
+        }
+        if ((listed == cnt) && (oes_router_mc_key_cmp(&route_p->key, &route_list_pp[cnt - 1]->key) > 0)) {
+            continue;
+        }
+        i = (listed < cnt) ? listed++ : cnt - 1;
+        for (; (i > 0) && (oes_router_mc_key_cmp(&route_list_pp[i - 1]->key, &route_p->key) > 0); i--) {
+            route_list_pp[i] = route_list_pp[i - 1];
+        }
+        route_list_pp[i] = route_p;
+    }
+    return listed;
+}
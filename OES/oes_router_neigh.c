@@ -0,0 +1,550 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_router.h"
+
+#define OES_ROUTER_NEIGH_TABLE_MIN 64
+#define OES_ROUTER_NEIGH_DEP_MIN   4
+#define OES_ROUTER_NEIGH_WORD_BITS 64
+#define OES_ROUTER_NEIGH_BITMAPS   3
+
+static unsigned int
+oes_router_neigh_hash(const struct oes_ip_addr *addr_p)
+{
+    unsigned int hash = addr_p->version, words[4], cnt, i;
+
+    if (addr_p->version == OES_IPV4) {
+        words[0] = addr_p->addr.ipv4.s_addr;
+        cnt = 1;
+    } else {
+        memcpy(words, &addr_p->addr.ipv6, sizeof(words));
+        cnt = 4;
+    }
+    for (i = 0; i < cnt; i++) {
+        hash ^= words[i];
+        hash *= 0x85ebca6b;
+        hash ^= hash >> 13;
+        hash *= 0xc2b2ae35;
+        hash ^= hash >> 16;
+    }
+    return hash;
+}
+
+static void
+oes_router_neigh_hash_link(struct oes_router_neigh_table *table_p, const unsigned int idx)
+{
+    struct oes_router_neigh *neigh_p = &table_p->neighs[idx];
+    unsigned int bucket = neigh_p->hash & (table_p->hash_size - 1);
+
+    neigh_p->hash_next = table_p->hash[bucket];
+    table_p->hash[bucket] = idx + 1;
+}
+
+static void
+oes_router_neigh_hash_unlink(struct oes_router_neigh_table *table_p, const unsigned int idx)
+{
+    struct oes_router_neigh *neigh_p = &table_p->neighs[idx];
+    unsigned int *next_p = &table_p->hash[neigh_p->hash & (table_p->hash_size - 1)];
+
+    while (*next_p != idx + 1) {
+        next_p = &table_p->neighs[*next_p - 1].hash_next;
+    }
+    *next_p = neigh_p->hash_next;
+}
+
+static unsigned int
+oes_router_neigh_words(const unsigned int size)
+{
+    return size / OES_ROUTER_NEIGH_WORD_BITS;
+}
+
+/*
+ * Moves the traffic of the bits of a word into the bitmaps of
+ * both readers.
+ */
+static void
+oes_router_neigh_activity_latch(struct oes_router_neigh_table *table_p,
+                                const unsigned int w,
+                                const unsigned long long mask)
+{
+    unsigned long long bits;
+
+    if (!(__atomic_load_n(&table_p->activity[w], __ATOMIC_RELAXED) & mask)) {
+        return;
+    }
+    bits = __atomic_fetch_and(&table_p->activity[w], ~mask, __ATOMIC_RELAXED) & mask;
+    __atomic_fetch_or(&table_p->activity_read[w], bits, __ATOMIC_RELAXED);
+    __atomic_fetch_or(&table_p->activity_age[w], bits, __ATOMIC_RELAXED);
+}
+
+/*
+ * Grows the neighbor array, the activity bitmaps and the hash
+ * together, the hash keeps one chain per neighbor slot. The
+ * bitmaps share one allocation.
+ */
+static oes_status_e
+oes_router_neigh_table_grow(struct oes_router_neigh_table *table_p)
+{
+    unsigned int size = table_p->neigh_size ? table_p->neigh_size * 2 : OES_ROUTER_NEIGH_TABLE_MIN;
+    unsigned int words = oes_router_neigh_words(table_p->neigh_size);
+    unsigned int new_words = oes_router_neigh_words(size);
+    struct oes_router_neigh *neighs_p;
+    unsigned long long *activity_p;
+    unsigned int *hash_p, idx;
+
+    hash_p = oes_router_pool_calloc(table_p->pool, size, sizeof(*hash_p));
+    if (hash_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    activity_p = oes_router_pool_calloc(table_p->pool, OES_ROUTER_NEIGH_BITMAPS * new_words, sizeof(*activity_p));
+    if (activity_p == NULL) {
+        oes_router_pool_free(table_p->pool, hash_p, size * sizeof(*hash_p));
+        return OES_STATUS_NO_MEMORY;
+    }
+    neighs_p = oes_router_pool_realloc(table_p->pool, table_p->neighs, table_p->neigh_size * sizeof(*neighs_p),
+                                       size * sizeof(*neighs_p));
+    if (neighs_p == NULL) {
+        oes_router_pool_free(table_p->pool, hash_p, size * sizeof(*hash_p));
+        oes_router_pool_free(table_p->pool, activity_p, OES_ROUTER_NEIGH_BITMAPS * new_words * sizeof(*activity_p));
+        return OES_STATUS_NO_MEMORY;
+    }
+    memset(&neighs_p[table_p->neigh_size], 0, (size - table_p->neigh_size) * sizeof(*neighs_p));
+    table_p->neighs = neighs_p;
+    /* no lookup reads the bitmaps, the table grows under the write lock */
+    if (words) {
+        memcpy(activity_p, table_p->activity, words * sizeof(*activity_p));
+        memcpy(&activity_p[new_words], table_p->activity_read, words * sizeof(*activity_p));
+        memcpy(&activity_p[2 * new_words], table_p->activity_age, words * sizeof(*activity_p));
+    }
+    oes_router_pool_free(table_p->pool, table_p->activity, OES_ROUTER_NEIGH_BITMAPS * words * sizeof(*activity_p));
+    table_p->activity = activity_p;
+    table_p->activity_read = &activity_p[new_words];
+    table_p->activity_age = &activity_p[2 * new_words];
+    oes_router_pool_free(table_p->pool, table_p->hash, table_p->hash_size * sizeof(*table_p->hash));
+    table_p->hash = hash_p;
+    table_p->hash_size = size;
+    for (idx = 0; idx < table_p->neigh_size; idx++) {
+        if (neighs_p[idx].in_use) {
+            oes_router_neigh_hash_link(table_p, idx);
+        }
+    }
+    for (idx = size; idx > table_p->neigh_size; idx--) {
+        neighs_p[idx - 1].hash_next = table_p->neigh_free;
+        table_p->neigh_free = idx;
+    }
+    table_p->neigh_size = size;
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function sets up an empty table.
+ *
+ * @param[out] table_p - neighbor table
+ * @param[in] pool_p - pool the neighbors are allocated from
+ */
+void
+oes_router_neigh_table_init(struct oes_router_neigh_table *table_p, struct oes_router_pool *pool_p)
+{
+    memset(table_p, 0, sizeof(*table_p));
+    table_p->pool = pool_p;
+}
+
+/**
+ * This function frees all the neighbors of a table.
+ *
+ * @param[in] table_p - neighbor table
+ */
+void
+oes_router_neigh_table_deinit(struct oes_router_neigh_table *table_p)
+{
+    unsigned int idx;
+
+    for (idx = 0; idx < table_p->neigh_size; idx++) {
+        oes_router_pool_free(table_p->pool, table_p->neighs[idx].dep_list,
+                             table_p->neighs[idx].dep_size * sizeof(*table_p->neighs[idx].dep_list));
+    }
+    oes_router_pool_free(table_p->pool, table_p->neighs, table_p->neigh_size * sizeof(*table_p->neighs));
+    oes_router_pool_free(table_p->pool, table_p->hash, table_p->hash_size * sizeof(*table_p->hash));
+    oes_router_pool_free(table_p->pool, table_p->activity,
+                         OES_ROUTER_NEIGH_BITMAPS * oes_router_neigh_words(table_p->neigh_size) *
+                         sizeof(*table_p->activity));
+    memset(table_p, 0, sizeof(*table_p));
+}
+
+/**
+ * This function returns the entry of an address, resolved or
+ * not, NULL if there is none.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] addr_p - neighbor address
+ *
+ * @return the neighbor
+ */
+struct oes_router_neigh *
+oes_router_neigh_find(const struct oes_router_neigh_table *table_p, const struct oes_ip_addr *addr_p)
+{
+    unsigned int hash, next;
+
+    if (table_p->neigh_cnt == 0) {
+        return NULL;
+    }
+    hash = oes_router_neigh_hash(addr_p);
+    for (next = table_p->hash[hash & (table_p->hash_size - 1)]; next; next = table_p->neighs[next - 1].hash_next) {
+        if ((table_p->neighs[next - 1].hash == hash) &&
+            (oes_router_ip_addr_cmp(&table_p->neighs[next - 1].addr, addr_p) == 0)) {
+            return &table_p->neighs[next - 1];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * This function adds an unresolved entry with an address not in
+ * the table yet. The caller sets its data.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] addr_p - neighbor address
+ * @param[out] neigh_pp - neighbor
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the table cannot grow
+ */
+oes_status_e
+oes_router_neigh_add(struct oes_router_neigh_table *table_p,
+                     const struct oes_ip_addr *addr_p,
+                     struct oes_router_neigh **neigh_pp)
+{
+    struct oes_router_neigh *neigh_p;
+    oes_status_e status;
+    unsigned int idx;
+
+    if (!table_p->neigh_free) {
+        status = oes_router_neigh_table_grow(table_p);
+        if (status != OES_STATUS_SUCCESS) {
+            return status;
+        }
+    }
+    idx = table_p->neigh_free - 1;
+    neigh_p = &table_p->neighs[idx];
+    table_p->neigh_free = neigh_p->hash_next;
+    memset(neigh_p, 0, sizeof(*neigh_p));
+    neigh_p->addr = *addr_p;
+    neigh_p->in_use = 1;
+    neigh_p->hash = oes_router_neigh_hash(addr_p);
+    oes_router_neigh_hash_link(table_p, idx);
+    table_p->neigh_cnt++;
+    *neigh_pp = neigh_p;
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function deletes an entry, with its dependents.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ */
+void
+oes_router_neigh_delete(struct oes_router_neigh_table *table_p, struct oes_router_neigh *neigh_p)
+{
+    unsigned int idx = neigh_p - table_p->neighs;
+
+    oes_router_neigh_hash_unlink(table_p, idx);
+    oes_router_pool_free(table_p->pool, neigh_p->dep_list, neigh_p->dep_size * sizeof(*neigh_p->dep_list));
+    neigh_p->dep_list = NULL;
+    neigh_p->dep_cnt = 0;
+    neigh_p->dep_size = 0;
+    oes_router_neigh_resolved_set(table_p, neigh_p, 0);
+    neigh_p->in_use = 0;
+    neigh_p->hash_next = table_p->neigh_free;
+    table_p->neigh_free = idx + 1;
+    table_p->neigh_cnt--;
+}
+
+/**
+ * This function marks an entry resolved or not. An unresolved
+ * entry has no activity.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ * @param[in] resolved - 1 once added as a neighbor, 0 once deleted
+ */
+void
+oes_router_neigh_resolved_set(struct oes_router_neigh_table *table_p,
+                              struct oes_router_neigh *neigh_p,
+                              const int resolved)
+{
+    unsigned int idx = neigh_p - table_p->neighs, w = idx / OES_ROUTER_NEIGH_WORD_BITS;
+    unsigned long long bit = 1ULL << (idx % OES_ROUTER_NEIGH_WORD_BITS);
+
+    if (neigh_p->resolved == resolved) {
+        return;
+    }
+    neigh_p->resolved = resolved;
+    if (resolved) {
+        table_p->resolved_cnt++;
+        return;
+    }
+    table_p->resolved_cnt--;
+    __atomic_fetch_and(&table_p->activity[w], ~bit, __ATOMIC_RELAXED);
+    __atomic_fetch_and(&table_p->activity_read[w], ~bit, __ATOMIC_RELAXED);
+    __atomic_fetch_and(&table_p->activity_age[w], ~bit, __ATOMIC_RELAXED);
+}
+
+/**
+ * This function records traffic to a neighbor. Runs under the
+ * read lock.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] idx - entry index
+ */
+void
+oes_router_neigh_activity_set(struct oes_router_neigh_table *table_p, const unsigned int idx)
+{
+    unsigned long long *word_p = &table_p->activity[idx / OES_ROUTER_NEIGH_WORD_BITS];
+    unsigned long long bit = 1ULL << (idx % OES_ROUTER_NEIGH_WORD_BITS);
+
+    /* mostly set already, the read keeps the line shared */
+    if (!table_p->neighs[idx].resolved || (__atomic_load_n(word_p, __ATOMIC_RELAXED) & bit)) {
+        return;
+    }
+    __atomic_fetch_or(word_p, bit, __ATOMIC_RELAXED);
+}
+
+/**
+ * This function returns whether a neighbor had traffic, and
+ * clears its activity if asked. Runs under the read lock.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ * @param[in] clear - clear the activity read
+ *
+ * @return 1 if the neighbor had traffic, 0 otherwise
+ */
+int
+oes_router_neigh_activity_get(struct oes_router_neigh_table *table_p,
+                              const struct oes_router_neigh *neigh_p,
+                              const int clear)
+{
+    unsigned int idx = neigh_p - table_p->neighs, w = idx / OES_ROUTER_NEIGH_WORD_BITS;
+    unsigned long long bit = 1ULL << (idx % OES_ROUTER_NEIGH_WORD_BITS);
+
+    oes_router_neigh_activity_latch(table_p, w, bit);
+    if (clear) {
+        return (__atomic_fetch_and(&table_p->activity_read[w], ~bit, __ATOMIC_RELAXED) & bit) != 0;
+    }
+    return (__atomic_load_n(&table_p->activity_read[w], __ATOMIC_RELAXED) & bit) != 0;
+}
+
+/**
+ * This function returns whether a neighbor had traffic since the
+ * aging last asked, and clears it for the aging only.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ *
+ * @return 1 if the neighbor had traffic, 0 otherwise
+ */
+int
+oes_router_neigh_activity_age(struct oes_router_neigh_table *table_p,
+                              const struct oes_router_neigh *neigh_p)
+{
+    unsigned int idx = neigh_p - table_p->neighs, w = idx / OES_ROUTER_NEIGH_WORD_BITS;
+    unsigned long long bit = 1ULL << (idx % OES_ROUTER_NEIGH_WORD_BITS);
+
+    oes_router_neigh_activity_latch(table_p, w, bit);
+    return (__atomic_fetch_and(&table_p->activity_age[w], ~bit, __ATOMIC_RELAXED) & bit) != 0;
+}
+
+/**
+ * This function lists the resolved neighbors which had traffic,
+ * or those which had none, in entry order. It scans the activity
+ * bitmap, the entries of the inactive neighbors only. The
+ * activity is cleared when all neighbors found fit in the list,
+ * traffic during the sweep is kept for the next one. Runs under
+ * the read lock.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] active - 1 for the neighbors with traffic, 0 for
+ *       those without
+ * @param[in] clear - clear the activity swept
+ * @param[out] neigh_list_pp - neighbors
+ * @param[in] cnt - list size
+ *
+ * @return number of neighbors found, the list holds up to cnt
+ */
+unsigned int
+oes_router_neigh_activity_sweep(struct oes_router_neigh_table *table_p,
+                                const int active,
+                                const int clear,
+                                struct oes_router_neigh **neigh_list_pp,
+                                const unsigned int cnt)
+{
+    unsigned int words = oes_router_neigh_words(table_p->neigh_size), found = 0, w, idx;
+    unsigned long long bits, left;
+    int clearing;
+
+    /* the count decides whether the list takes them all */
+    for (w = 0; w < words; w++) {
+        oes_router_neigh_activity_latch(table_p, w, ~0ULL);
+        found += __builtin_popcountll(__atomic_load_n(&table_p->activity_read[w], __ATOMIC_RELAXED));
+    }
+    clearing = clear && ((active ? found : table_p->resolved_cnt - found) <= cnt);
+
+    found = 0;
+    for (w = 0; w < words; w++) {
+        bits = clearing ? __atomic_exchange_n(&table_p->activity_read[w], 0, __ATOMIC_RELAXED) :
+                          __atomic_load_n(&table_p->activity_read[w], __ATOMIC_RELAXED);
+        for (left = active ? bits : ~bits; left; left &= left - 1) {
+            idx = w * OES_ROUTER_NEIGH_WORD_BITS + __builtin_ctzll(left);
+            if (!table_p->neighs[idx].resolved) {
+                continue;
+            }
+            if (found < cnt) {
+                neigh_list_pp[found] = &table_p->neighs[idx];
+            } else if (clearing && active) {
+                /* traffic since the count which the list cannot take */
+                __atomic_fetch_or(&table_p->activity_read[w], left & -left, __ATOMIC_RELAXED);
+            }
+            found++;
+        }
+    }
+    return found;
+}
+
+/**
+ * This function records a group member depending on an entry.
+ * Its position in the dependents is kept at pos_p, and updated
+ * when it moves.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ * @param[in] nhg_id - group ID
+ * @param[out] pos_p - position of the dependent
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the dependents cannot grow
+ */
+oes_status_e
+oes_router_neigh_dep_add(struct oes_router_neigh_table *table_p,
+                         struct oes_router_neigh *neigh_p,
+                         const unsigned int nhg_id,
+                         unsigned int *pos_p)
+{
+    struct oes_router_neigh_dep *dep_list_p;
+    unsigned int size;
+
+    if (neigh_p->dep_cnt == neigh_p->dep_size) {
+        size = neigh_p->dep_size ? neigh_p->dep_size * 2 : OES_ROUTER_NEIGH_DEP_MIN;
+        dep_list_p = oes_router_pool_realloc(table_p->pool, neigh_p->dep_list,
+                                             neigh_p->dep_size * sizeof(*dep_list_p), size * sizeof(*dep_list_p));
+        if (dep_list_p == NULL) {
+            return OES_STATUS_NO_MEMORY;
+        }
+        neigh_p->dep_list = dep_list_p;
+        neigh_p->dep_size = size;
+    }
+    neigh_p->dep_list[neigh_p->dep_cnt].nhg_id = nhg_id;
+    neigh_p->dep_list[neigh_p->dep_cnt].pos_p = pos_p;
+    *pos_p = neigh_p->dep_cnt++;
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function removes a dependent of an entry.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] neigh_p - neighbor
+ * @param[in] pos - position of the dependent
+ */
+void
+oes_router_neigh_dep_delete(struct oes_router_neigh_table *table_p,
+                            struct oes_router_neigh *neigh_p,
+                            const unsigned int pos)
+{
+    /* the last dependent takes the place */
+    if (pos != --neigh_p->dep_cnt) {
+        neigh_p->dep_list[pos] = neigh_p->dep_list[neigh_p->dep_cnt];
+        *neigh_p->dep_list[pos].pos_p = pos;
+    }
+    if (neigh_p->dep_cnt == 0) {
+        oes_router_pool_free(table_p->pool, neigh_p->dep_list, neigh_p->dep_size * sizeof(*neigh_p->dep_list));
+        neigh_p->dep_list = NULL;
+        neigh_p->dep_size = 0;
+    }
+}
+
+/**
+ * This function lists, in address order, the first resolved
+ * neighbors after an address. It walks the whole table.
+ *
+ * @param[in] table_p - neighbor table
+ * @param[in] after_p - address, NULL to start from the first
+ *       neighbor
+ * @param[out] neigh_list_pp - neighbors
+ * @param[in] cnt - list size
+ *
+ * @return number of neighbors listed
+ */
+unsigned int
+oes_router_neigh_list(const struct oes_router_neigh_table *table_p,
+                      const struct oes_ip_addr *after_p,
+                      struct oes_router_neigh **neigh_list_pp,
+                      const unsigned int cnt)
+{
+    struct oes_router_neigh *neigh_p;
+    unsigned int listed = 0, idx, i;
+
+    if (cnt == 0) {
+        return 0;
+    }
+    /* insertion into the list kept sorted, most neighbors fall past its end */
+    for (idx = 0; idx < table_p->neigh_size; idx++) {
+        neigh_p = &table_p->neighs[idx];
+        if (!neigh_p->resolved || ((after_p != NULL) && (oes_router_ip_addr_cmp(&neigh_p->addr, after_p) <= 0))) {
+            continue;
+        }
+        if ((listed == cnt) && (oes_router_ip_addr_cmp(&neigh_p->addr, &neigh_list_pp[cnt - 1]->addr) > 0)) {
+            continue;
+        }
+        i = (listed < cnt) ? listed++ : cnt - 1;
+        for (; (i > 0) && (oes_router_ip_addr_cmp(&neigh_list_pp[i - 1]->addr, &neigh_p->addr) > 0); i--) {
+            neigh_list_pp[i] = neigh_list_pp[i - 1];
+        }
+        neigh_list_pp[i] = neigh_p;
+    }
+    return listed;
+}
@@ -0,0 +1,716 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_router.h"
+
+#define OES_ROUTER_NHG_TABLE_MIN 64
+
+static int
+oes_router_nhg_addr_cmp(const void *a_p, const void *b_p)
+{
+    return oes_router_ip_addr_cmp(a_p, b_p);
+}
+
+/*
+ * A next-hop set holds distinct addresses of one IP version. The
+ * sort orders by version first, a mixed set differs at its ends.
+ */
+static int
+oes_router_nhg_list_valid(const struct oes_ip_addr *sorted_p, const unsigned int cnt)
+{
+    unsigned int i;
+
+    if (((sorted_p[0].version != OES_IPV4) && (sorted_p[0].version != OES_IPV6)) ||
+        (sorted_p[cnt - 1].version != sorted_p[0].version)) {
+        return 0;
+    }
+    for (i = 1; i < cnt; i++) {
+        if (oes_router_ip_addr_cmp(&sorted_p[i - 1], &sorted_p[i]) == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static unsigned int
+oes_router_nhg_hash(const struct oes_ip_addr *next_hop_list_p,
+                    const unsigned short next_hop_cnt,
+                    const unsigned short bucket_cnt,
+                    const unsigned int idle_timer)
+{
+    unsigned int hash = next_hop_cnt ^ (bucket_cnt << 16) ^ idle_timer, words[4], i, j, cnt;
+
+    for (i = 0; i < next_hop_cnt; i++) {
+        if (next_hop_list_p[i].version == OES_IPV4) {
+            words[0] = next_hop_list_p[i].addr.ipv4.s_addr;
+            cnt = 1;
+        } else {
+            memcpy(words, &next_hop_list_p[i].addr.ipv6, sizeof(words));
+            cnt = 4;
+        }
+        for (j = 0; j < cnt; j++) {
+            hash ^= words[j];
+            hash *= 0x85ebca6b;
+            hash ^= hash >> 13;
+            hash *= 0xc2b2ae35;
+            hash ^= hash >> 16;
+        }
+    }
+    return hash;
+}
+
+static int
+oes_router_nhg_equal(const struct oes_router_nhg *nhg_p,
+                     const struct oes_ip_addr *next_hop_list_p,
+                     const unsigned short next_hop_cnt,
+                     const unsigned short bucket_cnt,
+                     const unsigned int idle_timer)
+{
+    unsigned int i;
+
+    if ((nhg_p->next_hop_cnt != next_hop_cnt) || (nhg_p->bucket_cnt != bucket_cnt) ||
+        (nhg_p->idle_timer != idle_timer)) {
+        return 0;
+    }
+    for (i = 0; i < next_hop_cnt; i++) {
+        if (oes_router_ip_addr_cmp(&nhg_p->next_hop_list[i], &next_hop_list_p[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void
+oes_router_nhg_hash_link(struct oes_router_nhg_table *table_p, const unsigned int nhg_id)
+{
+    struct oes_router_nhg *nhg_p = &table_p->nhgs[nhg_id];
+    unsigned int bucket = nhg_p->hash & (table_p->hash_size - 1);
+
+    nhg_p->hash_next = table_p->hash[bucket];
+    table_p->hash[bucket] = nhg_id + 1;
+}
+
+static void
+oes_router_nhg_hash_unlink(struct oes_router_nhg_table *table_p, const unsigned int nhg_id)
+{
+    struct oes_router_nhg *nhg_p = &table_p->nhgs[nhg_id];
+    unsigned int *next_p = &table_p->hash[nhg_p->hash & (table_p->hash_size - 1)];
+
+    while (*next_p != nhg_id + 1) {
+        next_p = &table_p->nhgs[*next_p - 1].hash_next;
+    }
+    *next_p = nhg_p->hash_next;
+}
+
+/**
+ * This function returns the time of the bucket tables, in ms.
+ *
+ * @return monotonic time in ms
+ */
+unsigned long long
+oes_router_nhg_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+static unsigned long long
+oes_router_nhg_bucket(const unsigned int member, const unsigned long long now)
+{
+    return (now << OES_ROUTER_NHG_BUCKET_TIME_SHIFT) | member;
+}
+
+/* buckets a member should hold, the first ones take the remainder */
+static unsigned int
+oes_router_nhg_share(const struct oes_router_nhg *nhg_p, const unsigned int member)
+{
+    return nhg_p->bucket_cnt / nhg_p->next_hop_cnt + (member < nhg_p->bucket_cnt % nhg_p->next_hop_cnt);
+}
+
+/* first member at or after from below its share, next_hop_cnt if none */
+static unsigned int
+oes_router_nhg_underweight(const struct oes_router_nhg *nhg_p, unsigned int from)
+{
+    for (; from < nhg_p->next_hop_cnt; from++) {
+        if (__atomic_load_n(&nhg_p->occupancy[from], __ATOMIC_RELAXED) < oes_router_nhg_share(nhg_p, from)) {
+            break;
+        }
+    }
+    return from;
+}
+
+static void
+oes_router_nhg_bucket_move(struct oes_router_nhg *nhg_p,
+                           const unsigned int bucket,
+                           const unsigned int member,
+                           const unsigned long long now)
+{
+    nhg_p->occupancy[member]++;
+    nhg_p->buckets[bucket] = oes_router_nhg_bucket(member, now);
+}
+
+/*
+ * Moves the buckets of members above their share, idle for the
+ * group's idle timer, to members below it. An idle timer of 0
+ * rebalances all of them. Runs under the write lock, returns
+ * the number of buckets moved.
+ */
+static unsigned int
+oes_router_nhg_buckets_rebalance(struct oes_router_nhg *nhg_p, const unsigned long long now)
+{
+    unsigned int bucket, member, moved = 0, under = oes_router_nhg_underweight(nhg_p, 0);
+
+    for (bucket = 0; (bucket < nhg_p->bucket_cnt) && (under < nhg_p->next_hop_cnt); bucket++) {
+        member = nhg_p->buckets[bucket] & OES_ROUTER_NHG_BUCKET_MEMBER_MASK;
+        if ((nhg_p->occupancy[member] <= oes_router_nhg_share(nhg_p, member)) ||
+            (now - (nhg_p->buckets[bucket] >> OES_ROUTER_NHG_BUCKET_TIME_SHIFT) < nhg_p->idle_timer)) {
+            continue;
+        }
+        nhg_p->occupancy[member]--;
+        oes_router_nhg_bucket_move(nhg_p, bucket, under, now);
+        under = oes_router_nhg_underweight(nhg_p, under);
+        moved++;
+    }
+    return moved;
+}
+
+static oes_status_e
+oes_router_nhg_buckets_init(struct oes_router_pool *pool_p, struct oes_router_nhg *nhg_p)
+{
+    unsigned long long now = oes_router_nhg_now();
+    unsigned int bucket;
+
+    nhg_p->buckets = oes_router_pool_alloc(pool_p, nhg_p->bucket_cnt * sizeof(*nhg_p->buckets));
+    nhg_p->occupancy = oes_router_pool_calloc(pool_p, nhg_p->next_hop_cnt, sizeof(*nhg_p->occupancy));
+    if ((nhg_p->buckets == NULL) || (nhg_p->occupancy == NULL)) {
+        oes_router_pool_free(pool_p, nhg_p->buckets, nhg_p->bucket_cnt * sizeof(*nhg_p->buckets));
+        oes_router_pool_free(pool_p, nhg_p->occupancy, nhg_p->next_hop_cnt * sizeof(*nhg_p->occupancy));
+        return OES_STATUS_NO_MEMORY;
+    }
+    for (bucket = 0; bucket < nhg_p->bucket_cnt; bucket++) {
+        oes_router_nhg_bucket_move(nhg_p, bucket, bucket % nhg_p->next_hop_cnt, now);
+    }
+    return OES_STATUS_SUCCESS;
+}
+
+/*
+ * Carries the buckets over to a new member list. Buckets of the
+ * members that left go to the members below their share right
+ * away, the others move when idle.
+ */
+static oes_status_e
+oes_router_nhg_buckets_remap(struct oes_router_pool *pool_p,
+                             struct oes_router_nhg *nhg_p,
+                             const struct oes_ip_addr *list_p,
+                             const unsigned int cnt)
+{
+    unsigned int *occupancy_p, *remap_p, bucket, member, under;
+    unsigned long long now = oes_router_nhg_now();
+    const struct oes_ip_addr *found_p;
+
+    occupancy_p = oes_router_pool_calloc(pool_p, cnt, sizeof(*occupancy_p));
+    remap_p = malloc(nhg_p->next_hop_cnt * sizeof(*remap_p));
+    if ((occupancy_p == NULL) || (remap_p == NULL)) {
+        oes_router_pool_free(pool_p, occupancy_p, cnt * sizeof(*occupancy_p));
+        free(remap_p);
+        return OES_STATUS_NO_MEMORY;
+    }
+    for (member = 0; member < nhg_p->next_hop_cnt; member++) {
+        found_p = bsearch(&nhg_p->next_hop_list[member], list_p, cnt, sizeof(*list_p),
+                          oes_router_nhg_addr_cmp);
+        remap_p[member] = (found_p != NULL) ? found_p - list_p : OES_ROUTER_NHG_BUCKET_MEMBER_MASK;
+    }
+    oes_router_pool_free(pool_p, nhg_p->occupancy, nhg_p->next_hop_cnt * sizeof(*nhg_p->occupancy));
+    nhg_p->occupancy = occupancy_p;
+    nhg_p->next_hop_cnt = cnt;
+    for (bucket = 0; bucket < nhg_p->bucket_cnt; bucket++) {
+        member = remap_p[nhg_p->buckets[bucket] & OES_ROUTER_NHG_BUCKET_MEMBER_MASK];
+        nhg_p->buckets[bucket] = (nhg_p->buckets[bucket] & ~(unsigned long long)OES_ROUTER_NHG_BUCKET_MEMBER_MASK) |
+                                 member;
+        if (member != OES_ROUTER_NHG_BUCKET_MEMBER_MASK) {
+            occupancy_p[member]++;
+        }
+    }
+    under = oes_router_nhg_underweight(nhg_p, 0);
+    for (bucket = 0; bucket < nhg_p->bucket_cnt; bucket++) {
+        if ((nhg_p->buckets[bucket] & OES_ROUTER_NHG_BUCKET_MEMBER_MASK) == OES_ROUTER_NHG_BUCKET_MEMBER_MASK) {
+            oes_router_nhg_bucket_move(nhg_p, bucket, under, now);
+            under = oes_router_nhg_underweight(nhg_p, under);
+        }
+    }
+    free(remap_p);
+    oes_router_nhg_buckets_rebalance(nhg_p, now);
+    return OES_STATUS_SUCCESS;
+}
+
+static void
+oes_router_nhg_free(struct oes_router_pool *pool_p, struct oes_router_nhg *nhg_p)
+{
+    oes_router_pool_free(pool_p, nhg_p->next_hop_list, nhg_p->next_hop_cnt * sizeof(*nhg_p->next_hop_list));
+    if (nhg_p->bucket_cnt) {
+        oes_router_pool_free(pool_p, nhg_p->buckets, nhg_p->bucket_cnt * sizeof(*nhg_p->buckets));
+        oes_router_pool_free(pool_p, nhg_p->occupancy, nhg_p->next_hop_cnt * sizeof(*nhg_p->occupancy));
+    }
+}
+
+/*
+ * Grows the group array and the hash together, the hash keeps one
+ * chain per group slot. The fwd array is copied rather than
+ * resized, lookups may be reading it.
+ */
+static oes_status_e
+oes_router_nhg_table_grow(struct oes_router_nhg_table *table_p)
+{
+    unsigned int size = table_p->nhg_size ? table_p->nhg_size * 2 : OES_ROUTER_NHG_TABLE_MIN;
+    struct oes_router_nhg *nhgs_p;
+    unsigned int *hash_p, id;
+    unsigned char *fwd_p;
+
+    hash_p = oes_router_pool_calloc(table_p->pool, size, sizeof(*hash_p));
+    fwd_p = oes_router_pool_alloc(table_p->pool, size);
+    if ((hash_p == NULL) || (fwd_p == NULL)) {
+        oes_router_pool_free(table_p->pool, hash_p, size * sizeof(*hash_p));
+        oes_router_pool_free(table_p->pool, fwd_p, size);
+        return OES_STATUS_NO_MEMORY;
+    }
+    nhgs_p = oes_router_pool_realloc(table_p->pool, table_p->nhgs, table_p->nhg_size * sizeof(*nhgs_p),
+                                     size * sizeof(*nhgs_p));
+    if (nhgs_p == NULL) {
+        oes_router_pool_free(table_p->pool, hash_p, size * sizeof(*hash_p));
+        oes_router_pool_free(table_p->pool, fwd_p, size);
+        return OES_STATUS_NO_MEMORY;
+    }
+    memset(&nhgs_p[table_p->nhg_size], 0, (size - table_p->nhg_size) * sizeof(*nhgs_p));
+    table_p->nhgs = nhgs_p;
+    if (table_p->nhg_size) {
+        memcpy(fwd_p, table_p->fwd, table_p->nhg_size);
+    }
+    memset(&fwd_p[table_p->nhg_size], OES_ROUTER_ACTION_TRAP, size - table_p->nhg_size);
+    oes_router_pool_retire(table_p->pool, __atomic_exchange_n(&table_p->fwd, fwd_p, __ATOMIC_ACQ_REL),
+                           table_p->nhg_size);
+    oes_router_pool_free(table_p->pool, table_p->hash, table_p->hash_size * sizeof(*table_p->hash));
+    table_p->hash = hash_p;
+    table_p->hash_size = size;
+    for (id = 0; id < table_p->nhg_size; id++) {
+        if (nhgs_p[id].ref_cnt) {
+            oes_router_nhg_hash_link(table_p, id);
+        }
+    }
+    for (id = size; id > table_p->nhg_size; id--) {
+        nhgs_p[id - 1].hash_next = table_p->nhg_free;
+        table_p->nhg_free = id;
+    }
+    table_p->nhg_size = size;
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function sets up an empty table.
+ *
+ * @param[out] table_p - next-hop group table
+ * @param[in] pool_p - pool the groups are allocated from
+ */
+void
+oes_router_nhg_table_init(struct oes_router_nhg_table *table_p, struct oes_router_pool *pool_p)
+{
+    memset(table_p, 0, sizeof(*table_p));
+    table_p->pool = pool_p;
+}
+
+/**
+ * This function frees all the groups of a table.
+ *
+ * @param[in] table_p - next-hop group table
+ */
+void
+oes_router_nhg_table_deinit(struct oes_router_nhg_table *table_p)
+{
+    unsigned int id;
+
+    for (id = 0; id < table_p->nhg_size; id++) {
+        if (table_p->nhgs[id].ref_cnt) {
+            oes_router_nhg_free(table_p->pool, &table_p->nhgs[id]);
+        }
+    }
+    oes_router_pool_free(table_p->pool, table_p->nhgs, table_p->nhg_size * sizeof(*table_p->nhgs));
+    oes_router_pool_free(table_p->pool, table_p->hash, table_p->hash_size * sizeof(*table_p->hash));
+    oes_router_pool_free(table_p->pool, table_p->fwd, table_p->nhg_size);
+    memset(table_p, 0, sizeof(*table_p));
+}
+
+/**
+ * This function takes a reference on the group of a next-hop
+ * set, creating it when the set is new.
+ *
+ * @param[in] table_p - next-hop group table
+ * @param[in] next_hop_list_p - next hops, in any order
+ * @param[in] next_hop_cnt - number of next hops, 0 gives
+ *       OES_ROUTER_NEXT_HOP_GROUP_INVALID
+ * @param[in] bucket_cnt - resilient hashing buckets, 0 for plain
+ *       hashing
+ * @param[in] idle_timer - ms before an idle bucket moves
+ * @param[out] nhg_id_p - group ID
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_ERROR if a next hop is repeated or the
+ *         next hops mix IP versions
+ * @return OES_STATUS_NO_MEMORY if the group cannot be allocated
+ */
+oes_status_e
+oes_router_nhg_get(struct oes_router_nhg_table *table_p,
+                   const struct oes_ip_addr *next_hop_list_p,
+                   const unsigned short next_hop_cnt,
+                   const unsigned short bucket_cnt,
+                   const unsigned int idle_timer,
+                   unsigned int *nhg_id_p)
+{
+    struct oes_ip_addr *sorted_p;
+    struct oes_router_nhg *nhg_p;
+    oes_status_e status;
+    unsigned int hash, next, id;
+
+    if (next_hop_cnt == 0) {
+        *nhg_id_p = OES_ROUTER_NEXT_HOP_GROUP_INVALID;
+        return OES_STATUS_SUCCESS;
+    }
+    sorted_p = oes_router_pool_alloc(table_p->pool, next_hop_cnt * sizeof(*sorted_p));
+    if (sorted_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    memcpy(sorted_p, next_hop_list_p, next_hop_cnt * sizeof(*sorted_p));
+    qsort(sorted_p, next_hop_cnt, sizeof(*sorted_p), oes_router_nhg_addr_cmp);
+    if (!oes_router_nhg_list_valid(sorted_p, next_hop_cnt)) {
+        oes_router_pool_free(table_p->pool, sorted_p, next_hop_cnt * sizeof(*sorted_p));
+        return OES_STATUS_PARAM_ERROR;
+    }
+    hash = oes_router_nhg_hash(sorted_p, next_hop_cnt, bucket_cnt, idle_timer);
+
+    next = table_p->hash_size ? table_p->hash[hash & (table_p->hash_size - 1)] : 0;
+    while (next) {
+        nhg_p = &table_p->nhgs[next - 1];
+        if ((nhg_p->hash == hash) && oes_router_nhg_equal(nhg_p, sorted_p, next_hop_cnt, bucket_cnt, idle_timer)) {
+            nhg_p->ref_cnt++;
+            *nhg_id_p = next - 1;
+            oes_router_pool_free(table_p->pool, sorted_p, next_hop_cnt * sizeof(*sorted_p));
+            return OES_STATUS_SUCCESS;
+        }
+        next = nhg_p->hash_next;
+    }
+
+    if (!table_p->nhg_free) {
+        status = oes_router_nhg_table_grow(table_p);
+        if (status != OES_STATUS_SUCCESS) {
+            oes_router_pool_free(table_p->pool, sorted_p, next_hop_cnt * sizeof(*sorted_p));
+            return status;
+        }
+    }
+    id = table_p->nhg_free - 1;
+    nhg_p = &table_p->nhgs[id];
+    nhg_p->next_hop_cnt = next_hop_cnt;
+    nhg_p->bucket_cnt = bucket_cnt;
+    nhg_p->idle_timer = idle_timer;
+    if (bucket_cnt && (oes_router_nhg_buckets_init(table_p->pool, nhg_p) != OES_STATUS_SUCCESS)) {
+        oes_router_pool_free(table_p->pool, sorted_p, next_hop_cnt * sizeof(*sorted_p));
+        return OES_STATUS_NO_MEMORY;
+    }
+    table_p->nhg_free = nhg_p->hash_next;
+    nhg_p->ref_cnt = 1;
+    nhg_p->hash = hash;
+    nhg_p->next_hop_list = sorted_p;
+    nhg_p->resolved_cnt = 0;
+    nhg_p->deps = NULL;
+    __atomic_store_n(&table_p->fwd[id], OES_ROUTER_ACTION_TRAP, __ATOMIC_RELAXED);
+    oes_router_nhg_hash_link(table_p, id);
+    table_p->nhg_cnt++;
+    *nhg_id_p = id;
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function drops a reference on a group, freeing it with
+ * the last one.
+ *
+ * @param[in] table_p - next-hop group table
+ * @param[in] nhg_id - group ID, OES_ROUTER_NEXT_HOP_GROUP_INVALID
+ *       is ignored
+ */
+void
+oes_router_nhg_put(struct oes_router_nhg_table *table_p, const unsigned int nhg_id)
+{
+    struct oes_router_nhg *nhg_p;
+
+    if (nhg_id == OES_ROUTER_NEXT_HOP_GROUP_INVALID) {
+        return;
+    }
+    nhg_p = &table_p->nhgs[nhg_id];
+    if (--nhg_p->ref_cnt) {
+        return;
+    }
+    oes_router_nhg_hash_unlink(table_p, nhg_id);
+    oes_router_nhg_free(table_p->pool, nhg_p);
+    memset(nhg_p, 0, sizeof(*nhg_p));
+    nhg_p->hash_next = table_p->nhg_free;
+    table_p->nhg_free = nhg_id + 1;
+    table_p->nhg_cnt--;
+}
+
+/**
+ * This function returns a group in use, NULL for an invalid or
+ * free group ID.
+ *
+ * @param[in] table_p - next-hop group table
+ * @param[in] nhg_id - group ID
+ *
+ * @return the group
+ */
+struct oes_router_nhg *
+oes_router_nhg_find(const struct oes_router_nhg_table *table_p, const unsigned int nhg_id)
+{
+    if ((nhg_id >= table_p->nhg_size) || (table_p->nhgs[nhg_id].ref_cnt == 0)) {
+        return NULL;
+    }
+    return &table_p->nhgs[nhg_id];
+}
+
+/**
+ * This function sets the action the FORWARD routes of a group
+ * take from its resolved members, lookups see it at once.
+ *
+ * @param[in] table_p - next-hop group table
+ * @param[in] nhg_id - group ID
+ */
+void
+oes_router_nhg_fwd_update(struct oes_router_nhg_table *table_p, const unsigned int nhg_id)
+{
+    __atomic_store_n(&table_p->fwd[nhg_id],
+                     table_p->nhgs[nhg_id].resolved_cnt ? OES_ROUTER_ACTION_FORWARD : OES_ROUTER_ACTION_TRAP,
+                     __ATOMIC_RELAXED);
+}
+
+/**
+ * This function adds, deletes or replaces the members of a group
+ * in place. A group whose members become equal to another group's
+ * keeps its ID, new routes with that set share the older group.
+ *
+ * @param[in] table_p - next-hop group table
+ * @param[in] access_cmd - ADD/DELETE/EDIT
+ * @param[in] nhg_id - group ID
+ * @param[in] next_hop_list_p - next hops to add, delete or set
+ * @param[in] next_hop_cnt - number of next hops
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_ERROR if the group would be left empty,
+ *         with more members than buckets, with a member twice or
+ *         with members of both IP versions
+ * @return OES_STATUS_ENTRY_NOT_FOUND if a deleted next hop is not a
+ *         member
+ * @return OES_STATUS_NO_MEMORY if the list cannot be allocated
+ */
+oes_status_e
+oes_router_nhg_members_set(struct oes_router_nhg_table *table_p,
+                           const enum oes_access_cmd access_cmd,
+                           const unsigned int nhg_id,
+                           const struct oes_ip_addr *next_hop_list_p,
+                           const unsigned short next_hop_cnt)
+{
+    struct oes_router_nhg *nhg_p = oes_router_nhg_find(table_p, nhg_id);
+    struct oes_ip_addr *list_p, *members_p;
+    unsigned int cnt, old_cnt, i, j;
+
+    if (nhg_p == NULL) {
+        return OES_STATUS_ENTRY_NOT_FOUND;
+    }
+    /* remapping the buckets already updates next_hop_cnt */
+    old_cnt = nhg_p->next_hop_cnt;
+    switch (access_cmd) {
+    case OES_ACCESS_CMD_ADD:
+        cnt = nhg_p->next_hop_cnt + next_hop_cnt;
+        break;
+
+    case OES_ACCESS_CMD_DELETE:
+        cnt = nhg_p->next_hop_cnt;
+        break;
+
+    case OES_ACCESS_CMD_EDIT:
+        cnt = next_hop_cnt;
+        break;
+
+    default:
+        return OES_STATUS_CMD_UNSUPPORTED;
+    }
+    if ((cnt == 0) || (cnt > 0xffff) || (nhg_p->bucket_cnt && (cnt > nhg_p->bucket_cnt))) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    list_p = malloc(cnt * sizeof(*list_p));
+    if (list_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+
+    if (access_cmd == OES_ACCESS_CMD_DELETE) {
+        memcpy(list_p, nhg_p->next_hop_list, cnt * sizeof(*list_p));
+        for (i = 0; i < next_hop_cnt; i++) {
+            for (j = 0; j < cnt; j++) {
+                if (oes_router_ip_addr_cmp(&list_p[j], &next_hop_list_p[i]) == 0) {
+                    break;
+                }
+            }
+            if ((j == cnt) || (cnt == 1)) {
+                free(list_p);
+                return (j == cnt) ? OES_STATUS_ENTRY_NOT_FOUND : OES_STATUS_PARAM_ERROR;
+            }
+            list_p[j] = list_p[--cnt];
+        }
+    } else if (access_cmd == OES_ACCESS_CMD_ADD) {
+        memcpy(list_p, nhg_p->next_hop_list, nhg_p->next_hop_cnt * sizeof(*list_p));
+        memcpy(&list_p[nhg_p->next_hop_cnt], next_hop_list_p, next_hop_cnt * sizeof(*list_p));
+    } else {
+        memcpy(list_p, next_hop_list_p, cnt * sizeof(*list_p));
+    }
+    qsort(list_p, cnt, sizeof(*list_p), oes_router_nhg_addr_cmp);
+    if (!oes_router_nhg_list_valid(list_p, cnt)) {
+        free(list_p);
+        return OES_STATUS_PARAM_ERROR;
+    }
+    /* the pool keeps the list at its final size */
+    members_p = oes_router_pool_alloc(table_p->pool, cnt * sizeof(*members_p));
+    if (members_p == NULL) {
+        free(list_p);
+        return OES_STATUS_NO_MEMORY;
+    }
+    memcpy(members_p, list_p, cnt * sizeof(*members_p));
+    free(list_p);
+    if (nhg_p->bucket_cnt &&
+        (oes_router_nhg_buckets_remap(table_p->pool, nhg_p, members_p, cnt) != OES_STATUS_SUCCESS)) {
+        oes_router_pool_free(table_p->pool, members_p, cnt * sizeof(*members_p));
+        return OES_STATUS_NO_MEMORY;
+    }
+
+    oes_router_nhg_hash_unlink(table_p, nhg_id);
+    oes_router_pool_free(table_p->pool, nhg_p->next_hop_list, old_cnt * sizeof(*members_p));
+    nhg_p->next_hop_list = members_p;
+    nhg_p->next_hop_cnt = cnt;
+    nhg_p->hash = oes_router_nhg_hash(members_p, cnt, nhg_p->bucket_cnt, nhg_p->idle_timer);
+    oes_router_nhg_hash_link(table_p, nhg_id);
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function returns the member of a group a flow hash
+ * selects. It does not record the use of the bucket, see
+ * oes_router_nhg_bucket_use.
+ *
+ * @param[in] nhg_p - group
+ * @param[in] hash - flow hash
+ *
+ * @return index in the next-hop list
+ */
+unsigned int
+oes_router_nhg_member_select(const struct oes_router_nhg *nhg_p, const unsigned int hash)
+{
+    if (nhg_p->bucket_cnt == 0) {
+        return oes_router_ecmp_member(hash, nhg_p->next_hop_cnt);
+    }
+    return __atomic_load_n(&nhg_p->buckets[oes_router_ecmp_member(hash, nhg_p->bucket_cnt)],
+                           __ATOMIC_RELAXED) & OES_ROUTER_NHG_BUCKET_MEMBER_MASK;
+}
+
+/**
+ * This function records traffic on the bucket of a flow hash in
+ * a resilient group, which keeps the bucket on its member for
+ * the idle timer. Only the time of the bucket changes. Runs
+ * under the read lock.
+ *
+ * @param[in] nhg_p - group
+ * @param[in] hash - flow hash
+ * @param[in] now - time in ms, oes_router_nhg_now
+ */
+void
+oes_router_nhg_bucket_use(struct oes_router_nhg *nhg_p,
+                          const unsigned int hash,
+                          const unsigned long long now)
+{
+    unsigned long long *bucket_p, entry;
+
+    if (nhg_p->bucket_cnt == 0) {
+        return;
+    }
+    bucket_p = &nhg_p->buckets[oes_router_ecmp_member(hash, nhg_p->bucket_cnt)];
+    entry = __atomic_load_n(bucket_p, __ATOMIC_RELAXED);
+    /* a failed swap means another flow of the bucket refreshed it */
+    if ((entry >> OES_ROUTER_NHG_BUCKET_TIME_SHIFT) != now) {
+        __atomic_compare_exchange_n(bucket_p, &entry,
+                                    oes_router_nhg_bucket(entry & OES_ROUTER_NHG_BUCKET_MEMBER_MASK, now),
+                                    0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * This function moves the idle buckets of the members above their
+ * share to the members below it, in all the resilient groups of
+ * a table. Runs under the write lock.
+ *
+ * @param[in] table_p - next-hop group table
+ *
+ * @return number of buckets moved
+ */
+unsigned int
+oes_router_nhg_buckets_upkeep(struct oes_router_nhg_table *table_p)
+{
+    unsigned long long now = oes_router_nhg_now();
+    struct oes_router_nhg *nhg_p;
+    unsigned int id, member, moved = 0;
+
+    for (id = 0; id < table_p->nhg_size; id++) {
+        nhg_p = &table_p->nhgs[id];
+        if ((nhg_p->ref_cnt == 0) || (nhg_p->bucket_cnt == 0)) {
+            continue;
+        }
+        /* balanced groups, the common case, are left at once */
+        for (member = 0; member < nhg_p->next_hop_cnt; member++) {
+            if (nhg_p->occupancy[member] != oes_router_nhg_share(nhg_p, member)) {
+                break;
+            }
+        }
+        if (member < nhg_p->next_hop_cnt) {
+            moved += oes_router_nhg_buckets_rebalance(nhg_p, now);
+        }
+    }
+    return moved;
+}
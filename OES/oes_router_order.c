@@ -0,0 +1,367 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_router.h"
+
+#define OES_ROUTER_ORDER_FILL       (OES_ROUTER_ORDER_LEAF * 3 / 4)
+#define OES_ROUTER_ORDER_LOW        (OES_ROUTER_ORDER_LEAF / 4)
+#define OES_ROUTER_ORDER_SLOTS_MIN  16
+
+struct oes_router_order_sort {
+    struct oes_ip_prefix    key;
+    unsigned int            idx;
+};
+
+static int
+oes_router_order_cmp(const struct oes_ip_prefix *a_p, const struct oes_ip_prefix *b_p)
+{
+    int cmp = oes_router_ip_addr_cmp(&a_p->prefix, &b_p->prefix);
+
+    if ((cmp == 0) && (a_p->prefix_len != b_p->prefix_len)) {
+        cmp = (a_p->prefix_len < b_p->prefix_len) ? -1 : 1;
+    }
+    return cmp;
+}
+
+static int
+oes_router_order_sort_cmp(const void *a_p, const void *b_p)
+{
+    return oes_router_order_cmp(&((const struct oes_router_order_sort *)a_p)->key,
+                                &((const struct oes_router_order_sort *)b_p)->key);
+}
+
+static const struct oes_ip_prefix *
+oes_router_order_key(const struct oes_router_order *order_p, const unsigned int idx)
+{
+    return order_p->key_get(order_p->ctx_p, idx);
+}
+
+/* the leaf a key falls in: the last one starting at or before it, else the first */
+static unsigned int
+oes_router_order_leaf_find(const struct oes_router_order *order_p, const struct oes_ip_prefix *key_p)
+{
+    unsigned int lo = 0, hi = order_p->leaf_cnt, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (oes_router_order_cmp(&order_p->slots[mid].first, key_p) <= 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo ? lo - 1 : 0;
+}
+
+/* the position in a leaf of the first route from a key on, or past it */
+static unsigned int
+oes_router_order_leaf_pos(const struct oes_router_order *order_p,
+                          const struct oes_router_order_leaf *leaf_p,
+                          const struct oes_ip_prefix *key_p,
+                          const int past)
+{
+    unsigned int lo = 0, hi = leaf_p->cnt, mid;
+    int cmp;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        cmp = oes_router_order_cmp(oes_router_order_key(order_p, leaf_p->idx_list[mid]), key_p);
+        if ((cmp < 0) || (past && (cmp == 0))) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void
+oes_router_order_first_set(struct oes_router_order *order_p, const unsigned int slot)
+{
+    order_p->slots[slot].first = *oes_router_order_key(order_p, order_p->slots[slot].leaf_p->idx_list[0]);
+}
+
+/* inserts an empty leaf at a slot */
+static struct oes_router_order_leaf *
+oes_router_order_leaf_add(struct oes_router_order *order_p, const unsigned int slot)
+{
+    struct oes_router_order_slot *slots_p;
+    struct oes_router_order_leaf *leaf_p;
+    unsigned int size;
+
+    if (order_p->leaf_cnt == order_p->leaf_size) {
+        size = order_p->leaf_size ? order_p->leaf_size * 2 : OES_ROUTER_ORDER_SLOTS_MIN;
+        slots_p = oes_router_pool_realloc(order_p->pool, order_p->slots, order_p->leaf_size * sizeof(*slots_p),
+                                          size * sizeof(*slots_p));
+        if (slots_p == NULL) {
+            return NULL;
+        }
+        order_p->slots = slots_p;
+        order_p->leaf_size = size;
+    }
+    leaf_p = oes_router_pool_alloc(order_p->pool, sizeof(*leaf_p));
+    if (leaf_p == NULL) {
+        return NULL;
+    }
+    leaf_p->cnt = 0;
+    memmove(&order_p->slots[slot + 1], &order_p->slots[slot],
+            (order_p->leaf_cnt - slot) * sizeof(order_p->slots[0]));
+    order_p->slots[slot].leaf_p = leaf_p;
+    order_p->leaf_cnt++;
+    return leaf_p;
+}
+
+static void
+oes_router_order_leaf_del(struct oes_router_order *order_p, const unsigned int slot)
+{
+    oes_router_pool_free(order_p->pool, order_p->slots[slot].leaf_p, sizeof(struct oes_router_order_leaf));
+    memmove(&order_p->slots[slot], &order_p->slots[slot + 1],
+            (order_p->leaf_cnt - slot - 1) * sizeof(order_p->slots[0]));
+    order_p->leaf_cnt--;
+}
+
+/**
+ * This function sets up an empty order.
+ *
+ * @param[out] order_p - route order
+ * @param[in] pool_p - pool the leaves are allocated from
+ * @param[in] key_get - returns the key of a route index
+ * @param[in] ctx_p - key_get context
+ */
+void
+oes_router_order_init(struct oes_router_order *order_p,
+                      struct oes_router_pool *pool_p,
+                      const struct oes_ip_prefix *(*key_get)(const void *ctx_p, const unsigned int idx),
+                      const void *ctx_p)
+{
+    memset(order_p, 0, sizeof(*order_p));
+    order_p->pool = pool_p;
+    order_p->key_get = key_get;
+    order_p->ctx_p = ctx_p;
+}
+
+/**
+ * This function frees all the leaves of an order.
+ *
+ * @param[in] order_p - route order
+ */
+void
+oes_router_order_deinit(struct oes_router_order *order_p)
+{
+    unsigned int slot;
+
+    for (slot = 0; slot < order_p->leaf_cnt; slot++) {
+        oes_router_pool_free(order_p->pool, order_p->slots[slot].leaf_p, sizeof(struct oes_router_order_leaf));
+    }
+    oes_router_pool_free(order_p->pool, order_p->slots, order_p->leaf_size * sizeof(*order_p->slots));
+    oes_router_order_init(order_p, order_p->pool, order_p->key_get, order_p->ctx_p);
+}
+
+/**
+ * This function builds an empty order from a list of routes, in
+ * any order, sorting them once. Leaves are filled to three
+ * quarters, leaving room for the routes added next.
+ *
+ * @param[in] order_p - route order, empty
+ * @param[in] idx_list_p - route indexes
+ * @param[in] cnt - number of routes
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the order cannot be allocated
+ */
+oes_status_e
+oes_router_order_build(struct oes_router_order *order_p, const unsigned int *idx_list_p, const unsigned int cnt)
+{
+    struct oes_router_order_sort *sort_list_p;
+    struct oes_router_order_leaf *leaf_p = NULL;
+    unsigned int i;
+
+    sort_list_p = malloc((cnt ? cnt : 1) * sizeof(*sort_list_p));
+    if (sort_list_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    for (i = 0; i < cnt; i++) {
+        sort_list_p[i].key = *oes_router_order_key(order_p, idx_list_p[i]);
+        sort_list_p[i].idx = idx_list_p[i];
+    }
+    qsort(sort_list_p, cnt, sizeof(*sort_list_p), oes_router_order_sort_cmp);
+    for (i = 0; i < cnt; i++) {
+        if ((leaf_p == NULL) || (leaf_p->cnt == OES_ROUTER_ORDER_FILL)) {
+            leaf_p = oes_router_order_leaf_add(order_p, order_p->leaf_cnt);
+            if (leaf_p == NULL) {
+                free(sort_list_p);
+                oes_router_order_deinit(order_p);
+                return OES_STATUS_NO_MEMORY;
+            }
+            order_p->slots[order_p->leaf_cnt - 1].first = sort_list_p[i].key;
+        }
+        leaf_p->idx_list[leaf_p->cnt++] = sort_list_p[i].idx;
+    }
+    order_p->cnt = cnt;
+    free(sort_list_p);
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function adds a route to an order, its key set already.
+ *
+ * @param[in] order_p - route order
+ * @param[in] idx - route index
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if a leaf cannot be split
+ */
+oes_status_e
+oes_router_order_insert(struct oes_router_order *order_p, const unsigned int idx)
+{
+    const struct oes_ip_prefix *key_p = oes_router_order_key(order_p, idx);
+    struct oes_router_order_leaf *leaf_p, *next_p;
+    unsigned int slot, pos, half = OES_ROUTER_ORDER_LEAF / 2;
+
+    if ((order_p->leaf_cnt == 0) && (oes_router_order_leaf_add(order_p, 0) == NULL)) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    slot = oes_router_order_leaf_find(order_p, key_p);
+    leaf_p = order_p->slots[slot].leaf_p;
+    pos = oes_router_order_leaf_pos(order_p, leaf_p, key_p, 0);
+    if (leaf_p->cnt == OES_ROUTER_ORDER_LEAF) {
+        next_p = oes_router_order_leaf_add(order_p, slot + 1);
+        if (next_p == NULL) {
+            return OES_STATUS_NO_MEMORY;
+        }
+        memcpy(next_p->idx_list, &leaf_p->idx_list[half], (OES_ROUTER_ORDER_LEAF - half) * sizeof(unsigned int));
+        next_p->cnt = OES_ROUTER_ORDER_LEAF - half;
+        leaf_p->cnt = half;
+        oes_router_order_first_set(order_p, slot + 1);
+        if (pos > half) {
+            leaf_p = next_p;
+            pos -= half;
+            slot++;
+        }
+    }
+    memmove(&leaf_p->idx_list[pos + 1], &leaf_p->idx_list[pos], (leaf_p->cnt - pos) * sizeof(unsigned int));
+    leaf_p->idx_list[pos] = idx;
+    leaf_p->cnt++;
+    if (pos == 0) {
+        oes_router_order_first_set(order_p, slot);
+    }
+    order_p->cnt++;
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function deletes a route from an order, its key still
+ * set.
+ *
+ * @param[in] order_p - route order
+ * @param[in] idx - route index
+ */
+void
+oes_router_order_remove(struct oes_router_order *order_p, const unsigned int idx)
+{
+    const struct oes_ip_prefix *key_p = oes_router_order_key(order_p, idx);
+    struct oes_router_order_leaf *leaf_p, *next_p;
+    unsigned int slot, pos;
+
+    if (order_p->leaf_cnt == 0) {
+        return;
+    }
+    slot = oes_router_order_leaf_find(order_p, key_p);
+    leaf_p = order_p->slots[slot].leaf_p;
+    pos = oes_router_order_leaf_pos(order_p, leaf_p, key_p, 0);
+    if ((pos == leaf_p->cnt) || (leaf_p->idx_list[pos] != idx)) {
+        return;
+    }
+    leaf_p->cnt--;
+    memmove(&leaf_p->idx_list[pos], &leaf_p->idx_list[pos + 1], (leaf_p->cnt - pos) * sizeof(unsigned int));
+    order_p->cnt--;
+    if (leaf_p->cnt == 0) {
+        oes_router_order_leaf_del(order_p, slot);
+        return;
+    }
+    if (pos == 0) {
+        oes_router_order_first_set(order_p, slot);
+    }
+    /* a leaf running low takes in the next one, when both fit */
+    if ((leaf_p->cnt < OES_ROUTER_ORDER_LOW) && (slot + 1 < order_p->leaf_cnt)) {
+        next_p = order_p->slots[slot + 1].leaf_p;
+        if (leaf_p->cnt + next_p->cnt <= OES_ROUTER_ORDER_FILL) {
+            memcpy(&leaf_p->idx_list[leaf_p->cnt], next_p->idx_list, next_p->cnt * sizeof(unsigned int));
+            leaf_p->cnt += next_p->cnt;
+            oes_router_order_leaf_del(order_p, slot + 1);
+        }
+    }
+}
+
+/**
+ * This function lists, in key order, the first routes after a
+ * key, which need not be a route's.
+ *
+ * @param[in] order_p - route order
+ * @param[in] after_p - key, NULL to start from the first route
+ * @param[out] idx_list_p - route indexes
+ * @param[in] cnt - list size
+ *
+ * @return number of routes listed
+ */
+unsigned int
+oes_router_order_list(const struct oes_router_order *order_p,
+                      const struct oes_ip_prefix *after_p,
+                      unsigned int *idx_list_p,
+                      const unsigned int cnt)
+{
+    const struct oes_router_order_leaf *leaf_p;
+    unsigned int listed = 0, slot = 0, pos = 0, n;
+
+    if (order_p->leaf_cnt == 0) {
+        return 0;
+    }
+    if (after_p != NULL) {
+        slot = oes_router_order_leaf_find(order_p, after_p);
+        pos = oes_router_order_leaf_pos(order_p, order_p->slots[slot].leaf_p, after_p, 1);
+    }
+    for (; (listed < cnt) && (slot < order_p->leaf_cnt); slot++, pos = 0) {
+        leaf_p = order_p->slots[slot].leaf_p;
+        n = leaf_p->cnt - pos;
+        if (n > cnt - listed) {
+            n = cnt - listed;
+        }
+        memcpy(&idx_list_p[listed], &leaf_p->idx_list[pos], n * sizeof(*idx_list_p));
+        listed += n;
+    }
+    return listed;
+}
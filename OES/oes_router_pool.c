@@ -0,0 +1,359 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_router.h"
+
+#define OES_ROUTER_POOL_RESIDENT_PAGES 4096     /* pages mincore() is asked about at once */
+
+static void
+oes_router_pool_uncharge(struct oes_router_pool *pool_p, const size_t size)
+{
+    for (; pool_p != NULL; pool_p = pool_p->parent) {
+        __atomic_sub_fetch(&pool_p->bytes, size, __ATOMIC_RELAXED);
+    }
+}
+
+/* charges the parents first, the limit of any of them fails it */
+static int
+oes_router_pool_charge(struct oes_router_pool *pool_p, const size_t size)
+{
+    unsigned long long limit, bytes, peak;
+
+    if ((pool_p->parent != NULL) && !oes_router_pool_charge(pool_p->parent, size)) {
+        return 0;
+    }
+    limit = __atomic_load_n(&pool_p->limit, __ATOMIC_RELAXED);
+    bytes = __atomic_add_fetch(&pool_p->bytes, size, __ATOMIC_RELAXED);
+    peak = __atomic_load_n(&pool_p->peak_bytes, __ATOMIC_RELAXED);
+    if (limit && (bytes > limit)) {
+        __atomic_sub_fetch(&pool_p->bytes, size, __ATOMIC_RELAXED);
+        oes_router_pool_uncharge(pool_p->parent, size);
+        return 0;
+    }
+    while ((bytes > peak) &&
+           !__atomic_compare_exchange_n(&pool_p->peak_bytes, &peak, bytes, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    return 1;
+}
+
+static void
+oes_router_pool_release(void *mem_p, const unsigned int arg)
+{
+    free(mem_p);
+}
+
+/**
+ * This function allocates memory from a pool.
+ *
+ * @param[in] pool_p - pool
+ * @param[in] size - bytes
+ *
+ * @return the memory, NULL when out of memory or past the limit
+ */
+void *
+oes_router_pool_alloc(struct oes_router_pool *pool_p, const size_t size)
+{
+    void *mem_p;
+
+    if (!oes_router_pool_charge(pool_p, size)) {
+        return NULL;
+    }
+    mem_p = malloc(size);
+    if (mem_p == NULL) {
+        oes_router_pool_uncharge(pool_p, size);
+    }
+    return mem_p;
+}
+
+/**
+ * This function allocates zeroed memory from a pool.
+ *
+ * @param[in] pool_p - pool
+ * @param[in] cnt - number of elements
+ * @param[in] size - element size
+ *
+ * @return the memory, NULL when out of memory or past the limit
+ */
+void *
+oes_router_pool_calloc(struct oes_router_pool *pool_p, const size_t cnt, const size_t size)
+{
+    void *mem_p;
+
+    if (!oes_router_pool_charge(pool_p, cnt * size)) {
+        return NULL;
+    }
+    mem_p = calloc(cnt, size);
+    if (mem_p == NULL) {
+        oes_router_pool_uncharge(pool_p, cnt * size);
+    }
+    return mem_p;
+}
+
+/**
+ * This function resizes memory of a pool. On failure the memory
+ * is left as it was.
+ *
+ * @param[in] pool_p - pool
+ * @param[in] mem_p - memory, NULL to allocate
+ * @param[in] old_size - current size
+ * @param[in] size - new size
+ *
+ * @return the memory, NULL when out of memory or past the limit
+ */
+void *
+oes_router_pool_realloc(struct oes_router_pool *pool_p,
+                        void *mem_p,
+                        const size_t old_size,
+                        const size_t size)
+{
+    void *new_p;
+
+    if ((size > old_size) && !oes_router_pool_charge(pool_p, size - old_size)) {
+        return NULL;
+    }
+    new_p = realloc(mem_p, size);
+    if (new_p == NULL) {
+        if (size > old_size) {
+            oes_router_pool_uncharge(pool_p, size - old_size);
+        }
+        return NULL;
+    }
+    if (size < old_size) {
+        oes_router_pool_uncharge(pool_p, old_size - size);
+    }
+    return new_p;
+}
+
+/**
+ * This function allocates memory from a pool aligned to a power
+ * of 2, such as a cache line. It is freed like the rest.
+ *
+ * @param[in] pool_p - pool
+ * @param[in] align - alignment, a power of 2 multiple of the
+ *       pointer size
+ * @param[in] size - bytes
+ *
+ * @return the memory, NULL when out of memory or past the limit
+ */
+void *
+oes_router_pool_alloc_aligned(struct oes_router_pool *pool_p, const size_t align, const size_t size)
+{
+    void *mem_p;
+
+    if (!oes_router_pool_charge(pool_p, size)) {
+        return NULL;
+    }
+    if (posix_memalign(&mem_p, align, size) != 0) {
+        oes_router_pool_uncharge(pool_p, size);
+        return NULL;
+    }
+    return mem_p;
+}
+
+/**
+ * This function frees memory of a pool.
+ *
+ * @param[in] pool_p - pool
+ * @param[in] mem_p - memory, NULL is ignored
+ * @param[in] size - size it was allocated with
+ */
+void
+oes_router_pool_free(struct oes_router_pool *pool_p, void *mem_p, const size_t size)
+{
+    if (mem_p == NULL) {
+        return;
+    }
+    oes_router_pool_uncharge(pool_p, size);
+    free(mem_p);
+}
+
+/**
+ * This function frees memory of a pool lookups may still read,
+ * once they are done. It stops counting at once.
+ *
+ * @param[in] pool_p - pool
+ * @param[in] mem_p - memory, NULL is ignored
+ * @param[in] size - size it was allocated with
+ */
+void
+oes_router_pool_retire(struct oes_router_pool *pool_p, void *mem_p, const size_t size)
+{
+    if (mem_p == NULL) {
+        return;
+    }
+    oes_router_pool_uncharge(pool_p, size);
+    oes_router_rcu_defer(oes_router_pool_release, mem_p, 0);
+}
+
+/**
+ * This function returns the bytes of a mapping backed by memory,
+ * the pages a table mapped with MAP_NORESERVE actually uses.
+ *
+ * @param[in] mem_p - mapping, page aligned
+ * @param[in] size - mapping size
+ *
+ * @return resident bytes
+ */
+unsigned long long
+oes_router_map_resident(const void *mem_p, const size_t size)
+{
+    unsigned char vec[OES_ROUTER_POOL_RESIDENT_PAGES];
+    size_t page_size = sysconf(_SC_PAGESIZE), page_cnt = (size + page_size - 1) / page_size, base, cnt, i;
+    unsigned long long pages = 0;
+
+    for (base = 0; base < page_cnt; base += cnt) {
+        cnt = page_cnt - base;
+        if (cnt > OES_ROUTER_POOL_RESIDENT_PAGES) {
+            cnt = OES_ROUTER_POOL_RESIDENT_PAGES;
+        }
+        if (mincore((char *)mem_p + base * page_size, cnt * page_size, vec) != 0) {
+            break;
+        }
+        for (i = 0; i < cnt; i++) {
+            pages += vec[i] & 1;
+        }
+    }
+    return pages * page_size;
+}
+
+/**
+ * This function calls page_fn on each page of a mapping its
+ * table wrote to since the page was last dropped, in address
+ * order. The others are left alone: they are not backed, or only
+ * by the zero page lookups read.
+ *
+ * @param[in] mem_p - mapping, page aligned
+ * @param[in] size - mapping size
+ * @param[in] written_p - written granules of the mapping
+ * @param[in] page_fn - called on each written page
+ * @param[in] ctx_p - passed to page_fn
+ */
+void
+oes_router_map_walk(void *mem_p,
+                    const size_t size,
+                    const unsigned long long *written_p,
+                    oes_router_map_page_fn page_fn,
+                    void *ctx_p)
+{
+    size_t page_size = sysconf(_SC_PAGESIZE), offset, granule;
+
+    for (offset = 0; offset < size; offset += page_size) {
+        for (granule = offset; (granule < offset + page_size) && (granule < size);
+             granule += OES_ROUTER_MAP_GRANULE) {
+            if (oes_router_map_written_get(written_p, granule)) {
+                page_fn(ctx_p, (char *)mem_p + offset, page_size);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * This function returns the bytes of the pages of a mapping its
+ * table wrote to, the memory it holds.
+ *
+ * @param[in] size - mapping size
+ * @param[in] written_p - written granules of the mapping
+ *
+ * @return written bytes
+ */
+unsigned long long
+oes_router_map_written_bytes(const size_t size, const unsigned long long *written_p)
+{
+    size_t page_size = sysconf(_SC_PAGESIZE), offset, granule;
+    unsigned long long bytes = 0;
+
+    for (offset = 0; offset < size; offset += page_size) {
+        for (granule = offset; (granule < offset + page_size) && (granule < size);
+             granule += OES_ROUTER_MAP_GRANULE) {
+            if (oes_router_map_written_get(written_p, granule)) {
+                bytes += page_size;
+                break;
+            }
+        }
+    }
+    return bytes;
+}
+
+/**
+ * This function gives a page of a mapping back to the system and
+ * forgets it was written. Lookups reading it see zeros.
+ *
+ * @param[in] mem_p - mapping, page aligned
+ * @param[in,out] written_p - written granules of the mapping
+ * @param[in] page_p - page
+ * @param[in] page_size - page size
+ *
+ * @return bytes given back
+ */
+unsigned long long
+oes_router_map_drop(void *mem_p, unsigned long long *written_p, void *page_p, const size_t page_size)
+{
+    size_t granule;
+
+    madvise(page_p, page_size, MADV_DONTNEED);
+    for (granule = (char *)page_p - (char *)mem_p; granule < (size_t)((char *)page_p - (char *)mem_p) + page_size;
+         granule += OES_ROUTER_MAP_GRANULE) {
+        written_p[granule / OES_ROUTER_MAP_GRANULE / 64] &= ~(1ULL << (granule / OES_ROUTER_MAP_GRANULE % 64));
+    }
+    return page_size;
+}
+
+/**
+ * This function returns whether a page of a mapping holds only
+ * zeros, the state it is dropped to by madvise(MADV_DONTNEED).
+ *
+ * @param[in] page_p - page
+ * @param[in] page_size - page size
+ *
+ * @return 1 if the page is all zeros, 0 otherwise
+ */
+int
+oes_router_map_zero(const void *page_p, const size_t page_size)
+{
+    const unsigned long long *word_p = page_p;
+    size_t                    i;
+
+    for (i = 0; i < page_size / sizeof(*word_p); i++) {
+        if (__atomic_load_n(&word_p[i], __ATOMIC_RELAXED) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
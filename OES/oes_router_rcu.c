@@ -0,0 +1,270 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <pthread.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_router.h"
+
+#define OES_ROUTER_RCU_DEFER_MIN 1024
+
+struct oes_router_rcu_reader {
+    unsigned long long  epoch;      /**< epoch the read section started in, 0 outside one */
+    int                 in_use;
+} __attribute__((aligned(64)));
+
+struct oes_router_rcu_deferred {
+    unsigned long long  stamp;      /**< epoch the object was unlinked in */
+    void             (* fn)(void *ctx_p, const unsigned int arg);
+    void              * ctx_p;
+    unsigned int        arg;
+};
+
+struct oes_router_rcu {
+    unsigned long long                epoch;
+    struct oes_router_rcu_reader      readers[OES_ROUTER_RCU_READER_MAX];
+    unsigned int                      reader_hwm;
+    pthread_key_t                     reader_key;
+    pthread_once_t                    reader_once;
+    pthread_mutex_t                   lock;       /**< deferred ring, bulk builds defer from several threads */
+    struct oes_router_rcu_deferred  * ring;
+    unsigned int                      ring_size;  /**< power of 2 */
+    unsigned int                      head;
+    unsigned int                      tail;
+};
+
+static struct oes_router_rcu oes_router_rcu = {
+    .epoch = 1,
+    .reader_once = PTHREAD_ONCE_INIT,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static __thread struct oes_router_rcu_reader *oes_router_rcu_self;
+
+static void
+oes_router_rcu_reader_release(void *reader_p)
+{
+    struct oes_router_rcu_reader *slot_p = reader_p;
+
+    __atomic_store_n(&slot_p->epoch, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&slot_p->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void
+oes_router_rcu_key_create(void)
+{
+    pthread_key_create(&oes_router_rcu.reader_key, oes_router_rcu_reader_release);
+}
+
+/*
+ * Takes a reader slot for the calling thread, given back when the
+ * thread exits.
+ */
+static struct oes_router_rcu_reader *
+oes_router_rcu_reader_register(void)
+{
+    struct oes_router_rcu_reader *slot_p;
+    unsigned int i, hwm;
+    int free_slot;
+
+    pthread_once(&oes_router_rcu.reader_once, oes_router_rcu_key_create);
+    for (i = 0; i < OES_ROUTER_RCU_READER_MAX; i++) {
+        slot_p = &oes_router_rcu.readers[i];
+        free_slot = 0;
+        if (__atomic_compare_exchange_n(&slot_p->in_use, &free_slot, 1, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+    if (i == OES_ROUTER_RCU_READER_MAX) {
+        return NULL;
+    }
+    if (pthread_setspecific(oes_router_rcu.reader_key, slot_p) != 0) {
+        __atomic_store_n(&slot_p->in_use, 0, __ATOMIC_RELEASE);
+        return NULL;
+    }
+    hwm = __atomic_load_n(&oes_router_rcu.reader_hwm, __ATOMIC_RELAXED);
+    while ((hwm < i + 1) &&
+           !__atomic_compare_exchange_n(&oes_router_rcu.reader_hwm, &hwm, i + 1, 0,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+    }
+    oes_router_rcu_self = slot_p;
+    return slot_p;
+}
+
+/*
+ * Oldest epoch a reader is still in, past the current one when
+ * there is none. Objects stamped before it can be released.
+ */
+static unsigned long long
+oes_router_rcu_oldest(void)
+{
+    unsigned long long oldest = __atomic_load_n(&oes_router_rcu.epoch, __ATOMIC_SEQ_CST) + 1, epoch;
+    unsigned int hwm = __atomic_load_n(&oes_router_rcu.reader_hwm, __ATOMIC_SEQ_CST), i;
+
+    for (i = 0; i < hwm; i++) {
+        epoch = __atomic_load_n(&oes_router_rcu.readers[i].epoch, __ATOMIC_SEQ_CST);
+        if (epoch && (epoch < oldest)) {
+            oldest = epoch;
+        }
+    }
+    return oldest;
+}
+
+/**
+ * This function enters a read section. The calling thread takes
+ * a reader slot on its first call.
+ *
+ * @return 1 in a read section, 0 when all reader slots are taken
+ */
+int
+oes_router_rcu_read_lock(void)
+{
+    struct oes_router_rcu_reader *slot_p = oes_router_rcu_self;
+
+    if ((slot_p == NULL) && ((slot_p = oes_router_rcu_reader_register()) == NULL)) {
+        return 0;
+    }
+    __atomic_store_n(&slot_p->epoch, __atomic_load_n(&oes_router_rcu.epoch, __ATOMIC_ACQUIRE),
+                     __ATOMIC_RELAXED);
+    /* the epoch is visible to writers before any table is read */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return 1;
+}
+
+/**
+ * This function leaves a read section.
+ */
+void
+oes_router_rcu_read_unlock(void)
+{
+    __atomic_store_n(&oes_router_rcu_self->epoch, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * This function waits until all the read sections in progress
+ * are over.
+ */
+void
+oes_router_rcu_synchronize(void)
+{
+    unsigned long long target = __atomic_fetch_add(&oes_router_rcu.epoch, 1, __ATOMIC_SEQ_CST);
+
+    while (oes_router_rcu_oldest() <= target) {
+        sched_yield();
+    }
+}
+
+/**
+ * This function hands an object, already unlinked from the
+ * tables, over to be released by fn(ctx_p, arg) once no reader
+ * can still see it. When the deferred list cannot grow, it waits
+ * for the readers and releases the object at once.
+ *
+ * @param[in] fn - release function
+ * @param[in] ctx_p - release context
+ * @param[in] arg - release argument
+ */
+void
+oes_router_rcu_defer(void (*fn)(void *ctx_p, const unsigned int arg),
+                     void *ctx_p,
+                     const unsigned int arg)
+{
+    struct oes_router_rcu_deferred *ring_p, *entry_p;
+    unsigned int size, i;
+
+    pthread_mutex_lock(&oes_router_rcu.lock);
+    if (oes_router_rcu.tail - oes_router_rcu.head == oes_router_rcu.ring_size) {
+        size = oes_router_rcu.ring_size ? oes_router_rcu.ring_size * 2 : OES_ROUTER_RCU_DEFER_MIN;
+        ring_p = malloc(size * sizeof(*ring_p));
+        if (ring_p == NULL) {
+            pthread_mutex_unlock(&oes_router_rcu.lock);
+            oes_router_rcu_synchronize();
+            fn(ctx_p, arg);
+            return;
+        }
+        for (i = 0; i < oes_router_rcu.tail - oes_router_rcu.head; i++) {
+            ring_p[i] = oes_router_rcu.ring[(oes_router_rcu.head + i) & (oes_router_rcu.ring_size - 1)];
+        }
+        free(oes_router_rcu.ring);
+        oes_router_rcu.ring = ring_p;
+        oes_router_rcu.tail -= oes_router_rcu.head;
+        oes_router_rcu.head = 0;
+        oes_router_rcu.ring_size = size;
+    }
+    entry_p = &oes_router_rcu.ring[oes_router_rcu.tail++ & (oes_router_rcu.ring_size - 1)];
+    entry_p->stamp = __atomic_fetch_add(&oes_router_rcu.epoch, 1, __ATOMIC_SEQ_CST);
+    entry_p->fn = fn;
+    entry_p->ctx_p = ctx_p;
+    entry_p->arg = arg;
+    pthread_mutex_unlock(&oes_router_rcu.lock);
+}
+
+/**
+ * This function releases the deferred objects no reader can see
+ * anymore, without waiting for the others.
+ */
+void
+oes_router_rcu_reclaim(void)
+{
+    struct oes_router_rcu_deferred entry;
+    unsigned long long oldest;
+
+    pthread_mutex_lock(&oes_router_rcu.lock);
+    if (oes_router_rcu.head == oes_router_rcu.tail) {
+        pthread_mutex_unlock(&oes_router_rcu.lock);
+        return;
+    }
+    oldest = oes_router_rcu_oldest();
+    while ((oes_router_rcu.head != oes_router_rcu.tail) &&
+           (oes_router_rcu.ring[oes_router_rcu.head & (oes_router_rcu.ring_size - 1)].stamp < oldest)) {
+        entry = oes_router_rcu.ring[oes_router_rcu.head++ & (oes_router_rcu.ring_size - 1)];
+        pthread_mutex_unlock(&oes_router_rcu.lock);
+        entry.fn(entry.ctx_p, entry.arg);
+        pthread_mutex_lock(&oes_router_rcu.lock);
+    }
+    pthread_mutex_unlock(&oes_router_rcu.lock);
+}
+
+/**
+ * This function waits for the read sections in progress and
+ * releases all the objects deferred before the call.
+ */
+void
+oes_router_rcu_barrier(void)
+{
+    oes_router_rcu_synchronize();
+    oes_router_rcu_reclaim();
+}
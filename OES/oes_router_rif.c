@@ -0,0 +1,591 @@
+/* This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING, or the Open Ethernet BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/types.h>
+
+#include <sys/types.h>
+#include <net/ethernet.h>
+#include <netinet/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include "oes_status.h"
+#include "oes_types.h"
+#include "oes_router.h"
+
+#define OES_ROUTER_RIF_TABLE_MIN 64
+#define OES_ROUTER_RIF_MAC_MIN   64
+#define OES_ROUTER_RIF_VLAN_MAX  4094
+#define OES_ROUTER_RIF_L2_VLAN   (1ULL << 63)
+
+/*
+ * Key of an L2 interface: (bridge, VLAN) with the top bit set,
+ * or the port + 1. 0 if the L2 interface is not valid.
+ */
+static unsigned long long
+oes_router_rif_l2(const struct oes_l3_interface *ifc_p)
+{
+    switch (ifc_p->type) {
+    case OES_INTERFACE_TYPE_VLAN:
+        if ((ifc_p->ifc.vlan.vlan == 0) || (ifc_p->ifc.vlan.vlan > OES_ROUTER_RIF_VLAN_MAX)) {
+            return 0;
+        }
+        return OES_ROUTER_RIF_L2_VLAN | ((unsigned long long)(unsigned int)ifc_p->ifc.vlan.br_id << 16) |
+               ifc_p->ifc.vlan.vlan;
+
+    case OES_INTERFACE_TYPE_ROUTER_PORT:
+        if ((unsigned long long)ifc_p->ifc.port.port & OES_ROUTER_RIF_L2_VLAN) {
+            return 0;
+        }
+        return ifc_p->ifc.port.port + 1;
+
+    default:
+        return 0;
+    }
+}
+
+static unsigned int
+oes_router_rif_hash(const unsigned long long l2, const struct ether_addr *mac_p)
+{
+    unsigned int hash = 0, words[3], i;
+
+    words[0] = (unsigned int)l2;
+    words[1] = (unsigned int)(l2 >> 32);
+    words[2] = 0;
+    if (mac_p != NULL) {
+        words[2] = ((unsigned int)mac_p->ether_addr_octet[0] << 8) | mac_p->ether_addr_octet[1];
+        hash = ((unsigned int)mac_p->ether_addr_octet[2] << 24) | ((unsigned int)mac_p->ether_addr_octet[3] << 16) |
+               ((unsigned int)mac_p->ether_addr_octet[4] << 8) | mac_p->ether_addr_octet[5];
+    }
+    for (i = 0; i < 3; i++) {
+        hash ^= words[i];
+        hash *= 0x85ebca6b;
+        hash ^= hash >> 13;
+        hash *= 0xc2b2ae35;
+        hash ^= hash >> 16;
+    }
+    return hash;
+}
+
+static unsigned int *
+oes_router_rif_l2_chain(const struct oes_router_rif_table *table_p, const unsigned long long l2)
+{
+    return &table_p->l2_hash[oes_router_rif_hash(l2, NULL) & (table_p->rif_size - 1)];
+}
+
+/*
+ * Grows the interface array and its L2 hash together, the hash
+ * keeps one chain per interface slot. Rifs keep their index.
+ */
+static oes_status_e
+oes_router_rif_table_grow(struct oes_router_rif_table *table_p)
+{
+    unsigned int size = table_p->rif_size ? table_p->rif_size * 2 : OES_ROUTER_RIF_TABLE_MIN;
+    struct oes_router_rif *rifs_p;
+    unsigned int *hash_p, *chain_p, idx;
+
+    hash_p = oes_router_pool_calloc(table_p->pool, size, sizeof(*hash_p));
+    if (hash_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    rifs_p = oes_router_pool_realloc(table_p->pool, table_p->rifs, table_p->rif_size * sizeof(*rifs_p),
+                                     size * sizeof(*rifs_p));
+    if (rifs_p == NULL) {
+        oes_router_pool_free(table_p->pool, hash_p, size * sizeof(*hash_p));
+        return OES_STATUS_NO_MEMORY;
+    }
+    memset(&rifs_p[table_p->rif_size], 0, (size - table_p->rif_size) * sizeof(*rifs_p));
+    oes_router_pool_free(table_p->pool, table_p->l2_hash, table_p->rif_size * sizeof(*table_p->l2_hash));
+    table_p->rifs = rifs_p;
+    table_p->l2_hash = hash_p;
+    for (idx = 0; idx < table_p->rif_size; idx++) {
+        if (rifs_p[idx].in_use) {
+            chain_p = &hash_p[oes_router_rif_hash(oes_router_rif_l2(&rifs_p[idx].ifc), NULL) & (size - 1)];
+            rifs_p[idx].hash_next = *chain_p;
+            *chain_p = idx + 1;
+        }
+    }
+    /* the lowest rifs are handed out first */
+    for (idx = size; idx > table_p->rif_size; idx--) {
+        rifs_p[idx - 1].hash_next = table_p->rif_free;
+        table_p->rif_free = idx;
+    }
+    table_p->rif_size = size;
+    return OES_STATUS_SUCCESS;
+}
+
+/*
+ * Grows the MAC entries and their hash together, the hash keeps
+ * one chain per entry.
+ */
+static oes_status_e
+oes_router_rif_mac_grow(struct oes_router_rif_table *table_p)
+{
+    unsigned int size = table_p->mac_size ? table_p->mac_size * 2 : OES_ROUTER_RIF_MAC_MIN;
+    struct oes_router_rif_mac *macs_p;
+    unsigned int *hash_p, bucket, idx;
+
+    hash_p = oes_router_pool_calloc(table_p->pool, size, sizeof(*hash_p));
+    if (hash_p == NULL) {
+        return OES_STATUS_NO_MEMORY;
+    }
+    macs_p = oes_router_pool_realloc(table_p->pool, table_p->macs, table_p->mac_size * sizeof(*macs_p),
+                                     size * sizeof(*macs_p));
+    if (macs_p == NULL) {
+        oes_router_pool_free(table_p->pool, hash_p, size * sizeof(*hash_p));
+        return OES_STATUS_NO_MEMORY;
+    }
+    memset(&macs_p[table_p->mac_size], 0, (size - table_p->mac_size) * sizeof(*macs_p));
+    oes_router_pool_free(table_p->pool, table_p->mac_hash, table_p->mac_size * sizeof(*table_p->mac_hash));
+    table_p->macs = macs_p;
+    table_p->mac_hash = hash_p;
+    for (idx = 0; idx < table_p->mac_size; idx++) {
+        if (macs_p[idx].primary || macs_p[idx].added) {
+            bucket = macs_p[idx].hash & (size - 1);
+            macs_p[idx].hash_next = hash_p[bucket];
+            hash_p[bucket] = idx + 1;
+        }
+    }
+    for (idx = size; idx > table_p->mac_size; idx--) {
+        macs_p[idx - 1].hash_next = table_p->mac_free;
+        table_p->mac_free = idx;
+    }
+    table_p->mac_size = size;
+    return OES_STATUS_SUCCESS;
+}
+
+/* grows the MAC entries until cnt more fit */
+static oes_status_e
+oes_router_rif_mac_reserve(struct oes_router_rif_table *table_p, const unsigned int cnt)
+{
+    oes_status_e status;
+
+    while (table_p->mac_size - table_p->mac_cnt < cnt) {
+        status = oes_router_rif_mac_grow(table_p);
+        if (status != OES_STATUS_SUCCESS) {
+            return status;
+        }
+    }
+    return OES_STATUS_SUCCESS;
+}
+
+static struct oes_router_rif_mac *
+oes_router_rif_mac_find(const struct oes_router_rif_table *table_p,
+                        const unsigned long long l2,
+                        const struct ether_addr *mac_p)
+{
+    unsigned int hash, next;
+    struct oes_router_rif_mac *entry_p;
+
+    if (table_p->mac_cnt == 0) {
+        return NULL;
+    }
+    hash = oes_router_rif_hash(l2, mac_p);
+    for (next = table_p->mac_hash[hash & (table_p->mac_size - 1)]; next; next = entry_p->hash_next) {
+        entry_p = &table_p->macs[next - 1];
+        if ((entry_p->hash == hash) && (entry_p->l2 == l2) &&
+            (memcmp(&entry_p->mac, mac_p, sizeof(*mac_p)) == 0)) {
+            return entry_p;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Returns the entry of a MAC of an interface, adding it when
+ * there is none. An entry must be free.
+ */
+static struct oes_router_rif_mac *
+oes_router_rif_mac_link(struct oes_router_rif_table *table_p,
+                        struct oes_router_rif *rif_p,
+                        const unsigned long long l2,
+                        const struct ether_addr *mac_p)
+{
+    struct oes_router_rif_mac *entry_p = oes_router_rif_mac_find(table_p, l2, mac_p);
+    unsigned int idx, bucket;
+
+    if (entry_p != NULL) {
+        return entry_p;
+    }
+    idx = table_p->mac_free - 1;
+    entry_p = &table_p->macs[idx];
+    table_p->mac_free = entry_p->hash_next;
+    memset(entry_p, 0, sizeof(*entry_p));
+    entry_p->l2 = l2;
+    entry_p->mac = *mac_p;
+    entry_p->rif = rif_p - table_p->rifs;
+    entry_p->hash = oes_router_rif_hash(l2, mac_p);
+    bucket = entry_p->hash & (table_p->mac_size - 1);
+    entry_p->hash_next = table_p->mac_hash[bucket];
+    table_p->mac_hash[bucket] = idx + 1;
+    entry_p->rif_next = rif_p->mac_head;
+    rif_p->mac_head = idx + 1;
+    table_p->mac_cnt++;
+    return entry_p;
+}
+
+/* frees an entry once it is neither the interface MAC nor added */
+static void
+oes_router_rif_mac_unlink(struct oes_router_rif_table *table_p,
+                          struct oes_router_rif *rif_p,
+                          struct oes_router_rif_mac *entry_p)
+{
+    unsigned int idx = entry_p - table_p->macs, *next_p;
+
+    if (entry_p->primary || entry_p->added) {
+        return;
+    }
+    next_p = &table_p->mac_hash[entry_p->hash & (table_p->mac_size - 1)];
+    while (*next_p != idx + 1) {
+        next_p = &table_p->macs[*next_p - 1].hash_next;
+    }
+    *next_p = entry_p->hash_next;
+    next_p = &rif_p->mac_head;
+    while (*next_p != idx + 1) {
+        next_p = &table_p->macs[*next_p - 1].rif_next;
+    }
+    *next_p = entry_p->rif_next;
+    entry_p->hash_next = table_p->mac_free;
+    table_p->mac_free = idx + 1;
+    table_p->mac_cnt--;
+}
+
+/**
+ * This function sets up an empty table.
+ *
+ * @param[out] table_p - router interface table
+ * @param[in] pool_p - pool the interfaces are allocated from
+ */
+void
+oes_router_rif_table_init(struct oes_router_rif_table *table_p, struct oes_router_pool *pool_p)
+{
+    memset(table_p, 0, sizeof(*table_p));
+    table_p->pool = pool_p;
+}
+
+/**
+ * This function frees all the interfaces of a table.
+ *
+ * @param[in] table_p - router interface table
+ */
+void
+oes_router_rif_table_deinit(struct oes_router_rif_table *table_p)
+{
+    struct oes_router_pool *pool_p = table_p->pool;
+
+    oes_router_pool_free(pool_p, table_p->rifs, table_p->rif_size * sizeof(*table_p->rifs));
+    oes_router_pool_free(pool_p, table_p->l2_hash, table_p->rif_size * sizeof(*table_p->l2_hash));
+    oes_router_pool_free(pool_p, table_p->macs, table_p->mac_size * sizeof(*table_p->macs));
+    oes_router_pool_free(pool_p, table_p->mac_hash, table_p->mac_size * sizeof(*table_p->mac_hash));
+    oes_router_rif_table_init(table_p, pool_p);
+}
+
+/**
+ * This function adds an interface on an L2 interface without
+ * one, with its MAC. Its admin state is down for both IP
+ * versions.
+ *
+ * @param[in] table_p - router interface table
+ * @param[in] vrid - virtual router of the interface
+ * @param[in] ifc_p - L2 interface
+ * @param[in] attr_p - interface attributes
+ * @param[out] rif_p - rif
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_ERROR if the L2 interface is invalid
+ * @return OES_STATUS_ENTRY_ALREADY_EXISTS if the L2 interface has
+ *         a router interface
+ * @return OES_STATUS_NO_RESOURCES if there are
+ *         OES_ROUTER_RIF_MAX interfaces
+ * @return OES_STATUS_NO_MEMORY if the table cannot grow
+ */
+oes_status_e
+oes_router_rif_add(struct oes_router_rif_table *table_p,
+                   const unsigned int vrid,
+                   const struct oes_l3_interface *ifc_p,
+                   const struct oes_l3_interface_attributes *attr_p,
+                   unsigned int *rif_p)
+{
+    unsigned long long l2 = oes_router_rif_l2(ifc_p);
+    struct oes_router_rif *new_p;
+    unsigned int idx, *chain_p;
+    oes_status_e status;
+
+    if (l2 == 0) {
+        return OES_STATUS_PARAM_ERROR;
+    }
+    if (table_p->rif_cnt) {
+        for (idx = *oes_router_rif_l2_chain(table_p, l2); idx; idx = table_p->rifs[idx - 1].hash_next) {
+            if (oes_router_rif_l2(&table_p->rifs[idx - 1].ifc) == l2) {
+                return OES_STATUS_ENTRY_ALREADY_EXISTS;
+            }
+        }
+    }
+    if (table_p->rif_cnt == OES_ROUTER_RIF_MAX) {
+        return OES_STATUS_NO_RESOURCES;
+    }
+    if (!table_p->rif_free) {
+        status = oes_router_rif_table_grow(table_p);
+        if (status != OES_STATUS_SUCCESS) {
+            return status;
+        }
+    }
+    status = oes_router_rif_mac_reserve(table_p, 1);
+    if (status != OES_STATUS_SUCCESS) {
+        return status;
+    }
+    idx = table_p->rif_free - 1;
+    new_p = &table_p->rifs[idx];
+    table_p->rif_free = new_p->hash_next;
+    memset(new_p, 0, sizeof(*new_p));
+    new_p->ifc = *ifc_p;
+    new_p->attr = *attr_p;
+    new_p->in_use = 1;
+    new_p->vrid = vrid;
+    chain_p = oes_router_rif_l2_chain(table_p, l2);
+    new_p->hash_next = *chain_p;
+    *chain_p = idx + 1;
+    table_p->rif_cnt++;
+    oes_router_rif_mac_link(table_p, new_p, l2, &attr_p->mac_addr)->primary = 1;
+    *rif_p = idx;
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function deletes an interface, with its MACs.
+ *
+ * @param[in] table_p - router interface table
+ * @param[in] rif_p - interface
+ */
+void
+oes_router_rif_delete(struct oes_router_rif_table *table_p, struct oes_router_rif *rif_p)
+{
+    unsigned int idx = rif_p - table_p->rifs, *next_p;
+    struct oes_router_rif_mac *entry_p;
+
+    while (rif_p->mac_head) {
+        entry_p = &table_p->macs[rif_p->mac_head - 1];
+        entry_p->primary = 0;
+        entry_p->added = 0;
+        oes_router_rif_mac_unlink(table_p, rif_p, entry_p);
+    }
+    next_p = oes_router_rif_l2_chain(table_p, oes_router_rif_l2(&rif_p->ifc));
+    while (*next_p != idx + 1) {
+        next_p = &table_p->rifs[*next_p - 1].hash_next;
+    }
+    *next_p = rif_p->hash_next;
+    rif_p->in_use = 0;
+    rif_p->hash_next = table_p->rif_free;
+    table_p->rif_free = idx + 1;
+    table_p->rif_cnt--;
+}
+
+/**
+ * This function sets the attributes of an interface, moving its
+ * MAC in the hash when it changes.
+ *
+ * @param[in] table_p - router interface table
+ * @param[in] rif_p - interface
+ * @param[in] attr_p - interface attributes
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_NO_MEMORY if the table cannot grow
+ */
+oes_status_e
+oes_router_rif_attr_set(struct oes_router_rif_table *table_p,
+                        struct oes_router_rif *rif_p,
+                        const struct oes_l3_interface_attributes *attr_p)
+{
+    unsigned long long l2 = oes_router_rif_l2(&rif_p->ifc);
+    struct oes_router_rif_mac *entry_p;
+    oes_status_e status;
+
+    if (memcmp(&rif_p->attr.mac_addr, &attr_p->mac_addr, sizeof(attr_p->mac_addr)) != 0) {
+        status = oes_router_rif_mac_reserve(table_p, 1);
+        if (status != OES_STATUS_SUCCESS) {
+            return status;
+        }
+        oes_router_rif_mac_link(table_p, rif_p, l2, &attr_p->mac_addr)->primary = 1;
+        entry_p = oes_router_rif_mac_find(table_p, l2, &rif_p->attr.mac_addr);
+        entry_p->primary = 0;
+        oes_router_rif_mac_unlink(table_p, rif_p, entry_p);
+    }
+    rif_p->attr = *attr_p;
+    return OES_STATUS_SUCCESS;
+}
+
+/**
+ * This function adds MACs to an interface, or deletes them from
+ * it. MACs the interface has already, or has not for a delete,
+ * are skipped. The table grows first, an add changes all the
+ * MACs or none.
+ *
+ * @param[in] table_p - router interface table
+ * @param[in] rif_p - interface
+ * @param[in] add - 1 to add, 0 to delete
+ * @param[in] mac_list_p - MACs
+ * @param[in] mac_cnt - number of MACs
+ *
+ * @return OES_STATUS_SUCCESS if operation completes successfully
+ * @return OES_STATUS_PARAM_EXCEEDS_RANGE if the interface would
+ *         get more than OES_ROUTER_RIF_MAC_MAX MACs
+ * @return OES_STATUS_NO_MEMORY if the table cannot grow
+ */
+oes_status_e
+oes_router_rif_macs_update(struct oes_router_rif_table *table_p,
+                           struct oes_router_rif *rif_p,
+                           const int add,
+                           const struct ether_addr *mac_list_p,
+                           const unsigned int mac_cnt)
+{
+    unsigned long long l2 = oes_router_rif_l2(&rif_p->ifc);
+    struct oes_router_rif_mac *entry_p;
+    unsigned int i, next, new_cnt = 0;
+    oes_status_e status;
+
+    if (!add) {
+        for (i = 0; i < mac_cnt; i++) {
+            entry_p = oes_router_rif_mac_find(table_p, l2, &mac_list_p[i]);
+            if ((entry_p != NULL) && entry_p->added) {
+                entry_p->added = 0;
+                rif_p->mac_added--;
+                oes_router_rif_mac_unlink(table_p, rif_p, entry_p);
+            }
+        }
+        return OES_STATUS_SUCCESS;
+    }
+
+    /* the list may repeat MACs, enough entries for all of them */
+    for (i = 0; i < mac_cnt; i++) {
+        entry_p = oes_router_rif_mac_find(table_p, l2, &mac_list_p[i]);
+        new_cnt += (entry_p == NULL);
+    }
+    status = oes_router_rif_mac_reserve(table_p, new_cnt);
+    if (status != OES_STATUS_SUCCESS) {
+        return status;
+    }
+    /* the MACs this call adds are marked 2 until it is done */
+    for (i = 0; i < mac_cnt; i++) {
+        entry_p = oes_router_rif_mac_link(table_p, rif_p, l2, &mac_list_p[i]);
+        if (!entry_p->added) {
+            entry_p->added = 2;
+            rif_p->mac_added++;
+        }
+    }
+    status = (rif_p->mac_added > OES_ROUTER_RIF_MAC_MAX) ? OES_STATUS_PARAM_EXCEEDS_RANGE : OES_STATUS_SUCCESS;
+    for (next = rif_p->mac_head; next; ) {
+        entry_p = &table_p->macs[next - 1];
+        next = entry_p->rif_next;
+        if (entry_p->added != 2) {
+            continue;
+        }
+        if (status == OES_STATUS_SUCCESS) {
+            entry_p->added = 1;
+            continue;
+        }
+        entry_p->added = 0;
+        rif_p->mac_added--;
+        oes_router_rif_mac_unlink(table_p, rif_p, entry_p);
+    }
+    return status;
+}
+
+/**
+ * This function deletes all the MACs added to an interface, its
+ * own MAC stays.
+ *
+ * @param[in] table_p - router interface table
+ * @param[in] rif_p - interface
+ */
+void
+oes_router_rif_macs_clear(struct oes_router_rif_table *table_p, struct oes_router_rif *rif_p)
+{
+    struct oes_router_rif_mac *entry_p;
+    unsigned int next;
+
+    for (next = rif_p->mac_head; next; ) {
+        entry_p = &table_p->macs[next - 1];
+        next = entry_p->rif_next;
+        entry_p->added = 0;
+        oes_router_rif_mac_unlink(table_p, rif_p, entry_p);
+    }
+    rif_p->mac_added = 0;
+}
+
+/**
+ * This function lists the MACs added to an interface, the
+ * latest first.
+ *
+ * @param[in] table_p - router interface table
+ * @param[in] rif_p - interface
+ * @param[out] mac_list_p - MACs
+ * @param[in] cnt - list size
+ *
+ * @return number of MACs listed
+ */
+unsigned int
+oes_router_rif_macs_list(const struct oes_router_rif_table *table_p,
+                         const struct oes_router_rif *rif_p,
+                         struct ether_addr *mac_list_p,
+                         const unsigned int cnt)
+{
+    unsigned int next, listed = 0;
+
+    for (next = rif_p->mac_head; next && (listed < cnt); next = table_p->macs[next - 1].rif_next) {
+        if (table_p->macs[next - 1].added) {
+            mac_list_p[listed++] = table_p->macs[next - 1].mac;
+        }
+    }
+    return listed;
+}
+
+/**
+ * This function returns the interface of an L2 interface which
+ * has a MAC, NULL if there is none.
+ *
+ * @param[in] table_p - router interface table
+ * @param[in] ifc_p - L2 interface
+ * @param[in] mac_p - MAC
+ *
+ * @return the interface
+ */
+struct oes_router_rif *
+oes_router_rif_lookup(const struct oes_router_rif_table *table_p,
+                      const struct oes_l3_interface *ifc_p,
+                      const struct ether_addr *mac_p)
+{
+    unsigned long long l2 = oes_router_rif_l2(ifc_p);
+    struct oes_router_rif_mac *entry_p;
+
+    if (l2 == 0) {
+        return NULL;
+    }
+    entry_p = oes_router_rif_mac_find(table_p, l2, mac_p);
+    return (entry_p != NULL) ? &table_p->rifs[entry_p->rif] : NULL;
+}
@@ -46,6 +46,9 @@ enum oes_access_cmd {
     OES_ACCESS_CMD_GET          = 14,
     OES_ACCESS_CMD_GET_FIRST    = 15,
     OES_ACCESS_CMD_GET_NEXT     = 16,
+    OES_ACCESS_CMD_READ         = 17,
+    OES_ACCESS_CMD_READ_CLEAR   = 18,
+    OES_ACCESS_CMD_GET_ACTIVITY = 19,
 };
 
 enum oes_span_type {
@@ -152,6 +155,25 @@ enum oes_ip_version {
 enum oes_event {
     OES_EVENT_ID_FDB,/**< FDB learning and aging event */
     OES_EVENT_ID_PORT,/**< port up/down*/
+    OES_EVENT_ID_NEIGH,/**< neighbour refresh and aging, registered per virtual router */
+    OES_EVENT_ID_SNAPSHOT_END,/**< end of a registration snapshot, not registrable */
+
+    OES_EVENT_ID_MIN = OES_EVENT_ID_FDB,
+    OES_EVENT_ID_MAX = OES_EVENT_ID_SNAPSHOT_END
+};
+
+/*
+ * Event priority lanes, drained in strict priority order so
+ * that port state changes never wait behind FDB floods.
+ */
+enum oes_event_lane {
+    OES_EVENT_LANE_PORT,      /**< port up/down */
+    OES_EVENT_LANE_FDB_FLUSH, /**< FDB flush all/vid/port/port vid */
+    OES_EVENT_LANE_FDB_LEARN, /**< FDB learn and age */
+    OES_EVENT_LANE_NEIGH,     /**< neighbour refresh and age */
+
+    OES_EVENT_LANE_MIN = OES_EVENT_LANE_PORT,
+    OES_EVENT_LANE_MAX = OES_EVENT_LANE_NEIGH
 };
 
 enum oes_l2_packet {
@@ -307,6 +329,66 @@ struct oes_router_attributes {
     unsigned char  enable_ipv6;
     enum oes_router_action ttl_0_action;
     enum oes_router_action ttl_1_action;
+    unsigned long long memory_limit;    /**< bytes the router tables may take, 0 for no limit */
+};
+
+/*
+ * Memory of a virtual router. Its tables are allocated from a
+ * pool of its own, counted against memory_limit. The LPM tables
+ * are mapped, only the pages in use count.
+ */
+struct oes_router_memory {
+    unsigned long long pool_bytes;      /**< routes, next-hop groups, neighbors, LPM tree nodes */
+    unsigned long long pool_peak_bytes;
+    unsigned long long table_bytes;     /**< pages of the LPM tables written */
+};
+
+/*
+ * Memory of one table of a virtual router. Ratios are in 1/10000.
+ * free_bytes is the part of bytes holding no entry: hash and
+ * record slots not in use and, for the LPM tables, exactly what
+ * oes_api_router_memory_compact() gives back, the tbl8 tail past
+ * the groups in use and the table pages left empty by withdrawn
+ * routes.
+ */
+struct oes_router_table_usage {
+    unsigned long long bytes;           /**< allocated or resident */
+    unsigned long long free_bytes;      /**< of bytes, holding no entry */
+    unsigned int       entry_cnt;       /**< entries in use */
+    unsigned int       entry_max;       /**< entries the table holds without growing */
+    unsigned int       fill;            /**< entry_cnt over entry_max */
+    unsigned int       fragmentation;   /**< free_bytes over bytes */
+};
+
+/*
+ * Memory of a virtual router per table. The LPM entries are tbl8
+ * groups for IPv4 and direct table entries for IPv6, the IPv6
+ * bytes include the tree nodes. A virtual router with a few
+ * thousand routes of an IP version or less keeps them in a tree
+ * only: that LPM has no entries and its bytes are the nodes.
+ */
+struct oes_router_memory_stats {
+    unsigned int                  ipv4_route_cnt;
+    unsigned int                  ipv6_route_cnt;
+    struct oes_router_table_usage routes;       /**< route records and their hash */
+    struct oes_router_table_usage lpm4;
+    struct oes_router_table_usage lpm6;
+    struct oes_router_table_usage nhgs;         /**< next-hop groups and their members */
+    struct oes_router_table_usage neighs;       /**< neighbors and their aging */
+    struct oes_router_table_usage mc_routes;
+};
+
+/*
+ * Neighbour aging of a virtual router. A neighbour without
+ * traffic for age_time gets refresh events every
+ * refresh_interval, and is removed after refresh_cnt of them.
+ * Each delay is shortened by up to jitter percent at random.
+ */
+struct oes_router_neigh_age_params {
+    unsigned int age_time;          /**< ms, 0 disables aging */
+    unsigned int refresh_interval;  /**< ms between refresh events */
+    unsigned int refresh_cnt;       /**< refresh events before removal */
+    unsigned int jitter;            /**< percent, up to 50 */
 };
 
 
@@ -333,6 +415,16 @@ struct oes_l3_interface_admin_state {
     unsigned char  enable_ipv6;
 };
 
+/*
+ * Router interface a frame is routed by: the interface of its
+ * ingress L2 interface which has its destination MAC.
+ */
+struct oes_l3_interface_lookup {
+    unsigned int vrid;
+    unsigned int rif;
+    struct oes_l3_interface_admin_state admin_state;   /**< IP versions the interface routes */
+};
+
 
 struct oes_ip_addr {
     enum oes_ip_version version;
@@ -349,6 +441,8 @@ struct oes_neigh_data {
     unsigned char activity;
 };
 
+#define OES_ROUTER_INTERFACE_INVALID 0xffffffff
+
 struct oes_ip_prefix {
     struct oes_ip_addr prefix;
     unsigned int prefix_len;
@@ -356,9 +450,37 @@ struct oes_ip_prefix {
 
 struct oes_uc_route_data {
     enum oes_router_action  action;
-    struct oes_ip_addr * next_hop_list;
+    struct oes_ip_addr * next_hop_list;   /**< distinct next hops of one IP version */
     unsigned short   next_hop_cnt;
     unsigned char activity;
+    unsigned short   ecmp_bucket_cnt;   /**< resilient hashing buckets, 128 to 4096, 0 for plain hashing */
+    unsigned int     ecmp_idle_timer;   /**< ms a bucket stays idle before it moves to another next hop */
+};
+
+#define OES_ROUTER_ECMP_BUCKET_MIN 128
+#define OES_ROUTER_ECMP_BUCKET_MAX 4096
+
+#define OES_ROUTER_NEXT_HOP_GROUP_INVALID 0xffffffff
+
+struct oes_uc_route_lookup {
+    unsigned char valid;            /**< a route matched the address */
+    enum oes_router_action  action; /**< matched route action */
+    unsigned int prefix_len;        /**< matched route prefix length */
+    unsigned int next_hop_group;    /**< next-hop group ID, OES_ROUTER_NEXT_HOP_GROUP_INVALID if none */
+};
+
+/*
+ * Header fields of a packet, as far as ECMP hashing goes. Fields
+ * not enabled in struct oes_router_ecmp_hash_fields are ignored.
+ */
+struct oes_router_flow {
+    struct oes_ip_addr  src_ip;
+    struct oes_ip_addr  dst_ip;
+    unsigned int        flow_label;     /**< IPv6 only */
+    unsigned char       tc;             /**< IPv4 TOS or IPv6 traffic class */
+    unsigned char       protocol;       /**< IPv4 protocol or IPv6 next header */
+    unsigned short      src_port;       /**< TCP/UDP ports, host order */
+    unsigned short      dst_port;
 };
 
 struct oes_router_cntr {
@@ -393,6 +515,19 @@ struct oes_mc_route_data {
     unsigned short rif_cnt;
 };
 
+/*
+ * Result of a multicast route lookup: the (S,G) route of the
+ * ingress interface, else its (*,G) route, else the (*,G) route
+ * of any ingress interface.
+ */
+struct oes_mc_route_lookup {
+    unsigned char valid;                /**< a route matched the packet */
+    unsigned char any_source;           /**< the route matched is a (*,G) one */
+    unsigned int  ingress_rif;          /**< of the route matched, OES_ROUTER_INTERFACE_INVALID for any */
+    struct oes_mc_router_action action; /**< matched route action */
+    unsigned short rif_cnt;             /**< egress interfaces of the route matched */
+};
+
 struct oes_event_port {
     unsigned int       log_port;/**<! logical port */
     enum oes_port_oper_state port_state;/**<! operational state */
@@ -426,14 +561,67 @@ struct oes_event_fdb {
 
 };
 
+enum oes_neigh_event_type {
+    OES_NEIGH_EVENT_REFRESH, /**< idle neighbour, to be probed */
+    OES_NEIGH_EVENT_AGE,     /**< neighbour still idle after its probes, removed */
+};
+
+struct oes_event_neigh {
+    enum oes_neigh_event_type neigh_event_type;
+    unsigned int       vrid;          /**<! virtual router */
+    struct oes_ip_addr neigh_addr;    /**<! neighbour address */
+    unsigned int       rif;           /**<! router interface */
+    struct ether_addr  mac_addr;      /**<! neighbour MAC */
+    unsigned int       refresh_cnt;   /**<! refresh events sent since the neighbour was last active */
+};
+
+struct oes_event_snapshot_end {
+    enum oes_event event_id;   /**<! event ID the snapshot was taken for */
+    int br_id;                 /**<! bridge the snapshot was taken for */
+    unsigned int entry_cnt;    /**<! snapshot events delivered before this one */
+};
+
 union oes_event_data {
     struct oes_event_port port_event;/**<! port up/down event data */
     struct oes_event_fdb  fdb_event;/**<! FDB  event data */
+    struct oes_event_neigh neigh_event;/**<! neighbour event data */
+    struct oes_event_snapshot_end snapshot_end;/**<! end of snapshot marker */
 };
 
 struct oes_event_info {
     enum oes_event      event_id; /**<!event ID */
     union oes_event_data        event_info; /**<! event info */
+    unsigned long long  timestamp; /**<! production time in ns, comparable to CLOCK_MONOTONIC */
+};
+
+/*
+ * Log-linear latency buckets: values below 8ns have one bucket
+ * each, above that every power of two is split in 8 buckets.
+ * Bucket b >= 8 starts at (8 + (b & 7)) << ((b >> 3) - 1) ns,
+ * the last bucket also holds everything above 2^40 ns.
+ */
+#define OES_EVENT_LATENCY_SUB_BITS      3
+#define OES_EVENT_LATENCY_BUCKET_CNT    304
+
+struct oes_event_latency_histogram {
+    unsigned long long count;   /**<! events measured */
+    unsigned long long sum_ns;  /**<! total enqueue to dequeue time */
+    unsigned long long max_ns;  /**<! worst enqueue to dequeue time since the last READ_CLEAR */
+    unsigned long long buckets[OES_EVENT_LATENCY_BUCKET_CNT];
+};
+
+struct oes_event_register_params {
+    unsigned char enable_snapshot; /**<! deliver the current FDB entries / port states before live events */
+};
+
+struct oes_event_channel_stats {
+    unsigned long long received;  /**<! events delivered on the channel */
+    unsigned long long dropped;   /**<! events overwritten before the channel read them */
+    unsigned long long lag;       /**<! events published but not yet read */
+    unsigned long long max_lag;   /**<! highest lane lag seen since the channel was created */
+    unsigned char      slow;      /**<! a lane lag went above half of the lane */
+    unsigned long long lane_depth[OES_EVENT_LANE_MAX + 1];   /**<! events pending per lane */
+    unsigned long long lane_dropped[OES_EVENT_LANE_MAX + 1]; /**<! events lost per lane */
 };
 
 #endif